@@ -26,6 +26,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include "darray.h"
+#include "hashtable.h"
 #include "whereami/whereami.h"
 #include "assetfs.h"
 #include "util.h"
@@ -88,6 +89,7 @@ struct assetdirentry_t
 
 struct assetdir_t
 {
+    char* vpath; /* virtual path of this directory ("" for the root) */
     DARRAY(assetdirentry_t, dir); /* subdirs */
     DARRAY(assetfile_t*, file); /* files */
 };
@@ -98,13 +100,16 @@ static char* afs_gameid = NULL;
 /* internal functions */
 static bool is_valid_id(const char* str);
 static bool is_sane_vpath(const char* vpath);
+static bool is_canonical_vpath(const char* vpath);
 static bool is_asset_folder(const char* fullpath);
 static bool is_writable_file(const char* fullpath);
 static inline char* clone_str(const char* str);
 static inline char* join_path(const char* path, const char* basename);
+static inline char* join_vpath(const char* vpath, const char* basename);
 static inline char* pathify(const char* path);
 static inline int vpathcmp(const char* vp1, const char* vp2);
 static inline int vpathncmp(const char* vp1, const char* vp2, int n);
+static inline uint32_t vpathhash(const char* vpath);
 static inline int vpc(int c) { return (c == '\\') ? '/' : tolower(c); }
 static void scan_default_folders(const char* gameid, const char* basedir);
 static bool scan_exedir(assetdir_t* dir, assetpriority_t priority);
@@ -131,12 +136,17 @@ static assetfile_t* afs_rmfile(assetfile_t* file);
 static void afs_storefile(assetdir_t* dir, assetfile_t* file);
 static void afs_updatefile(assetfile_t* file, const char* fullpath);
 static assetfile_t* afs_findfile(assetdir_t* dir, const char* vpath);
+static assetfile_t* afs_lookup(const char* vpath);
 static int afs_foreach(assetdir_t* dir, const char* extension_filter, int (*callback)(const char* fullpath, void* param), void* param, bool recursive, bool* stop);
 static void afs_sort(assetdir_t* base);
 static bool afs_empty(assetdir_t* base);
 static assetdir_t* afs_mkpath(assetdir_t* base, const char* vpath);
 static bool afs_strict = true;
 
+/* a lookup table mapping normalized vpaths to files (case-insensitive, slash-insensitive) */
+HASHTABLE_GENERATE_CODE_EX(assetfile_t, NULL, char*, vpathcmp, vpathhash, __h_clone_string_assetfile_t, __h_delete_string_assetfile_t);
+static HASHTABLE(assetfile_t, lookup_table);
+
 
 
 /* public API */
@@ -157,6 +167,7 @@ void assetfs_init(const char* gameid, const char* basedir, const char* datadir)
     }
 
     /* create the root */
+    lookup_table = hashtable_assetfile_t_create();
     root = afs_mkdir(NULL, ".");
 
     /* get the gameid */
@@ -196,6 +207,7 @@ void assetfs_init(const char* gameid, const char* basedir, const char* datadir)
  */
 void assetfs_release()
 {
+    lookup_table = hashtable_assetfile_t_destroy(lookup_table);
     root = afs_rmdir(root);
     free(afs_gameid);
     afs_gameid = NULL;
@@ -207,7 +219,7 @@ void assetfs_release()
  */
 const char* assetfs_fullpath(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
     static char path[4096] = { 0 };
 
     if(file == NULL) {
@@ -235,7 +247,7 @@ const char* assetfs_fullpath(const char* vpath)
  */
 bool assetfs_exists(const char* vpath)
 {
-    return afs_findfile(root, vpath) != NULL;
+    return afs_lookup(vpath) != NULL;
 }
 
 /*
@@ -278,7 +290,7 @@ bool assetfs_use_strict(bool strict)
  */
 bool assetfs_is_primary_file(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
     return file != NULL ? file->priority == ASSET_PRIMARY : false;
 }
 
@@ -289,7 +301,7 @@ bool assetfs_is_primary_file(const char* vpath)
  */
 const char* assetfs_create_config_file(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
 
     if(file == NULL) {
         int dirlen = -1;
@@ -347,7 +359,7 @@ const char* assetfs_create_config_file(const char* vpath)
  */
 const char* assetfs_create_cache_file(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
 
     if(file == NULL) {
         int dirlen = -1;
@@ -412,7 +424,7 @@ const char* assetfs_create_cache_file(const char* vpath)
  */
 const char* assetfs_create_data_file(const char* vpath, bool prefer_user_space)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
 
     if(file == NULL) {
         int dirlen = -1;
@@ -474,7 +486,7 @@ const char* assetfs_create_data_file(const char* vpath, bool prefer_user_space)
  */
 bool assetfs_is_config_file(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
     return file != NULL && file->type == ASSET_CONFIG;
 }
 
@@ -484,7 +496,7 @@ bool assetfs_is_config_file(const char* vpath)
  */
 bool assetfs_is_cache_file(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
     return file != NULL && file->type == ASSET_CACHE;
 }
 
@@ -494,7 +506,7 @@ bool assetfs_is_cache_file(const char* vpath)
  */
 bool assetfs_is_data_file(const char* vpath)
 {
-    assetfile_t* file = afs_findfile(root, vpath);
+    assetfile_t* file = afs_lookup(vpath);
     return file != NULL && file->type == ASSET_DATA;
 }
 
@@ -534,6 +546,24 @@ bool is_sane_vpath(const char* vpath)
     return true;
 }
 
+/* checks if a vpath is in the normalized form used by the lookup table,
+   i.e., no leading slash, no empty segments and no "." or ".." segments */
+bool is_canonical_vpath(const char* vpath)
+{
+    const char* segment = vpath;
+
+    for(const char* p = vpath; ; p++) {
+        if(*p == '/' || *p == '\\' || *p == '\0') {
+            int len = p - segment;
+            if(len == 0 || (segment[0] == '.' && (len == 1 || (len == 2 && segment[1] == '.'))))
+                return false;
+            if(*p == '\0')
+                return true;
+            segment = p + 1;
+        }
+    }
+}
+
 /* duplicates a string */
 char* clone_str(const char* str)
 {
@@ -563,6 +593,20 @@ char* join_path(const char* path, const char* basename)
         return clone_str(basename);
 }
 
+/* combines a virtual path to a basename using '/' as separator; you must free() this afterwards */
+char* join_vpath(const char* vpath, const char* basename)
+{
+    if(vpath && *vpath) {
+        char *s = mallocx((2 + strlen(vpath) + strlen(basename)) * sizeof(*s));
+        strcpy(s, vpath);
+        strcat(s, "/");
+        strcat(s, basename);
+        return s;
+    }
+    else
+        return clone_str(basename);
+}
+
 /* creates a directory at a certain location, returning it */
 assetdir_t* afs_mkdir(assetdir_t* parent, const char* dirname)
 {
@@ -570,6 +614,7 @@ assetdir_t* afs_mkdir(assetdir_t* parent, const char* dirname)
     assetdirentry_t self = { .name = clone_str("."), .contents = dir };
     assetdirentry_t back = { .name = clone_str(".."), .contents = parent ? parent : dir };
 
+    dir->vpath = parent ? join_vpath(parent->vpath, dirname) : clone_str("");
     darray_init(dir->file);
     darray_init(dir->dir);
     darray_push(dir->dir, self);
@@ -598,6 +643,7 @@ assetdir_t* afs_rmdir(assetdir_t* dir)
     }
     darray_release(dir->dir);
 
+    free(dir->vpath);
     free(dir);
     return NULL;
 }
@@ -634,6 +680,20 @@ assetdir_t* afs_finddir(assetdir_t* dir, const char* vpath)
 }
 
 
+/* finds a virtual file given its vpath relative to the root (returns NULL if not found) */
+assetfile_t* afs_lookup(const char* vpath)
+{
+    /* a single hash of the normalized vpath; no allocation */
+    assetfile_t* file = hashtable_assetfile_t_find(lookup_table, vpath);
+
+    /* paths such as "images/../sprites/foo.spr" aren't stored in the
+       lookup table; walk the directory tree in this uncommon case */
+    if(file == NULL && !is_canonical_vpath(vpath))
+        file = afs_findfile(root, vpath);
+
+    return file;
+}
+
 /* finds a virtual file in a virtual dir (returns NULL if not found) */
 assetfile_t* afs_findfile(assetdir_t* dir, const char* vpath)
 {
@@ -741,7 +801,10 @@ assetfile_t* afs_rmfile(assetfile_t* file)
 /* stores a virtual file in a virtual directory */
 void afs_storefile(assetdir_t* dir, assetfile_t* file)
 {
+    char* vpath = join_vpath(dir->vpath, file->name);
+    hashtable_assetfile_t_add(lookup_table, vpath, file);
     darray_push(dir->file, file);
+    free(vpath);
 }
 
 /* updates the fullpath of a virtual file */
@@ -775,6 +838,18 @@ int vpathcmp(const char* vp1, const char* vp2)
     return delta;
 }
 
+/* case-insensitive hash of a vpath; backslashes are treated as slashes */
+uint32_t vpathhash(const char* vpath)
+{
+    const unsigned char* p = (const unsigned char*)vpath;
+    uint32_t hash = 0;
+
+    while(*p)
+        hash = vpc(*(p++)) + (hash << 6) + (hash << 16) - hash;
+
+    return hash;
+}
+
 /* compares two vpaths up to n characters */
 int vpathncmp(const char* vp1, const char* vp2, int n)
 {
@@ -1202,10 +1277,13 @@ assetdir_t* afs_mkpath(assetdir_t* base, const char* vpath)
 
     if((p = strchr(path, '/')) != NULL) {
         *p = '\0';
-        dir = afs_mkpath(afs_mkdir(base, path), p+1);
+        dir = afs_finddir(base, path);
+        dir = afs_mkpath(dir ? dir : afs_mkdir(base, path), p+1);
+    }
+    else if(*path != '\0') { /* && NULL == strchr(path, '.'))*/
+        dir = afs_finddir(base, path);
+        dir = dir ? dir : afs_mkdir(base, path);
     }
-    else if(*path != '\0') /* && NULL == strchr(path, '.'))*/
-        dir = afs_mkdir(base, path);
     else
         dir = base;
 
@@ -1251,36 +1329,7 @@ const char* vpathbasename(const char* vpath, int* dirname_length)
 /* get the vpath of a given directory; you'll need to free() the returned string */
 char* dir2vpath(assetdir_t* dir)
 {
-    if(dir != root) {
-        assetdir_t* parent = afs_finddir(dir, "..");
-        if(parent != NULL) {
-            const char* dirname = "";
-            char* parent_path, *path;
-
-            /* find dirname */
-            for(int i = 0; i < darray_length(parent->dir); i++) {
-                if(parent->dir[i].contents == dir) {
-                    dirname = parent->dir[i].name;
-                    break;
-                }
-            }
-
-            /* build path */
-            parent_path = dir2vpath(parent);
-            if(*parent_path != '\0')
-                path = join_path(parent_path, dirname);
-            else
-                path = clone_str(dirname);
-            free(parent_path);
-
-            /* done */
-            return path;
-        }
-        else
-            return pathify(""); /* this shouldn't happen */
-    }
-    else
-        return pathify("");
+    return clone_str(dir->vpath);
 }
 
 /* The absolute filepath of a configuration file
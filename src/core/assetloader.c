@@ -0,0 +1,409 @@
+/*
+ * Open Surge Engine
+ * assetloader.c - asynchronous asset loader
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "assetloader.h"
+#include "assetfs.h"
+#include "stringutil.h"
+#include "logfile.h"
+#include "timer.h"
+#include "util.h"
+
+#if defined(A5BUILD)
+#include <allegro5/allegro.h>
+#endif
+
+/* a loading job */
+typedef enum assetjobstate_t assetjobstate_t;
+typedef struct assetjob_t assetjob_t;
+
+enum assetjobstate_t
+{
+    JOB_QUEUED,     /* waiting for a worker */
+    JOB_DECODING,   /* a worker is decoding it */
+    JOB_DECODED     /* waiting to be finalized on the main thread */
+};
+
+struct assetjob_t
+{
+    char* path; /* relative path */
+    char* fullpath; /* absolute path, resolved on the main thread */
+    void* (*decode)(const char*); /* runs on a worker thread (may be NULL) */
+    void (*finalize)(const char*,void*); /* runs on the main thread */
+    void* data; /* decoded data */
+    assetjobstate_t state;
+    bool low_priority; /* prefetching */
+    assetjob_t* next;
+};
+
+/* private data */
+#define WORKER_COUNT        2 /* number of worker threads */
+static const double FRAME_BUDGET = 0.008; /* how much time (in seconds) we spend finalizing assets on each frame */
+static assetjob_t* first_job = NULL; /* a FIFO of jobs */
+static assetjob_t* last_job = NULL;
+static int batch_size = 0; /* number of jobs enqueued since the loader was last idle (low priority jobs aren't counted) */
+static int batch_done = 0; /* number of finalized jobs of the current batch */
+static bool initialized = false;
+static void enqueue_job(const char* path, void* (*decode)(const char*), void (*finalize)(const char*,void*), bool low_priority);
+static assetjob_t* find_job(const char* path);
+static assetjob_t* find_queued_job();
+static assetjob_t* detach_job(assetjobstate_t state, bool low_priority);
+static assetjob_t* destroy_job(assetjob_t* job);
+static void run_job(assetjob_t* job);
+static inline double elapsed_time();
+
+#if defined(A5BUILD)
+static ALLEGRO_THREAD* worker[WORKER_COUNT] = { NULL };
+static ALLEGRO_MUTEX* mutex = NULL;
+static ALLEGRO_COND* cond = NULL;
+static void* worker_thread(ALLEGRO_THREAD* thread, void* arg);
+#define LOCK()              al_lock_mutex(mutex)
+#define UNLOCK()            al_unlock_mutex(mutex)
+#else
+#define LOCK()              ((void)0) /* no worker threads */
+#define UNLOCK()            ((void)0)
+#endif
+
+
+
+/* public API */
+
+/*
+ * assetloader_init()
+ * Initializes the asset loader and spawns the worker threads
+ */
+void assetloader_init()
+{
+    if(initialized)
+        return;
+
+    logfile_message("assetloader_init()");
+    first_job = last_job = NULL;
+    batch_size = batch_done = 0;
+
+#if defined(A5BUILD)
+    mutex = al_create_mutex();
+    cond = al_create_cond();
+    if(mutex == NULL || cond == NULL)
+        fatal_error("assetloader_init(): can't create synchronization primitives");
+
+    for(int i = 0; i < WORKER_COUNT; i++) {
+        if(NULL == (worker[i] = al_create_thread(worker_thread, NULL)))
+            fatal_error("assetloader_init(): can't create worker thread");
+        al_start_thread(worker[i]);
+    }
+#endif
+
+    initialized = true;
+}
+
+/*
+ * assetloader_release()
+ * Stops the worker threads and finalizes any decoded assets
+ */
+void assetloader_release()
+{
+    if(!initialized)
+        return;
+
+    logfile_message("assetloader_release()");
+
+#if defined(A5BUILD)
+    /* stop the workers */
+    LOCK();
+    for(int i = 0; i < WORKER_COUNT; i++)
+        al_set_thread_should_stop(worker[i]);
+    al_broadcast_cond(cond);
+    UNLOCK();
+
+    for(int i = 0; i < WORKER_COUNT; i++) {
+        al_join_thread(worker[i], NULL);
+        al_destroy_thread(worker[i]);
+        worker[i] = NULL;
+    }
+#endif
+
+    /* the jobs that were decoded must be finalized, so that
+       their data is released along with the resource manager */
+    while(first_job != NULL) {
+        assetjob_t* job = detach_job(first_job->state, first_job->low_priority);
+        if(job->state == JOB_DECODED)
+            job->finalize(job->path, job->data);
+        destroy_job(job);
+    }
+    batch_size = batch_done = 0;
+
+#if defined(A5BUILD)
+    al_destroy_cond(cond);
+    al_destroy_mutex(mutex);
+    cond = NULL;
+    mutex = NULL;
+#endif
+
+    initialized = false;
+}
+
+/*
+ * assetloader_update()
+ * Finalizes the decoded assets. This runs on the main
+ * thread and spends a limited amount of time on each frame
+ */
+void assetloader_update()
+{
+#if defined(A5BUILD)
+    const assetjobstate_t ready = JOB_DECODED;
+#else
+    const assetjobstate_t ready = JOB_QUEUED; /* no workers */
+#endif
+    double start_time = elapsed_time();
+    int count = 0;
+    assetjob_t* job;
+
+    if(!initialized)
+        return;
+
+    /* regular jobs */
+    do {
+        LOCK();
+        job = detach_job(ready, false);
+        UNLOCK();
+
+        if(job == NULL)
+            break;
+
+        run_job(job);
+        batch_done++;
+        count++;
+    } while(elapsed_time() - start_time < FRAME_BUDGET);
+
+    /* low priority jobs: at most one per frame,
+       and only if there is nothing else to do */
+    if(count == 0) {
+        LOCK();
+        job = detach_job(ready, true);
+        UNLOCK();
+
+        if(job != NULL)
+            run_job(job);
+    }
+
+    /* the loader is idle */
+    if(batch_done >= batch_size)
+        batch_size = batch_done = 0;
+}
+
+/*
+ * assetloader_enqueue()
+ * Schedules an asset to be loaded asynchronously
+ * path is the relative path of the asset
+ */
+void assetloader_enqueue(const char* path, void* (*decode)(const char*), void (*finalize)(const char*,void*))
+{
+    if(!initialized) {
+        /* load it right away */
+        finalize(path, decode != NULL ? decode(assetfs_fullpath(path)) : NULL);
+        return;
+    }
+
+    enqueue_job(path, decode, finalize, false);
+}
+
+/*
+ * assetloader_prefetch()
+ * Schedules an asset to be loaded with low priority. It will only be
+ * finalized when there is nothing else to do, one asset per frame.
+ * Prefetching doesn't make the loader busy
+ */
+void assetloader_prefetch(const char* path, void* (*decode)(const char*), void (*finalize)(const char*,void*))
+{
+    if(initialized)
+        enqueue_job(path, decode, finalize, true);
+}
+
+/*
+ * assetloader_is_busy()
+ * Are there assets being loaded?
+ */
+bool assetloader_is_busy()
+{
+    return batch_size > 0;
+}
+
+/*
+ * assetloader_progress()
+ * The progress of the current batch of assets, in [0,1]
+ */
+float assetloader_progress()
+{
+    return batch_size > 0 ? (float)batch_done / (float)batch_size : 1.0f;
+}
+
+
+
+/* private */
+
+/* adds a job to the queue */
+void enqueue_job(const char* path, void* (*decode)(const char*), void (*finalize)(const char*,void*), bool low_priority)
+{
+    assetjob_t* job;
+
+    LOCK();
+    if(NULL == (job = find_job(path))) {
+        job = mallocx(sizeof *job);
+        job->path = str_dup(path);
+        job->fullpath = str_dup(assetfs_fullpath(path)); /* assetfs isn't thread-safe */
+        job->decode = decode;
+        job->finalize = finalize;
+        job->data = NULL;
+        job->state = JOB_QUEUED;
+        job->low_priority = low_priority;
+        job->next = NULL;
+
+        if(last_job != NULL)
+            last_job->next = job;
+        else
+            first_job = job;
+        last_job = job;
+
+        if(!low_priority)
+            batch_size++;
+#if defined(A5BUILD)
+        al_signal_cond(cond);
+#endif
+    }
+    else if(job->low_priority && !low_priority) {
+        /* someone needs a prefetched asset right now; the caller's
+           callbacks take over (a worker may be decoding it already) */
+        if(job->state == JOB_QUEUED)
+            job->decode = decode;
+        job->finalize = finalize;
+        job->low_priority = false;
+        batch_size++;
+    }
+    UNLOCK();
+}
+
+/* decodes (if necessary) and finalizes a job on the main thread */
+void run_job(assetjob_t* job)
+{
+    /* no workers? decode it here */
+    if(job->state == JOB_QUEUED && job->decode != NULL)
+        job->data = job->decode(job->fullpath);
+
+    /* upload & store the asset */
+    job->finalize(job->path, job->data);
+    destroy_job(job);
+}
+
+/* finds a job given its path; call it with the mutex locked */
+assetjob_t* find_job(const char* path)
+{
+    for(assetjob_t* job = first_job; job != NULL; job = job->next) {
+        if(str_icmp(job->path, path) == 0)
+            return job;
+    }
+
+    return NULL;
+}
+
+/* finds the next job to be decoded, giving preference to the regular ones; call it with the mutex locked */
+assetjob_t* find_queued_job()
+{
+    assetjob_t* low_priority_job = NULL;
+
+    for(assetjob_t* job = first_job; job != NULL; job = job->next) {
+        if(job->state == JOB_QUEUED) {
+            if(!job->low_priority)
+                return job;
+            else if(low_priority_job == NULL)
+                low_priority_job = job;
+        }
+    }
+
+    return low_priority_job;
+}
+
+/* removes the first job with the given state and priority from the queue; call it with the mutex locked */
+assetjob_t* detach_job(assetjobstate_t state, bool low_priority)
+{
+    assetjob_t* prev = NULL;
+
+    for(assetjob_t* job = first_job; job != NULL; prev = job, job = job->next) {
+        if(job->state == state && job->low_priority == low_priority) {
+            if(prev != NULL)
+                prev->next = job->next;
+            else
+                first_job = job->next;
+            if(last_job == job)
+                last_job = prev;
+            job->next = NULL;
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+/* destroys a job */
+assetjob_t* destroy_job(assetjob_t* job)
+{
+    free(job->fullpath);
+    free(job->path);
+    free(job);
+    return NULL;
+}
+
+/* elapsed time, in seconds */
+double elapsed_time()
+{
+#if defined(A5BUILD)
+    return al_get_time();
+#else
+    return 0.001 * timer_get_ticks();
+#endif
+}
+
+#if defined(A5BUILD)
+/* worker thread: decodes the queued assets */
+void* worker_thread(ALLEGRO_THREAD* thread, void* arg)
+{
+    LOCK();
+    while(!al_get_thread_should_stop(thread)) {
+        /* find a queued job */
+        assetjob_t* job = find_queued_job();
+        if(job == NULL) {
+            al_wait_cond(cond, mutex);
+            continue;
+        }
+
+        /* decode it without holding the lock */
+        job->state = JOB_DECODING;
+        UNLOCK();
+        void* data = job->decode != NULL ? job->decode(job->fullpath) : NULL;
+        LOCK();
+        job->data = data;
+        job->state = JOB_DECODED;
+    }
+    UNLOCK();
+
+    return NULL;
+}
+#endif
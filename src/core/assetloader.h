@@ -0,0 +1,52 @@
+/*
+ * Open Surge Engine
+ * assetloader.h - asynchronous asset loader
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ASSETLOADER_H
+#define _ASSETLOADER_H
+
+#include <stdbool.h>
+
+/*
+ * Asynchronous asset loader
+ *
+ * decode(fullpath) runs on a worker thread and must not touch the video card
+ * or the resource manager. It returns the decoded data (or NULL on error).
+ *
+ * finalize(path, data) runs on the main thread, during assetloader_update().
+ * It uploads the decoded data and stores it in the resource manager.
+ *
+ * decode may be NULL: in this case, finalize(path, NULL) does all the work on
+ * the main thread (the work is still spread across frames). This is also what
+ * happens on builds without threads (legacy Allegro 4).
+ *
+ * Prefetched assets have low priority: they are finalized one per frame,
+ * when there's nothing else to do, and don't make the loader busy. If a
+ * prefetched asset is enqueued again, it becomes a regular job.
+ */
+void assetloader_init();
+void assetloader_release();
+void assetloader_update(); /* call once per frame on the main thread */
+
+void assetloader_enqueue(const char* path, void* (*decode)(const char*), void (*finalize)(const char*,void*)); /* duplicate paths are ignored */
+void assetloader_prefetch(const char* path, void* (*decode)(const char*), void (*finalize)(const char*,void*)); /* low priority */
+bool assetloader_is_busy(); /* are there assets being loaded? */
+float assetloader_progress(); /* progress of the current batch of assets, in [0,1] */
+
+#endif
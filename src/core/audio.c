@@ -18,11 +18,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
 #include "audio.h"
 #include "assetfs.h"
 #include "stringutil.h"
 #include "resourcemanager.h"
+#include "assetloader.h"
 #include "logfile.h"
 #include "timer.h"
 #include "util.h"
@@ -34,27 +39,87 @@
 #include <allegro5/allegro_audio.h>
 #include <allegro5/allegro_acodec.h>
 
+/* track structure: a sample being played by the offline mixer */
+typedef struct track_t {
+    ALLEGRO_SAMPLE* sample; /* NULL if the track is stopped */
+    double position; /* in sample frames */
+    float gain; /* 0: silence; 1: default */
+    float pan; /* -1: left; 0: center; 1: right */
+    float speed; /* 1: default */
+    bool loop;
+    bool paused;
+} track_t;
+
 /* music structure */
 struct music_t {
-    ALLEGRO_AUDIO_STREAM* stream;
+    ALLEGRO_AUDIO_STREAM* stream; /* NULL in offline mode */
+    ALLEGRO_SAMPLE* data; /* the decoded music (offline mode only) */
+    track_t track; /* offline mode only */
     bool is_paused;
     char* filepath; /* relative path */
 };
 
 /* sound structure */
 struct sound_t {
-    ALLEGRO_SAMPLE* sample;
-    ALLEGRO_SAMPLE_ID id;
-    bool valid_id;
-    float duration;
-    float end_time;
+    ALLEGRO_SAMPLE* sample; /* NULL while it's being decoded */
     float volume; /* 0: silence; 1: default */
+    int priority; /* see sound_set_priority() */
     char* filepath; /* relative path */
+
+    /* played before it was decoded? */
+    bool pending_play;
+    float pending_pan, pending_freq;
+    float pending_deadline; /* if it's decoded after this time, the play request is dropped */
 };
 
+/* voice structure: a sample instance attached to the default mixer */
+typedef struct voice_t {
+    ALLEGRO_SAMPLE_INSTANCE* instance; /* NULL in offline mode */
+    track_t track; /* used instead of the instance in offline mode */
+    sound_t* sound; /* the sound being played, if any */
+    float volume; /* volume of the sound */
+    float loudness; /* how loud it's heard: distant sounds are quieter and panned */
+    int priority; /* priority of the sound */
+    uint32_t frame; /* frame in which the sound was played */
+    uint32_t age; /* a sequence number: higher values are more recent */
+} voice_t;
+
 /* private stuff */
-static const int PREFERRED_NUMBER_OF_SAMPLES = 16; /* how many samples can be played at the same time */
+#define PREFERRED_NUMBER_OF_SAMPLES 16 /* how many samples can be played at the same time */
+static const int MAX_INSTANCES_PER_SAMPLE = 4; /* how many instances of the same sample can be played at the same time */
+static const float MAX_PLAY_DELAY = 0.1f; /* a sample that isn't decoded within this many seconds of being played is silent */
 static music_t *current_music = NULL; /* music being played at the moment (NULL if none) */
+static voice_t voice[PREFERRED_NUMBER_OF_SAMPLES]; /* voice manager */
+static int voice_count = 0;
+static uint32_t voice_age = 0;
+static uint32_t audio_frame = 0; /* incremented on audio_update() */
+static audio_voicestats_t voice_stats = { 0 };
+static sound_t* create_sound(const char* path, ALLEGRO_SAMPLE* sample);
+static void attach_sample(sound_t* s, ALLEGRO_SAMPLE* sample);
+static voice_t* find_voice(const sound_t* s, float loudness);
+static inline bool is_voice_playing(const voice_t* v);
+static bool start_voice(voice_t* v, ALLEGRO_SAMPLE* sample, float gain, float pan, float speed);
+static void stop_voice(voice_t* v);
+static void set_voice_gain(voice_t* v, float gain);
+static void set_voice_pan(voice_t* v, float pan);
+
+/* offline mixer: instead of playing the audio on a device, the active sounds
+   and the music are mixed into memory at the game's timestep */
+#define OFFLINE_FREQUENCY 44100 /* output sampling rate, in Hz (stereo) */
+static bool offline = false; /* is the offline mixer enabled? */
+static float* offline_buffer = NULL; /* the mix of the last frame: interleaved stereo samples */
+static int offline_buffer_capacity = 0; /* in frames */
+static double offline_pending_frames = 0.0; /* fractional frames carried over to the next mix */
+static uint64_t offline_mixed_frames = 0; /* total number of frames mixed so far */
+static FILE* offline_wav = NULL; /* optional output file */
+static void mix_offline(float seconds);
+static void mix_track(track_t* t, float* out, int frames);
+static void stop_track(track_t* t);
+static inline float read_sample(const void* data, ALLEGRO_AUDIO_DEPTH depth, unsigned index);
+static void write_wav_header(FILE* fp, uint32_t frames);
+static void write_wav_data(FILE* fp, const float* samples, int frames);
+static void* decode_sample(const char* fullpath); /* asynchronous loading */
+static void store_sample(const char* path, void* sample);
 
 #elif !defined(__USE_OPENAL__)
 
@@ -137,6 +202,8 @@ static void eom_callback(void *userdata, ALuint source);
 
 #endif
 
+static void (*load_function)(const char*) = NULL; /* called whenever sound_load() is called */
+
 
 /*
  * music_load()
@@ -152,19 +219,34 @@ music_t *music_load(const char *path)
 
     if(NULL == (m = resourcemanager_find_music(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("Loading music \"%s\"...", fullpath);
+        logfile_debug("Loading music \"%s\"...", fullpath);
 
         /* build the music object */
         m = mallocx(sizeof *m);
         m->is_paused = false;
         m->filepath = str_dup(path);
-        if(NULL == (m->stream = al_load_audio_stream(fullpath, 4, 1024)))
-            fatal_error("Can't load music \"%s\"", path);
-        
-        /* configure the audio stream */
-        al_attach_audio_stream_to_mixer(m->stream, al_get_default_mixer());
-        al_set_audio_stream_playmode(m->stream, ALLEGRO_PLAYMODE_LOOP);
-        al_set_audio_stream_playing(m->stream, false);
+        m->stream = NULL;
+        m->data = NULL;
+        m->track.gain = 1.0f;
+        m->track.pan = 0.0f;
+        m->track.speed = 1.0f;
+        m->track.loop = false;
+        stop_track(&m->track);
+
+        /* the offline mixer can't read from audio streams, so it decodes the entire music */
+        if(offline) {
+            if(NULL == (m->data = al_load_sample(fullpath)))
+                fatal_error("Can't load music \"%s\"", path);
+        }
+        else {
+            if(NULL == (m->stream = al_load_audio_stream(fullpath, 4, 1024)))
+                fatal_error("Can't load music \"%s\"", path);
+
+            /* configure the audio stream */
+            al_attach_audio_stream_to_mixer(m->stream, al_get_default_mixer());
+            al_set_audio_stream_playmode(m->stream, ALLEGRO_PLAYMODE_LOOP);
+            al_set_audio_stream_playing(m->stream, false);
+        }
 
         /* adding it to the resource manager */
         resourcemanager_add_music(path, m);
@@ -185,7 +267,7 @@ music_t *music_load(const char *path)
 
     if(NULL == (m = resourcemanager_find_music(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("music_load('%s')", fullpath);
+        logfile_debug("music_load('%s')", fullpath);
 
         /* build the music object */
         m = mallocx(sizeof *m);
@@ -196,7 +278,7 @@ music_t *music_load(const char *path)
         /* load the ogg stream */
         m->stream = logg_get_stream(fullpath, 255, 128, 0);
         if(m->stream == NULL) {
-            logfile_message("music_load() error: can't get ogg stream");
+            logfile_error("music_load() error: can't get ogg stream");
             free(m->filepath);
             free(m);
             return NULL;
@@ -207,7 +289,7 @@ music_t *music_load(const char *path)
         resourcemanager_ref_music(path);
 
         /* done! */
-        logfile_message("music_load() ok");
+        logfile_debug("music_load() ok");
     }
     else
         resourcemanager_ref_music(path);
@@ -224,7 +306,7 @@ music_t *music_load(const char *path)
 
     if(NULL == (m = resourcemanager_find_music(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("music_load('%s')", fullpath);
+        logfile_debug("music_load('%s')", fullpath);
 
         /* build the music object */
         m = mallocx(sizeof *m);
@@ -236,11 +318,11 @@ music_t *music_load(const char *path)
         if(!(IS_VALID_FORMAT(path) && (m->stream = alureCreateStreamFromFile(fullpath, 250000, 0, NULL)))) {
 
             if(!IS_VALID_FORMAT(path)) {
-                logfile_message("music_load() invalid file format");
+                logfile_error("music_load() invalid file format");
                 alureDestroyStream(m->stream, 0, NULL);
             }
             else
-                logfile_message("music_load() error: %s", alureGetErrorString());
+                logfile_error("music_load() error: %s", alureGetErrorString());
 
             free(m->filepath);
             free(m);
@@ -252,7 +334,7 @@ music_t *music_load(const char *path)
         resourcemanager_ref_music(path);
 
         /* done! */
-        logfile_message("music_load() ok");
+        logfile_debug("music_load() ok");
     }
     else
         resourcemanager_ref_music(path);
@@ -316,7 +398,10 @@ void music_destroy(music_t *music)
             current_music = NULL;
         }
 
-        al_destroy_audio_stream(music->stream);
+        if(music->stream != NULL)
+            al_destroy_audio_stream(music->stream);
+        if(music->data != NULL)
+            al_destroy_sample(music->data);
         free(music->filepath);
         free(music);
     }
@@ -359,9 +444,15 @@ void music_play(music_t *music, bool loop)
     music_stop();
 
     if(music != NULL) {
-        ALLEGRO_PLAYMODE mode = loop ? ALLEGRO_PLAYMODE_LOOP : ALLEGRO_PLAYMODE_ONCE;
-        al_set_audio_stream_playmode(music->stream, mode);
-        al_set_audio_stream_playing(music->stream, true);
+        if(music->stream != NULL) {
+            ALLEGRO_PLAYMODE mode = loop ? ALLEGRO_PLAYMODE_LOOP : ALLEGRO_PLAYMODE_ONCE;
+            al_set_audio_stream_playmode(music->stream, mode);
+            al_set_audio_stream_playing(music->stream, true);
+        }
+        else {
+            music->track.sample = music->data;
+            music->track.loop = loop;
+        }
         music->is_paused = false;
     }
 
@@ -424,8 +515,12 @@ void eom_callback(void *userdata, ALuint source)
 void music_stop()
 {
     if(current_music != NULL) {
-        al_set_audio_stream_playing(current_music->stream, false);
-        al_rewind_audio_stream(current_music->stream);
+        if(current_music->stream != NULL) {
+            al_set_audio_stream_playing(current_music->stream, false);
+            al_rewind_audio_stream(current_music->stream);
+        }
+        else
+            stop_track(&current_music->track);
         current_music->is_paused = false; /* it's stopped, not paused */
     }
 
@@ -462,7 +557,9 @@ void music_stop()
 void music_pause()
 {
     if(current_music != NULL && !(current_music->is_paused)) {
-        al_set_audio_stream_playing(current_music->stream, false);
+        if(current_music->stream != NULL)
+            al_set_audio_stream_playing(current_music->stream, false);
+        current_music->track.paused = true;
         current_music->is_paused = true;
     }
 }
@@ -494,7 +591,9 @@ void music_pause()
 void music_resume()
 {
     if(current_music != NULL && current_music->is_paused) {
-        al_set_audio_stream_playing(current_music->stream, true);
+        if(current_music->stream != NULL)
+            al_set_audio_stream_playing(current_music->stream, true);
+        current_music->track.paused = false;
         current_music->is_paused = false;
     }
 }
@@ -527,7 +626,9 @@ void music_set_volume(float volume)
 {
     if(current_music != NULL) {
         float gain = max(volume, 0.0f);
-        al_set_audio_stream_gain(current_music->stream, gain);
+        if(current_music->stream != NULL)
+            al_set_audio_stream_gain(current_music->stream, gain);
+        current_music->track.gain = gain;
     }
 }
 #elif !defined(__USE_OPENAL__)
@@ -557,8 +658,10 @@ void music_set_volume(float volume)
 #if defined(A5BUILD)
 float music_get_volume()
 {
-    if(current_music != NULL)
+    if(current_music != NULL && current_music->stream != NULL)
         return al_get_audio_stream_gain(current_music->stream);
+    else if(current_music != NULL)
+        return current_music->track.gain;
     else
         return 0.0f;
 }
@@ -592,7 +695,12 @@ float music_get_volume()
 #if defined(A5BUILD)
 bool music_is_playing()
 {
-    return (current_music != NULL) && al_get_audio_stream_playing(current_music->stream);
+    if(current_music == NULL)
+        return false;
+    else if(current_music->stream != NULL)
+        return al_get_audio_stream_playing(current_music->stream);
+    else
+        return current_music->track.sample != NULL && !(current_music->track.paused);
 }
 #elif !defined(__USE_OPENAL__)
 bool music_is_playing()
@@ -616,7 +724,10 @@ float music_duration()
 {
     if(current_music != NULL) {
         /* this may be zero if the length is unknown */
-        return al_get_audio_stream_length_secs(current_music->stream);
+        if(current_music->stream != NULL)
+            return al_get_audio_stream_length_secs(current_music->stream);
+        else
+            return al_get_sample_length(current_music->data) / (float)al_get_sample_frequency(current_music->data);
     }
 
     return 0.0f;
@@ -687,6 +798,46 @@ bool music_is_paused()
 #endif
 
 
+/*
+ * music_size()
+ * The approximate amount of memory used by a music, in bytes.
+ * Musics are streamed, so only their buffers are accounted for
+ * (except in offline mode, in which they are fully decoded)
+ */
+#if defined(A5BUILD)
+size_t music_size(const music_t *music)
+{
+    if(music != NULL && music->data != NULL) {
+        ALLEGRO_SAMPLE* s = music->data;
+        return sizeof(*music) + (size_t)al_get_sample_length(s) *
+            al_get_channel_count(al_get_sample_channels(s)) *
+            al_get_audio_depth_size(al_get_sample_depth(s));
+    }
+    else if(music != NULL) {
+        ALLEGRO_AUDIO_STREAM* s = music->stream;
+        return sizeof(*music) + (size_t)al_get_audio_stream_fragments(s) *
+            al_get_audio_stream_length(s) *
+            al_get_channel_count(al_get_audio_stream_channels(s)) *
+            al_get_audio_depth_size(al_get_audio_stream_depth(s));
+    }
+    else
+        return 0;
+}
+#elif !defined(__USE_OPENAL__)
+size_t music_size(const music_t *music)
+{
+    /* an estimate: LOGG keeps a couple of decoding buffers */
+    return (music != NULL) ? sizeof(*music) + 2 * 65536 : 0;
+}
+#else
+size_t music_size(const music_t *music)
+{
+    /* we use streams with NUM_BUFS chunks of 250000 bytes */
+    return (music != NULL) ? sizeof(*music) + NUM_BUFS * 250000 : 0;
+}
+#endif
+
+
 /* sound management */
 
 
@@ -699,30 +850,24 @@ sound_t *sound_load(const char *path)
 {
     sound_t *s;
 
-    if(NULL == (s = resourcemanager_find_sample(path))) {
-        ALLEGRO_SAMPLE_INSTANCE* spl;
-        const char* fullpath = assetfs_fullpath(path);
-        logfile_message("Loading sound \"%s\"...", fullpath);
+    if(load_function != NULL)
+        load_function(path);
 
-        /* build the sound object */
-        s = mallocx(sizeof *s);
-        s->duration = 0.0f;
-        s->end_time = 0.0f;
-        s->valid_id = false;
-        s->volume = 1.0f;
-        s->filepath = str_dup(path);
-        if(NULL == (s->sample = al_load_sample(fullpath)))
+    if(NULL == (s = resourcemanager_find_sample(path))) {
+        logfile_debug("Loading sound \"%s\"...", assetfs_fullpath(path));
+        if(!assetfs_exists(path))
             fatal_error("Can't load sound \"%s\"", path);
 
-        /* compute its duration */
-        if(NULL != (spl = al_create_sample_instance(s->sample))) {
-            s->duration = al_get_sample_instance_time(spl);
-            al_destroy_sample_instance(spl);
-        }
+        /* build the sound object */
+        s = create_sound(path, NULL);
 
         /* adding it to the resource manager */
         resourcemanager_add_sample(path, s);
         resourcemanager_ref_sample(path);
+
+        /* the sample will be decoded on a worker thread
+           and attached to the sound object later on */
+        assetloader_enqueue(path, decode_sample, store_sample);
     }
     else
         resourcemanager_ref_sample(path);
@@ -734,9 +879,12 @@ sound_t *sound_load(const char *path)
 {
     sound_t *s;
 
+    if(load_function != NULL)
+        load_function(path);
+
     if(NULL == (s = resourcemanager_find_sample(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("sound_load('%s')", fullpath);
+        logfile_debug("sound_load('%s')", fullpath);
 
         /* build the sound object */
         s = mallocx(sizeof *s);
@@ -746,7 +894,7 @@ sound_t *sound_load(const char *path)
 
         /* loading the sample */
         if(NULL == (s->data = IS_OGG(path) ? logg_load(fullpath) : load_sample(fullpath))) {
-            logfile_message("sound_load() error: %s", allegro_error);
+            logfile_error("sound_load() error: %s", allegro_error);
             free(s->filepath);
             free(s);
             return NULL;
@@ -757,7 +905,7 @@ sound_t *sound_load(const char *path)
         resourcemanager_ref_sample(path);
 
         /* done! */
-        logfile_message("sound_load() ok");
+        logfile_debug("sound_load() ok");
     }
     else
         resourcemanager_ref_sample(path);
@@ -772,9 +920,12 @@ sound_t *sound_load(const char *path)
     if(quiet)
         return NULL;
 
+    if(load_function != NULL)
+        load_function(path);
+
     if(NULL == (s = resourcemanager_find_sample(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("sound_load('%s')", fullpath);
+        logfile_debug("sound_load('%s')", fullpath);
 
         /* build the sound object */
         s = mallocx(sizeof *s);
@@ -786,11 +937,11 @@ sound_t *sound_load(const char *path)
         if(!(IS_VALID_FORMAT(path) && (s->buf = alureCreateBufferFromFile(fullpath)))) {
             
             if(!IS_VALID_FORMAT(path)) {
-                logfile_message("sound_load() error: invalid file format");
+                logfile_error("sound_load() error: invalid file format");
                 alDeleteBuffers(1, &(s->buf));
             }
             else
-                logfile_message("sound_load() error: %s", alureGetErrorString());
+                logfile_error("sound_load() error: %s", alureGetErrorString());
 
             free(s->filepath);
             free(s);
@@ -801,7 +952,7 @@ sound_t *sound_load(const char *path)
         sbuf[sbuf_count] = s->buf;
         if(++sbuf_count >= sbuf_capacity) {
             sbuf_capacity *= 2;
-            logfile_message("Expanding the array of audio buffers to hold %d elements", sbuf_capacity);
+            logfile_debug("Expanding the array of audio buffers to hold %d elements", sbuf_capacity);
             sbuf = reallocx(sbuf, sbuf_capacity * sizeof(*sbuf));
         }
 
@@ -810,7 +961,7 @@ sound_t *sound_load(const char *path)
         resourcemanager_ref_sample(path);
 
         /* done! */
-        logfile_message("sound_load() ok");
+        logfile_debug("sound_load() ok");
     }
     else
         resourcemanager_ref_sample(path);
@@ -819,6 +970,48 @@ sound_t *sound_load(const char *path)
 }
 #endif
 
+/*
+ * sound_preload()
+ * Loads a sample asynchronously: it will be decoded on a worker
+ * thread and stored in the resource manager (see assetloader.h),
+ * so that a subsequent sound_load() will find it there
+ */
+#if defined(A5BUILD)
+void sound_preload(const char *path)
+{
+    if(resourcemanager_peek_sample(path) == NULL)
+        assetloader_enqueue(path, decode_sample, store_sample);
+}
+#else
+static void preload_sample(const char* path, void* unused)
+{
+    sound_t* s;
+
+    /* no worker threads: load it on the main thread */
+    if(resourcemanager_peek_sample(path) == NULL) {
+        if(NULL != (s = sound_load(path)))
+            sound_unref(s);
+    }
+}
+
+void sound_preload(const char *path)
+{
+    if(resourcemanager_peek_sample(path) == NULL)
+        assetloader_enqueue(path, NULL, preload_sample);
+}
+#endif
+
+/*
+ * sound_set_load_function()
+ * fun(path) will be called whenever sound_load() is called.
+ * This is used to find out which sounds are used by a level.
+ * Pass NULL to disable it
+ */
+void sound_set_load_function(void (*fun)(const char*))
+{
+    load_function = fun;
+}
+
 /*
  * sound_unref()
  * Will try to release the resource from
@@ -861,7 +1054,8 @@ void sound_destroy(sound_t *sample)
 {
     if(sample != NULL) {
         sound_stop(sample);
-        al_destroy_sample(sample->sample);
+        if(sample->sample != NULL)
+            al_destroy_sample(sample->sample);
         free(sample->filepath);
         free(sample);
     }
@@ -928,16 +1122,48 @@ void sound_play_ex(sound_t *sample, float vol, float pan, float freq)
         pan = clip(pan, -1.0f, 1.0f);
         freq = max(freq, 0.0f);
 
-        /* play the sample */
-        if(al_play_sample(sample->sample, vol, pan, freq, ALLEGRO_PLAYMODE_ONCE, &sample->id)) {
-            sample->end_time = (0.001f * timer_get_ticks()) + sample->duration; /* when does it end? */
-            sample->valid_id = true;
+        /* the sample hasn't been decoded yet: play it when it's ready */
+        if(sample->sample == NULL) {
+            sample->pending_play = true;
+            sample->pending_pan = pan;
+            sample->pending_freq = freq;
+            sample->pending_deadline = (0.001f * timer_get_ticks()) + MAX_PLAY_DELAY;
             sample->volume = vol;
+            return;
         }
-        else {
-            sample->end_time = 0.0f;
-            sample->valid_id = false;
-            sample->volume = vol;
+
+        /* find a voice */
+        voice_t* v;
+        float loudness = vol * (1.0f - 0.5f * fabsf(pan));
+        sample->volume = vol;
+        voice_stats.plays++;
+        if(NULL == (v = find_voice(sample, loudness)))
+            return;
+
+        /* merge identical samples played within the same frame */
+        if(v->sound == sample && v->frame == audio_frame && is_voice_playing(v)) {
+            if(vol > v->volume) {
+                set_voice_gain(v, vol);
+                set_voice_pan(v, pan);
+                v->volume = vol;
+                v->loudness = loudness;
+            }
+            voice_stats.merged++;
+            return;
+        }
+
+        /* play the sample */
+        if(v->sound != NULL && is_voice_playing(v))
+            voice_stats.stolen++;
+        v->sound = NULL;
+        if(start_voice(v, sample->sample, vol, pan, freq)) {
+            v->sound = sample;
+            v->volume = vol;
+            v->loudness = loudness;
+            v->priority = sample->priority;
+            v->frame = audio_frame;
+            v->age = ++voice_age;
+            voice_stats.peak_voices = max(voice_stats.peak_voices, audio_voice_stats()->active_voices);
         }
     }
 }
@@ -1012,10 +1238,11 @@ void eos_callback(void *userdata, ALuint source)
 void sound_stop(sound_t *sample)
 {
     if(sample != NULL) {
-        if(sample->valid_id) {
-            al_stop_sample(&sample->id);
-            sample->valid_id = false;
-            sample->end_time = 0.0f;
+        sample->pending_play = false;
+        for(int i = 0; i < voice_count; i++) {
+            if(voice[i].sound == sample) {
+                stop_voice(&voice[i]);
+            }
         }
     }
 }
@@ -1043,28 +1270,15 @@ void sound_stop(sound_t *sample)
 #if defined(A5BUILD)
 bool sound_is_playing(sound_t *sample)
 {
-    if(sample != NULL)
-        return (0.001f * timer_get_ticks()) < sample->end_time;
-    else
-        return false;
-
-#if 0
-    /* Unstable API (Allegro 5.2.3) */
     if(sample != NULL) {
-        if(sample->valid_id) {
-            ALLEGRO_SAMPLE_INSTANCE* instance = al_lock_sample_id(&sample->id);
-            if(instance != NULL) {
-                bool is_playing = al_get_sample_instance_playing(instance);
-                al_unlock_sample_id(&sample->id);
-                return is_playing;
-            }
-            else
-                return false;
+        for(int i = 0; i < voice_count; i++) {
+            if(voice[i].sound == sample && is_voice_playing(&voice[i]))
+                return true;
         }
+        return sample->pending_play && (0.001f * timer_get_ticks()) < sample->pending_deadline;
     }
-
-    return false;
-#endif
+    else
+        return false;
 }
 #elif !defined(__USE_OPENAL__)
 bool sound_is_playing(sound_t *sample)
@@ -1121,15 +1335,13 @@ float sound_get_volume(sound_t *sample)
 #if defined(A5BUILD)
 void sound_set_volume(sound_t *sample, float volume)
 {
-    /* Unstable API (since Allegro 5.2.3) */
     if(sample != NULL) {
         sample->volume = max(0.0f, volume);
-        if(sample->valid_id) {
-            ALLEGRO_SAMPLE_INSTANCE* instance = al_lock_sample_id(&sample->id);
-            if(instance != NULL) {
-                if(al_get_sample_instance_playing(instance))
-                    al_set_sample_instance_gain(instance, sample->volume);
-                al_unlock_sample_id(&sample->id);
+        for(int i = 0; i < voice_count; i++) {
+            if(voice[i].sound == sample && is_voice_playing(&voice[i])) {
+                set_voice_gain(&voice[i], sample->volume);
+                voice[i].loudness *= (voice[i].volume > 0.0f) ? sample->volume / voice[i].volume : 0.0f;
+                voice[i].volume = sample->volume;
             }
         }
     }
@@ -1151,6 +1363,65 @@ void sound_set_volume(sound_t *sample, float volume)
 #endif
 
 
+/*
+ * sound_size()
+ * The approximate amount of memory used by a sample, in bytes
+ */
+#if defined(A5BUILD)
+size_t sound_size(const sound_t *sample)
+{
+    if(sample != NULL && sample->sample != NULL) {
+        ALLEGRO_SAMPLE* s = sample->sample;
+        return sizeof(*sample) + (size_t)al_get_sample_length(s) *
+            al_get_channel_count(al_get_sample_channels(s)) *
+            al_get_audio_depth_size(al_get_sample_depth(s));
+    }
+    else
+        return (sample != NULL) ? sizeof(*sample) : 0;
+}
+#elif !defined(__USE_OPENAL__)
+size_t sound_size(const sound_t *sample)
+{
+    if(sample != NULL)
+        return sizeof(*sample) + (size_t)sample->data->len * (sample->data->bits / 8) * (sample->data->stereo ? 2 : 1);
+    else
+        return 0;
+}
+#else
+size_t sound_size(const sound_t *sample)
+{
+    ALint size = 0;
+
+    if(sample != NULL) {
+        alGetBufferi(sample->buf, AL_SIZE, &size);
+        return sizeof(*sample) + (size_t)max(size, 0);
+    }
+    else
+        return 0;
+}
+#endif
+
+
+/*
+ * sound_set_priority()
+ * Sets the priority of a sound. When there are no free voices,
+ * the voices playing sounds of lower priority are stolen first.
+ * The default priority is zero
+ */
+#if defined(A5BUILD)
+void sound_set_priority(sound_t *sample, int priority)
+{
+    if(sample != NULL)
+        sample->priority = priority;
+}
+#else
+void sound_set_priority(sound_t *sample, int priority)
+{
+    /* not implemented */
+}
+#endif
+
+
 
 
 
@@ -1164,25 +1435,42 @@ void sound_set_volume(sound_t *sample, float volume)
 #if defined(A5BUILD)
 void audio_init()
 {
-    int samples;
-
     logfile_message("Initializing the audio...");
     current_music = NULL;
 
-    if(!al_install_audio())
+    /* the offline mixer doesn't need an audio device */
+    if(!offline && !al_install_audio())
         fatal_error("Can't initialize Allegro's audio addon");
 
     if(!al_init_acodec_addon())
         fatal_error("Can't initialize Allegro's acodec addon");
 
-    for(samples = PREFERRED_NUMBER_OF_SAMPLES; samples > 0; samples /= 2) {
-        if(al_reserve_samples(samples)) {
-            logfile_message("Reserved %d samples", samples);
+    /* we don't use the reserved samples of Allegro; we just need the default mixer */
+    if(!offline && !al_reserve_samples(0))
+        logfile_message("Can't create the default mixer");
+
+    /* create the voices */
+    for(voice_count = 0; voice_count < PREFERRED_NUMBER_OF_SAMPLES; voice_count++) {
+        voice_t* v = &voice[voice_count];
+
+        if(offline)
+            v->instance = NULL;
+        else if(NULL == (v->instance = al_create_sample_instance(NULL)))
+            break;
+        else if(al_get_default_mixer() == NULL || !al_attach_sample_instance_to_mixer(v->instance, al_get_default_mixer())) {
+            al_destroy_sample_instance(v->instance);
             break;
         }
-        else
-            logfile_message("Can't reserve %d samples", samples);
+
+        v->sound = NULL;
+        v->volume = v->loudness = 0.0f;
+        v->priority = 0;
+        v->frame = v->age = 0;
+        stop_track(&v->track);
     }
+
+    logfile_message("Created %d voices", voice_count);
+    voice_stats.voices = voice_count;
 }
 #elif !defined(__USE_OPENAL__)
 void audio_init()
@@ -1254,6 +1542,42 @@ void audio_init()
 #endif
 
 
+/*
+ * audio_init_offline()
+ * Initializes the Audio Manager without an audio device.
+ * The active sounds and the music are still decoded and
+ * mixed into memory at the game's timestep, so that their
+ * cost can be measured in headless runs. If wav_filepath
+ * isn't NULL, the mix is written to that file
+ */
+#if defined(A5BUILD)
+void audio_init_offline(const char *wav_filepath)
+{
+    offline = true;
+    offline_pending_frames = 0.0;
+    offline_mixed_frames = 0;
+
+    if(wav_filepath != NULL) {
+        if(NULL != (offline_wav = fopen(wav_filepath, "wb")))
+            write_wav_header(offline_wav, 0);
+        else
+            logfile_message("Can't open \"%s\" for writing", wav_filepath);
+    }
+
+    audio_init();
+    logfile_message("Mixing the audio offline at %d Hz", OFFLINE_FREQUENCY);
+}
+#else
+void audio_init_offline(const char *wav_filepath)
+{
+    /* not implemented */
+    logfile_message("The offline audio mixer isn't available in this build");
+    audio_init();
+    (void)wav_filepath;
+}
+#endif
+
+
 /*
  * audio_release()
  * Releases the audio manager
@@ -1262,6 +1586,33 @@ void audio_init()
 void audio_release()
 {
     logfile_message("audio_release()");
+
+    logfile_message(
+        "Voices: %d peak, %lu plays, %lu merged, %lu stolen, %lu dropped",
+        voice_stats.peak_voices, (unsigned long)voice_stats.plays, (unsigned long)voice_stats.merged,
+        (unsigned long)voice_stats.stolen, (unsigned long)voice_stats.dropped
+    );
+
+    for(int i = 0; i < voice_count; i++) {
+        if(voice[i].instance != NULL)
+            al_destroy_sample_instance(voice[i].instance);
+    }
+    voice_count = 0;
+
+    /* release the offline mixer */
+    if(offline) {
+        logfile_message("Mixed %.2f seconds of audio offline", (double)offline_mixed_frames / OFFLINE_FREQUENCY);
+        if(offline_wav != NULL) {
+            write_wav_header(offline_wav, (uint32_t)min(offline_mixed_frames, (UINT32_MAX - 36) / 4));
+            if(fclose(offline_wav) != 0)
+                logfile_message("Can't write the offline audio output");
+            offline_wav = NULL;
+        }
+        free(offline_buffer);
+        offline_buffer = NULL;
+        offline_buffer_capacity = 0;
+    }
+
     logfile_message("audio_release() ok");
 }
 #elif !defined(__USE_OPENAL__)
@@ -1297,10 +1648,18 @@ void audio_release()
 #if defined(A5BUILD)
 void audio_update()
 {
+    /* a new frame for the voice manager */
+    ++audio_frame;
+
+    /* mix the audio of this frame */
+    if(offline)
+        mix_offline(timer_get_delta());
+
     /* when the music finishes, set current_music to NULL */
     if(current_music != NULL && !(current_music->is_paused)) {
         if(!music_is_playing()) {
-            al_rewind_audio_stream(current_music->stream);
+            if(current_music->stream != NULL)
+                al_rewind_audio_stream(current_music->stream);
             current_music = NULL;
         }
     }
@@ -1327,3 +1686,401 @@ void audio_update()
         alureUpdate();*/
 }
 #endif
+
+
+/*
+ * audio_voice_stats()
+ * Voice usage statistics
+ */
+#if defined(A5BUILD)
+const audio_voicestats_t* audio_voice_stats()
+{
+    voice_stats.active_voices = 0;
+    for(int i = 0; i < voice_count; i++) {
+        if(is_voice_playing(&voice[i]))
+            voice_stats.active_voices++;
+    }
+
+    return &voice_stats;
+}
+#else
+const audio_voicestats_t* audio_voice_stats()
+{
+    /* not implemented */
+    static const audio_voicestats_t stats = { 0 };
+    return &stats;
+}
+#endif
+
+
+
+/* private stuff */
+#if defined(A5BUILD)
+
+/* creates a new sound object given a decoded sample (which may be NULL) */
+sound_t* create_sound(const char* path, ALLEGRO_SAMPLE* sample)
+{
+    sound_t* s = mallocx(sizeof *s);
+
+    s->sample = NULL;
+    s->volume = 1.0f;
+    s->priority = 0;
+    s->filepath = str_dup(path);
+    s->pending_play = false;
+    s->pending_pan = 0.0f;
+    s->pending_freq = 1.0f;
+    s->pending_deadline = 0.0f;
+
+    if(sample != NULL)
+        attach_sample(s, sample);
+
+    return s;
+}
+
+/* attaches a decoded sample to a sound object */
+void attach_sample(sound_t* s, ALLEGRO_SAMPLE* sample)
+{
+    s->sample = sample;
+
+    /* it was played while being decoded */
+    if(s->pending_play) {
+        s->pending_play = false;
+        if(0.001f * timer_get_ticks() <= s->pending_deadline)
+            sound_play_ex(s, s->volume, s->pending_pan, s->pending_freq);
+        else
+            logfile_warning("Sound \"%s\" wasn't decoded in time", s->filepath);
+    }
+}
+
+/* decodes a sample into memory (runs on a worker thread) */
+void* decode_sample(const char* fullpath)
+{
+    return al_load_sample(fullpath);
+}
+
+/* stores a decoded sample in the resource manager (runs on the main thread) */
+void store_sample(const char* path, void* sample)
+{
+    ALLEGRO_SAMPLE* data = (ALLEGRO_SAMPLE*)sample;
+    sound_t* s = resourcemanager_peek_sample(path);
+
+    /* error? */
+    if(data == NULL) {
+        if(s != NULL && s->sample == NULL)
+            fatal_error("Can't load sound \"%s\"", path);
+        return; /* it was just preloaded; sound_load() will report the error */
+    }
+
+    /* discard the sample if it's already loaded */
+    if(s != NULL && s->sample != NULL) {
+        al_destroy_sample(data);
+        return;
+    }
+
+    /* attach it to the sound object returned by sound_load() */
+    logfile_debug("Loaded sound \"%s\" asynchronously", path);
+    if(s != NULL)
+        attach_sample(s, data);
+    else
+        resourcemanager_add_sample(path, create_sound(path, data));
+}
+
+/* finds a voice to play a sound, stealing one if necessary. If the sound has
+   been played in the current frame, the voice that is playing it is returned.
+   Returns NULL if there are no voices available */
+voice_t* find_voice(const sound_t* s, float loudness)
+{
+    voice_t *free_voice = NULL, *oldest_instance = NULL, *victim = NULL;
+    int instances = 0;
+
+    for(int i = 0; i < voice_count; i++) {
+        voice_t* v = &voice[i];
+
+        if(!is_voice_playing(v)) {
+            if(free_voice == NULL)
+                free_voice = v;
+        }
+        else if(v->sound == s) {
+            if(v->frame == audio_frame)
+                return v;
+            else if(oldest_instance == NULL || v->age < oldest_instance->age)
+                oldest_instance = v;
+            instances++;
+        }
+        else if(victim == NULL || v->priority < victim->priority ||
+        (v->priority == victim->priority && (v->loudness < victim->loudness ||
+        (v->loudness == victim->loudness && v->age < victim->age))))
+            victim = v; /* lower priority, more distant, older */
+    }
+
+    /* too many instances of the same sample? restart the oldest one */
+    if(instances >= MAX_INSTANCES_PER_SAMPLE)
+        return oldest_instance;
+
+    /* is there a free voice? */
+    if(free_voice != NULL)
+        return free_voice;
+
+    /* steal the least important voice, unless the sound is even less important */
+    if(victim != NULL && (s->priority > victim->priority || (s->priority == victim->priority && loudness >= victim->loudness)))
+        return victim;
+
+    /* no voice is available */
+    voice_stats.dropped++;
+    return NULL;
+}
+
+/* is the voice playing a sound? */
+bool is_voice_playing(const voice_t* v)
+{
+    if(v->sound == NULL)
+        return false;
+    else if(v->instance != NULL)
+        return al_get_sample_instance_playing(v->instance);
+    else
+        return v->track.sample != NULL;
+}
+
+/* plays a sample on a voice. Returns true on success */
+bool start_voice(voice_t* v, ALLEGRO_SAMPLE* sample, float gain, float pan, float speed)
+{
+    if(v->instance == NULL) {
+        v->track.sample = sample;
+        v->track.position = 0.0;
+        v->track.gain = gain;
+        v->track.pan = pan;
+        v->track.speed = speed;
+        v->track.loop = false;
+        v->track.paused = false;
+        return true;
+    }
+
+    /* al_set_sample() detaches the instance (and so does al_destroy_sample()
+       on the instances that use the sample being destroyed) */
+    if(!al_set_sample(v->instance, sample))
+        return false;
+    else if(!al_get_sample_instance_attached(v->instance) && (al_get_default_mixer() == NULL || !al_attach_sample_instance_to_mixer(v->instance, al_get_default_mixer())))
+        return false;
+
+    al_set_sample_instance_playmode(v->instance, ALLEGRO_PLAYMODE_ONCE);
+    al_set_sample_instance_gain(v->instance, gain);
+    al_set_sample_instance_pan(v->instance, pan);
+    al_set_sample_instance_speed(v->instance, speed);
+    return al_play_sample_instance(v->instance);
+}
+
+/* stops a voice */
+void stop_voice(voice_t* v)
+{
+    if(v->instance != NULL)
+        al_stop_sample_instance(v->instance); /* keep it attached to the mixer */
+    else
+        stop_track(&v->track);
+
+    v->sound = NULL;
+}
+
+/* changes the gain of a voice */
+void set_voice_gain(voice_t* v, float gain)
+{
+    if(v->instance != NULL)
+        al_set_sample_instance_gain(v->instance, gain);
+    else
+        v->track.gain = gain;
+}
+
+/* changes the pan of a voice */
+void set_voice_pan(voice_t* v, float pan)
+{
+    if(v->instance != NULL)
+        al_set_sample_instance_pan(v->instance, pan);
+    else
+        v->track.pan = pan;
+}
+
+/* mixes the active voices and the music into memory, and optionally into the output file */
+void mix_offline(float seconds)
+{
+    int frames;
+
+    /* how many frames should we mix? */
+    offline_pending_frames += max(seconds, 0.0f) * OFFLINE_FREQUENCY;
+    frames = (int)offline_pending_frames;
+    offline_pending_frames -= frames;
+    if(frames <= 0)
+        return;
+
+    /* grow the buffer */
+    if(frames > offline_buffer_capacity) {
+        offline_buffer_capacity = frames;
+        offline_buffer = reallocx(offline_buffer, 2 * offline_buffer_capacity * sizeof(*offline_buffer));
+    }
+
+    /* mix the tracks */
+    memset(offline_buffer, 0, 2 * frames * sizeof(*offline_buffer));
+    for(int i = 0; i < voice_count; i++) {
+        if(is_voice_playing(&voice[i]))
+            mix_track(&voice[i].track, offline_buffer, frames);
+    }
+    if(current_music != NULL)
+        mix_track(&current_music->track, offline_buffer, frames);
+
+    /* clip the output */
+    for(int j = 0; j < 2 * frames; j++)
+        offline_buffer[j] = clip(offline_buffer[j], -1.0f, 1.0f);
+
+    /* write the output */
+    if(offline_wav != NULL)
+        write_wav_data(offline_wav, offline_buffer, frames);
+
+    offline_mixed_frames += frames;
+}
+
+/* mixes a track into a stereo buffer, resampling it with linear interpolation */
+void mix_track(track_t* t, float* out, int frames)
+{
+    ALLEGRO_SAMPLE* sample = t->sample;
+    const void* data;
+    ALLEGRO_AUDIO_DEPTH depth;
+    unsigned length, channels;
+    float left_gain, right_gain;
+    double step;
+
+    if(sample == NULL || t->paused)
+        return;
+
+    data = al_get_sample_data(sample);
+    depth = al_get_sample_depth(sample);
+    length = al_get_sample_length(sample);
+    channels = al_get_channel_count(al_get_sample_channels(sample));
+    step = t->speed * (double)al_get_sample_frequency(sample) / OFFLINE_FREQUENCY;
+    left_gain = t->gain * min(1.0f, 1.0f - t->pan);
+    right_gain = t->gain * min(1.0f, 1.0f + t->pan);
+    if(length == 0 || channels == 0 || step <= 0.0) {
+        stop_track(t);
+        return;
+    }
+
+    for(int i = 0; i < frames; i++) {
+        unsigned k, next;
+        float frac, left, right;
+
+        /* the end of the sample */
+        if(t->position >= length) {
+            if(!t->loop) {
+                stop_track(t);
+                return;
+            }
+            t->position = fmod(t->position, length);
+        }
+
+        /* interpolate two frames */
+        k = (unsigned)t->position;
+        next = (k + 1 < length) ? k + 1 : (t->loop ? 0 : k);
+        frac = (float)(t->position - k);
+        left = read_sample(data, depth, k * channels);
+        left += frac * (read_sample(data, depth, next * channels) - left);
+        if(channels > 1) {
+            right = read_sample(data, depth, k * channels + 1);
+            right += frac * (read_sample(data, depth, next * channels + 1) - right);
+        }
+        else
+            right = left;
+
+        out[2 * i] += left * left_gain;
+        out[2 * i + 1] += right * right_gain;
+        t->position += step;
+    }
+}
+
+/* stops a track */
+void stop_track(track_t* t)
+{
+    t->sample = NULL;
+    t->position = 0.0;
+    t->paused = false;
+}
+
+/* reads an audio sample from a buffer, converting it to the [-1,1] range */
+float read_sample(const void* data, ALLEGRO_AUDIO_DEPTH depth, unsigned index)
+{
+    switch(depth) {
+        case ALLEGRO_AUDIO_DEPTH_INT8:
+            return ((const int8_t*)data)[index] / 128.0f;
+
+        case ALLEGRO_AUDIO_DEPTH_UINT8:
+            return (((const uint8_t*)data)[index] - 128) / 128.0f;
+
+        case ALLEGRO_AUDIO_DEPTH_INT16:
+            return ((const int16_t*)data)[index] / 32768.0f;
+
+        case ALLEGRO_AUDIO_DEPTH_UINT16:
+            return (((const uint16_t*)data)[index] - 32768) / 32768.0f;
+
+        case ALLEGRO_AUDIO_DEPTH_INT24: /* stored in 32 bits */
+            return ((const int32_t*)data)[index] / 8388608.0f;
+
+        case ALLEGRO_AUDIO_DEPTH_UINT24:
+            return (((const int32_t*)data)[index] - 8388608) / 8388608.0f;
+
+        case ALLEGRO_AUDIO_DEPTH_FLOAT32:
+            return ((const float*)data)[index];
+
+        default:
+            return 0.0f;
+    }
+}
+
+/* writes the header of a 16-bit stereo PCM WAV file with the given number of frames */
+void write_wav_header(FILE* fp, uint32_t frames)
+{
+    uint32_t data_size = frames * 4;
+    uint8_t header[44] = {
+        'R', 'I', 'F', 'F',
+        0, 0, 0, 0, /* 36 + data_size */
+        'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ',
+        16, 0, 0, 0, /* size of the fmt chunk */
+        1, 0, /* PCM */
+        2, 0, /* stereo */
+        OFFLINE_FREQUENCY & 0xFF, (OFFLINE_FREQUENCY >> 8) & 0xFF, (OFFLINE_FREQUENCY >> 16) & 0xFF, 0,
+        0, 0, 0, 0, /* byte rate */
+        4, 0, /* block align */
+        16, 0, /* bits per sample */
+        'd', 'a', 't', 'a',
+        0, 0, 0, 0 /* data_size */
+    };
+    uint32_t riff_size = 36 + data_size, byte_rate = OFFLINE_FREQUENCY * 4;
+
+    for(int i = 0; i < 4; i++) {
+        header[4 + i] = (riff_size >> (8 * i)) & 0xFF;
+        header[28 + i] = (byte_rate >> (8 * i)) & 0xFF;
+        header[40 + i] = (data_size >> (8 * i)) & 0xFF;
+    }
+
+    fseek(fp, 0, SEEK_SET);
+    fwrite(header, sizeof(header), 1, fp);
+    fseek(fp, 0, SEEK_END);
+}
+
+/* appends stereo frames to a WAV file as 16-bit little-endian PCM */
+void write_wav_data(FILE* fp, const float* samples, int frames)
+{
+    uint8_t buf[4096];
+    int n = 0;
+
+    for(int j = 0; j < 2 * frames; j++) {
+        int16_t value = (int16_t)(samples[j] * 32767.0f);
+        buf[n++] = (uint16_t)value & 0xFF;
+        buf[n++] = ((uint16_t)value >> 8) & 0xFF;
+        if(n == sizeof(buf)) {
+            fwrite(buf, n, 1, fp);
+            n = 0;
+        }
+    }
+
+    if(n > 0)
+        fwrite(buf, n, 1, fp);
+}
+
+#endif
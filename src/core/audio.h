@@ -22,15 +22,34 @@
 #define _AUDIO_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* forward declarations */
 typedef struct music_t music_t;
 typedef struct sound_t sound_t;
 
+/* sound priorities (see sound_set_priority) */
+#define SOUND_PRIORITY_DEFAULT      0
+#define SOUND_PRIORITY_HIGH         10
+
+/* voice manager statistics */
+typedef struct audio_voicestats_t {
+    int voices; /* number of voices */
+    int active_voices; /* number of voices playing at the moment */
+    int peak_voices; /* maximum number of voices played at the same time */
+    uint64_t plays; /* play requests */
+    uint64_t merged; /* requests merged with an identical one made in the same frame */
+    uint64_t stolen; /* voices stolen from other sounds */
+    uint64_t dropped; /* requests dropped for lack of a voice */
+} audio_voicestats_t;
+
 /* audio manager */
 void audio_init();
+void audio_init_offline(const char *wav_filepath); /* mixes the audio into memory instead of playing it; wav_filepath may be NULL */
 void audio_update();
 void audio_release();
+const audio_voicestats_t* audio_voice_stats(); /* voice usage statistics */
 
 /* music management */
 music_t *music_load(const char *path); /* will be unloaded automatically */
@@ -47,9 +66,12 @@ int music_unref(music_t *music); /* returns the number of active references */
 float music_duration(); /* duration in seconds */
 music_t *music_current(); /* currently playing music. May be NULL */
 const char *music_path(const music_t *music); /* the filepath of the specified music */
+size_t music_size(const music_t *music); /* approximate memory usage, in bytes */
 
 /* sample management */
-sound_t *sound_load(const char *path); /* will be unloaded automatically */
+sound_t *sound_load(const char *path); /* will be unloaded automatically. The sample may be decoded asynchronously */
+void sound_preload(const char *path); /* loads a sample asynchronously; see assetloader.h */
+void sound_set_load_function(void (*fun)(const char *path)); /* fun(path) is called whenever sound_load() is called; may be NULL */
 void sound_destroy(sound_t *sample);
 void sound_play(sound_t *sample);
 void sound_play_ex(sound_t *sample, float vol, float pan, float freq); /* 0.0<=volume<=1.0; (left) -1.0<=pan<=1.0 (right); 1.0 = default frequency */
@@ -58,5 +80,7 @@ bool sound_is_playing(sound_t *sample);
 int sound_unref(sound_t *sample); /* returns the number of active references */
 float sound_get_volume(sound_t *sample);
 void sound_set_volume(sound_t *sample, float volume); /* volume is in the [0,1] range */
+size_t sound_size(const sound_t *sample); /* approximate memory usage, in bytes */
+void sound_set_priority(sound_t *sample, int priority); /* voices of sounds of higher priority are stolen last (default: 0) */
 
 #endif
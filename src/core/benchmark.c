@@ -0,0 +1,246 @@
+/*
+ * Open Surge Engine
+ * benchmark.c - unattended benchmarks of levels
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "benchmark.h"
+#include "profiler.h"
+#include "timer.h"
+#include "logfile.h"
+#include "stringutil.h"
+#include "global.h"
+#include "util.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/* private stuff */
+#define MAX_ZONES           64
+#define REPORT_SIZE         16384
+static const float TIMESTEP = 1.0f / 60.0f; /* simulated time between frames, in seconds */
+static bool running = false;
+static bool headless = false;
+static bool suspended = true; /* nothing is measured until a level is loaded */
+static int frame_count = 0, max_frames = 0;
+static double max_frame_time = 0.0, max_p99_time = 0.0; /* limits, in ms; 0 means no limit */
+static bool failed = false;
+static uint32_t initial_allocations = 0;
+static char* level = NULL;
+static char* replay = NULL;
+static size_t peak_memory_kb();
+static int append_string(char* buf, int size, int offset, const char* str);
+
+
+
+/* public API */
+
+/*
+ * benchmark_init()
+ * Starts a benchmark of a level. replay_path may be NULL.
+ * The benchmark fails if the frame times exceed the given limits
+ */
+void benchmark_init(const char* level_path, int frames, bool is_headless, const char* replay_path, double max_frame_ms, double max_p99_ms)
+{
+    running = true;
+    headless = is_headless;
+    suspended = true;
+    failed = false;
+    frame_count = 0;
+    max_frames = max(1, frames);
+    max_frame_time = max(0.0, max_frame_ms);
+    max_p99_time = max(0.0, max_p99_ms);
+    initial_allocations = allocation_count();
+    level = str_dup(level_path);
+    replay = (replay_path != NULL) ? str_dup(replay_path) : NULL;
+
+    /* the frames are simulated as fast as possible */
+    timer_set_fixed_timestep(TIMESTEP);
+    logfile_message("Benchmarking \"%s\" for %d frames%s", level, max_frames, headless ? " (headless)" : "");
+}
+
+/*
+ * benchmark_release()
+ * Writes the report of the benchmark and checks its limits
+ */
+void benchmark_release()
+{
+    profilerstats_t stats[MAX_ZONES + 1];
+    char* report;
+    int count, length = 0;
+
+    if(!running)
+        return;
+
+    /* write the report */
+    report = mallocx(REPORT_SIZE * sizeof(*report));
+    count = profiler_get_statistics(stats, sizeof(stats) / sizeof(stats[0]));
+
+    /* check the limits against the whole frame */
+    if(count > 0) {
+        if(max_frame_time > 0.0 && stats[0].max > max_frame_time) {
+            logfile_error("Benchmark failed: a frame took %.4f ms (limit: %.4f ms)", stats[0].max, max_frame_time);
+            failed = true;
+        }
+        if(max_p99_time > 0.0 && stats[0].p99 > max_p99_time) {
+            logfile_error("Benchmark failed: the p99 frame time is %.4f ms (limit: %.4f ms)", stats[0].p99, max_p99_time);
+            failed = true;
+        }
+    }
+
+    length += snprintf(report + length, REPORT_SIZE - length, "{\n  \"engine\": \"%s\",\n  \"level\": ", GAME_VERSION_STRING);
+    length = append_string(report, REPORT_SIZE, length, level);
+    length += snprintf(report + length, REPORT_SIZE - length, ",\n  \"replay\": ");
+    length = append_string(report, REPORT_SIZE, length, replay);
+    length += snprintf(report + length, REPORT_SIZE - length, ",\n  \"headless\": %s,\n  \"frames\": %d,\n  \"zones\": [\n", headless ? "true" : "false", frame_count);
+    for(int i = 0; i < count && length < REPORT_SIZE; i++) {
+        length += snprintf(report + length, REPORT_SIZE - length,
+            "    { \"zone\": \"%s\", \"frames\": %d, \"min_ms\": %.4f, \"avg_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f }%s\n",
+            stats[i].zone, stats[i].frames, stats[i].min, stats[i].avg, stats[i].p99, stats[i].max, (i < count - 1) ? "," : ""
+        );
+    }
+    if(length < REPORT_SIZE) {
+        snprintf(report + length, REPORT_SIZE - length, "  ],\n  \"peak_memory_kb\": %lu,\n  \"allocations\": %lu,\n  \"passed\": %s\n}\n",
+            (unsigned long)peak_memory_kb(), (unsigned long)(allocation_count() - initial_allocations), failed ? "false" : "true");
+    }
+
+    fputs(report, stdout);
+    fflush(stdout);
+    logfile_message("Benchmark report:\n%s", report);
+    free(report);
+
+    /* done */
+    free(replay);
+    free(level);
+    replay = level = NULL;
+    running = false;
+}
+
+/*
+ * benchmark_has_failed()
+ * Has the last benchmark exceeded its limits?
+ */
+bool benchmark_has_failed()
+{
+    return failed;
+}
+
+/*
+ * benchmark_update()
+ * Counts a frame. Quits the game when the benchmark is over
+ */
+void benchmark_update()
+{
+    if(!running || suspended)
+        return;
+
+    if(++frame_count == max_frames)
+        game_quit();
+}
+
+/*
+ * benchmark_suspend()
+ * Frames are not counted while suspended
+ */
+void benchmark_suspend()
+{
+    suspended = true;
+    if(running)
+        profiler_collect_statistics(false);
+}
+
+/*
+ * benchmark_resume()
+ * Resumes counting frames
+ */
+void benchmark_resume()
+{
+    suspended = false;
+    if(running)
+        profiler_collect_statistics(true);
+}
+
+/*
+ * benchmark_is_running()
+ * Is there a benchmark in progress?
+ */
+bool benchmark_is_running()
+{
+    return running;
+}
+
+/*
+ * benchmark_is_headless()
+ * Should we skip rendering?
+ */
+bool benchmark_is_headless()
+{
+    return running && headless;
+}
+
+
+
+/* private */
+
+/* peak resident memory of the process, in KB */
+size_t peak_memory_kb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / 1024;
+    return 0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; /* bytes */
+#else
+    return usage.ru_maxrss; /* kilobytes */
+#endif
+#endif
+}
+
+/* appends a JSON string (or null) to buf. Returns the new offset */
+int append_string(char* buf, int size, int offset, const char* str)
+{
+    if(str == NULL)
+        return offset + snprintf(buf + offset, max(0, size - offset), "null");
+
+    if(offset < size - 1)
+        buf[offset++] = '"';
+    for(; *str && offset < size - 3; str++) {
+        if(*str == '"' || *str == '\\')
+            buf[offset++] = '\\';
+        buf[offset++] = ((unsigned char)*str >= 32) ? *str : ' ';
+    }
+    if(offset < size - 1)
+        buf[offset++] = '"';
+    buf[offset] = '\0';
+
+    return offset;
+}
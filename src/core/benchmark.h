@@ -0,0 +1,50 @@
+/*
+ * Open Surge Engine
+ * benchmark.h - unattended benchmarks of levels
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include <stdbool.h>
+
+/*
+   A benchmark runs a level unattended, as fast as possible,
+   for a given number of frames. The frames are timed by the
+   profiler while the level isn't loading. At the end, a
+   report is written to stdout (and to the logfile) as JSON:
+   min/avg/p99/max frame times of each phase of the frame,
+   peak memory usage and number of allocations.
+
+   Optionally, the benchmark fails if the frame times exceed
+   given limits, so that it can be used to catch regressions.
+*/
+
+void benchmark_init(const char* level_path, int frames, bool headless, const char* replay_path, double max_frame_ms, double max_p99_ms); /* a limit of 0 means no limit */
+void benchmark_release(); /* writes the report */
+bool benchmark_has_failed(); /* has the last benchmark exceeded its limits? Call after benchmark_release() */
+void benchmark_update(); /* call once per frame; quits the game when the benchmark is over */
+
+void benchmark_suspend(); /* stop counting frames (e.g., while a level is being loaded) */
+void benchmark_resume(); /* count frames again */
+
+bool benchmark_is_running(); /* is there a benchmark in progress? */
+bool benchmark_is_headless(); /* skip rendering? */
+
+#endif
@@ -65,6 +65,20 @@ commandline_t commandline_parse(int argc, char **argv)
     cmd.gamedir[0] = '\0';
     cmd.gameid[0] = '\0';
     cmd.allow_font_smoothing = COMMANDLINE_UNDEFINED;
+    cmd.offline_audio = COMMANDLINE_UNDEFINED;
+    cmd.verbose = COMMANDLINE_UNDEFINED;
+    cmd.offline_audio_path[0] = '\0';
+    cmd.capture_name[0] = '\0';
+    cmd.profile = COMMANDLINE_UNDEFINED;
+    cmd.profile_path[0] = '\0';
+    cmd.record_path[0] = '\0';
+    cmd.replay_path[0] = '\0';
+    cmd.benchmark = COMMANDLINE_UNDEFINED;
+    cmd.benchmark_frames = COMMANDLINE_UNDEFINED;
+    cmd.benchmark_max_frame_ms = 0.0;
+    cmd.benchmark_max_p99_ms = 0.0;
+    cmd.headless = COMMANDLINE_UNDEFINED;
+    cmd.jobs = COMMANDLINE_UNDEFINED;
     cmd.user_argv = NULL;
     cmd.user_argc = 0;
 
@@ -105,8 +119,20 @@ commandline_t commandline_parse(int argc, char **argv)
                 "    --game-folder \"/path/to/data\"    use game assets only from the specified folder\n"
                 "    --base \"/path/to/data\"           set a custom base folder for the assets (*nix only)\n"
                 "    --no-font-smoothing              disable antialiased fonts\n"
+                "    --offline-audio [\"output.wav\"]   mix the audio into memory instead of playing it\n"
+                "    --verbose                        write debug messages to the logfile\n"
+                "    --capture \"name\"                 record every frame at a fixed rate (use name.rgba for raw frames)\n"
+                "    --profile [\"output.csv\"]         show the frame profiler and optionally export its timings\n"
+                "    --record \"filepath\"              record the input of a level (use with --level)\n"
+                "    --replay \"filepath\"              replay a recorded input (use with --level)\n"
+                "    --benchmark \"filepath\"           run a level as fast as possible and print a report (e.g., levels/my_level.lev)\n"
+                "    --frames N                       number of frames of the benchmark (default: %d)\n"
+                "    --max-frame-ms X                 fail the benchmark if a frame takes longer than X milliseconds\n"
+                "    --max-p99 X                      fail the benchmark if the 99th percentile of the frame times exceeds X milliseconds\n"
+                "    --headless                       don't render the benchmark and mix its audio offline\n"
+                "    --jobs N                         number of worker threads (0 runs the jobs on the main thread, deterministically)\n"
                 "    -- -arg1 -arg2 -arg3...          user-defined arguments (useful for scripting)\n",
-                COPYRIGHT, program
+                COPYRIGHT, program, COMMANDLINE_BENCHMARKFRAMES
             );
             exit(0);
         }
@@ -166,6 +192,81 @@ commandline_t commandline_parse(int argc, char **argv)
         else if(strcmp(argv[i], "--no-font-smoothing") == 0)
             cmd.allow_font_smoothing = FALSE;
 
+        else if(strcmp(argv[i], "--offline-audio") == 0) {
+            cmd.offline_audio = TRUE;
+            if(i+1 < argc && *(argv[i+1]) != '-')
+                str_cpy(cmd.offline_audio_path, argv[++i], sizeof(cmd.offline_audio_path));
+        }
+
+        else if(strcmp(argv[i], "--verbose") == 0)
+            cmd.verbose = TRUE;
+
+        else if(strcmp(argv[i], "--capture") == 0) {
+            if(++i < argc && *(argv[i]) != '-')
+                str_cpy(cmd.capture_name, argv[i], sizeof(cmd.capture_name));
+            else
+                crash("%s: missing --capture parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--profile") == 0) {
+            cmd.profile = TRUE;
+            if(i+1 < argc && *(argv[i+1]) != '-')
+                str_cpy(cmd.profile_path, argv[++i], sizeof(cmd.profile_path));
+        }
+
+        else if(strcmp(argv[i], "--record") == 0) {
+            if(++i < argc && *(argv[i]) != '-')
+                str_cpy(cmd.record_path, argv[i], sizeof(cmd.record_path));
+            else
+                crash("%s: missing --record parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--replay") == 0) {
+            if(++i < argc && *(argv[i]) != '-')
+                str_cpy(cmd.replay_path, argv[i], sizeof(cmd.replay_path));
+            else
+                crash("%s: missing --replay parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--benchmark") == 0) {
+            cmd.benchmark = TRUE;
+            if(++i < argc && *(argv[i]) != '-')
+                str_cpy(cmd.custom_level_path, argv[i], sizeof(cmd.custom_level_path));
+            else
+                crash("%s: missing --benchmark parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--frames") == 0) {
+            if(++i < argc && atoi(argv[i]) > 0)
+                cmd.benchmark_frames = atoi(argv[i]);
+            else
+                crash("%s: invalid --frames parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--max-frame-ms") == 0) {
+            if(++i < argc && atof(argv[i]) > 0.0)
+                cmd.benchmark_max_frame_ms = atof(argv[i]);
+            else
+                crash("%s: invalid --max-frame-ms parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--max-p99") == 0) {
+            if(++i < argc && atof(argv[i]) > 0.0)
+                cmd.benchmark_max_p99_ms = atof(argv[i]);
+            else
+                crash("%s: invalid --max-p99 parameter", program);
+        }
+
+        else if(strcmp(argv[i], "--headless") == 0)
+            cmd.headless = TRUE;
+
+        else if(strcmp(argv[i], "--jobs") == 0) {
+            if(++i < argc && *(argv[i]) >= '0' && *(argv[i]) <= '9')
+                cmd.jobs = atoi(argv[i]);
+            else
+                crash("%s: invalid --jobs parameter", program);
+        }
+
         else if(strcmp(argv[i], "--level") == 0) {
             if(++i < argc && *(argv[i]) != '-')
                 str_cpy(cmd.custom_level_path, argv[i], sizeof(cmd.custom_level_path));
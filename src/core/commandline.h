@@ -23,6 +23,7 @@
 
 /* command line */
 #define COMMANDLINE_PATHMAX 4096
+#define COMMANDLINE_BENCHMARKFRAMES 3600 /* default number of frames of a benchmark */
 typedef struct commandline_t commandline_t;
 
 /* command line structure */
@@ -45,6 +46,20 @@ struct commandline_t {
     /* other options */
     char gameid[128];
     int allow_font_smoothing;
+    int offline_audio;
+    int verbose;
+    char offline_audio_path[COMMANDLINE_PATHMAX];
+    char capture_name[COMMANDLINE_PATHMAX];
+    int profile;
+    char profile_path[COMMANDLINE_PATHMAX];
+    char record_path[COMMANDLINE_PATHMAX];
+    char replay_path[COMMANDLINE_PATHMAX];
+    int benchmark;
+    int benchmark_frames;
+    double benchmark_max_frame_ms; /* 0 means no limit */
+    double benchmark_max_p99_ms;
+    int headless;
+    int jobs;
 
     /* user arguments: what comes after "--" */
     const char** user_argv;
@@ -26,6 +26,7 @@
 #endif
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <locale.h>
 #include <time.h>
@@ -36,9 +37,13 @@
 #include "util.h"
 #include "assetfs.h"
 #include "resourcemanager.h"
+#include "assetloader.h"
+#include "jobs.h"
+#include "memtrack.h"
 #include "stringutil.h"
 #include "logfile.h"
 #include "video.h"
+#include "image.h"
 #include "audio.h"
 #include "input.h"
 #include "timer.h"
@@ -46,6 +51,10 @@
 #include "sprite.h"
 #include "lang.h"
 #include "screenshot.h"
+#include "framecapture.h"
+#include "profiler.h"
+#include "inputrecorder.h"
+#include "benchmark.h"
 #include "modmanager.h"
 #include "prefs.h"
 #include "commandline.h"
@@ -135,12 +144,20 @@ void engine_mainloop()
     if(!timer)
         fatal_error("Can't create Allegro timer");
     al_register_event_source(a5_event_queue, al_get_timer_event_source(timer));
-    al_start_timer(timer);
+    if(!benchmark_is_running()) /* benchmarks run as fast as possible */
+        al_start_timer(timer);
 
     /* main loop */
     while(!game_is_over() && !scenestack_empty()) {
         ALLEGRO_EVENT event;
-        al_wait_for_event(a5_event_queue, &event);
+
+        /* when benchmarking, an idle event queue means a new frame */
+        if(!benchmark_is_running())
+            al_wait_for_event(a5_event_queue, &event);
+        else if(!al_get_next_event(a5_event_queue, &event)) {
+            event.type = ALLEGRO_EVENT_TIMER;
+            event.timer.source = timer;
+        }
 
         /* handle events */
         switch(event.type) {
@@ -149,15 +166,27 @@ void engine_mainloop()
                 ALLEGRO_EVENT next_event;
 
                 /* updating the managers */
+                profiler_new_frame();
                 timer_update();
+                profiler_begin("input");
                 input_update();
+                profiler_end();
+                profiler_begin("audio");
                 audio_update();
+                profiler_end();
+                profiler_begin("assets");
                 clean_garbage();
+                jobs_update();
+                assetloader_update();
+                profiler_end();
 
                 /* updating the current scene */
                 current_scene = scenestack_top();
+                profiler_begin("update");
                 current_scene->update();
+                profiler_end();
                 redraw = (current_scene == scenestack_top()); /* same scene? */
+                benchmark_update();
 
                 /* prevent locking */
                 while(al_peek_next_event(a5_event_queue, &next_event) && next_event.type == ALLEGRO_EVENT_TIMER && next_event.timer.source == event.timer.source)
@@ -202,11 +231,17 @@ void engine_mainloop()
         }
 
         /* render */
-        if(redraw && al_is_event_queue_empty(a5_event_queue)) {
+        if(redraw && !benchmark_is_headless() && (al_is_event_queue_empty(a5_event_queue) || framecapture_is_active() || benchmark_is_running())) {
+            profiler_begin("render");
             current_scene->render();
+            profiler_end();
+            profiler_begin("video_render");
             screenshot_update();
             fadefx_update();
+            framecapture_update();
+            profiler_render();
             video_render();
+            profiler_end();
             redraw = false;
         }
     }
@@ -218,20 +253,41 @@ void engine_mainloop()
 
     while(!game_is_over() && !scenestack_empty()) {
         /* updating the managers */
+        profiler_new_frame();
         timer_update();
+        profiler_begin("input");
         input_update();
+        profiler_end();
+        profiler_begin("audio");
         audio_update();
+        profiler_end();
+        profiler_begin("assets");
+        jobs_update();
+        assetloader_update();
+        profiler_end();
 
         /* current scene: logic & rendering */
         scn = scenestack_top();
+        profiler_begin("update");
         scn->update();
-        if(scn == scenestack_top()) /* scn may have been 'popped' out */
-            scn->render();
+        profiler_end();
+        benchmark_update();
+        if(!benchmark_is_headless()) {
+            if(scn == scenestack_top()) { /* scn may have been 'popped' out */
+                profiler_begin("render");
+                scn->render();
+                profiler_end();
+            }
 
-        /* more rendering */
-        screenshot_update();
-        fadefx_update();
-        video_render();
+            /* more rendering */
+            profiler_begin("video_render");
+            screenshot_update();
+            fadefx_update();
+            framecapture_update();
+            profiler_render();
+            video_render();
+            profiler_end();
+        }
 
         /* calling the garbage collector */
         clean_garbage();
@@ -243,13 +299,17 @@ void engine_mainloop()
 /*
  * engine_release()
  * Releases the game engine and its
- * subsystems
+ * subsystems. Returns the exit status
  */
-void engine_release()
+int engine_release()
 {
     release_accessories();
     release_managers();
     release_basic_stuff();
+    memtrack_dump_leaks();
+
+    /* a failed benchmark is a failed run */
+    return benchmark_has_failed() ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 
@@ -267,7 +327,8 @@ void clean_garbage()
 
     if(t >= last + 2000) { /* every 2 seconds */
         last = t;
-        resourcemanager_release_unused_resources();
+        if(!assetloader_is_busy()) /* don't release the assets that are being preloaded */
+            resourcemanager_release_unused_resources();
     }
 }
 
@@ -287,6 +348,8 @@ void init_basic_stuff(const commandline_t* cmd)
     srand(time(NULL));
     assetfs_init(gameid, basedir, gamedir);
     logfile_init();
+    if(commandline_getint(cmd->verbose, FALSE))
+        logfile_set_level(LOGLEVEL_DEBUG);
     init_nanoparser();
 
     /* initialize Allegro */
@@ -306,6 +369,8 @@ void init_basic_stuff(const commandline_t* cmd)
     srand(time(NULL));
     assetfs_init(gameid, basedir, gamedir);
     logfile_init();
+    if(commandline_getint(cmd->verbose, FALSE))
+        logfile_set_level(LOGLEVEL_DEBUG);
     init_nanoparser();
 #endif
 }
@@ -323,6 +388,8 @@ void init_managers(const commandline_t* cmd)
     prefs = modmanager_prefs();
 
     timer_init();
+    if(commandline_getint(cmd->benchmark, FALSE))
+        video_disable_vsync();
     video_init(
         commandline_getint(
             cmd->video_resolution,
@@ -336,9 +403,17 @@ void init_managers(const commandline_t* cmd)
     video_show_fps(
         commandline_getint(cmd->show_fps, prefs_get_bool(prefs, ".showfps"))
     );
-    audio_init();
+    if(commandline_getint(cmd->offline_audio, FALSE) || (commandline_getint(cmd->benchmark, FALSE) && commandline_getint(cmd->headless, FALSE)))
+        audio_init_offline(commandline_getstring(cmd->offline_audio_path, NULL));
+    else
+        audio_init();
     input_init();
+    inputrecorder_init(commandline_getstring(cmd->record_path, NULL), commandline_getstring(cmd->replay_path, NULL));
     resourcemanager_init();
+    if(prefs_has_item(prefs, ".resourcebudget")) /* in megabytes */
+        resourcemanager_set_memory_budget((size_t)max(0, prefs_get_int(prefs, ".resourcebudget")) * 1024 * 1024);
+    jobs_init(commandline_getint(cmd->jobs, -1));
+    assetloader_init();
 }
 
 
@@ -359,10 +434,16 @@ void init_accessories(const commandline_t* cmd)
     sprite_init();
     font_init(commandline_getint(cmd->allow_font_smoothing, TRUE));
     fontext_register_variables();
+    profiler_init(commandline_getstring(cmd->profile_path, NULL));
+    profiler_show(commandline_getint(cmd->profile, FALSE));
+    if(commandline_getint(cmd->benchmark, FALSE))
+        benchmark_init(cmd->custom_level_path, commandline_getint(cmd->benchmark_frames, COMMANDLINE_BENCHMARKFRAMES), commandline_getint(cmd->headless, FALSE), commandline_getstring(cmd->replay_path, NULL), cmd->benchmark_max_frame_ms, cmd->benchmark_max_p99_ms);
     charactersystem_init();
     objects_init();
     storyboard_init();
     screenshot_init();
+    if(commandline_getstring(cmd->capture_name, NULL) != NULL)
+        framecapture_start(commandline_getstring(cmd->capture_name, ""));
     fadefx_init();
     lang_init();
     if(custom_lang && *custom_lang)
@@ -423,9 +504,12 @@ void release_accessories()
     scripting_release();
     lang_release();
     fadefx_release();
+    framecapture_stop();
     screenshot_release();
     objects_release();
     charactersystem_release();
+    benchmark_release();
+    profiler_release();
     font_release();
     sprite_release();
 }
@@ -437,7 +521,11 @@ void release_accessories()
 void release_managers()
 {
     modmanager_release();
+    inputrecorder_release();
     input_release();
+    assetloader_release();
+    jobs_release();
+    image_release_prefetched();
     video_release();
     resourcemanager_release();
     audio_release();
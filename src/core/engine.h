@@ -23,7 +23,7 @@
 
 void engine_init(int argc, char **argv);
 void engine_mainloop();
-void engine_release();
+int engine_release(); /* returns the exit status of the program */
 
 #endif
 
@@ -124,10 +124,10 @@ void* fasthash_get(fasthash_t* hashtable, uint64_t key)
             if(hashtable->data[k].key == key) {
                 /* swap marker */
                 if(marker < hashtable->capacity) {
-                    /* remove deleted entry */
+                    /* move the element closer to its home (the old slot
+                       is marked as deleted so that the probe chain is kept) */
                     hashtable->data[marker] = hashtable->data[k];
-                    hashtable->data[k] = BLANK_ENTRY;
-                    hashtable->length--;
+                    hashtable->data[k].state = DELETED;
                     return hashtable->data[marker].value;
                 }
 
@@ -153,32 +153,38 @@ void fasthash_put(fasthash_t* hashtable, uint64_t key, void* value)
 {
     if(hashtable->length < hashtable->capacity / SPARSITY) { /* make it sparse */
         uint32_t k = hash(key, hashtable->cap_mask);
+        uint32_t marker = hashtable->capacity;
 
         /* won't accept NULL values */
         if(value == NULL)
             return;
 
         while(hashtable->data[k].state != BLANK) {
-            if(hashtable->data[k].state == DELETED) {
-                /* replace deleted element */
-                hashtable->data[k].key = key;
-                hashtable->data[k].value = value;
-                hashtable->data[k].state = ACTIVE;
-                return;
-            }
-            else if(hashtable->data[k].key == key) {
-                /* replace active element */
-                if(value != hashtable->data[k].value) {
-                    hashtable->destructor(hashtable->data[k].value); /* TODO: save until later? */
-                    hashtable->data[k].value = value;
+            if(hashtable->data[k].state == ACTIVE) {
+                if(hashtable->data[k].key == key) {
+                    /* replace active element */
+                    if(value != hashtable->data[k].value) {
+                        hashtable->destructor(hashtable->data[k].value); /* TODO: save until later? */
+                        hashtable->data[k].value = value;
+                    }
+                    return;
                 }
-                return;
             }
+            else if(marker == hashtable->capacity)
+                marker = k; /* save first deleted entry */
 
             /* probe */
             ++k; k &= hashtable->cap_mask;
         }
 
+        /* replace deleted element */
+        if(marker < hashtable->capacity) {
+            hashtable->data[marker].key = key;
+            hashtable->data[marker].value = value;
+            hashtable->data[marker].state = ACTIVE;
+            return;
+        }
+
         /* insert new element */
         hashtable->data[k].key = key;
         hashtable->data[k].value = value;
@@ -201,15 +207,11 @@ bool fasthash_delete(fasthash_t* hashtable, uint64_t key)
     uint32_t k = hash(key, hashtable->cap_mask);
 
     while(hashtable->data[k].state != BLANK) {
-        if(hashtable->data[k].key == key) {
-            if(hashtable->data[k].state == ACTIVE) {
-                /* lazy removal of the entry */
-                hashtable->data[k].state = DELETED;
-                hashtable->destructor(hashtable->data[k].value);
-                return true;
-            }
-            else
-                return false; /* duplicate removal */
+        if(hashtable->data[k].key == key && hashtable->data[k].state == ACTIVE) {
+            /* lazy removal of the entry */
+            hashtable->data[k].state = DELETED;
+            hashtable->destructor(hashtable->data[k].value);
+            return true;
         }
 
         /* probe */
@@ -245,14 +247,30 @@ void* fasthash_find(fasthash_t* hashtable, bool (*test)(const void*,void*), void
 
 void grow(fasthash_t* hashtable)
 {
+    fasthash_entry_t* old_data = hashtable->data;
     size_t old_cap = hashtable->capacity;
     int i;
 
     hashtable->capacity *= 2;
     hashtable->cap_mask = (hashtable->cap_mask << 1) | 1;
-    hashtable->data = reallocx(hashtable->data, hashtable->capacity * sizeof(fasthash_entry_t));
-    for(i = old_cap; i < hashtable->capacity; i++)
+    hashtable->data = mallocx(hashtable->capacity * sizeof(fasthash_entry_t));
+    for(i = 0; i < hashtable->capacity; i++)
         hashtable->data[i] = BLANK_ENTRY;
+
+    /* rehash the elements (deleted entries are dropped) */
+    hashtable->length = 0;
+    for(i = 0; i < old_cap; i++) {
+        if(old_data[i].state == ACTIVE) {
+            uint32_t k = hash(old_data[i].key, hashtable->cap_mask);
+            while(hashtable->data[k].state != BLANK) {
+                ++k; k &= hashtable->cap_mask;
+            }
+            hashtable->data[k] = old_data[i];
+            hashtable->length++;
+        }
+    }
+
+    free(old_data);
 }
 
 uint64_t hash(uint64_t x, uint64_t m)
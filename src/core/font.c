@@ -42,6 +42,7 @@
 #include "logfile.h"
 #include "hashtable.h"
 #include "nanoparser/nanoparser.h"
+#include "parsecache.h"
 #include "utf8/utf8.h"
 
 /* private stuff */
@@ -1140,9 +1141,8 @@ int traverse_ttf(const parsetree_statement_t *stmt, void *data)
 
 int dirfill(const char *vpath, void *param)
 {
-    const char* fullpath = assetfs_fullpath(vpath);
     parsetree_program_t** p = (parsetree_program_t**)param;
-    *p = nanoparser_append_program(*p, nanoparser_construct_tree(fullpath));
+    *p = nanoparser_append_program(*p, parsecache_construct_tree(vpath));
     return 0;
 }
 
@@ -0,0 +1,296 @@
+/*
+ * Open Surge Engine
+ * framecapture.c - fixed-rate frame capture
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "framecapture.h"
+#include "assetfs.h"
+#include "logfile.h"
+#include "stringutil.h"
+#include "image.h"
+#include "video.h"
+#include "timer.h"
+#include "util.h"
+
+#if defined(A5BUILD)
+#include <allegro5/allegro.h>
+#endif
+
+/* private data */
+#define QUEUE_SIZE          8 /* how many frames may be waiting to be written */
+#define CAPTURE_PATH        "captures/"
+static const float CAPTURE_TIMESTEP = 1.0f / 60.0f; /* simulated time between frames, in seconds */
+static bool active = false;
+
+#if defined(A5BUILD)
+/* a bounded queue of frames: the main thread fills the slots and the writer thread empties them */
+typedef struct frameslot_t {
+    uint8_t* pixels; /* RGBA */
+    uint32_t number; /* frame number */
+} frameslot_t;
+
+static frameslot_t queue[QUEUE_SIZE];
+static int queue_head = 0; /* first slot to be written */
+static int queue_count = 0; /* number of slots waiting to be written */
+static int width = 0, height = 0; /* size of the frames */
+static uint32_t frame_count = 0; /* frames captured so far */
+static uint32_t stall_count = 0; /* how many times the main thread had to wait for the writer */
+static bool write_error = false;
+static float previous_timestep = 0.0f; /* the fixed time step before the capture */
+static FILE* raw_file = NULL; /* raw mode */
+static char* png_prefix = NULL; /* PNG mode: absolute path of the folder of the frames */
+static ALLEGRO_THREAD* writer = NULL;
+static ALLEGRO_MUTEX* mutex = NULL;
+static ALLEGRO_COND* cond_not_empty = NULL;
+static ALLEGRO_COND* cond_not_full = NULL;
+static void* writer_thread(ALLEGRO_THREAD* thread, void* arg);
+static bool write_frame(const frameslot_t* slot);
+#endif
+
+
+
+/* public API */
+
+/*
+ * framecapture_start()
+ * Starts recording the rendered frames. If name ends with ".rgba",
+ * the frames are written as a single stream of raw RGBA frames;
+ * otherwise, they're written as PNG files in a folder called name.
+ * Returns false on error
+ */
+bool framecapture_start(const char* name)
+{
+#if defined(A5BUILD)
+    const image_t* backbuffer = video_get_backbuffer();
+    char vpath[1024];
+
+    if(active)
+        framecapture_stop();
+
+    /* the frames have the size of the backbuffer of the game */
+    width = image_width(backbuffer);
+    height = image_height(backbuffer);
+    frame_count = stall_count = 0;
+    write_error = false;
+
+    /* open the output */
+    if(strlen(name) > 5 && strcmp(name + strlen(name) - 5, ".rgba") == 0) {
+        const char* fullpath;
+        snprintf(vpath, sizeof(vpath), "%s%s", CAPTURE_PATH, name);
+        fullpath = assetfs_create_cache_file(vpath);
+        if(NULL == (raw_file = fopen(fullpath, "wb"))) {
+            logfile_message("Frame capture: can't open \"%s\" for writing", fullpath);
+            return false;
+        }
+        logfile_message("Capturing %d x %d RGBA frames at %g fps to \"%s\"", width, height, 1.0f / CAPTURE_TIMESTEP, fullpath);
+    }
+    else {
+        const char* fullpath;
+        snprintf(vpath, sizeof(vpath), "%s%s/000000.png", CAPTURE_PATH, name);
+        fullpath = assetfs_create_cache_file(vpath); /* creates the folder */
+        png_prefix = str_dup(fullpath);
+        png_prefix[strlen(png_prefix) - strlen("000000.png")] = '\0';
+        logfile_message("Capturing %d x %d PNG frames at %g fps to \"%s\"", width, height, 1.0f / CAPTURE_TIMESTEP, png_prefix);
+    }
+
+    /* allocate the queue */
+    queue_head = queue_count = 0;
+    for(int i = 0; i < QUEUE_SIZE; i++) {
+        queue[i].pixels = mallocx(4 * width * height * sizeof(*(queue[i].pixels)));
+        queue[i].number = 0;
+    }
+
+    /* start the writer */
+    mutex = al_create_mutex();
+    cond_not_empty = al_create_cond();
+    cond_not_full = al_create_cond();
+    if(mutex == NULL || cond_not_empty == NULL || cond_not_full == NULL || NULL == (writer = al_create_thread(writer_thread, NULL)))
+        fatal_error("Frame capture: can't create the writer thread");
+    al_start_thread(writer);
+
+    /* lock-step timing */
+    previous_timestep = timer_get_fixed_timestep();
+    timer_set_fixed_timestep(CAPTURE_TIMESTEP);
+    active = true;
+    return true;
+#else
+    logfile_message("Frame capture: not available in this build");
+    return false;
+#endif
+}
+
+/*
+ * framecapture_stop()
+ * Stops recording. The pending frames are written before returning
+ */
+void framecapture_stop()
+{
+#if defined(A5BUILD)
+    if(!active)
+        return;
+
+    /* wait for the writer */
+    al_lock_mutex(mutex);
+    al_set_thread_should_stop(writer);
+    al_broadcast_cond(cond_not_empty);
+    al_unlock_mutex(mutex);
+    al_join_thread(writer, NULL);
+    al_destroy_thread(writer);
+    al_destroy_cond(cond_not_full);
+    al_destroy_cond(cond_not_empty);
+    al_destroy_mutex(mutex);
+    writer = NULL;
+    cond_not_full = cond_not_empty = NULL;
+    mutex = NULL;
+
+    /* release the output */
+    if(raw_file != NULL) {
+        if(fclose(raw_file) != 0)
+            write_error = true;
+        raw_file = NULL;
+    }
+    if(png_prefix != NULL) {
+        free(png_prefix);
+        png_prefix = NULL;
+    }
+
+    for(int i = 0; i < QUEUE_SIZE; i++) {
+        free(queue[i].pixels);
+        queue[i].pixels = NULL;
+    }
+
+    logfile_message("Captured %u frames (the game waited for the writer %u times)%s", frame_count, stall_count, write_error ? ". Some frames couldn't be written" : "");
+    timer_set_fixed_timestep(previous_timestep);
+    active = false;
+#endif
+}
+
+/*
+ * framecapture_update()
+ * Captures the rendered frame. If the writer thread
+ * is behind, this waits until a slot is available
+ */
+void framecapture_update()
+{
+#if defined(A5BUILD)
+    frameslot_t* slot;
+
+    if(!active)
+        return;
+
+    /* stop recording if the writer has failed */
+    al_lock_mutex(mutex);
+    if(write_error) {
+        al_unlock_mutex(mutex);
+        logfile_message("Frame capture: can't write the frames. Stopping...");
+        framecapture_stop();
+        return;
+    }
+
+    /* wait for a free slot */
+    if(queue_count == QUEUE_SIZE) {
+        stall_count++;
+        while(queue_count == QUEUE_SIZE)
+            al_wait_cond(cond_not_full, mutex);
+    }
+    al_unlock_mutex(mutex);
+
+    /* the slot after the last queued one is ours until we queue it */
+    slot = &queue[(queue_head + queue_count) % QUEUE_SIZE];
+    if(!image_read_pixels(video_get_backbuffer(), slot->pixels))
+        return; /* skip this frame */
+    slot->number = frame_count++;
+
+    al_lock_mutex(mutex);
+    queue_count++;
+    al_signal_cond(cond_not_empty);
+    al_unlock_mutex(mutex);
+#endif
+}
+
+/*
+ * framecapture_is_active()
+ * Are we recording?
+ */
+bool framecapture_is_active()
+{
+    return active;
+}
+
+
+
+/* private */
+#if defined(A5BUILD)
+
+/* writer thread: writes the queued frames in order */
+void* writer_thread(ALLEGRO_THREAD* thread, void* arg)
+{
+    al_lock_mutex(mutex);
+    for(;;) {
+        frameslot_t* slot;
+        bool success;
+
+        /* wait for a frame. The queued frames are written before we stop */
+        if(queue_count == 0) {
+            if(al_get_thread_should_stop(thread))
+                break;
+            al_wait_cond(cond_not_empty, mutex);
+            continue;
+        }
+
+        /* write it without holding the lock */
+        slot = &queue[queue_head];
+        al_unlock_mutex(mutex);
+        success = write_frame(slot);
+        al_lock_mutex(mutex);
+        write_error = write_error || !success;
+
+        /* release the slot */
+        queue_head = (queue_head + 1) % QUEUE_SIZE;
+        queue_count--;
+        al_signal_cond(cond_not_full);
+    }
+    al_unlock_mutex(mutex);
+
+    return NULL;
+}
+
+/* writes a frame to the disk (runs on the writer thread) */
+bool write_frame(const frameslot_t* slot)
+{
+    size_t size = 4 * (size_t)width * (size_t)height;
+
+    if(raw_file != NULL)
+        return fwrite(slot->pixels, size, 1, raw_file) == 1;
+    else {
+        char fullpath[4096];
+        snprintf(fullpath, sizeof(fullpath), "%s%06u.png", png_prefix, slot->number);
+
+        /* the frames are opaque */
+        for(size_t i = 3; i < size; i += 4)
+            slot->pixels[i] = 255;
+
+        return image_save_pixels(slot->pixels, width, height, fullpath);
+    }
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Open Surge Engine
+ * framecapture.h - fixed-rate frame capture
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FRAMECAPTURE_H
+#define _FRAMECAPTURE_H
+
+#include <stdbool.h>
+
+/*
+   The frame capture records every rendered frame of the game,
+   which runs at a fixed simulated timestep while recording.
+   Frames are read back from the backbuffer and handed to a
+   writer thread through a bounded queue. If the writer falls
+   behind, the game slows down; no frames are ever dropped.
+
+   Frames are written to the captures/ folder of the cache,
+   either as a sequence of PNG files or, if the name of the
+   capture ends with ".rgba", as a single stream of raw RGBA
+   frames (8 bits per channel, no header).
+*/
+
+bool framecapture_start(const char* name); /* starts recording; returns false on error */
+void framecapture_stop(); /* stops recording, waiting for the pending frames to be written */
+void framecapture_update(); /* captures the rendered frame; call it once per frame */
+bool framecapture_is_active(); /* are we recording? */
+
+#endif
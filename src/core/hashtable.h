@@ -32,10 +32,30 @@
 #include "stringutil.h"
 #include "logfile.h"
 
+/*
+   Open addressing with linear probing. The table grows as
+   needed, and the hash of each key is stored alongside it,
+   so that lookups seldom need to compare keys and resizing
+   doesn't need to hash them again. Keys are cloned (interned)
+   once, at insertion time; string keys are case-folded then.
+*/
+
 /* utilities */
-#define __H_CAPACITY               727 /* prime number (must be a compile-time constant for compiler optimization) */
-#define __H_BUCKET(h, key)         ((h)->hash_function(key) % __H_CAPACITY)
+#define __H_INITIAL_CAPACITY       16 /* must be a power of two */
+#define __H_MAX_USAGE(cap)         ((cap) >> 1) /* max load factor, including deleted entries */
 #define __H_CONST(KEY_TYPE)        const KEY_TYPE
+enum { __H_BLANK = 0, __H_ACTIVE, __H_DELETED }; /* state of an entry */
+
+/* improves the distribution of the lower bits of a hash (murmur3 finalizer) */
+static inline uint32_t __h_mix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
 
 /* hashtable_<typename> class: pretty much like C++ templates */
 /* DESTRUCTOR_FN is a void function that takes a T* as an argument (i.e., the object destructor) */
@@ -46,6 +66,7 @@
 /* Using keys that are not case-insensitive strings */
 /* currently, the KEY_TYPE must be a pointer */
 /* KEY_COMPARE_FN must return 0 if two keys are the same - set this to NULL to use a default function */
+/* KEY_COMPARE_FN takes the stored (cloned) key first and the key being looked up second */
 /* KEY_HASH_FN must be a uint32_t function - set this function pointer to NULL to use a default implementation */
 /* KEY_CLONE_FN, KEY_DELETE_FN may be set to NULL */
 #define HASHTABLE_GENERATE_CODE_EX(T, DESTRUCTOR_FN, KEY_TYPE, KEY_COMPARE_FN, KEY_HASH_FN, KEY_CLONE_FN, KEY_DELETE_FN) \
@@ -59,24 +80,67 @@ static KEY_TYPE __h_default_clone_key_##T(__H_CONST(KEY_TYPE) key); \
 static void __h_default_delete_key_##T(KEY_TYPE key); \
 static void __h_unused_##T(); \
 typedef struct hashtable_##T hashtable_##T; \
-typedef struct hashtable_list_##T hashtable_list_##T; \
+typedef struct hashtable_entry_##T hashtable_entry_##T; \
 struct hashtable_##T { \
-    hashtable_list_##T *data[__H_CAPACITY]; \
+    hashtable_entry_##T *data; \
+    size_t capacity; /* a power of two */ \
+    size_t length; /* number of active entries */ \
+    size_t usage; /* number of active or deleted entries */ \
     void (*destructor)(T*); \
     uint32_t (*hash_function)(__H_CONST(KEY_TYPE)); \
     int (*key_compare)(__H_CONST(KEY_TYPE),__H_CONST(KEY_TYPE)); \
     KEY_TYPE (*key_clone)(__H_CONST(KEY_TYPE)); \
     void (*key_delete)(KEY_TYPE); \
 }; \
-struct hashtable_list_##T { \
+struct hashtable_entry_##T { \
     KEY_TYPE key; \
-    T *value;\
-    int reference_count;\
-    hashtable_list_##T *next; \
+    T *value; \
+    uint32_t hash; \
+    int reference_count; \
+    int state; \
 }; \
+static hashtable_entry_##T* __h_alloc_##T(size_t capacity) \
+{ \
+    hashtable_entry_##T *data = mallocx(capacity * sizeof *data); \
+    for(size_t i = 0; i < capacity; i++) \
+        data[i].state = __H_BLANK; \
+    return data; \
+} \
+static uint32_t __h_hash_##T(const hashtable_##T *h, __H_CONST(KEY_TYPE) key) \
+{ \
+    return __h_mix(h->hash_function(key)); \
+} \
+static size_t __h_locate_##T(const hashtable_##T *h, __H_CONST(KEY_TYPE) key, uint32_t hash) \
+{ \
+    /* returns h->capacity if the key doesn't exist */ \
+    size_t mask = h->capacity - 1, k = hash & mask; \
+    while(h->data[k].state != __H_BLANK) { \
+        if(h->data[k].state == __H_ACTIVE && h->data[k].hash == hash && h->key_compare(h->data[k].key, key) == 0) \
+            return k; \
+        k = (k + 1) & mask; \
+    } \
+    return h->capacity; \
+} \
+static void __h_rehash_##T(hashtable_##T *h, size_t capacity) \
+{ \
+    /* the stored hashes are reused */ \
+    hashtable_entry_##T *old_data = h->data; \
+    size_t old_capacity = h->capacity; \
+    h->data = __h_alloc_##T(capacity); \
+    h->capacity = capacity; \
+    for(size_t i = 0; i < old_capacity; i++) { \
+        if(old_data[i].state == __H_ACTIVE) { \
+            size_t k = old_data[i].hash & (capacity - 1); \
+            while(h->data[k].state != __H_BLANK) \
+                k = (k + 1) & (capacity - 1); \
+            h->data[k] = old_data[i]; \
+        } \
+    } \
+    h->usage = h->length; \
+    free(old_data); \
+} \
 static hashtable_##T* hashtable_##T##_create() \
 { \
-    int i; \
     hashtable_##T *h = mallocx(sizeof *h); \
     logfile_message("hashtable_" #T "_create()"); \
     h->destructor = (DESTRUCTOR_FN); \
@@ -92,171 +156,129 @@ static hashtable_##T* hashtable_##T##_create() \
         h->key_clone = __h_default_clone_key_##T; \
     if(h->key_delete == NULL) \
         h->key_delete = __h_default_delete_key_##T; \
-    for(i = 0; i < __H_CAPACITY; i++) \
-        h->data[i] = NULL; \
+    h->capacity = __H_INITIAL_CAPACITY; \
+    h->length = h->usage = 0; \
+    h->data = __h_alloc_##T(h->capacity); \
     return h; \
 } \
 static hashtable_##T* hashtable_##T##_destroy(hashtable_##T *h) \
 { \
-    int i; \
-    hashtable_list_##T *p, *q; \
     logfile_message("hashtable_" #T "_destroy()"); \
-    for(i = 0; i < __H_CAPACITY; i++) { \
-        p = h->data[i]; \
-        while(p != NULL) { \
-            q = p->next; \
+    for(size_t i = 0; i < h->capacity; i++) { \
+        if(h->data[i].state == __H_ACTIVE) { \
+            h->data[i].state = __H_DELETED; \
             if(h->destructor != NULL) \
-                h->destructor(p->value); \
+                h->destructor(h->data[i].value); \
             if(h->key_delete != NULL) \
-                h->key_delete(p->key); \
-            free(p); \
-            p = q; \
+                h->key_delete(h->data[i].key); \
         } \
     } \
+    free(h->data); \
     free(h); \
     __h_unused_##T(); \
     return NULL; \
 } \
 static T* hashtable_##T##_find(const hashtable_##T *h, __H_CONST(KEY_TYPE) key) \
 { \
-    uint32_t k = __H_BUCKET(h, key); \
-    hashtable_list_##T *q = h->data[k]; \
-    while(q != NULL) { \
-        if(h->key_compare(q->key, key) == 0) \
-            return q->value; \
-        else \
-            q = q->next; \
-    } \
-    return NULL; \
+    size_t k = __h_locate_##T(h, key, __h_hash_##T(h, key)); \
+    return k < h->capacity ? h->data[k].value : NULL; \
 } \
 static void hashtable_##T##_add(hashtable_##T *h, __H_CONST(KEY_TYPE) key, T *value) \
 { \
-    if(NULL == hashtable_##T##_find(h, key)) { \
-        uint32_t k = __H_BUCKET(h, key); \
-        hashtable_list_##T *q; \
-        q = mallocx(sizeof *q); \
-        q->key = (h->key_clone != NULL) ? h->key_clone(key) : (KEY_TYPE)key; \
-        q->value = value; \
-        q->reference_count = 0;\
-        q->next = h->data[k]; \
-        h->data[k] = q; \
+    uint32_t hash = __h_hash_##T(h, key); \
+    if(__h_locate_##T(h, key, hash) == h->capacity) { \
+        size_t k, mask; \
+        if(h->usage + 1 > __H_MAX_USAGE(h->capacity)) { \
+            /* grow the table or just clear the deleted entries */ \
+            bool grow = (h->length + 1 > __H_MAX_USAGE(h->capacity) / 2); \
+            __h_rehash_##T(h, grow ? 2 * h->capacity : h->capacity); \
+        } \
+        mask = h->capacity - 1; \
+        k = hash & mask; \
+        while(h->data[k].state == __H_ACTIVE) /* reuse deleted entries */ \
+            k = (k + 1) & mask; \
+        if(h->data[k].state == __H_BLANK) \
+            h->usage++; \
+        h->data[k].key = (h->key_clone != NULL) ? h->key_clone(key) : (KEY_TYPE)key; \
+        h->data[k].value = value; \
+        h->data[k].hash = hash; \
+        h->data[k].reference_count = 0; \
+        h->data[k].state = __H_ACTIVE; \
+        h->length++; \
     } \
 } \
 static void hashtable_##T##_remove(hashtable_##T *h, __H_CONST(KEY_TYPE) key) \
 { \
-    uint32_t k = __H_BUCKET(h, key); \
-    hashtable_list_##T *p, *q; \
-    if(h->data[k] != NULL) { \
-        p = h->data[k]; \
-        if(h->key_compare(p->key, key) == 0) { \
-            if(p->reference_count <= 0) { \
-                h->data[k] = p->next; \
-                if(h->destructor != NULL) \
-                    h->destructor(p->value); \
-                if(h->key_delete != NULL) \
-                    h->key_delete(p->key); \
-                free(p); \
-            } \
-            else \
-                logfile_message("hashtable_" #T "_remove(): can't remove element with %d active references.", p->reference_count); \
-            return; \
-        } \
-        else { \
-            while(p->next != NULL) { \
-                if(h->key_compare(p->next->key, key) == 0) { \
-                    if(p->next->reference_count <= 0) { \
-                        q = p->next; \
-                        p->next = q->next; \
-                        if(h->destructor != NULL) \
-                            h->destructor(q->value); \
-                        if(h->key_delete != NULL) \
-                            h->key_delete(q->key); \
-                        free(q); \
-                    } \
-                    else \
-                        logfile_message("hashtable_" #T "_remove(): can't remove element with %d active references.", p->next->reference_count); \
-                    return; \
-                } \
-                p = p->next; \
-            } \
+    size_t k = __h_locate_##T(h, key, __h_hash_##T(h, key)); \
+    if(k < h->capacity) { \
+        if(h->data[k].reference_count <= 0) { \
+            /* lazy removal of the entry */ \
+            h->data[k].state = __H_DELETED; \
+            h->length--; \
+            if(h->destructor != NULL) \
+                h->destructor(h->data[k].value); \
+            if(h->key_delete != NULL) \
+                h->key_delete(h->data[k].key); \
         } \
+        else \
+            logfile_message("hashtable_" #T "_remove(): can't remove element with %d active references.", h->data[k].reference_count); \
     } \
 } \
 static int hashtable_##T##_foreach(hashtable_##T *h, void *data, void (*callback)(T*,void*)) \
 { \
-    int i, count = 0; \
-    hashtable_list_##T *p; \
-    for(i = 0; i < __H_CAPACITY; i++) { \
-        for(p = h->data[i]; p != NULL; p = p->next) { \
+    int count = 0; \
+    for(size_t i = 0; i < h->capacity; i++) { \
+        if(h->data[i].state == __H_ACTIVE) { \
             ++count; \
-            callback(p->value, data); \
+            callback(h->data[i].value, data); \
         } \
     } \
     return count; \
 } \
 static T* hashtable_##T##_findsome(hashtable_##T *h, void *data, bool (*test_fn)(T*,void*)) \
 { \
-    hashtable_list_##T *p; \
-    for(int i = 0; i < __H_CAPACITY; i++) { \
-        for(p = h->data[i]; p != NULL; p = p->next) { \
-            if(test_fn(p->value, data)) \
-                return p->value; \
+    for(size_t i = 0; i < h->capacity; i++) { \
+        if(h->data[i].state == __H_ACTIVE) { \
+            if(test_fn(h->data[i].value, data)) \
+                return h->data[i].value; \
         } \
     } \
     return NULL; \
 } \
 static int hashtable_##T##_ref(hashtable_##T *h, __H_CONST(KEY_TYPE) key) \
 { \
-    uint32_t k = __H_BUCKET(h, key); \
-    hashtable_list_##T *q = h->data[k]; \
-    while(q != NULL) { \
-        if(h->key_compare(q->key, key) == 0) \
-            return ++(q->reference_count); \
-        else \
-            q = q->next; \
-    } \
+    size_t k = __h_locate_##T(h, key, __h_hash_##T(h, key)); \
+    if(k < h->capacity) \
+        return ++(h->data[k].reference_count); \
     logfile_message("hashtable_" #T "_ref(): element does not exist."); \
     return 0; \
 } \
 static int hashtable_##T##_unref(hashtable_##T *h, __H_CONST(KEY_TYPE) key) \
 { \
-    uint32_t k = __H_BUCKET(h, key); \
-    hashtable_list_##T *q = h->data[k]; \
-    while(q != NULL) { \
-        if(h->key_compare(q->key, key) == 0) { \
-            q->reference_count = max(0, q->reference_count - 1); \
-            return q->reference_count; \
-        } \
-        else \
-            q = q->next; \
+    size_t k = __h_locate_##T(h, key, __h_hash_##T(h, key)); \
+    if(k < h->capacity) { \
+        h->data[k].reference_count = max(0, h->data[k].reference_count - 1); \
+        return h->data[k].reference_count; \
     } \
     logfile_message("hashtable_" #T "_unref(): element does not exist."); \
     return 0; \
 } \
 static int hashtable_##T##_refcount(const hashtable_##T *h, __H_CONST(KEY_TYPE) key) \
 { \
-    uint32_t k = __H_BUCKET(h, key); \
-    const hashtable_list_##T *q = h->data[k]; \
-    while(q != NULL) { \
-        if(h->key_compare(q->key, key) == 0) \
-            return q->reference_count; \
-        else \
-            q = q->next; \
-    } \
-    return 0; \
+    size_t k = __h_locate_##T(h, key, __h_hash_##T(h, key)); \
+    return k < h->capacity ? h->data[k].reference_count : 0; \
 } \
 static void hashtable_##T##_release_unreferenced_entries(hashtable_##T *h) \
 { \
-    /* TODO: improve the performance of this routine by using a queue
-             to store the unreferenced entries */ \
-    int i; \
-    hashtable_list_##T *q; \
-    for(i = 0; i < __H_CAPACITY; i++) { \
-        for(q = h->data[i]; q != NULL; q = q->next) { \
-            if(q->reference_count <= 0) { \
-                hashtable_##T##_remove(h, q->key); \
-                return; /* fast hack */ \
-            } \
+    /* removed entries are only marked as deleted, so it's safe to keep iterating */ \
+    for(size_t i = 0; i < h->capacity; i++) { \
+        if(h->data[i].state == __H_ACTIVE && h->data[i].reference_count <= 0) { \
+            h->data[i].state = __H_DELETED; \
+            h->length--; \
+            if(h->destructor != NULL) \
+                h->destructor(h->data[i].value); \
+            if(h->key_delete != NULL) \
+                h->key_delete(h->data[i].key); \
         } \
     } \
 } \
@@ -264,17 +286,24 @@ static uint32_t __h_hash_string_##T(const char *key) \
 { \
     uint32_t hash = 0; \
     while(*key) /* case-insensitive hash */ \
-        hash = tolower(*(key++)) + (hash << 6) + (hash << 16) - hash; \
+        hash = tolower((unsigned char)*(key++)) + (hash << 6) + (hash << 16) - hash; \
     return hash; \
 } \
 static int __h_compare_string_##T(const char *key1, const char *key2) \
 { \
-    /* case-insensitive comparison */ \
-    return str_icmp(key1, key2); \
+    /* case-insensitive comparison: key1 has been case-folded by __h_clone_string */ \
+    while(*key1 && *key1 == tolower((unsigned char)*key2)) { \
+        ++key1; \
+        ++key2; \
+    } \
+    return (unsigned char)*key1 - tolower((unsigned char)*key2); \
 } \
 static char* __h_clone_string_##T(const char *key) \
 { \
-    return strcpy(mallocx((1 + strlen(key)) * sizeof(char)), key); \
+    /* case folding */ \
+    char *clone = mallocx((1 + strlen(key)) * sizeof(char)), *p = clone; \
+    while((*(p++) = tolower((unsigned char)*(key++)))); \
+    return clone; \
 } \
 static void __h_delete_string_##T(char *key) \
 { \
@@ -286,7 +315,7 @@ static uint32_t __h_default_hash_key_##T(__H_CONST(KEY_TYPE) key) \
     const uint8_t* data = (const uint8_t*)key; \
     for(size_t j = 0; j < sizeof *key; j++) \
         hash = (uint32_t)(data[j]) + (hash << 6) + (hash << 16) - hash; \
-    return 0; \
+    return hash; \
 } \
 static int __h_default_compare_key_##T(__H_CONST(KEY_TYPE) key1, __H_CONST(KEY_TYPE) key2) \
 { \
@@ -27,6 +27,8 @@
 #include "assetfs.h"
 #include "util.h"
 #include "resourcemanager.h"
+#include "assetloader.h"
+#include "darray.h"
 
 #if defined(A5BUILD)
 
@@ -47,6 +49,10 @@ struct image_t {
 /* misc */
 static image_t* target = NULL; /* drawing target */
 static const int MAX_IMAGE_SIZE = 2048; /* maximum image size for broad compatibility with video cards */
+static void* decode_image(const char* fullpath); /* asynchronous loading */
+static void upload_image(const char* path, void* bitmap);
+static void prefetch_image(const char* path, void* bitmap);
+static bool read_pixels(ALLEGRO_BITMAP* bitmap, uint8_t* pixels);
 
 #else
 
@@ -84,8 +90,20 @@ static fast_getb_funptr fast_getb_fun(); /* returns a function */
 static image_t* _target = NULL;
 #define get_target() (_target ? _target : video_get_backbuffer())
 
+/* asynchronous loading */
+static void preload_image(const char* path, void* unused);
+static void prefetch_image(const char* path, void* unused);
+static bool read_image_size(const char* fullpath, int* width, int* height);
+
 #endif
 
+/* prefetching */
+static bool prefetching = false; /* will image_preload() prefetch images? */
+static size_t prefetch_budget = 0; /* how much memory (in bytes) the prefetched images may use */
+static size_t prefetch_usage = 0; /* how much memory (in bytes) the prefetched images use */
+STATIC_DARRAY(image_t*, prefetched_images); /* we keep a reference to each prefetched image */
+static bool pin_image(const char* path);
+
 /*
  * image_load()
  * Loads a image from a file.
@@ -98,7 +116,7 @@ image_t* image_load(const char* path)
 
     if(NULL == (img = resourcemanager_find_image(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("Loading image \"%s\"...", fullpath);
+        logfile_debug("Loading image \"%s\"...", fullpath);
 
         /* build the image object */
         img = mallocx(sizeof *img);
@@ -138,7 +156,7 @@ image_t* image_load(const char* path)
 
     if(NULL == (img = resourcemanager_find_image(path))) {
         const char* fullpath = assetfs_fullpath(path);
-        logfile_message("Loading image \"%s\"...", fullpath);
+        logfile_debug("Loading image \"%s\"...", fullpath);
 
         /* build the image object */
         img = mallocx(sizeof *img);
@@ -168,6 +186,77 @@ image_t* image_load(const char* path)
 #endif
 }
 
+/*
+ * image_preload()
+ * Loads an image asynchronously: it will be decoded on a worker thread
+ * and uploaded to the video card on the main thread (see assetloader.h).
+ * The image is then kept in the resource manager, so that a subsequent
+ * image_load() will find it there
+ */
+void image_preload(const char* path)
+{
+    if(prefetching) {
+        if(resourcemanager_peek_image(path) != NULL)
+            pin_image(path);
+#if defined(A5BUILD)
+        else
+            assetloader_prefetch(path, decode_image, prefetch_image);
+#else
+        else
+            assetloader_prefetch(path, NULL, prefetch_image);
+#endif
+    }
+    else if(resourcemanager_peek_image(path) == NULL) {
+#if defined(A5BUILD)
+        assetloader_enqueue(path, decode_image, upload_image);
+#else
+        assetloader_enqueue(path, NULL, preload_image);
+#endif
+    }
+}
+
+/*
+ * image_begin_prefetch()
+ * From now on, image_preload() will load the images with low priority
+ * and keep a reference to them, so that they stay in memory until
+ * image_release_prefetched() is called. The prefetched images won't
+ * use more than budget bytes
+ */
+void image_begin_prefetch(size_t budget)
+{
+    if(prefetched_images == NULL)
+        darray_init(prefetched_images);
+
+    prefetch_budget = budget;
+    prefetching = true;
+}
+
+/*
+ * image_end_prefetch()
+ * From now on, image_preload() will work as usual
+ */
+void image_end_prefetch()
+{
+    prefetching = false;
+}
+
+/*
+ * image_release_prefetched()
+ * Releases the references to the prefetched images
+ */
+void image_release_prefetched()
+{
+    if(prefetched_images == NULL)
+        return;
+
+    for(int i = 0; i < darray_length(prefetched_images); i++)
+        image_unload(prefetched_images[i]);
+
+    logfile_debug("Released %d prefetched images (%lu KB)", (int)darray_length(prefetched_images), (unsigned long)(prefetch_usage / 1024));
+    darray_release(prefetched_images);
+    prefetch_usage = 0;
+}
+
 
 
 /*
@@ -182,13 +271,13 @@ void image_save(const image_t* img, const char *path)
     if(al_save_bitmap(fullpath, img->data))
         logfile_message("Saved image to \"%s\"", fullpath);
     else
-        logfile_message("Failed to save image to \"%s\"", fullpath);
+        logfile_warning("Failed to save image to \"%s\"", fullpath);
 #else
     int i, j, c, bpp = video_get_color_depth();
     const char* fullpath = assetfs_create_cache_file(path);
     const char* extension = strrchr(fullpath, '.');
 
-    logfile_message("image_save(\"%s\")", fullpath);
+    logfile_debug("image_save(\"%s\")", fullpath);
 
     switch(bpp) {
         case 16:
@@ -247,7 +336,7 @@ image_t* image_create(int width, int height)
         al_restore_state(&state);
     }
     else
-        logfile_message("ERROR - image_create(%d,%d) failed", img->w, img->h);
+        logfile_error("ERROR - image_create(%d,%d) failed", img->w, img->h);
 
     return img;
 #else
@@ -261,7 +350,7 @@ image_t* image_create(int width, int height)
     if(img->data != NULL)
         clear_to_color(img->data, makecol(0,0,0));
     else
-        logfile_message("ERROR - image_create(%d,%d): couldn't create image", width, height);
+        logfile_error("ERROR - image_create(%d,%d): couldn't create image", width, height);
 
     return img;
 #endif
@@ -532,6 +621,133 @@ image_t* image_snapshot()
 #endif
 }
 
+/*
+ * image_snapshot_pixels()
+ * Copies the contents of the screen (the same as image_snapshot())
+ * to a newly allocated buffer of RGBA pixels, 8 bits per channel.
+ * Release it with free(). Returns NULL if the screen can't be read
+ */
+uint8_t* image_snapshot_pixels(int* width, int* height)
+{
+#if defined(A5BUILD)
+    ALLEGRO_BITMAP* screen = al_get_backbuffer(al_get_current_display());
+    uint8_t* pixels;
+
+    *width = al_get_bitmap_width(screen);
+    *height = al_get_bitmap_height(screen);
+    pixels = mallocx(4 * (*width) * (*height) * sizeof(*pixels));
+    if(!read_pixels(screen, pixels)) {
+        logfile_warning("Failed to take snapshot: can't read the screen");
+        free(pixels);
+        return NULL;
+    }
+
+    return pixels;
+#else
+    uint8_t* pixels = mallocx(4 * screen->w * screen->h * sizeof(*pixels));
+    uint8_t* p = pixels;
+
+    *width = screen->w;
+    *height = screen->h;
+    for(int y = 0; y < screen->h; y++) {
+        for(int x = 0; x < screen->w; x++) {
+            int c = getpixel(screen, x, y);
+            *(p++) = getr(c);
+            *(p++) = getg(c);
+            *(p++) = getb(c);
+            *(p++) = 255;
+        }
+    }
+
+    return pixels;
+#endif
+}
+
+/*
+ * image_read_pixels()
+ * Copies the contents of an image to a buffer of RGBA pixels,
+ * 8 bits per channel, of size 4 * width * height bytes.
+ * Returns false if the image can't be read
+ */
+bool image_read_pixels(const image_t* img, uint8_t* pixels)
+{
+#if defined(A5BUILD)
+    if(!read_pixels(img->data, pixels)) {
+        logfile_warning("Can't read the pixels of a %d x %d image", img->w, img->h);
+        return false;
+    }
+
+    return true;
+#else
+    uint8_t* p = pixels;
+
+    for(int y = 0; y < img->h; y++) {
+        for(int x = 0; x < img->w; x++) {
+            int c = getpixel(img->data, x, y);
+            *(p++) = getr(c);
+            *(p++) = getg(c);
+            *(p++) = getb(c);
+            *(p++) = 255;
+        }
+    }
+
+    return true;
+#endif
+}
+
+/*
+ * image_save_pixels()
+ * Saves a buffer of RGBA pixels (8 bits per channel) to a file
+ * given its absolute path. Unlike image_save(), this doesn't
+ * touch the video card, so it may be called from any thread
+ * (Allegro 5 only). Returns true on success
+ */
+bool image_save_pixels(const uint8_t* pixels, int width, int height, const char* fullpath)
+{
+#if defined(A5BUILD)
+    ALLEGRO_STATE state;
+    ALLEGRO_BITMAP* bitmap;
+    ALLEGRO_LOCKED_REGION* region;
+    bool success = false;
+
+    /* create a memory bitmap */
+    al_store_state(&state, ALLEGRO_STATE_NEW_BITMAP_PARAMETERS);
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    al_set_new_bitmap_format(ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE);
+    bitmap = al_create_bitmap(width, height);
+    al_restore_state(&state);
+    if(bitmap == NULL)
+        return false;
+
+    /* copy the pixels and save the bitmap */
+    if(NULL != (region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY))) {
+        for(int y = 0; y < height; y++)
+            memcpy((uint8_t*)region->data + y * region->pitch, pixels + y * width * 4, width * 4);
+        al_unlock_bitmap(bitmap);
+        success = al_save_bitmap(fullpath, bitmap);
+    }
+
+    al_destroy_bitmap(bitmap);
+    return success;
+#else
+    BITMAP* bitmap;
+    const uint8_t* p = pixels;
+    bool success;
+
+    if(NULL == (bitmap = create_bitmap_ex(32, width, height)))
+        return false;
+
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++, p += 4)
+            putpixel(bitmap, x, y, makeacol32(p[0], p[1], p[2], p[3]));
+    }
+
+    success = (save_bitmap(fullpath, bitmap, NULL) == 0);
+    destroy_bitmap(bitmap);
+    return success;
+#endif
+}
+
 /*
  * image_lock()
  * Locks the image, enabling fast in-memory pixel access
@@ -982,7 +1198,140 @@ image_t* image_drawing_target()
 
 
 /* private methods */
-#if !defined(A5BUILD)
+#if defined(A5BUILD)
+
+/* decodes an image into a memory bitmap (runs on a worker thread) */
+void* decode_image(const char* fullpath)
+{
+    ALLEGRO_BITMAP* bitmap;
+
+    /* bitmap flags are thread-local */
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    if(NULL != (bitmap = al_load_bitmap(fullpath)))
+        al_convert_mask_to_alpha(bitmap, al_map_rgb(255, 0, 255));
+
+    return bitmap;
+}
+
+/* uploads a decoded image to the video card and stores it in the resource manager (runs on the main thread) */
+void upload_image(const char* path, void* bitmap)
+{
+    ALLEGRO_BITMAP* data = (ALLEGRO_BITMAP*)bitmap;
+    image_t* img;
+
+    /* image_load() will report the error */
+    if(data == NULL)
+        return;
+
+    /* discard the image if it's already loaded or if it's invalid */
+    if(resourcemanager_peek_image(path) != NULL || al_get_bitmap_width(data) > MAX_IMAGE_SIZE || al_get_bitmap_height(data) > MAX_IMAGE_SIZE) {
+        al_destroy_bitmap(data);
+        return;
+    }
+
+    /* upload to the video card */
+    logfile_debug("Loaded image \"%s\" asynchronously", path);
+    al_convert_bitmap(data);
+
+    /* adding the image to the resource manager */
+    img = mallocx(sizeof *img);
+    img->data = data;
+    img->w = al_get_bitmap_width(data);
+    img->h = al_get_bitmap_height(data);
+    img->path = str_dup(path);
+    resourcemanager_add_image(img->path, img);
+}
+
+/* uploads a prefetched image, if it fits the budget, and keeps a reference to it (runs on the main thread) */
+void prefetch_image(const char* path, void* bitmap)
+{
+    ALLEGRO_BITMAP* data = (ALLEGRO_BITMAP*)bitmap;
+    size_t size;
+
+    if(data == NULL)
+        return;
+
+    /* check the budget before uploading to the video card */
+    size = 4 * (size_t)al_get_bitmap_width(data) * (size_t)al_get_bitmap_height(data);
+    if(prefetch_usage + size > prefetch_budget) {
+        logfile_debug("Won't prefetch image \"%s\": out of budget", path);
+        al_destroy_bitmap(data);
+        return;
+    }
+
+    upload_image(path, data);
+    if(resourcemanager_peek_image(path) != NULL)
+        pin_image(path);
+}
+
+/* copies the pixels of a bitmap to a RGBA buffer. Returns false on error */
+bool read_pixels(ALLEGRO_BITMAP* bitmap, uint8_t* pixels)
+{
+    int width = al_get_bitmap_width(bitmap), height = al_get_bitmap_height(bitmap);
+    ALLEGRO_LOCKED_REGION* region;
+
+    if(NULL == (region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY)))
+        return false;
+
+    for(int y = 0; y < height; y++)
+        memcpy(pixels + y * width * 4, (const uint8_t*)region->data + y * region->pitch, width * 4);
+
+    al_unlock_bitmap(bitmap);
+    return true;
+}
+#else
+
+/* loads an image on the main thread and keeps it in the resource manager */
+void preload_image(const char* path, void* unused)
+{
+    if(resourcemanager_peek_image(path) == NULL)
+        image_unload(image_load(path));
+}
+
+/* loads an image on the main thread and keeps a reference to it, if it fits the budget */
+void prefetch_image(const char* path, void* unused)
+{
+    int width, height;
+    bool fits;
+
+    /* check the budget before decoding the image. If we can't
+       read its size, we only check if the budget is exhausted */
+    if(read_image_size(assetfs_fullpath(path), &width, &height))
+        fits = (prefetch_usage + 4 * (size_t)width * (size_t)height <= prefetch_budget);
+    else
+        fits = (prefetch_usage < prefetch_budget);
+
+    if(!fits) {
+        logfile_debug("Won't prefetch image \"%s\": out of budget", path);
+        return;
+    }
+
+    preload_image(path, NULL);
+    pin_image(path);
+}
+
+/* reads the dimensions of a PNG image from its header. Returns false
+   if the file can't be read or if it's in some other format */
+bool read_image_size(const char* fullpath, int* width, int* height)
+{
+    static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t header[24];
+    FILE* fp;
+
+    if(NULL == (fp = fopen(fullpath, "rb")))
+        return false;
+
+    if(1 != fread(header, sizeof(header), 1, fp) || 0 != memcmp(header, signature, sizeof(signature)) || 0 != memcmp(header + 12, "IHDR", 4)) {
+        fclose(fp);
+        return false;
+    }
+
+    /* the IHDR chunk comes first; its fields are big-endian */
+    *width = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    *height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    fclose(fp);
+    return *width > 0 && *height > 0;
+}
 
 /*
  * maskcolor_bugfix()
@@ -1094,4 +1443,36 @@ fast_getb_funptr fast_getb_fun()
     }
 }
 
-#endif
\ No newline at end of file
+#endif
+
+
+
+/* prefetching */
+
+/* keeps a reference to an image of the resource manager, if it fits the budget */
+bool pin_image(const char* path)
+{
+    image_t* img = resourcemanager_peek_image(path);
+    size_t size;
+
+    if(img == NULL || prefetched_images == NULL)
+        return false;
+
+    /* already pinned? */
+    for(int i = 0; i < darray_length(prefetched_images); i++) {
+        if(prefetched_images[i] == img)
+            return true;
+    }
+
+    /* check the budget */
+    size = 4 * (size_t)image_width(img) * (size_t)image_height(img);
+    if(prefetch_usage + size > prefetch_budget) {
+        logfile_debug("Won't prefetch image \"%s\": out of budget", path);
+        return false;
+    }
+
+    /* keep a reference */
+    prefetch_usage += size;
+    darray_push(prefetched_images, image_load(path));
+    return true;
+}
@@ -21,6 +21,9 @@
 #ifndef _IMAGE_H
 #define _IMAGE_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "color.h"
 #include "v2d.h"
 
@@ -36,6 +39,10 @@ typedef enum imageflags_t {
 
 /* image management */
 image_t* image_load(const char* path); /* will be unloaded automatically */
+void image_preload(const char* path); /* loads an image asynchronously; see assetloader.h */
+void image_begin_prefetch(size_t budget); /* image_preload() will prefetch images, keeping them in memory within a budget (in bytes) */
+void image_end_prefetch(); /* image_preload() will work as usual */
+void image_release_prefetched(); /* releases the prefetched images */
 image_t* image_create(int width, int height); /* create a memory surface */
 image_t* image_create_shared(const image_t* parent, int x, int y, int width, int height); /* creates a shared sub-image */
 void image_destroy(image_t* img); /* call this after image_create() */
@@ -48,6 +55,9 @@ void image_save(const image_t* img, const char *path); /* saves the image to a f
 image_t* image_clone(const image_t* src); /* clones an image */
 image_t* image_clone_region(const image_t* src, int x, int y, int width, int height); /* clones a region */
 image_t* image_snapshot(); /* take a snapshot */
+uint8_t* image_snapshot_pixels(int* width, int* height); /* take a snapshot as a RGBA buffer; free() it after usage */
+bool image_read_pixels(const image_t* img, uint8_t* pixels); /* copies the image to a RGBA buffer of 4 * width * height bytes; false on error */
+bool image_save_pixels(const uint8_t* pixels, int width, int height, const char* fullpath); /* saves a RGBA buffer; may be called from any thread */
 
 /* pixel manipulation */
 void image_lock(image_t* img);
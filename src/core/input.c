@@ -30,6 +30,7 @@
 #include "logfile.h"
 #include "timer.h"
 #include "inputmap.h"
+#include "inputrecorder.h"
 #include "stringutil.h"
 
 /* <base class>: generic input */
@@ -208,6 +209,9 @@ void input_update()
     a5_mouse.z = state.z;
     a5_mouse.b = a5_mouse_b; /* received from the event queue */
 
+    /* record or replay the input */
+    inputrecorder_update();
+
     /* updating the input objects */
     for(input_list_t* it = inlist; it; it = it->next) {
         for(int i = 0; i < IB_MAX; i++)
@@ -229,6 +233,9 @@ void input_update()
     if(input_is_joystick_enabled())
         poll_joystick();
 
+    /* record or replay the input */
+    inputrecorder_update();
+
     /* updating input objects */
     for(it = inlist; it; it=it->next) {
 
@@ -704,6 +711,9 @@ void inputuserdefined_update(input_t* in)
         in->state[IB_FIRE8] = in->state[IB_FIRE8] || ((joy[k].num_buttons > im->joystick.button[IB_FIRE8]) && joy[k].button[ im->joystick.button[IB_FIRE8] ].b);
     }
 #endif
+
+    /* record or replay the input */
+    inputrecorder_process(((inputuserdefined_t*)in)->inputmap->name, in->state);
 }
 
 #if defined(A5BUILD)
@@ -32,6 +32,7 @@
 #include "assetfs.h"
 #include "hashtable.h"
 #include "nanoparser/nanoparser.h"
+#include "parsecache.h"
 
 /* storage */
 typedef struct inputmapnode_t inputmapnode_t;
@@ -741,12 +742,11 @@ int traverse_inputmap_joystick(const parsetree_statement_t *stmt, void *inputmap
 void load_inputmap_table()
 {
     parsetree_program_t *s = NULL;
-    const char* fullpath = assetfs_fullpath(INPUTMAP_FILE);
 
     logfile_message("inputmap: loading the input mappings...");
     hashtable_inputmapnode_t_add(mappings, NULL_INPUTMAP, inputmapnode_create(NULL_INPUTMAP));
 
-    s = nanoparser_construct_tree(fullpath);
+    s = parsecache_construct_tree(INPUTMAP_FILE);
     nanoparser_traverse_program(s, traverse);
     s = nanoparser_deconstruct_tree(s);
 }
@@ -0,0 +1,397 @@
+/*
+ * Open Surge Engine
+ * inputrecorder.c - deterministic input recording & replay
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "inputrecorder.h"
+#include "input.h"
+#include "timer.h"
+#include "logfile.h"
+#include "stringutil.h"
+#include "util.h"
+
+/*
+   input recording file format (little-endian):
+
+   header:      magic[8] | format u32 | seed u32
+   frames:      change count u8 | { device u8 | buttons u16 } x change count
+
+   a frame lists the devices whose buttons have changed since the
+   previous frame. buttons is a bitmask (bit i is inputbutton_t i).
+   If device is the number of devices seen so far, a new device is
+   being introduced and it's followed by: name length u8 | name
+*/
+#define INPUTRECORDER_MAGIC     "SURGEINP"
+#define INPUTRECORDER_FORMAT    1 /* increment whenever the format changes */
+#define HEADER_SIZE             16
+#define MAX_DEVICES             255
+static const float TIMESTEP = 1.0f / 60.0f; /* fixed timestep, in seconds */
+
+/* private stuff */
+typedef enum { IDLE, RECORDING, REPLAYING } recordermode_t;
+static recordermode_t mode = IDLE;
+static bool suspended = true; /* nothing happens until a level is loaded */
+static bool frame_open = false; /* is the current frame being recorded/replayed? */
+static uint32_t seed = 0;
+static uint32_t frame_count = 0;
+
+/* the devices, identified by the name of their input map */
+static char* device_name[MAX_DEVICES];
+static uint16_t device_buttons[MAX_DEVICES]; /* current state */
+static int device_count = 0;
+
+/* recording */
+static FILE* record_file = NULL;
+static uint8_t changes[MAX_DEVICES * (4 + 255)]; /* changes of the current frame */
+static int changes_size = 0, change_count = 0;
+
+/* replaying */
+static uint8_t* replay_data = NULL;
+static size_t replay_size = 0, replay_offset = 0;
+
+static int find_device(const char* name);
+static int add_device(const char* name, uint16_t mask);
+static bool read_replay(const char* filepath);
+static bool read_frame();
+static void write_frame();
+static inline uint16_t buttons_to_mask(const bool state[]);
+static inline void mask_to_buttons(uint16_t mask, bool state[]);
+
+
+
+/* public API */
+
+/*
+ * inputrecorder_init()
+ * Initializes the input recorder. If record_filepath
+ * is not NULL, the input will be recorded to that file.
+ * If replay_filepath is not NULL, a recording will be
+ * replayed. Replaying takes precedence over recording.
+ */
+void inputrecorder_init(const char* record_filepath, const char* replay_filepath)
+{
+    mode = IDLE;
+    suspended = true;
+    frame_open = false;
+    frame_count = 0;
+    device_count = 0;
+    changes_size = change_count = 0;
+
+    if(replay_filepath != NULL) {
+        if(read_replay(replay_filepath)) {
+            logfile_message("Replaying input from \"%s\" (seed: %u)", replay_filepath, seed);
+            mode = REPLAYING;
+        }
+        else
+            logfile_message("Can't replay \"%s\": invalid file", replay_filepath);
+    }
+    else if(record_filepath != NULL) {
+        uint8_t header[HEADER_SIZE];
+        seed = (uint32_t)time(NULL);
+
+        if(NULL != (record_file = fopen(record_filepath, "wb"))) {
+            memcpy(header, INPUTRECORDER_MAGIC, 8);
+            cpu_to_le32(INPUTRECORDER_FORMAT, header + 8);
+            cpu_to_le32(seed, header + 12);
+            fwrite(header, sizeof(header), 1, record_file);
+            logfile_message("Recording input to \"%s\" (seed: %u)", record_filepath, seed);
+            mode = RECORDING;
+        }
+        else
+            logfile_message("Can't open \"%s\" for writing", record_filepath);
+    }
+
+    /* reproducible runs need a fixed timestep */
+    if(mode != IDLE)
+        timer_set_fixed_timestep(TIMESTEP);
+}
+
+/*
+ * inputrecorder_release()
+ * Releases the input recorder, closing the files
+ */
+void inputrecorder_release()
+{
+    if(mode == RECORDING) {
+        if(frame_open)
+            write_frame();
+        if(fclose(record_file) != 0)
+            logfile_message("Can't write the input recording");
+        else
+            logfile_message("Recorded %u frames of input", frame_count);
+        record_file = NULL;
+    }
+
+    if(replay_data != NULL) {
+        free(replay_data);
+        replay_data = NULL;
+    }
+
+    for(int i = 0; i < device_count; i++)
+        free(device_name[i]);
+    device_count = 0;
+
+    mode = IDLE;
+}
+
+/*
+ * inputrecorder_update()
+ * Starts a new frame. Call it before updating the input devices
+ */
+void inputrecorder_update()
+{
+    if(mode == RECORDING) {
+        /* write the previous frame */
+        if(frame_open)
+            write_frame();
+        frame_open = !suspended;
+    }
+    else if(mode == REPLAYING) {
+        /* read the current frame */
+        frame_open = !suspended;
+        if(frame_open && !read_frame()) {
+            logfile_message("Finished replaying %u frames of input", frame_count);
+            frame_open = false;
+            mode = IDLE;
+        }
+    }
+
+    if(frame_open)
+        frame_count++;
+}
+
+/*
+ * inputrecorder_process()
+ * Records the state of a device given the name of its input
+ * map or, if a replay is in progress, overwrites its state
+ */
+void inputrecorder_process(const char* inputmap_name, bool state[])
+{
+    int id;
+
+    if(mode == RECORDING) {
+        uint16_t mask = buttons_to_mask(state);
+
+        if(!frame_open || change_count >= 255)
+            return;
+        else if((id = find_device(inputmap_name)) < 0)
+            add_device(inputmap_name, mask);
+        else if(mask != device_buttons[id]) {
+            device_buttons[id] = mask;
+            changes[changes_size++] = id;
+            changes[changes_size++] = mask & 0xFF;
+            changes[changes_size++] = mask >> 8;
+            change_count++;
+        }
+    }
+    else if(mode == REPLAYING) {
+        /* the live input is ignored */
+        id = frame_open ? find_device(inputmap_name) : -1;
+        mask_to_buttons(id >= 0 ? device_buttons[id] : 0, state);
+    }
+}
+
+/*
+ * inputrecorder_suspend()
+ * Frames are neither recorded nor replayed while suspended
+ */
+void inputrecorder_suspend()
+{
+    suspended = true;
+}
+
+/*
+ * inputrecorder_resume()
+ * Resumes recording / replaying. The random number
+ * generators are reseeded, so that each level starts
+ * from the same state
+ */
+void inputrecorder_resume()
+{
+    if(mode != IDLE)
+        random_seed(seed);
+
+    suspended = false;
+}
+
+/*
+ * inputrecorder_is_recording()
+ * Are we recording?
+ */
+bool inputrecorder_is_recording()
+{
+    return mode == RECORDING;
+}
+
+/*
+ * inputrecorder_is_replaying()
+ * Is there a replay in progress?
+ */
+bool inputrecorder_is_replaying()
+{
+    return mode == REPLAYING;
+}
+
+
+
+/* private */
+
+/* finds a device by name. Returns -1 if there's no such device */
+int find_device(const char* name)
+{
+    for(int i = 0; i < device_count; i++) {
+        if(strcmp(device_name[i], name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/* adds a new device to the recording. Returns -1 if there's no room */
+int add_device(const char* name, uint16_t mask)
+{
+    size_t length = strlen(name);
+
+    if(device_count >= MAX_DEVICES || length > 255)
+        return -1;
+
+    changes[changes_size++] = device_count;
+    changes[changes_size++] = mask & 0xFF;
+    changes[changes_size++] = mask >> 8;
+    changes[changes_size++] = length;
+    memcpy(changes + changes_size, name, length);
+    changes_size += length;
+    change_count++;
+
+    device_name[device_count] = str_dup(name);
+    device_buttons[device_count] = mask;
+    return device_count++;
+}
+
+/* writes the changes of the current frame to the file */
+void write_frame()
+{
+    uint8_t count = change_count;
+
+    fwrite(&count, 1, 1, record_file);
+    if(changes_size > 0)
+        fwrite(changes, changes_size, 1, record_file);
+
+    changes_size = change_count = 0;
+}
+
+/* reads the next frame of the replay, updating the devices. Returns false at the end */
+bool read_frame()
+{
+    int count;
+
+    if(replay_offset >= replay_size)
+        return false;
+
+    count = replay_data[replay_offset++];
+    while(count-- > 0) {
+        int id;
+        uint16_t mask;
+
+        if(replay_offset + 3 > replay_size)
+            return false;
+
+        id = replay_data[replay_offset];
+        mask = replay_data[replay_offset + 1] | (replay_data[replay_offset + 2] << 8);
+        replay_offset += 3;
+
+        /* a new device */
+        if(id == device_count && id < MAX_DEVICES) {
+            size_t length;
+            if(replay_offset >= replay_size || replay_offset + 1 + (length = replay_data[replay_offset]) > replay_size)
+                return false;
+            device_name[device_count] = mallocx((length + 1) * sizeof(char));
+            memcpy(device_name[device_count], replay_data + replay_offset + 1, length);
+            device_name[device_count][length] = '\0';
+            device_count++;
+            replay_offset += 1 + length;
+        }
+        else if(id > device_count)
+            return false;
+
+        device_buttons[id] = mask;
+    }
+
+    return true;
+}
+
+/* reads a recording into memory */
+bool read_replay(const char* filepath)
+{
+    FILE* fp;
+    long size;
+    bool success;
+
+    if(NULL == (fp = fopen(filepath, "rb")))
+        return false;
+
+    /* read the whole file */
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(size < HEADER_SIZE) {
+        fclose(fp);
+        return false;
+    }
+    replay_data = mallocx(size);
+    replay_size = size;
+    success = (fread(replay_data, replay_size, 1, fp) == 1);
+    fclose(fp);
+
+    /* validate the header */
+    success = success && (memcmp(replay_data, INPUTRECORDER_MAGIC, 8) == 0);
+    success = success && (le32_to_cpu(replay_data + 8) == INPUTRECORDER_FORMAT);
+    if(!success) {
+        free(replay_data);
+        replay_data = NULL;
+        return false;
+    }
+
+    seed = le32_to_cpu(replay_data + 12);
+    replay_offset = HEADER_SIZE;
+    return true;
+}
+
+/* converts button states to a bitmask */
+uint16_t buttons_to_mask(const bool state[])
+{
+    uint16_t mask = 0;
+
+    for(int i = 0; i < IB_MAX; i++)
+        mask |= state[i] ? (1 << i) : 0;
+
+    return mask;
+}
+
+/* converts a bitmask to button states */
+void mask_to_buttons(uint16_t mask, bool state[])
+{
+    for(int i = 0; i < IB_MAX; i++)
+        state[i] = (mask >> i) & 1;
+}
@@ -0,0 +1,51 @@
+/*
+ * Open Surge Engine
+ * inputrecorder.h - deterministic input recording & replay
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _INPUTRECORDER_H
+#define _INPUTRECORDER_H
+
+#include <stdbool.h>
+
+/*
+   The input recorder writes the per-frame button states of
+   the user-defined input devices (keyed by the name of their
+   input map) and a seed for the random number generators to
+   a compact file. A replay feeds them back into the devices.
+
+   The game runs at a fixed timestep while recording or
+   replaying, and the recorder is suspended while a level is
+   being loaded, so that the run doesn't depend on how long
+   the loading takes. The first frame is the first frame of
+   the level that finishes loading first (see --level).
+*/
+
+void inputrecorder_init(const char* record_filepath, const char* replay_filepath); /* both may be NULL */
+void inputrecorder_release();
+void inputrecorder_update(); /* call once per frame, before the input devices are updated */
+void inputrecorder_process(const char* inputmap_name, bool state[]); /* records (or replays) the state of a device */
+
+void inputrecorder_suspend(); /* stop counting frames (e.g., while a level is being loaded) */
+void inputrecorder_resume(); /* count frames again; reseeds the random number generators */
+
+bool inputrecorder_is_recording(); /* are we recording? */
+bool inputrecorder_is_replaying(); /* is there a replay in progress? */
+
+#endif
@@ -0,0 +1,678 @@
+/*
+ * Open Surge Engine
+ * jobs.c - job system
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "jobs.h"
+#include "logfile.h"
+#include "darray.h"
+#include "util.h"
+
+#if defined(A5BUILD)
+#include <allegro5/allegro.h>
+#endif
+
+/* a job */
+struct job_t
+{
+    void (*fun)(void*); /* runs on a worker thread */
+    void* data;
+    void (*callback)(void*); /* runs on the main thread (may be NULL) */
+    void* callback_data;
+    int pending; /* number of unfinished dependencies, plus one while the job isn't submitted */
+    int refs; /* reference count: the handle, the scheduler and the jobs it depends on */
+    bool submitted;
+    bool finished;
+    DARRAY(job_t*, dependents); /* jobs that depend on this one */
+    job_t* next; /* completion queue */
+};
+
+/* the queue of a worker thread: the owner takes the most recent
+   jobs (back) and the other threads steal the oldest ones (front) */
+typedef struct jobqueue_t jobqueue_t;
+struct jobqueue_t
+{
+    job_t** job; /* circular buffer */
+    int capacity;
+    int head; /* index of the first job */
+    int count; /* number of jobs */
+#if defined(A5BUILD)
+    ALLEGRO_MUTEX* mutex;
+#endif
+};
+
+/* a range of iterations of a parallel for */
+typedef struct parallelfor_t parallelfor_t;
+struct parallelfor_t
+{
+    void (*fun)(int,void*);
+    void* data;
+    int count; /* number of iterations */
+    int next; /* next iteration to be taken */
+    int grain; /* number of iterations taken at a time */
+};
+
+/* private data */
+#define MAX_THREADS         16 /* maximum number of worker threads */
+#define QUEUE_CAPACITY      64 /* initial capacity of the queues */
+static int thread_count = 0; /* number of worker threads */
+static jobqueue_t queue[MAX_THREADS]; /* one per worker thread */
+static int next_queue = 0; /* jobs submitted by other threads are distributed among the queues */
+static int queued_count = 0; /* number of jobs in the queues */
+static int active_count = 0; /* number of submitted jobs that haven't finished */
+static int running_count = 0; /* number of jobs taken from the queues (or about to run) that haven't finished */
+static job_t* first_completed = NULL; /* completion queue (FIFO) */
+static job_t* last_completed = NULL;
+static bool initialized = false;
+static void schedule_job(job_t* job, int worker_id);
+static job_t* take_job(int worker_id);
+static void run_job(job_t* job, int worker_id);
+static void wait_for(const job_t* job);
+static void release_job(job_t* job);
+static job_t* destroy_job(job_t* job);
+static void run_range(void* range);
+static void init_queue(jobqueue_t* q);
+static void release_queue(jobqueue_t* q);
+static void push_back(jobqueue_t* q, job_t* job);
+static job_t* pop_back(jobqueue_t* q);
+static job_t* pop_front(jobqueue_t* q);
+
+#if defined(A5BUILD)
+static ALLEGRO_THREAD* worker[MAX_THREADS] = { NULL };
+static ALLEGRO_MUTEX* mutex = NULL; /* protects the job graph, the counters and the completion queue */
+static ALLEGRO_COND* cond = NULL; /* signaled when a job is queued or finishes */
+static void* worker_thread(ALLEGRO_THREAD* thread, void* arg);
+#define LOCK()              do { if(mutex != NULL) al_lock_mutex(mutex); } while(0)
+#define UNLOCK()            do { if(mutex != NULL) al_unlock_mutex(mutex); } while(0)
+#define WAIT()              al_wait_cond(cond, mutex)
+#define BROADCAST()         do { if(cond != NULL) al_broadcast_cond(cond); } while(0)
+#define LOCK_QUEUE(q)       al_lock_mutex((q)->mutex)
+#define UNLOCK_QUEUE(q)     al_unlock_mutex((q)->mutex)
+#else
+#define LOCK()              ((void)0) /* no worker threads */
+#define UNLOCK()            ((void)0)
+#define WAIT()              ((void)0)
+#define BROADCAST()         ((void)0)
+#define LOCK_QUEUE(q)       ((void)0)
+#define UNLOCK_QUEUE(q)     ((void)0)
+#endif
+
+
+
+/* public API */
+
+/*
+ * jobs_init()
+ * Initializes the job system and spawns the worker threads.
+ * If thread_count is zero, the jobs run on the thread that
+ * submits them, in a deterministic order. If it's negative,
+ * one worker per additional CPU core is spawned
+ */
+void jobs_init(int thread_count_hint)
+{
+    if(initialized)
+        return;
+
+#if defined(A5BUILD)
+    if(thread_count_hint < 0) {
+        int cpu_count = al_get_cpu_count();
+        thread_count_hint = (cpu_count > 1) ? cpu_count - 1 : 1; /* the main thread helps while it waits */
+    }
+    thread_count = clip(thread_count_hint, 0, MAX_THREADS);
+#else
+    thread_count = 0;
+#endif
+
+    logfile_message("jobs_init(): %d worker threads", thread_count);
+    first_completed = last_completed = NULL;
+    queued_count = active_count = running_count = 0;
+    next_queue = 0;
+
+#if defined(A5BUILD)
+    mutex = al_create_mutex();
+    cond = al_create_cond();
+    if(mutex == NULL || cond == NULL)
+        fatal_error("jobs_init(): can't create synchronization primitives");
+
+    for(int i = 0; i < thread_count; i++)
+        init_queue(&queue[i]);
+
+    for(int i = 0; i < thread_count; i++) {
+        if(NULL == (worker[i] = al_create_thread(worker_thread, (void*)(intptr_t)i)))
+            fatal_error("jobs_init(): can't create worker thread");
+        al_start_thread(worker[i]);
+    }
+#endif
+
+    initialized = true;
+}
+
+/*
+ * jobs_release()
+ * Waits for the submitted jobs, runs their completion
+ * callbacks and stops the worker threads
+ */
+void jobs_release()
+{
+    if(!initialized)
+        return;
+
+    logfile_message("jobs_release()");
+    wait_for(NULL);
+
+#if defined(A5BUILD)
+    /* stop the workers */
+    LOCK();
+    for(int i = 0; i < thread_count; i++)
+        al_set_thread_should_stop(worker[i]);
+    BROADCAST();
+    UNLOCK();
+
+    for(int i = 0; i < thread_count; i++) {
+        al_join_thread(worker[i], NULL);
+        al_destroy_thread(worker[i]);
+        worker[i] = NULL;
+    }
+#endif
+
+    /* run the pending callbacks */
+    jobs_update();
+
+    for(int i = 0; i < thread_count; i++)
+        release_queue(&queue[i]);
+    thread_count = 0;
+
+#if defined(A5BUILD)
+    al_destroy_cond(cond);
+    al_destroy_mutex(mutex);
+    cond = NULL;
+    mutex = NULL;
+#endif
+
+    initialized = false;
+}
+
+/*
+ * jobs_update()
+ * Runs the completion callbacks of the jobs that have
+ * finished. Call it once per frame on the main thread
+ */
+void jobs_update()
+{
+    job_t* job;
+
+    LOCK();
+    job = first_completed;
+    first_completed = last_completed = NULL;
+    UNLOCK();
+
+    while(job != NULL) {
+        job_t* next = job->next;
+        job->callback(job->callback_data);
+        release_job(job);
+        job = next;
+    }
+}
+
+/*
+ * jobs_thread_count()
+ * The number of worker threads
+ */
+int jobs_thread_count()
+{
+    return thread_count;
+}
+
+/*
+ * jobs_create()
+ * Creates a job that calls fun(data). It won't
+ * run until it's submitted
+ */
+job_t* jobs_create(void (*fun)(void*), void* data)
+{
+    job_t* job = mallocx(sizeof *job);
+
+    job->fun = fun;
+    job->data = data;
+    job->callback = NULL;
+    job->callback_data = NULL;
+    job->pending = 1;
+    job->refs = 1;
+    job->submitted = false;
+    job->finished = false;
+    darray_init(job->dependents);
+    job->next = NULL;
+
+    return job;
+}
+
+/*
+ * jobs_destroy()
+ * Releases the handle of a job. If the job has been
+ * submitted, it will still run
+ */
+job_t* jobs_destroy(job_t* job)
+{
+    if(job != NULL)
+        release_job(job);
+
+    return NULL;
+}
+
+/*
+ * jobs_depend()
+ * The job will only run after the dependency finishes.
+ * Call this before submitting the job
+ */
+void jobs_depend(job_t* job, job_t* dependency)
+{
+    if(job->submitted)
+        fatal_error("jobs_depend(): the job has already been submitted");
+
+    LOCK();
+    if(!dependency->finished) {
+        darray_push(dependency->dependents, job);
+        job->pending++;
+        job->refs++;
+    }
+    UNLOCK();
+}
+
+/*
+ * jobs_on_complete()
+ * Sets a callback that runs on the main thread, during
+ * jobs_update(), after the job finishes. Call this
+ * before submitting the job
+ */
+void jobs_on_complete(job_t* job, void (*callback)(void*), void* data)
+{
+    if(job->submitted)
+        fatal_error("jobs_on_complete(): the job has already been submitted");
+
+    job->callback = callback;
+    job->callback_data = data;
+}
+
+/*
+ * jobs_submit()
+ * Schedules a job. It runs as soon as its dependencies
+ * finish. Without worker threads, it may run right away
+ */
+void jobs_submit(job_t* job)
+{
+    bool ready;
+
+    if(job->submitted)
+        return;
+
+    LOCK();
+    job->submitted = true;
+    job->refs++; /* the scheduler holds a reference until the job finishes */
+    active_count++;
+    ready = (--job->pending == 0);
+    UNLOCK();
+
+    if(ready)
+        schedule_job(job, -1);
+}
+
+/*
+ * jobs_wait()
+ * Waits for a job to finish, submitting it if necessary.
+ * Meanwhile, the calling thread runs other queued jobs
+ */
+void jobs_wait(job_t* job)
+{
+    jobs_submit(job);
+    wait_for(job);
+}
+
+/*
+ * jobs_is_finished()
+ * Has the job finished?
+ */
+bool jobs_is_finished(const job_t* job)
+{
+    bool finished;
+
+    LOCK();
+    finished = job->finished;
+    UNLOCK();
+
+    return finished;
+}
+
+/*
+ * jobs_parallel_for()
+ * Calls fun(i, data) for 0 <= i < count. The iterations are split among
+ * the worker threads and the calling thread, in no particular order.
+ * Without worker threads, they run in order. Returns when all are done
+ */
+void jobs_parallel_for(int count, void (*fun)(int,void*), void* data)
+{
+    parallelfor_t range = { fun, data, count, 0, 1 };
+    job_t* helper[MAX_THREADS];
+    int helper_count;
+
+    if(count <= 0)
+        return;
+
+    /* no worker threads */
+    if(thread_count == 0) {
+        for(int i = 0; i < count; i++)
+            fun(i, data);
+        return;
+    }
+
+    /* the iterations are taken in chunks, a few per thread */
+    range.grain = max(1, count / (4 * (thread_count + 1)));
+    helper_count = min(thread_count, (count - 1) / range.grain);
+    for(int i = 0; i < helper_count; i++) {
+        helper[i] = jobs_create(run_range, &range);
+        jobs_submit(helper[i]);
+    }
+
+    /* help the workers */
+    run_range(&range);
+    for(int i = 0; i < helper_count; i++) {
+        jobs_wait(helper[i]);
+        helper[i] = jobs_destroy(helper[i]);
+    }
+}
+
+
+
+/* private */
+
+/* puts a job that is ready to run in a queue; worker_id is -1 if the calling thread isn't a worker */
+void schedule_job(job_t* job, int worker_id)
+{
+    /* no worker threads: run it right away */
+    if(thread_count == 0) {
+        running_count++;
+        run_job(job, -1);
+        return;
+    }
+
+    /* workers keep the jobs they unlock in their own queues */
+    if(worker_id < 0) {
+        LOCK();
+        worker_id = next_queue;
+        next_queue = (next_queue + 1) % thread_count;
+        UNLOCK();
+    }
+
+    push_back(&queue[worker_id], job);
+
+    LOCK();
+    queued_count++;
+    BROADCAST();
+    UNLOCK();
+}
+
+/* takes a job from the queue of a worker or steals one from the others. Returns NULL if there are no jobs */
+job_t* take_job(int worker_id)
+{
+    job_t* job = NULL;
+
+    if(worker_id >= 0)
+        job = pop_back(&queue[worker_id]);
+
+    for(int i = 0; i < thread_count && job == NULL; i++) {
+        int victim = (worker_id + 1 + i) % thread_count;
+        if(victim != worker_id)
+            job = pop_front(&queue[victim]);
+    }
+
+    /* a taken job is counted as running right away, so that
+       queued_count and running_count are never both zero in
+       between (see wait_for) */
+    if(job != NULL) {
+        LOCK();
+        queued_count--;
+        running_count++;
+        UNLOCK();
+    }
+
+    return job;
+}
+
+/* runs a job that has been counted as running and schedules the jobs that depend on it */
+void run_job(job_t* job, int worker_id)
+{
+    int ready_count = 0;
+
+    job->fun(job->data);
+
+    /* no job is added to the dependents after this */
+    LOCK();
+    job->finished = true;
+    active_count--;
+    for(int i = 0; i < darray_length(job->dependents); i++) {
+        job_t* dependent = job->dependents[i];
+        dependent->refs--;
+        if(--dependent->pending == 0)
+            job->dependents[ready_count++] = dependent; /* submitted; the scheduler holds it */
+        else if(dependent->refs == 0)
+            destroy_job(dependent); /* never submitted and released */
+    }
+    BROADCAST();
+    UNLOCK();
+
+    for(int i = 0; i < ready_count; i++)
+        schedule_job(job->dependents[i], worker_id);
+
+    /* the completion queue takes the reference of the scheduler */
+    LOCK();
+    if(job->callback != NULL) {
+        if(last_completed != NULL)
+            last_completed->next = job;
+        else
+            first_completed = job;
+        last_completed = job;
+        job = NULL;
+    }
+    running_count--; /* the dependents have been queued by now */
+    BROADCAST();
+    UNLOCK();
+
+    if(job != NULL)
+        release_job(job);
+}
+
+/* runs the queued jobs until the given job finishes (or until all jobs finish, if job is NULL).
+   If nothing is queued nor running, the unfinished jobs depend on jobs that were never submitted */
+void wait_for(const job_t* job)
+{
+    for(;;) {
+        job_t* queued_job;
+        bool done, stuck;
+
+        if(NULL != (queued_job = take_job(-1))) {
+            run_job(queued_job, -1);
+            continue;
+        }
+
+        LOCK();
+        done = (job != NULL) ? job->finished : (active_count == 0);
+        stuck = !done && queued_count <= 0 && (thread_count == 0 || running_count <= 0);
+        if(!done && !stuck && thread_count > 0 && queued_count <= 0)
+            WAIT();
+        UNLOCK();
+
+        if(done)
+            break;
+        else if(stuck)
+            fatal_error("jobs: a job depends on jobs that were never submitted");
+    }
+}
+
+/* releases a reference to a job */
+void release_job(job_t* job)
+{
+    bool unreferenced;
+
+    LOCK();
+    unreferenced = (--job->refs == 0);
+    UNLOCK();
+
+    if(unreferenced)
+        destroy_job(job);
+}
+
+/* destroys a job */
+job_t* destroy_job(job_t* job)
+{
+    darray_release(job->dependents);
+    free(job);
+    return NULL;
+}
+
+/* runs chunks of iterations of a parallel for until there are none left */
+void run_range(void* range)
+{
+    parallelfor_t* r = (parallelfor_t*)range;
+
+    for(;;) {
+        int first, last;
+
+        LOCK();
+        first = r->next;
+        r->next = min(r->count, first + r->grain);
+        last = r->next;
+        UNLOCK();
+
+        if(first >= last)
+            break;
+
+        for(int i = first; i < last; i++)
+            r->fun(i, r->data);
+    }
+}
+
+/* initializes a queue */
+void init_queue(jobqueue_t* q)
+{
+    q->capacity = QUEUE_CAPACITY;
+    q->job = mallocx(q->capacity * sizeof(*(q->job)));
+    q->head = q->count = 0;
+
+#if defined(A5BUILD)
+    if(NULL == (q->mutex = al_create_mutex()))
+        fatal_error("jobs_init(): can't create synchronization primitives");
+#endif
+}
+
+/* releases a queue */
+void release_queue(jobqueue_t* q)
+{
+#if defined(A5BUILD)
+    al_destroy_mutex(q->mutex);
+    q->mutex = NULL;
+#endif
+
+    free(q->job);
+    q->job = NULL;
+    q->capacity = q->head = q->count = 0;
+}
+
+/* adds a job to the back of a queue */
+void push_back(jobqueue_t* q, job_t* job)
+{
+    LOCK_QUEUE(q);
+
+    /* grow the buffer, keeping the jobs in order */
+    if(q->count == q->capacity) {
+        job_t** buffer = mallocx(2 * q->capacity * sizeof(*buffer));
+        for(int i = 0; i < q->count; i++)
+            buffer[i] = q->job[(q->head + i) % q->capacity];
+        free(q->job);
+        q->job = buffer;
+        q->capacity *= 2;
+        q->head = 0;
+    }
+
+    q->job[(q->head + q->count) % q->capacity] = job;
+    q->count++;
+
+    UNLOCK_QUEUE(q);
+}
+
+/* removes the most recent job of a queue. Returns NULL if the queue is empty */
+job_t* pop_back(jobqueue_t* q)
+{
+    job_t* job = NULL;
+
+    LOCK_QUEUE(q);
+    if(q->count > 0) {
+        q->count--;
+        job = q->job[(q->head + q->count) % q->capacity];
+    }
+    UNLOCK_QUEUE(q);
+
+    return job;
+}
+
+/* removes the oldest job of a queue. Returns NULL if the queue is empty */
+job_t* pop_front(jobqueue_t* q)
+{
+    job_t* job = NULL;
+
+    LOCK_QUEUE(q);
+    if(q->count > 0) {
+        job = q->job[q->head];
+        q->head = (q->head + 1) % q->capacity;
+        q->count--;
+    }
+    UNLOCK_QUEUE(q);
+
+    return job;
+}
+
+#if defined(A5BUILD)
+/* worker thread: runs the queued jobs */
+void* worker_thread(ALLEGRO_THREAD* thread, void* arg)
+{
+    int worker_id = (int)(intptr_t)arg;
+
+    for(;;) {
+        job_t* job;
+        bool stop;
+
+        if(NULL != (job = take_job(worker_id))) {
+            run_job(job, worker_id);
+            continue;
+        }
+
+        /* sleep until there are jobs */
+        LOCK();
+        while(queued_count <= 0 && !al_get_thread_should_stop(thread))
+            WAIT();
+        stop = (queued_count <= 0);
+        UNLOCK();
+
+        if(stop)
+            break;
+    }
+
+    return NULL;
+}
+#endif
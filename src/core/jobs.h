@@ -0,0 +1,66 @@
+/*
+ * Open Surge Engine
+ * jobs.h - job system
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _JOBS_H
+#define _JOBS_H
+
+#include <stdbool.h>
+
+/*
+ * Job system
+ *
+ * A job is a function that runs on a worker thread. Each worker has its own
+ * queue of jobs; idle workers steal jobs from the queues of the others.
+ * Jobs must not touch the video card, the resource manager or the assetfs.
+ *
+ * Jobs may depend on other jobs, forming a graph: a job only runs after its
+ * dependencies have finished. A job may also have a completion callback,
+ * which runs on the main thread during jobs_update().
+ *
+ * A thread that waits for a job helps running the queued jobs. If the job
+ * system has no worker threads (this is always the case on builds without
+ * threads - legacy Allegro 4), the jobs run on the thread that submits them,
+ * in a deterministic order.
+ *
+ * Usage:
+ *     job_t* job = jobs_create(fun, data);
+ *     jobs_submit(job);
+ *     ...
+ *     jobs_wait(job);
+ *     job = jobs_destroy(job);
+ */
+typedef struct job_t job_t;
+
+void jobs_init(int thread_count); /* number of worker threads: 0 runs the jobs deterministically; a negative value picks a number based on the CPU */
+void jobs_release(); /* waits for the submitted jobs */
+void jobs_update(); /* runs the completion callbacks; call once per frame on the main thread */
+int jobs_thread_count(); /* number of worker threads */
+
+job_t* jobs_create(void (*fun)(void*), void* data); /* creates a job; it won't run until it's submitted */
+job_t* jobs_destroy(job_t* job); /* releases the handle of a job. A submitted job still runs. Returns NULL */
+void jobs_depend(job_t* job, job_t* dependency); /* job runs after dependency finishes; call it before submitting job */
+void jobs_on_complete(job_t* job, void (*callback)(void*), void* data); /* callback runs on the main thread after job finishes; call it before submitting job */
+void jobs_submit(job_t* job); /* schedules a job */
+void jobs_wait(job_t* job); /* waits for a job to finish, submitting it if necessary */
+bool jobs_is_finished(const job_t* job); /* has the job finished? */
+
+void jobs_parallel_for(int count, void (*fun)(int,void*), void* data); /* calls fun(i, data) for 0 <= i < count using all threads; returns when done */
+
+#endif
@@ -27,6 +27,7 @@
 #include "logfile.h"
 #include "hashtable.h"
 #include "nanoparser/nanoparser.h"
+#include "parsecache.h"
 
 /* default language file */
 const char* DEFAULT_LANGUAGE_FILEPATH = "languages/english.lng";
@@ -78,7 +79,6 @@ void lang_release()
  */
 void lang_loadfile(const char *filepath)
 {
-    const char* fullpath;
     int ver, subver, wipver;
     parsetree_program_t *prog;
 
@@ -97,8 +97,7 @@ void lang_loadfile(const char *filepath)
     if(game_version_compare(ver, subver, wipver) < 0) /* backwards compatibility */
         fatal_error("Language file \"%s\" (version %d.%d.%d) is not compatible with this version of the engine (%d.%d.%d)!", filepath, ver, subver, wipver, GAME_VERSION, GAME_SUB_VERSION, GAME_WIP_VERSION);
 
-    fullpath = assetfs_fullpath(filepath);
-    prog = nanoparser_construct_tree(fullpath);
+    prog = parsecache_construct_tree(filepath);
     nanoparser_traverse_program(prog, traverse);
     prog = nanoparser_deconstruct_tree(prog);
 }
@@ -113,13 +112,11 @@ void lang_readstring(const char *filepath, const char *desired_key, char *str, s
 {
     inout_t param;
     parsetree_program_t *prog;
-    const char* fullpath;
 
-    fullpath = assetfs_fullpath(filepath);
     param.key = desired_key;
     param.value = NULL;
 
-    prog = nanoparser_construct_tree(fullpath);
+    prog = parsecache_construct_tree(filepath);
     nanoparser_traverse_program_ex(prog, (void*)(&param), traverse_inout);
 
     if(param.value == NULL)
@@ -19,15 +19,78 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <errno.h>
 #include "logfile.h"
 #include "global.h"
 #include "assetfs.h"
 
+#if defined(A5BUILD)
+#include <allegro5/allegro.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* OS-specific includes: the ring buffer is written with write(2) */
+#if defined(_WIN32)
+#include <io.h>
+#define fd_of(fp) _fileno(fp)
+#define fd_write(fd, buf, count) _write((fd), (buf), (unsigned)(count))
+#else
+#include <unistd.h>
+#define fd_of(fp) fileno(fp)
+#define fd_write(fd, buf, count) write((fd), (buf), (count))
+#endif
+#endif
+
 
 /* private stuff ;) */
 static const char* LOGFILE_PATH = "logfile.txt"; /* default log file */
+static const char* LEVEL_PREFIX[] = { "[debug] ", "", "[warning] ", "[error] " };
 static FILE* logfile = NULL;
+static loglevel_t min_level = LOGLEVEL_INFO;
+static void log_message(loglevel_t level, const char* fmt, va_list args);
+static void write_line(loglevel_t level, const char* fmt, va_list args);
+
+#if defined(A5BUILD)
+/* log messages are stored in a lock-free ring buffer (a bounded queue
+   with many producers and a single consumer) and are written to the
+   disk in batches by a background thread */
+#define RING_SIZE           1024 /* number of lines; must be a power of two */
+#define LINE_SIZE           1024 /* maximum length of a line, including the '\0' */
+#define BATCH_SIZE          16384 /* lines are written in batches of up to this many bytes */
+static const double WRITE_INTERVAL = 0.1; /* how often (in seconds) the writer thread wakes up */
+typedef struct logline_t {
+    uint32_t sequence; /* see push_line() and drain_ring() */
+    char text[LINE_SIZE];
+} logline_t;
+static logline_t ring[RING_SIZE];
+static uint32_t ring_head = 0; /* next line to be written by a producer */
+static uint32_t ring_tail = 0; /* next line to be read by the consumer */
+static uint32_t draining = 0; /* 1 while a consumer is draining the ring buffer */
+static char batch[BATCH_SIZE]; /* owned by the consumer */
+static int logfile_fd = -1; /* file descriptor of the logfile */
+static ALLEGRO_THREAD* writer = NULL;
+static ALLEGRO_MUTEX* writer_mutex = NULL; /* protects the consumer side */
+static ALLEGRO_COND* writer_cond = NULL;
+static bool async = false; /* is the writer thread running? */
+static bool writer_started = false; /* has the writer thread been started (or has it failed to start)? */
+static void start_writer();
+static void stop_writer();
+static void* writer_thread(ALLEGRO_THREAD* thread, void* arg);
+static void push_line(loglevel_t level, const char* fmt, va_list args);
+static int drain_ring(int fd);
+static void write_batch(int fd, const char* data, size_t size);
+static void flush_at_exit();
+static void crash_handler(int sig);
+static inline uint32_t load_acquire(const volatile uint32_t* p);
+static inline void store_release(volatile uint32_t* p, uint32_t value);
+static inline bool compare_and_swap(volatile uint32_t* p, uint32_t expected, uint32_t desired);
+#endif
 
 
 /*
@@ -37,7 +100,25 @@ static FILE* logfile = NULL;
 void logfile_init()
 {
     const char* fullpath = assetfs_create_cache_file(LOGFILE_PATH);
+
+#if defined(A5BUILD)
+    /* the writer thread is started as soon as Allegro is initialized */
+    ring_head = ring_tail = 0;
+    for(uint32_t i = 0; i < RING_SIZE; i++)
+        ring[i].sequence = i;
+
+    /* flush the pending lines if we crash */
+    atexit(flush_at_exit);
+    signal(SIGSEGV, crash_handler);
+    signal(SIGFPE, crash_handler);
+    signal(SIGILL, crash_handler);
+    signal(SIGABRT, crash_handler);
+#endif
+
     if(NULL != (logfile = fopen(fullpath, "w"))) {
+#if defined(A5BUILD)
+        logfile_fd = fd_of(logfile);
+#endif
         logfile_message("%s version %s", GAME_TITLE, GAME_VERSION_STRING);
     }
     else {
@@ -53,19 +134,54 @@ void logfile_init()
  */
 void logfile_message(const char* fmt, ...)
 {
-    /*FILE* fp = logfile ? logfile : stdout;*/
-    FILE* fp = logfile;
+    va_list args;
+
+    va_start(args, fmt);
+    log_message(LOGLEVEL_INFO, fmt, args);
+    va_end(args);
+}
+
+
+/*
+ * logfile_message_ex()
+ * Prints a message of a given level to the logfile (printf format)
+ */
+void logfile_message_ex(loglevel_t level, const char* fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    log_message(level, fmt, args);
+    va_end(args);
+}
 
-    if(fp != NULL) {
-        va_list args;
 
-        va_start(args, fmt);
-        vfprintf(fp, fmt, args);
-        va_end(args);
+/*
+ * logfile_set_level()
+ * Messages below the given level will be filtered out
+ */
+void logfile_set_level(loglevel_t level)
+{
+    min_level = level;
+}
+
 
-        fputc('\n', fp);
-        fflush(fp);
+/*
+ * logfile_flush()
+ * Writes the pending messages to the disk
+ */
+void logfile_flush()
+{
+#if defined(A5BUILD)
+    if(async) {
+        al_lock_mutex(writer_mutex);
+        drain_ring(logfile_fd);
+        al_unlock_mutex(writer_mutex);
     }
+#endif
+
+    if(logfile != NULL)
+        fflush(logfile);
 }
 
 
@@ -77,6 +193,11 @@ void logfile_message(const char* fmt, ...)
 void logfile_release()
 {
     logfile_message("tchau!");
+
+#if defined(A5BUILD)
+    stop_writer();
+    logfile_fd = -1;
+#endif
     
     if(logfile != NULL)
         fclose(logfile);
@@ -84,3 +205,246 @@ void logfile_release()
     logfile = NULL;
 }
 
+
+
+/* private */
+
+/* prints a message to the logfile */
+void log_message(loglevel_t level, const char* fmt, va_list args)
+{
+    if(logfile == NULL || level < min_level)
+        return;
+
+#if defined(A5BUILD)
+    /* this happens on the main thread, before any other threads log anything */
+    if(!writer_started && al_is_system_installed())
+        start_writer();
+
+    if(async) {
+        push_line(level, fmt, args);
+        return;
+    }
+#endif
+
+    write_line(level, fmt, args);
+}
+
+/* writes a line to the logfile synchronously */
+void write_line(loglevel_t level, const char* fmt, va_list args)
+{
+    fputs(LEVEL_PREFIX[level], logfile);
+    vfprintf(logfile, fmt, args);
+    fputc('\n', logfile);
+    fflush(logfile);
+}
+
+#if defined(A5BUILD)
+
+/* starts the writer thread */
+void start_writer()
+{
+    writer_started = true;
+    writer_mutex = al_create_mutex();
+    writer_cond = al_create_cond();
+    if(writer_mutex == NULL || writer_cond == NULL || NULL == (writer = al_create_thread(writer_thread, NULL))) {
+        fputs("Can't start the writer thread of the logfile\n", logfile);
+        fflush(logfile);
+        return; /* keep on writing synchronously */
+    }
+
+    async = true;
+    al_start_thread(writer);
+}
+
+/* stops the writer thread and writes any pending lines */
+void stop_writer()
+{
+    if(writer == NULL)
+        return;
+
+    al_lock_mutex(writer_mutex);
+    al_set_thread_should_stop(writer);
+    al_signal_cond(writer_cond);
+    al_unlock_mutex(writer_mutex);
+
+    al_join_thread(writer, NULL);
+    al_destroy_thread(writer);
+    writer = NULL;
+
+    async = false;
+    drain_ring(logfile_fd);
+
+    al_destroy_cond(writer_cond);
+    al_destroy_mutex(writer_mutex);
+    writer_cond = NULL;
+    writer_mutex = NULL;
+}
+
+/* writer thread: writes the lines of the ring buffer in batches */
+void* writer_thread(ALLEGRO_THREAD* thread, void* arg)
+{
+    ALLEGRO_TIMEOUT timeout;
+
+    al_lock_mutex(writer_mutex);
+    while(!al_get_thread_should_stop(thread)) {
+        al_init_timeout(&timeout, WRITE_INTERVAL);
+        al_wait_cond_until(writer_cond, writer_mutex, &timeout);
+        drain_ring(logfile_fd);
+    }
+    al_unlock_mutex(writer_mutex);
+
+    return NULL;
+}
+
+/* pushes a line into the ring buffer. May be called by any thread.
+   A line whose sequence number equals its position is free; one
+   whose sequence number is its position + 1 is ready to be read */
+void push_line(loglevel_t level, const char* fmt, va_list args)
+{
+    uint32_t pos = load_acquire(&ring_head);
+    logline_t* line;
+    int length;
+
+    /* reserve a line */
+    for(;;) {
+        line = &ring[pos & (RING_SIZE - 1)];
+        int32_t diff = (int32_t)(load_acquire(&line->sequence) - pos);
+
+        if(diff == 0) {
+            if(compare_and_swap(&ring_head, pos, pos + 1))
+                break;
+        }
+        else if(diff < 0) {
+            /* the ring buffer is full: wait for the writer */
+            al_signal_cond(writer_cond);
+            al_rest(0.001);
+        }
+
+        pos = load_acquire(&ring_head);
+    }
+
+    /* format the message */
+    length = snprintf(line->text, LINE_SIZE, "%s", LEVEL_PREFIX[level]);
+    if(vsnprintf(line->text + length, LINE_SIZE - length, fmt, args) >= LINE_SIZE - length)
+        snprintf(line->text + LINE_SIZE - 4, 4, "...");
+
+    /* publish it */
+    store_release(&line->sequence, pos + 1);
+
+    /* wake up the writer if it's urgent or if the ring buffer is getting full */
+    if(level >= LOGLEVEL_WARNING || pos - load_acquire(&ring_tail) >= RING_SIZE / 2)
+        al_signal_cond(writer_cond);
+}
+
+/* writes the lines that are ready to be read to a file descriptor, bypassing stdio,
+   so that it may be called by the crash handler. There is a single consumer at any
+   given time: if another one is draining the ring buffer, this does nothing.
+   Returns the number of lines written */
+int drain_ring(int fd)
+{
+    size_t size = 0;
+    int count = 0;
+
+    if(!compare_and_swap(&draining, 0, 1))
+        return 0;
+
+    for(;;) {
+        uint32_t tail = ring_tail;
+        logline_t* line = &ring[tail & (RING_SIZE - 1)];
+        size_t length;
+
+        if(load_acquire(&line->sequence) != tail + 1)
+            break;
+
+        /* add the line to the batch */
+        for(length = 0; line->text[length] != '\0'; length++);
+        if(size + length + 1 > BATCH_SIZE) {
+            write_batch(fd, batch, size);
+            size = 0;
+        }
+        for(size_t i = 0; i < length; i++)
+            batch[size++] = line->text[i];
+        batch[size++] = '\n';
+
+        store_release(&line->sequence, tail + RING_SIZE);
+        store_release(&ring_tail, tail + 1);
+        count++;
+    }
+
+    write_batch(fd, batch, size);
+    store_release(&draining, 0);
+    return count;
+}
+
+/* writes a batch of lines to a file descriptor (async-signal-safe) */
+void write_batch(int fd, const char* data, size_t size)
+{
+    if(fd < 0)
+        return;
+
+    while(size > 0) {
+        int written = fd_write(fd, data, size);
+
+        if(written < 0 && errno == EINTR)
+            continue;
+        else if(written <= 0)
+            break;
+
+        data += written;
+        size -= written;
+    }
+}
+
+/* writes the pending lines when the program exits (e.g., after a fatal error) */
+void flush_at_exit()
+{
+    logfile_flush();
+}
+
+/* writes the pending lines when the program crashes. Only async-signal-safe
+   calls are made here. This is best effort: if the crash interrupts another
+   consumer, the lines it hasn't written yet are lost */
+void crash_handler(int sig)
+{
+    drain_ring(logfile_fd);
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* atomic operations */
+#if defined(__GNUC__) || defined(__clang__)
+uint32_t load_acquire(const volatile uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void store_release(volatile uint32_t* p, uint32_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+bool compare_and_swap(volatile uint32_t* p, uint32_t expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#elif defined(_MSC_VER)
+uint32_t load_acquire(const volatile uint32_t* p)
+{
+    return (uint32_t)_InterlockedOr((volatile long*)p, 0);
+}
+
+void store_release(volatile uint32_t* p, uint32_t value)
+{
+    _InterlockedExchange((volatile long*)p, (long)value);
+}
+
+bool compare_and_swap(volatile uint32_t* p, uint32_t expected, uint32_t desired)
+{
+    return (uint32_t)_InterlockedCompareExchange((volatile long*)p, (long)desired, (long)expected) == expected;
+}
+#else
+#error "logfile.c: atomic operations are not available for this compiler"
+#endif
+
+#endif
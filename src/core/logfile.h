@@ -21,9 +21,30 @@
 #ifndef _LOGFILE_H
 #define _LOGFILE_H
 
+/* log levels */
+typedef enum loglevel_t {
+    LOGLEVEL_DEBUG,     /* verbose messages */
+    LOGLEVEL_INFO,      /* regular messages (default) */
+    LOGLEVEL_WARNING,
+    LOGLEVEL_ERROR
+} loglevel_t;
+
+/* messages below this level are compiled out */
+#ifndef LOGFILE_COMPILED_LEVEL
+#define LOGFILE_COMPILED_LEVEL      LOGLEVEL_DEBUG
+#endif
+
 void logfile_init(); /* initializes the logfile module */
 void logfile_message(const char *fmt, ...); /* prints a message to the logfile (printf style) */
+void logfile_message_ex(loglevel_t level, const char *fmt, ...); /* prints a message of a given level */
+void logfile_set_level(loglevel_t level); /* messages below this level are filtered out (default: LOGLEVEL_INFO) */
+void logfile_flush(); /* writes the pending messages to the disk */
 void logfile_release(); /* releases the logfile module */
 
+/* shortcuts */
+#define logfile_debug(...)          ((LOGFILE_COMPILED_LEVEL <= LOGLEVEL_DEBUG) ? logfile_message_ex(LOGLEVEL_DEBUG, __VA_ARGS__) : (void)0)
+#define logfile_warning(...)        ((LOGFILE_COMPILED_LEVEL <= LOGLEVEL_WARNING) ? logfile_message_ex(LOGLEVEL_WARNING, __VA_ARGS__) : (void)0)
+#define logfile_error(...)          logfile_message_ex(LOGLEVEL_ERROR, __VA_ARGS__)
+
 #endif
 
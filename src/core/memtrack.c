@@ -0,0 +1,412 @@
+/*
+ * Open Surge Engine
+ * memtrack.c - allocation tracking
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "memtrack.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(TRACK_ALLOCATIONS)
+
+/* subsystems */
+typedef enum memtag_t {
+    MEMTAG_OTHER,
+    MEMTAG_PHYSICS,
+    MEMTAG_RENDER,
+    MEMTAG_SCRIPTING,
+    MEMTAG_ASSETS,
+    MEMTAG_LEGACY,
+    MEMTAG_COUNT
+} memtag_t;
+
+static const char* TAG_NAME[MEMTAG_COUNT] = {
+    [MEMTAG_OTHER] = "other",
+    [MEMTAG_PHYSICS] = "physics",
+    [MEMTAG_RENDER] = "render",
+    [MEMTAG_SCRIPTING] = "scripting",
+    [MEMTAG_ASSETS] = "assets",
+    [MEMTAG_LEGACY] = "legacy"
+};
+
+/* the source files of each subsystem; '/' matches any path separator */
+static const struct {
+    const char* path;
+    memtag_t tag;
+} RULE[] = {
+    { "entities/legacy/", MEMTAG_LEGACY },
+    { "physics/", MEMTAG_PHYSICS },
+    { "scripting/", MEMTAG_SCRIPTING },
+    { "core/video.", MEMTAG_RENDER },
+    { "core/image.", MEMTAG_RENDER },
+    { "core/font.", MEMTAG_RENDER },
+    { "core/fadefx.", MEMTAG_RENDER },
+    { "core/screenshot.", MEMTAG_RENDER },
+    { "core/framecapture.", MEMTAG_RENDER },
+    { "entities/renderqueue.", MEMTAG_RENDER },
+    { "core/assetfs.", MEMTAG_ASSETS },
+    { "core/assetloader.", MEMTAG_ASSETS },
+    { "core/resourcemanager.", MEMTAG_ASSETS },
+    { "core/parsecache.", MEMTAG_ASSETS },
+    { "core/sprite.", MEMTAG_ASSETS },
+    { "core/audio.", MEMTAG_ASSETS },
+    { "core/nanoparser/", MEMTAG_ASSETS }
+};
+
+/* a live block */
+typedef struct memblock_t {
+    void* ptr; /* NULL if the slot is empty */
+    size_t bytes;
+    const char* location; /* where it was allocated */
+    memtag_t tag;
+} memblock_t;
+
+/* private data */
+#define INITIAL_CAPACITY    4096 /* must be a power of two */
+static memblock_t* block = NULL; /* a hash table of the live blocks (open addressing) */
+static size_t capacity = 0; /* number of slots */
+static size_t block_count = 0; /* number of live blocks */
+static size_t live_bytes[MEMTAG_COUNT] = { 0 };
+static size_t peak_bytes[MEMTAG_COUNT] = { 0 };
+static uint32_t live_blocks[MEMTAG_COUNT] = { 0 };
+static uint32_t frame_allocations[MEMTAG_COUNT] = { 0 }; /* current frame */
+static uint32_t previous_frame_allocations[MEMTAG_COUNT] = { 0 };
+static size_t total_live_bytes = 0, total_peak_bytes = 0;
+static volatile long spinlock = 0; /* mallocx() may be called from any thread */
+static memtag_t find_tag(const char* location);
+static bool path_contains(const char* location, const char* path);
+static size_t find_slot(const void* ptr);
+static void remove_slot(size_t slot);
+static void grow_table();
+static void forget_block(const memblock_t* b);
+static int compare_locations(const void* a, const void* b);
+static inline size_t hash_pointer(const void* ptr);
+static inline void lock();
+static inline void unlock();
+
+#endif
+
+
+
+/* public API */
+
+/*
+ * memtrack_is_enabled()
+ * Is the allocation tracker available in this build?
+ */
+bool memtrack_is_enabled()
+{
+#if defined(TRACK_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*
+ * memtrack_new_frame()
+ * Starts counting the allocations of a new frame
+ */
+void memtrack_new_frame()
+{
+#if defined(TRACK_ALLOCATIONS)
+    lock();
+    memcpy(previous_frame_allocations, frame_allocations, sizeof(frame_allocations));
+    memset(frame_allocations, 0, sizeof(frame_allocations));
+    unlock();
+#endif
+}
+
+/*
+ * memtrack_get_stats()
+ * Gets the memory usage of the subsystems. The first entry
+ * is the total; subsystems that never allocated anything are
+ * skipped. Returns the number of entries written to stats
+ */
+int memtrack_get_stats(memstats_t* stats, int max_count)
+{
+    int count = 0;
+
+#if defined(TRACK_ALLOCATIONS)
+    if(max_count <= 0)
+        return 0;
+
+    lock();
+
+    stats[count++] = (memstats_t){ "total", total_live_bytes, total_peak_bytes, 0, 0 };
+    for(int i = 0; i < MEMTAG_COUNT; i++) {
+        stats[0].live_blocks += live_blocks[i];
+        stats[0].frame_allocations += previous_frame_allocations[i];
+        if(peak_bytes[i] > 0 && count < max_count)
+            stats[count++] = (memstats_t){ TAG_NAME[i], live_bytes[i], peak_bytes[i], live_blocks[i], previous_frame_allocations[i] };
+    }
+
+    unlock();
+#else
+    (void)stats;
+    (void)max_count;
+#endif
+
+    return count;
+}
+
+/*
+ * memtrack_dump_leaks()
+ * Lists the blocks that haven't been released, grouped by
+ * the location of the allocation. Call it at the very end
+ */
+void memtrack_dump_leaks()
+{
+#if defined(TRACK_ALLOCATIONS)
+    memblock_t* leak;
+    size_t leak_count = 0;
+
+    /* copy the live blocks */
+    lock();
+    if(NULL == (leak = malloc((block_count + 1) * sizeof(*leak)))) {
+        unlock();
+        return;
+    }
+    for(size_t i = 0; i < capacity; i++) {
+        if(block[i].ptr != NULL)
+            leak[leak_count++] = block[i];
+    }
+    unlock();
+
+    /* group them by location */
+    qsort(leak, leak_count, sizeof(*leak), compare_locations);
+    fprintf(stderr, "memtrack: %lu bytes in %lu blocks haven't been released\n", (unsigned long)total_live_bytes, (unsigned long)leak_count);
+    for(size_t i = 0, j; i < leak_count; i = j) {
+        size_t bytes = 0;
+        for(j = i; j < leak_count && strcmp(leak[j].location, leak[i].location) == 0; j++)
+            bytes += leak[j].bytes;
+        fprintf(stderr, "    %lu bytes in %lu blocks at %s (%s)\n", (unsigned long)bytes, (unsigned long)(j - i), leak[i].location, TAG_NAME[leak[i].tag]);
+    }
+
+    free(leak);
+#endif
+}
+
+/*
+ * memtrack_allocated()
+ * Records a block allocated at the given location
+ */
+void memtrack_allocated(void* ptr, size_t bytes, const char* location)
+{
+#if defined(TRACK_ALLOCATIONS)
+    memtag_t tag = find_tag(location);
+    size_t slot;
+
+    lock();
+
+    if(2 * (block_count + 1) > capacity)
+        grow_table();
+
+    /* the address is reused, but the block it referred to was
+       released in a file that doesn't see the free() of util.h */
+    if(block[(slot = find_slot(ptr))].ptr != NULL)
+        forget_block(&block[slot]);
+    else
+        block_count++;
+
+    block[slot] = (memblock_t){ ptr, bytes, location, tag };
+    live_bytes[tag] += bytes;
+    live_blocks[tag]++;
+    frame_allocations[tag]++;
+    total_live_bytes += bytes;
+    if(live_bytes[tag] > peak_bytes[tag])
+        peak_bytes[tag] = live_bytes[tag];
+    if(total_live_bytes > total_peak_bytes)
+        total_peak_bytes = total_live_bytes;
+
+    unlock();
+#else
+    (void)ptr;
+    (void)bytes;
+    (void)location;
+#endif
+}
+
+/*
+ * memtrack_released()
+ * Forgets a block that is about to be released
+ */
+void memtrack_released(void* ptr)
+{
+#if defined(TRACK_ALLOCATIONS)
+    size_t slot;
+
+    if(ptr == NULL)
+        return;
+
+    lock();
+    if(capacity > 0 && block[(slot = find_slot(ptr))].ptr != NULL) {
+        forget_block(&block[slot]);
+        remove_slot(slot);
+        block_count--;
+    }
+    unlock();
+#else
+    (void)ptr;
+#endif
+}
+
+
+
+/* private */
+
+#if defined(TRACK_ALLOCATIONS)
+
+/* the subsystem of a source file */
+memtag_t find_tag(const char* location)
+{
+    for(size_t i = 0; i < sizeof(RULE) / sizeof(RULE[0]); i++) {
+        if(path_contains(location, RULE[i].path))
+            return RULE[i].tag;
+    }
+
+    return MEMTAG_OTHER;
+}
+
+/* checks if location contains path, where '/' matches any path separator */
+bool path_contains(const char* location, const char* path)
+{
+    for(; *location; location++) {
+        const char *l = location, *p = path;
+        while(*p && (*l == *p || (*p == '/' && *l == '\\'))) {
+            l++;
+            p++;
+        }
+        if(!*p)
+            return true;
+    }
+
+    return false;
+}
+
+/* the slot of a pointer in the hash table, or the empty slot where it would be */
+size_t find_slot(const void* ptr)
+{
+    size_t mask = capacity - 1;
+    size_t slot = hash_pointer(ptr) & mask;
+
+    while(block[slot].ptr != NULL && block[slot].ptr != ptr)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+/* empties a slot of the hash table, moving back the blocks that were displaced by it */
+void remove_slot(size_t slot)
+{
+    size_t mask = capacity - 1;
+    size_t next = slot;
+
+    block[slot].ptr = NULL;
+    for(;;) {
+        size_t home;
+
+        next = (next + 1) & mask;
+        if(block[next].ptr == NULL)
+            break;
+
+        /* leave the block if its home is cyclically in (slot, next] */
+        home = hash_pointer(block[next].ptr) & mask;
+        if(slot <= next ? (slot < home && home <= next) : (slot < home || home <= next))
+            continue;
+
+        block[slot] = block[next];
+        block[next].ptr = NULL;
+        slot = next;
+    }
+}
+
+/* doubles the capacity of the hash table */
+void grow_table()
+{
+    memblock_t* old_block = block;
+    size_t old_capacity = capacity;
+
+    capacity = (capacity > 0) ? 2 * capacity : INITIAL_CAPACITY;
+    if(NULL == (block = calloc(capacity, sizeof(*block)))) {
+        fputs("memtrack: out of memory\n", stderr); /* fatal_error() would allocate */
+        abort();
+    }
+
+    for(size_t i = 0; i < old_capacity; i++) {
+        if(old_block[i].ptr != NULL)
+            block[find_slot(old_block[i].ptr)] = old_block[i];
+    }
+
+    free(old_block);
+}
+
+/* subtracts a block from the counters */
+void forget_block(const memblock_t* b)
+{
+    live_bytes[b->tag] -= b->bytes;
+    live_blocks[b->tag]--;
+    total_live_bytes -= b->bytes;
+}
+
+/* compares the locations of two blocks */
+int compare_locations(const void* a, const void* b)
+{
+    return strcmp(((const memblock_t*)a)->location, ((const memblock_t*)b)->location);
+}
+
+/* hashes a pointer */
+size_t hash_pointer(const void* ptr)
+{
+    uint64_t x = (uint64_t)(uintptr_t)ptr;
+
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+
+    return (size_t)x;
+}
+
+/* a spinlock: the critical sections are short */
+void lock()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    while(__atomic_exchange_n(&spinlock, 1, __ATOMIC_ACQUIRE))
+        ;
+#elif defined(_MSC_VER)
+    while(_InterlockedExchange(&spinlock, 1))
+        ;
+#endif
+}
+
+void unlock()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&spinlock, 0, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+    _InterlockedExchange(&spinlock, 0);
+#endif
+}
+
+#endif
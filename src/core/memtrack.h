@@ -0,0 +1,62 @@
+/*
+ * Open Surge Engine
+ * memtrack.h - allocation tracking
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MEMTRACK_H
+#define _MEMTRACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+   The allocation tracker keeps a record of every block
+   allocated with mallocx() / reallocx() and released with
+   free(). It's only enabled on builds with TRACK_ALLOCATIONS
+   defined (cmake -DTRACK_ALLOCATIONS=ON), since it's slow.
+
+   Each block is tagged by subsystem (physics, render,
+   scripting, assets, legacy) according to the source file
+   that allocated it. The tracker measures the live bytes,
+   their peak and the number of allocations per frame of
+   each subsystem, and lists the blocks that are leaked.
+
+   Memory allocated with mallocx() must be released in a file
+   that includes util.h; otherwise, it's reported as a leak.
+*/
+
+/* memory usage of a subsystem */
+typedef struct memstats_t {
+    const char* tag; /* e.g., "physics"; the first entry is the "total" */
+    size_t live_bytes; /* bytes currently allocated */
+    size_t peak_bytes; /* maximum value of live_bytes */
+    uint32_t live_blocks; /* blocks currently allocated */
+    uint32_t frame_allocations; /* allocations made in the previous frame */
+} memstats_t;
+
+bool memtrack_is_enabled(); /* is the tracker available in this build? */
+void memtrack_new_frame(); /* call it at the beginning of each frame */
+int memtrack_get_stats(memstats_t* stats, int max_count); /* returns the number of entries written to stats */
+void memtrack_dump_leaks(); /* lists the blocks that haven't been released (on stderr) */
+
+/* used by mallocx(), reallocx() and free() */
+void memtrack_allocated(void* ptr, size_t bytes, const char* location);
+void memtrack_released(void* ptr);
+
+#endif
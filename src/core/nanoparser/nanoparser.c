@@ -161,6 +161,7 @@ extern "C" {
 
 /* forward declarations */
 typedef struct sourcelocation_t sourcelocation_t;
+typedef struct arena_t arena_t;
 
 
 
@@ -171,6 +172,7 @@ typedef struct sourcelocation_t sourcelocation_t;
 struct parsetree_program_t {
     parsetree_statement_t *statement;
     parsetree_program_t *next;
+    arena_t *arena; /* the memory of the tree (set on its first node only) */
 };
 
 /* a statement is a line containing an identifier (i.e., a string) followed by a parameter */
@@ -200,6 +202,7 @@ struct parsetree_parameter_t {
 /* utilities */
 static void (*error_fun)(const char*) = NULL;
 static void (*warning_fun)(const char*) = NULL;
+static void (*dependency_fun)(const char*) = NULL;
 static void error(const char *fmt, ...); /* fatal error */
 static void warning(const char *fmt, ...); /* warning */
 static char* dirpath(const char *filepath); /* dirpath("f/folder/file.txt") = "f/folder/" */
@@ -211,37 +214,76 @@ static char* r_trim(char *s); /* r_trim */
 
 
 /* parse tree */
+/* parse tree: all nodes are allocated from the arena of the tree being constructed */
 static parsetree_parameter_t* parsetree_parameter_new_value(const char *str, parsetree_parameter_t *nextparam);
 static parsetree_parameter_t* parsetree_parameter_new_program(parsetree_program_t *prog);
-static parsetree_parameter_t* parsetree_parameter_delete(parsetree_parameter_t* param);
 static void parsetree_parameter_show(parsetree_parameter_t* param);
 
 static parsetree_statement_t* parsetree_statement_new(const char *str, parsetree_parameter_t *parameter);
-static parsetree_statement_t* parsetree_statement_delete(parsetree_statement_t* stmt);
 static void parsetree_statement_show(parsetree_statement_t* stmt);
 
 static parsetree_program_t* parsetree_program_new(parsetree_statement_t* stmt, parsetree_program_t* nextprog);
-static parsetree_program_t* parsetree_program_delete(parsetree_program_t* prog);
 static void parsetree_program_show(parsetree_program_t* prog);
 
 
 
+/* arena allocator: a parse tree is allocated in large chunks of memory,
+   which are released all at once when the tree is deconstructed */
+#define ARENA_ALIGNMENT         16 /* power of two */
+#define ARENA_MIN_CHUNK_SIZE    4096
+#define ARENA_MAX_CHUNK_SIZE    (1 << 20)
+
+typedef struct arenachunk_t arenachunk_t;
+struct arenachunk_t {
+    arenachunk_t *next; /* previous chunk */
+    size_t size; /* capacity of this chunk, in bytes */
+    size_t used; /* bytes in use */
+};
+
+struct arena_t {
+    arenachunk_t *chunk; /* current chunk */
+    size_t chunk_size; /* size of the next chunk */
+    arena_t *next; /* used when deconstructing appended trees */
+};
+
+static arena_t* tree_arena; /* the arena of the tree being constructed */
+static arena_t* arena_new(size_t size_hint); /* creates a new arena */
+static arena_t* arena_delete(arena_t *arena); /* releases an arena and all its memory */
+static void* arena_alloc(arena_t *arena, size_t bytes); /* allocates memory from an arena */
+static char* arena_strdup(arena_t *arena, const char *s); /* duplicates s using the arena */
+
+
+
 /* virtual file (in-memory) */
-GENERATE_INTERFACE_OF_EXPANDABLE_ARRAY(int);
-GENERATE_IMPLEMENTATION_OF_EXPANDABLE_ARRAY(int);
 static char* vfile_name; /* filename */
-static expandable_array_int* vfile_contents; /* file contents */
+static unsigned char* vfile_data; /* file contents */
+static int vfile_size; /* size of the file, in bytes */
+static int vfile_capacity; /* capacity of vfile_data */
 static int vfile_ptr; /* current file pointer */
 
-static void vfile_create(const char *name); /* creates the virtual file */
+static void vfile_create(const char *name, int size_hint); /* creates the virtual file */
 static void vfile_destroy(); /* destroys the virtual file */
-static int vfile_getc(); /* getchar */
-static int vfile_ungetc(int c); /* ungetchar */
-static int vfile_putc(int c); /* putchar */
+static inline int vfile_getc(); /* getchar */
+static inline int vfile_ungetc(int c); /* ungetchar */
+static inline int vfile_putc(int c); /* putchar */
 static void vfile_rewind(); /* rewind */
 
 
 
+/* source buffer: the contents of a source file, read all at once */
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t pos;
+} srcbuffer_t;
+
+static int srcbuffer_read(srcbuffer_t *buf, FILE *fp); /* reads the whole file. Returns TRUE on success */
+static void srcbuffer_release(srcbuffer_t *buf);
+static inline int srcbuffer_getc(srcbuffer_t *buf); /* getchar */
+static inline void srcbuffer_ungetc(int c, srcbuffer_t *buf); /* ungetchar */
+
+
+
 /* preprocessor */
 typedef char* pchar;
 GENERATE_INTERFACE_OF_EXPANDABLE_ARRAY(pchar);
@@ -251,7 +293,7 @@ static int preprocessor_line; /* current line number */
 
 static void preprocessor_init();
 static void preprocessor_release();
-static void preprocessor_run(FILE *in, int depth); /* runs the preprocessor */
+static void preprocessor_run(srcbuffer_t *in, int depth); /* runs the preprocessor */
 static void preprocessor_show(); /* shows the pre-processed file */
 static void preprocessor_add_to_include_table(const char *filepath);
 static int preprocessor_has_file_been_included(const char *filepath);
@@ -268,6 +310,9 @@ typedef struct {
 
     /* vfile_line_offset: used if there's another file included within filename (otherwise it's 0) */
     int vfile_line_offset;
+
+    /* a copy of filename that lives in the arena of the tree (lazily created) */
+    const char *tree_filename;
 } errorcontext;
 GENERATE_INTERFACE_OF_EXPANDABLE_ARRAY(errorcontext);
 GENERATE_IMPLEMENTATION_OF_EXPANDABLE_ARRAY(errorcontext);
@@ -278,6 +323,7 @@ static void errorcontext_release(); /* releases the erro context module */
 static void errorcontext_add_to_table(const char *filename, int vfile_start_line, int vfile_line_offset); /* adds a new error context to its internal table */
 static int errorcontext_detect_file_line(int vfile_line); /* provide a line number of the virtual file, and it will return you the line number of the real file at that place */
 static const char* errorcontext_detect_file_name(int vfile_line); /* provide a line number of the virtual file, and it will return you the name of the real file at that place */
+static const char* errorcontext_detect_tree_file_name(int vfile_line); /* same as above, but the name is stored in the arena of the tree */
 static errorcontext* errorcontext_find(int idx, int vfile_line); /* internal use only */
 
 
@@ -287,11 +333,10 @@ static errorcontext* errorcontext_find(int idx, int vfile_line); /* internal use
 /* source location (used for improved error detection) */
 /* this is an easy-to-use facade for errorcontext */
 struct sourcelocation_t {
-    char *file;
+    const char *file;
     int line;
 };
 static sourcelocation_t* sourcelocation_new(int vfile_line); /* must be called before errorcontext_release() */
-static sourcelocation_t* sourcelocation_delete(sourcelocation_t* s);
 static const char* sourcelocation_get_file(sourcelocation_t* s);
 static int sourcelocation_get_line(sourcelocation_t* s);
 
@@ -309,7 +354,8 @@ typedef enum {
 
 static int line; /* current line number (after preprocessing phase) */
 static symbol_t sym, oldsym; /* current/old token */
-static char symdata[SYMBOL_MAXLENGTH+1], oldsymdata[SYMBOL_MAXLENGTH+1]; /* current/old token textual data */
+static char symbuf[2][SYMBOL_MAXLENGTH+1]; /* storage for the textual data of the tokens */
+static char *symdata = symbuf[0], *oldsymdata = symbuf[1]; /* current/old token textual data (we swap the pointers instead of copying) */
 
 static void getsym(); /* read the next token */
 static void ungetsym(); /* put the last read token back into the stream */
@@ -338,6 +384,38 @@ static int traversal_adapter(const parsetree_statement_t *stmt, void *eval_fun);
 
 
 
+/* serialization */
+#define SERIALIZATION_MAGIC     "NPTREE"
+#define SERIALIZATION_VERSION   1
+#define SERIALIZATION_MAXDEPTH  256
+
+typedef struct {
+    FILE *fp;
+    const char **files; /* file table */
+    int file_count;
+    int file_capacity;
+    int last_file; /* index of the file of the last written statement */
+} treewriter_t;
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    const char **files; /* file table */
+    int file_count;
+    int file_capacity;
+    int ok; /* FALSE if the data is corrupted */
+} treereader_t;
+
+static void write_program(treewriter_t *w, const parsetree_program_t *prog);
+static void write_string(treewriter_t *w, const char *str);
+static void write_u32(treewriter_t *w, unsigned int x);
+static parsetree_program_t* read_program(treereader_t *r, int depth);
+static char* read_string(treereader_t *r);
+static unsigned int read_u32(treereader_t *r);
+
+
+
 
 
 /* ---------------------------------------------
@@ -347,12 +425,21 @@ static int traversal_adapter(const parsetree_statement_t *stmt, void *eval_fun);
 parsetree_program_t* nanoparser_construct_tree(const char *filepath)
 {
     FILE *fp;
+    srcbuffer_t src;
     parsetree_program_t *prog;
 
     fp = fopen(filepath, "r");
     if(fp != NULL) {
+        /* reads the whole file at once */
+        if(!srcbuffer_read(&src, fp))
+            error("Error reading from stream '%s'", filepath);
+        fclose(fp);
+
+        if(dependency_fun)
+            dependency_fun(filepath);
+
         /* creates the temporary virtual file */
-        vfile_create(filepath);
+        vfile_create(filepath, src.size);
 
         /* initializes the error context module (used for improved error detection) */
         errorcontext_init();
@@ -361,20 +448,24 @@ parsetree_program_t* nanoparser_construct_tree(const char *filepath)
         /* calls the preprocessor */
         preprocessor_init();
         preprocessor_add_to_include_table(filepath); /* you can't #include yourself */
-        preprocessor_run(fp, 0);
+        preprocessor_run(&src, 0);
         preprocessor_release();
+        srcbuffer_release(&src);
 
         /* calls the parser */
+        tree_arena = arena_new(vfile_size);
         prog = parse();
+        if(prog != NULL)
+            prog->arena = tree_arena;
+        else
+            arena_delete(tree_arena);
+        tree_arena = NULL;
 
         /* releases the error context module */
         errorcontext_release();
 
         /* destroys the temporary virtual file */
         vfile_destroy();
-
-        /* done! */
-        fclose(fp);
     }
     else {
         prog = NULL;
@@ -386,8 +477,25 @@ parsetree_program_t* nanoparser_construct_tree(const char *filepath)
 
 parsetree_program_t* nanoparser_deconstruct_tree(parsetree_program_t *tree)
 {
-    tree = parsetree_program_delete(tree);
-    return tree;
+    arena_t *arena = NULL, *next;
+    parsetree_program_t *p;
+
+    /* appended trees have their own arenas; we collect
+       all of them before releasing any memory */
+    for(p = tree; p != NULL; p = p->next) {
+        if(p->arena != NULL) {
+            p->arena->next = arena;
+            arena = p->arena;
+        }
+    }
+
+    /* release the arenas */
+    for(; arena != NULL; arena = next) {
+        next = arena->next;
+        arena_delete(arena);
+    }
+
+    return NULL;
 }
 
 void nanoparser_set_error_function(void (*fun)(const char*))
@@ -400,6 +508,11 @@ void nanoparser_set_warning_function(void (*fun)(const char*))
     warning_fun = fun;
 }
 
+void nanoparser_set_dependency_function(void (*fun)(const char*))
+{
+    dependency_fun = fun;
+}
+
 
 /* ---------------------------------------------
  * lexical analysis
@@ -410,11 +523,13 @@ void getsym()
 {
     int i = 0;
     unsigned int c;
-    char *p = symdata;
+    char *p;
 
     /* create a backup */
     oldsym = sym;
-    strcpy(oldsymdata, symdata);
+    p = oldsymdata;
+    oldsymdata = symdata;
+    symdata = p;
 
     /* skip white spaces */
     do {
@@ -518,7 +633,9 @@ void ungetsym()
     }
 
     /* restoring the backup */
-    strcpy(symdata, oldsymdata);
+    str = symdata;
+    symdata = oldsymdata;
+    oldsymdata = str;
     sym = oldsym;
 }
 
@@ -595,17 +712,14 @@ parsetree_program_t* parse()
 
 parsetree_program_t* program()
 {
-    parsetree_program_t *prog = NULL;
+    parsetree_program_t *prog = NULL, **tail = &prog;
 
-    if(sym != SYM_EOF && sym != SYM_ENDBLOCK) {
+    /* we should avoid using recursion here... 'prog' can be HUGE! */
+    while(sym != SYM_EOF && sym != SYM_ENDBLOCK) {
         parsetree_statement_t *stmt = statement();
-        prog = parsetree_program_new(
-            stmt,
-            program()
-        );
+        *tail = parsetree_program_new(stmt, NULL);
+        tail = &((*tail)->next);
     }
-    else
-        ; /* empty */
 
     return prog;
 }
@@ -613,7 +727,7 @@ parsetree_program_t* program()
 parsetree_statement_t* statement()
 {
     parsetree_statement_t *stmt = NULL;
-    char *str = str_dup(symdata);
+    char *str = arena_strdup(tree_arena, symdata);
 
     expect(SYM_STRING);
     stmt = parsetree_statement_new(
@@ -623,7 +737,6 @@ parsetree_statement_t* statement()
     if(sym != SYM_EOF)
         nl();
 
-    free(str);
     return stmt;
 }
 
@@ -632,13 +745,12 @@ parsetree_parameter_t* parameter()
     parsetree_parameter_t *param = NULL;
 
     if(sym == SYM_STRING) {
-        char *str = str_dup(symdata);
+        char *str = arena_strdup(tree_arena, symdata);
         accept(SYM_STRING);
         param = parsetree_parameter_new_value(
             str,
             parameter()
         );
-        free(str);
     }
     else if(sym == SYM_BEGINBLOCK) {
         param = parsetree_parameter_new_program(
@@ -696,11 +808,12 @@ void nl()
  * syntax analysis: parse tree manipulation
  * ---------------------------------------------- */
 
+/* str must have been allocated in the arena */
 parsetree_parameter_t* parsetree_parameter_new_value(const char *str, parsetree_parameter_t *nextparam)
 {
-    parsetree_parameter_t *p = malloc_x(sizeof *p);
+    parsetree_parameter_t *p = arena_alloc(tree_arena, sizeof *p);
     p->type = VALUE;
-    p->data.value.string = str_dup(str);
+    p->data.value.string = (char*)str;
     p->data.value.next = nextparam;
     p->stmt = NULL;
     return p;
@@ -708,30 +821,13 @@ parsetree_parameter_t* parsetree_parameter_new_value(const char *str, parsetree_
 
 parsetree_parameter_t* parsetree_parameter_new_program(parsetree_program_t *prog)
 {
-    parsetree_parameter_t *p = malloc_x(sizeof *p);
+    parsetree_parameter_t *p = arena_alloc(tree_arena, sizeof *p);
     p->type = PROGRAM;
     p->data.program = prog;
     p->stmt = NULL;
     return p;
 }
 
-parsetree_parameter_t* parsetree_parameter_delete(parsetree_parameter_t* param)
-{
-    if(param != NULL) {
-        if(param->type == VALUE) {
-            free(param->data.value.string);
-            param->data.value.string = NULL;
-            param->data.value.next = parsetree_parameter_delete(param->data.value.next);
-        }
-        else
-            param->data.program = parsetree_program_delete(param->data.program);
-
-        free(param);
-    }
-
-    return NULL;
-}
-
 void parsetree_parameter_show(parsetree_parameter_t* param)
 {
     printf("[ ");
@@ -749,38 +845,22 @@ void parsetree_parameter_show(parsetree_parameter_t* param)
     printf(" ] ");
 }
 
+/* str must have been allocated in the arena */
 parsetree_statement_t* parsetree_statement_new(const char *str, parsetree_parameter_t *parameter)
 {
-    parsetree_statement_t *p = malloc_x(sizeof *p);
+    parsetree_statement_t *p = arena_alloc(tree_arena, sizeof *p);
     parsetree_parameter_t *element;
-    int j, n;
 
-    p->string = str_dup(str);
+    p->string = (char*)str;
     p->parameter = parameter;
     p->source_location = sourcelocation_new(line-1);
 
-    n = nanoparser_get_number_of_parameters(element = parameter);
-    for(j=1; j<=n; j++) {
-        element = (parsetree_parameter_t*)nanoparser_get_nth_parameter(element, 1);
+    for(element = parameter; element != NULL; element = (element->type == VALUE) ? element->data.value.next : NULL)
         element->stmt = p;
-    }
 
     return p;
 }
 
-parsetree_statement_t* parsetree_statement_delete(parsetree_statement_t* stmt)
-{
-    if(stmt != NULL) {
-        stmt->source_location = sourcelocation_delete(stmt->source_location);
-        free(stmt->string);
-        stmt->string = NULL;
-        stmt->parameter = parsetree_parameter_delete(stmt->parameter);
-        free(stmt);
-    }
-
-    return NULL;
-}
-
 void parsetree_statement_show(parsetree_statement_t* stmt)
 {
     if(stmt != NULL) {
@@ -792,31 +872,91 @@ void parsetree_statement_show(parsetree_statement_t* stmt)
 
 parsetree_program_t* parsetree_program_new(parsetree_statement_t *stmt, parsetree_program_t *nextprog)
 {
-    parsetree_program_t *p = malloc_x(sizeof *p);
+    parsetree_program_t *p = arena_alloc(tree_arena, sizeof *p);
     p->statement = stmt;
     p->next = nextprog;
+    p->arena = NULL;
     return p;
 }
 
-parsetree_program_t* parsetree_program_delete(parsetree_program_t *prog)
+void parsetree_program_show(parsetree_program_t* prog)
+{
+    if(prog != NULL) {
+        parsetree_statement_show(prog->statement);
+        parsetree_program_show(prog->next);
+    }
+}
+
+
+
+/* ---------------------------------------------
+ * arena allocator
+ * ---------------------------------------------- */
+
+#define ARENA_CHUNK_HEADER_SIZE  ((sizeof(arenachunk_t) + (ARENA_ALIGNMENT-1)) & ~((size_t)ARENA_ALIGNMENT-1))
+
+arena_t* arena_new(size_t size_hint)
+{
+    arena_t *arena = malloc_x(sizeof *arena);
+
+    /* the parse tree takes a few times the size of the source */
+    arena->chunk_size = 4 * size_hint;
+    if(arena->chunk_size < ARENA_MIN_CHUNK_SIZE)
+        arena->chunk_size = ARENA_MIN_CHUNK_SIZE;
+    else if(arena->chunk_size > ARENA_MAX_CHUNK_SIZE)
+        arena->chunk_size = ARENA_MAX_CHUNK_SIZE;
+
+    arena->chunk = NULL;
+    arena->next = NULL;
+    return arena;
+}
+
+arena_t* arena_delete(arena_t *arena)
 {
-    parsetree_program_t *next = NULL;
+    arenachunk_t *chunk, *next;
 
-    for(; prog; prog = next) { /* we should avoid using recursion here... 'prog' can be HUGE! */
-        next = prog->next;
-        parsetree_statement_delete(prog->statement);
-        free(prog);
+    for(chunk = arena->chunk; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        free(chunk);
     }
 
+    free(arena);
     return NULL;
 }
 
-void parsetree_program_show(parsetree_program_t* prog)
+void* arena_alloc(arena_t *arena, size_t bytes)
 {
-    if(prog != NULL) {
-        parsetree_statement_show(prog->statement);
-        parsetree_program_show(prog->next);
+    arenachunk_t *chunk = arena->chunk;
+    void *ptr;
+
+    bytes = (bytes + (ARENA_ALIGNMENT-1)) & ~((size_t)ARENA_ALIGNMENT-1);
+
+    /* need a new chunk? */
+    if(chunk == NULL || chunk->used + bytes > chunk->size) {
+        size_t size = arena->chunk_size;
+        if(size < bytes)
+            size = bytes;
+
+        chunk = malloc_x(ARENA_CHUNK_HEADER_SIZE + size);
+        chunk->size = size;
+        chunk->used = 0;
+        chunk->next = arena->chunk;
+        arena->chunk = chunk;
+
+        if(arena->chunk_size < ARENA_MAX_CHUNK_SIZE)
+            arena->chunk_size *= 2;
     }
+
+    ptr = (char*)chunk + ARENA_CHUNK_HEADER_SIZE + chunk->used;
+    chunk->used += bytes;
+    return ptr;
+}
+
+char* arena_strdup(arena_t *arena, const char *s)
+{
+    size_t len = strlen(s);
+    char *p = arena_alloc(arena, len + 1);
+    return memcpy(p, s, len + 1);
 }
 
 
@@ -825,16 +965,20 @@ void parsetree_program_show(parsetree_program_t* prog)
  * virtual files
  * ---------------------------------------------- */
 
-void vfile_create(const char *name)
+void vfile_create(const char *name, int size_hint)
 {
     vfile_ptr = 0;
+    vfile_size = 0;
+    vfile_capacity = size_hint > 0 ? 1 + size_hint : 1024;
+    vfile_data = malloc_x(vfile_capacity * sizeof(*vfile_data));
     vfile_name = str_dup(name);
-    vfile_contents = expandable_array_int_new();
 }
 
 void vfile_destroy()
 {
-    vfile_contents = expandable_array_int_delete(vfile_contents);
+    free(vfile_data);
+    vfile_data = NULL;
+    vfile_size = vfile_capacity = 0;
     free(vfile_name);
     vfile_name = NULL;
     vfile_ptr = 0;
@@ -842,38 +986,31 @@ void vfile_destroy()
 
 int vfile_getc()
 {
-    if(vfile_ptr < expandable_array_int_size(vfile_contents)) {
-        int *ptr = expandable_array_int_at(vfile_contents, vfile_ptr++);
-        return *ptr;
-    }
-    else
-        return EOF;
+    return (vfile_ptr < vfile_size) ? vfile_data[vfile_ptr++] : EOF;
 }
 
 int vfile_ungetc(int c)
 {
-    if(vfile_ptr > 0 && c != EOF) {
-        int *ptr = expandable_array_int_at(vfile_contents, --vfile_ptr);
-        *ptr = c;
-        return *ptr;
-    }
+    if(vfile_ptr > 0 && c != EOF)
+        return (vfile_data[--vfile_ptr] = (unsigned char)c);
     else
         return EOF;
 }
 
 int vfile_putc(int c)
 {
-    int size = expandable_array_int_size(vfile_contents);
+    if(c == EOF)
+        return EOF; /* the end of the virtual file is given by its size */
 
-    if(vfile_ptr < size) {
-        int *ptr = expandable_array_int_at(vfile_contents, vfile_ptr++);
-        *ptr = c;
-    }
-    else {
-        expandable_array_int_push_back(vfile_contents, c);
-        vfile_ptr = size+1;
+    if(vfile_ptr >= vfile_capacity) {
+        vfile_capacity *= 2;
+        vfile_data = realloc_x(vfile_data, vfile_capacity * sizeof(*vfile_data));
     }
 
+    vfile_data[vfile_ptr++] = (unsigned char)c;
+    if(vfile_ptr > vfile_size)
+        vfile_size = vfile_ptr;
+
     return c;
 }
 
@@ -884,6 +1021,48 @@ void vfile_rewind()
 
 
 
+/* ---------------------------------------------
+ * source buffers
+ * ---------------------------------------------- */
+
+int srcbuffer_read(srcbuffer_t *buf, FILE *fp)
+{
+    size_t capacity = 4096, n;
+
+    /* we don't rely on the size of the file, because text mode may convert newlines */
+    buf->data = malloc_x(capacity);
+    buf->size = buf->pos = 0;
+    while((n = fread(buf->data + buf->size, 1, capacity - buf->size, fp)) > 0) {
+        buf->size += n;
+        if(buf->size == capacity) {
+            capacity *= 2;
+            buf->data = realloc_x(buf->data, capacity);
+        }
+    }
+
+    return !ferror(fp);
+}
+
+void srcbuffer_release(srcbuffer_t *buf)
+{
+    free(buf->data);
+    buf->data = NULL;
+    buf->size = buf->pos = 0;
+}
+
+int srcbuffer_getc(srcbuffer_t *buf)
+{
+    return (buf->pos < buf->size) ? buf->data[buf->pos++] : EOF;
+}
+
+void srcbuffer_ungetc(int c, srcbuffer_t *buf)
+{
+    if(c != EOF && buf->pos > 0)
+        buf->pos--;
+}
+
+
+
 
 /* ---------------------------------------------
  * preprocessor
@@ -922,34 +1101,34 @@ void preprocessor_show()
 #endif
 }
 
-void preprocessor_run(FILE *in, int depth)
+void preprocessor_run(srcbuffer_t *in, int depth)
 {
     int c;
     int line_start = TRUE;
 
-    while(EOF != (c = fgetc(in))) {
+    while(EOF != (c = srcbuffer_getc(in))) {
         /* do nothing with double-quoted strings */
         if(c == '"') {
             int old = c;
             vfile_putc(c);
-            c = fgetc(in);
+            c = srcbuffer_getc(in);
             while(((c != '"') || (old == '\\' && c == '"')) && c != EOF && c != '\n') {
                 vfile_putc(c);
                 old = c;
-                c = fgetc(in);
+                c = srcbuffer_getc(in);
             }
         }
 
         /* ignore comments */
         if(c == '/') {
-            int h = fgetc(in);
+            int h = srcbuffer_getc(in);
             if(h == '/') {
                 do {
-                    c = fgetc(in);
+                    c = srcbuffer_getc(in);
                 } while(c != '\n' && c != EOF);
             }
             else
-                ungetc(h, in);
+                srcbuffer_ungetc(h, in);
         }
 
         /* preprocessor directives */
@@ -963,27 +1142,27 @@ void preprocessor_run(FILE *in, int depth)
             p = key;
             do {
                 *(p++) = c;
-                c = fgetc(in);
+                c = srcbuffer_getc(in);
             } while(!isspace(c) && c != '\n' && c != EOF && ++key_len < 512);
             *p = 0;
 
             /* read value */
             p = value;
             while(c != '\n' && isspace(c)) /* skip spaces */
-                c = fgetc(in);
+                c = srcbuffer_getc(in);
             while(c != '\n' && c != EOF && value_len++ < 512) {
                 if(c == '/' && !quot) {
-                    int h = fgetc(in);
+                    int h = srcbuffer_getc(in);
                     if(h == '/')
                         break;
                     else
-                        ungetc(h, in);
+                        srcbuffer_ungetc(h, in);
                 }
                 if(c != '"')
                     *(p++) = c;
                 else
                     quot = !quot;
-                c = fgetc(in);
+                c = srcbuffer_getc(in);
             }
             *p = 0;
             r_trim(value);
@@ -1025,15 +1204,23 @@ void preprocessor_run(FILE *in, int depth)
                         char *old_vfile_name = vfile_name;
                         const char *me = errorcontext_detect_file_name(preprocessor_line);
                         int mel = errorcontext_detect_file_line(preprocessor_line);
-                        errorcontext_add_to_table(fullpath, preprocessor_line, 0);
+                        srcbuffer_t src;
+
+                        if(!srcbuffer_read(&src, fp))
+                            error("Error reading from stream '%s'", fullpath);
+                        fclose(fp);
+
+                        if(dependency_fun)
+                            dependency_fun(fullpath);
 
+                        errorcontext_add_to_table(fullpath, preprocessor_line, 0);
                         vfile_name = str_dup(fullpath);
-                        preprocessor_run(fp, depth+1);
+                        preprocessor_run(&src, depth+1);
                         free(vfile_name);
                         vfile_name = old_vfile_name;
+                        srcbuffer_release(&src);
 
                         errorcontext_add_to_table(me, preprocessor_line, mel);
-                        fclose(fp);
                     }
                     else {
                         error(
@@ -1087,10 +1274,6 @@ void preprocessor_run(FILE *in, int depth)
         /* accept this character */
         if(c != EOF)
             vfile_putc(c);
-        else if(feof(in))
-            vfile_putc(c);
-        else if(ferror(in))
-            error("Error reading from stream '%s'", vfile_name);
     }
 
     if(depth == 0) {
@@ -1146,6 +1329,7 @@ void errorcontext_add_to_table(const char *filename, int vfile_start_line, int v
 {
     errorcontext ctx;
     ctx.filename = str_dup(filename);
+    ctx.tree_filename = NULL;
     ctx.vfile_start_line = vfile_start_line;
     ctx.vfile_line_offset = vfile_line_offset;
     expandable_array_errorcontext_push_back(errorcontext_table, ctx);
@@ -1177,6 +1361,14 @@ const char* errorcontext_detect_file_name(int vfile_line)
     return c->filename;
 }
 
+const char* errorcontext_detect_tree_file_name(int vfile_line)
+{
+    errorcontext *c = errorcontext_find(0, vfile_line);
+    if(c->tree_filename == NULL)
+        c->tree_filename = arena_strdup(tree_arena, c->filename); /* shared by all statements */
+    return c->tree_filename;
+}
+
 
 
 /* ---------------------------------------------
@@ -1209,19 +1401,12 @@ int traversal_adapter(const parsetree_statement_t *stmt, void *eval_fun)
  * ---------------------------------------------- */
 sourcelocation_t* sourcelocation_new(int vfile_line)
 {
-    sourcelocation_t *s = malloc_x(sizeof *s);
-    s->file = str_dup(errorcontext_detect_file_name(vfile_line));
+    sourcelocation_t *s = arena_alloc(tree_arena, sizeof *s);
+    s->file = errorcontext_detect_tree_file_name(vfile_line);
     s->line = errorcontext_detect_file_line(vfile_line);
     return s;
 }
 
-sourcelocation_t* sourcelocation_delete(sourcelocation_t* s)
-{
-    free(s->file);
-    free(s);
-    return NULL;
-}
-
 const char* sourcelocation_get_file(sourcelocation_t* s)
 {
     return s->file;
@@ -1336,6 +1521,242 @@ parsetree_program_t* nanoparser_append_program(parsetree_program_t *dest, parset
 }
 
 
+/* ---------------------------------------------
+ * serialization
+ *
+ * format (little-endian):
+ *   header:     "NPTREE" | version u32
+ *   program:    statement count u32 | statements
+ *   statement:  identifier | file index u32 [ | file name ] | line u32 |
+ *               string count u32 | strings | has block u32 [ | program ]
+ *   string:     length u32 | characters (not null-terminated)
+ *
+ * file names are stored once: a file index equal to the
+ * number of files seen so far introduces a new file name
+ * --------------------------------------------- */
+
+int nanoparser_save_tree(const parsetree_program_t *tree, FILE *fp)
+{
+    treewriter_t w;
+
+    w.fp = fp;
+    w.file_count = 0;
+    w.file_capacity = 8;
+    w.files = malloc_x(w.file_capacity * sizeof(*(w.files)));
+    w.last_file = -1;
+
+    fwrite(SERIALIZATION_MAGIC, 1, strlen(SERIALIZATION_MAGIC), fp);
+    write_u32(&w, SERIALIZATION_VERSION);
+    write_program(&w, tree);
+
+    free(w.files);
+    return !ferror(fp);
+}
+
+int nanoparser_load_tree(FILE *fp, parsetree_program_t **tree)
+{
+    treereader_t r;
+    srcbuffer_t src;
+    size_t magic_length = strlen(SERIALIZATION_MAGIC);
+
+    *tree = NULL;
+    if(!srcbuffer_read(&src, fp))
+        return FALSE;
+
+    r.data = src.data;
+    r.size = src.size;
+    r.pos = 0;
+    r.file_count = 0;
+    r.file_capacity = 8;
+    r.files = malloc_x(r.file_capacity * sizeof(*(r.files)));
+    r.ok = (r.size >= magic_length && memcmp(r.data, SERIALIZATION_MAGIC, magic_length) == 0);
+
+    /* read the tree */
+    tree_arena = arena_new(src.size);
+    if(r.ok) {
+        r.pos = magic_length;
+        if(read_u32(&r) == SERIALIZATION_VERSION && r.ok)
+            *tree = read_program(&r, 0);
+        else
+            r.ok = FALSE;
+    }
+
+    /* the whole stream must have been consumed */
+    if(!r.ok || r.pos != r.size) {
+        *tree = NULL;
+        r.ok = FALSE;
+    }
+
+    if(*tree != NULL)
+        (*tree)->arena = tree_arena;
+    else
+        arena_delete(tree_arena);
+    tree_arena = NULL;
+
+    free(r.files);
+    srcbuffer_release(&src);
+    return r.ok;
+}
+
+void write_program(treewriter_t *w, const parsetree_program_t *prog)
+{
+    const parsetree_program_t *p;
+    const parsetree_parameter_t *param;
+    int i, count = 0;
+
+    for(p = prog; p != NULL; p = p->next)
+        count++;
+    write_u32(w, count);
+
+    for(p = prog; p != NULL; p = p->next) {
+        const parsetree_statement_t *stmt = p->statement;
+        const char *file = stmt->source_location->file;
+
+        /* identifier */
+        write_string(w, stmt->string);
+
+        /* source location */
+        if(w->last_file < 0 || strcmp(w->files[w->last_file], file) != 0) {
+            for(i = 0; i < w->file_count && strcmp(w->files[i], file) != 0; i++);
+            if(i == w->file_count) {
+                if(w->file_count >= w->file_capacity) {
+                    w->file_capacity *= 2;
+                    w->files = realloc_x(w->files, w->file_capacity * sizeof(*(w->files)));
+                }
+                w->files[w->file_count++] = file;
+                write_u32(w, i);
+                write_string(w, file);
+            }
+            else
+                write_u32(w, i);
+            w->last_file = i;
+        }
+        else
+            write_u32(w, w->last_file);
+        write_u32(w, (unsigned int)stmt->source_location->line);
+
+        /* parameters */
+        count = 0;
+        for(param = stmt->parameter; param != NULL && param->type == VALUE; param = param->data.value.next)
+            count++;
+        write_u32(w, count);
+        for(param = stmt->parameter; param != NULL && param->type == VALUE; param = param->data.value.next)
+            write_string(w, param->data.value.string);
+
+        /* block */
+        write_u32(w, param != NULL);
+        if(param != NULL)
+            write_program(w, param->data.program);
+    }
+}
+
+void write_string(treewriter_t *w, const char *str)
+{
+    size_t length = strlen(str);
+    write_u32(w, (unsigned int)length);
+    fwrite(str, 1, length, w->fp);
+}
+
+void write_u32(treewriter_t *w, unsigned int x)
+{
+    unsigned char buf[4] = { x & 0xFF, (x >> 8) & 0xFF, (x >> 16) & 0xFF, (x >> 24) & 0xFF };
+    fwrite(buf, 1, 4, w->fp);
+}
+
+parsetree_program_t* read_program(treereader_t *r, int depth)
+{
+    parsetree_program_t *prog = NULL, **tail = &prog;
+    unsigned int i, j, count;
+
+    if(depth > SERIALIZATION_MAXDEPTH) {
+        r->ok = FALSE;
+        return NULL;
+    }
+
+    count = read_u32(r);
+    for(i = 0; i < count && r->ok; i++) {
+        parsetree_statement_t *stmt = arena_alloc(tree_arena, sizeof *stmt);
+        parsetree_parameter_t **param = &(stmt->parameter);
+        unsigned int file, value_count;
+
+        /* identifier */
+        stmt->string = read_string(r);
+
+        /* source location */
+        stmt->source_location = arena_alloc(tree_arena, sizeof(sourcelocation_t));
+        file = read_u32(r);
+        if(file == (unsigned int)r->file_count && r->ok) {
+            if(r->file_count >= r->file_capacity) {
+                r->file_capacity *= 2;
+                r->files = realloc_x(r->files, r->file_capacity * sizeof(*(r->files)));
+            }
+            r->files[r->file_count++] = read_string(r);
+        }
+        else if(file > (unsigned int)r->file_count)
+            r->ok = FALSE;
+        stmt->source_location->file = r->ok ? r->files[file] : "";
+        stmt->source_location->line = (int)read_u32(r);
+
+        /* parameters */
+        value_count = read_u32(r);
+        for(j = 0; j < value_count && r->ok; j++) {
+            char *str = read_string(r);
+            *param = parsetree_parameter_new_value(str, NULL);
+            (*param)->stmt = stmt;
+            param = &((*param)->data.value.next);
+        }
+
+        /* block */
+        *param = NULL;
+        if(read_u32(r) && r->ok) {
+            *param = parsetree_parameter_new_program(read_program(r, depth + 1));
+            (*param)->stmt = stmt;
+        }
+
+        *tail = parsetree_program_new(stmt, NULL);
+        tail = &((*tail)->next);
+    }
+
+    return prog;
+}
+
+char* read_string(treereader_t *r)
+{
+    unsigned int length = read_u32(r);
+    char *str;
+
+    if(!r->ok || length > r->size - r->pos) {
+        r->ok = FALSE;
+        return "";
+    }
+
+    str = arena_alloc(tree_arena, length + 1);
+    memcpy(str, r->data + r->pos, length);
+    str[length] = 0;
+    r->pos += length;
+
+    return str;
+}
+
+unsigned int read_u32(treereader_t *r)
+{
+    const unsigned char *buf = r->data + r->pos;
+
+    if(!r->ok || r->size - r->pos < 4) {
+        r->ok = FALSE;
+        return 0;
+    }
+
+    r->pos += 4;
+    return
+        ((unsigned int)buf[0]) |
+        (((unsigned int)buf[1]) << 8) |
+        (((unsigned int)buf[2]) << 16) |
+        (((unsigned int)buf[3]) << 24)
+    ;
+}
+
+
 /* ---------------------------------------------
  * utilities
  * ---------------------------------------------- */
@@ -1444,3 +1865,76 @@ void* realloc_x(void *ptr, size_t bytes)
 }
 #endif
 
+
+
+/* ---------------------------------------------
+ * parse-throughput benchmark
+ * ---------------------------------------------- */
+#ifdef NANOPARSER_BENCHMARK
+#include <time.h>
+
+static int count_statements(const parsetree_program_t *prog)
+{
+    int n = 0;
+
+    for(; prog != NULL; prog = prog->next) {
+        const parsetree_parameter_t *param = prog->statement->parameter;
+        while(param != NULL && param->type == VALUE)
+            param = param->data.value.next;
+        n += 1 + (param != NULL ? count_statements(param->data.program) : 0);
+    }
+
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    int i, r, rounds = 100, statements = 0;
+    long bytes = 0;
+    double seconds;
+    clock_t start;
+
+    if(argc > 2 && strcmp(argv[1], "-n") == 0) {
+        rounds = atoi(argv[2]);
+        argv += 2;
+        argc -= 2;
+    }
+
+    if(argc < 2 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [-n rounds] file1 [file2 ...]\n", argv[0]);
+        return 1;
+    }
+
+    /* size of the input */
+    for(i = 1; i < argc; i++) {
+        FILE *fp = fopen(argv[i], "rb");
+        if(fp != NULL) {
+            fseek(fp, 0, SEEK_END);
+            bytes += ftell(fp);
+            fclose(fp);
+        }
+    }
+
+    /* parse the files a few times */
+    start = clock();
+    for(r = 0; r < rounds; r++) {
+        parsetree_program_t *tree = NULL;
+        for(i = 1; i < argc; i++)
+            tree = nanoparser_append_program(tree, nanoparser_construct_tree(argv[i]));
+        if(r == 0)
+            statements = count_statements(tree);
+        tree = nanoparser_deconstruct_tree(tree);
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* results */
+    printf("%d file(s), %ld bytes, %d statements, %d rounds\n", argc - 1, bytes, statements, rounds);
+    printf("%.3f s, %.2f MB/s, %.0f statements/s\n",
+        seconds,
+        seconds > 0.0 ? (double)bytes * rounds / (seconds * 1024.0 * 1024.0) : 0.0,
+        seconds > 0.0 ? (double)statements * rounds / seconds : 0.0
+    );
+
+    return 0;
+}
+#endif
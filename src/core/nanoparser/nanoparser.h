@@ -54,11 +54,22 @@ III) "my text file.txt" example:
                 }
             }
         }
+
+IV)  Benchmark
+
+        The parse tree of each file is allocated from a single arena,
+        which is released by nanoparser_deconstruct_tree(). To measure
+        the parse throughput, compile nanoparser.c as a program:
+
+        gcc -O2 -DNANOPARSER_BENCHMARK nanoparser.c -o nanoparser_benchmark
+        ./nanoparser_benchmark -n 100 "my text file.txt"
 */
 
 #ifndef _NANOPARSER_H
 #define _NANOPARSER_H
 
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -104,6 +115,19 @@ void nanoparser_set_error_function(void (*fun)(const char*));
 /* you may optionally define your own warning function (it will be called when a warning arises). It receives a warning string */
 void nanoparser_set_warning_function(void (*fun)(const char*));
 
+/* you may optionally define a dependency function. It will be called with the path of each file read by nanoparser_construct_tree() (the file itself and the files it #includes) */
+void nanoparser_set_dependency_function(void (*fun)(const char*));
+
+
+
+/* ===== SERIALIZATION ===== */
+
+/* writes a parse tree to a stream opened in binary mode. Returns non-zero on success. */
+int nanoparser_save_tree(const parsetree_program_t *tree, FILE *fp);
+
+/* reads a parse tree written by nanoparser_save_tree() from a stream opened in binary mode. Returns non-zero on success. The tree must be deconstructed as usual. */
+int nanoparser_load_tree(FILE *fp, parsetree_program_t **tree);
+
 
 
 /* ===== TREE TRAVERSAL ===== */
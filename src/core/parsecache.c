@@ -0,0 +1,211 @@
+/*
+ * Open Surge Engine
+ * parsecache.c - cache of parse trees
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "parsecache.h"
+#include "assetfs.h"
+#include "stringutil.h"
+#include "logfile.h"
+#include "global.h"
+#include "darray.h"
+#include "util.h"
+
+/*
+   cached tree file format (little-endian):
+
+   header:          magic[8] | format u32 | engine version u32 | dependency count u32
+   dependencies:    { path length u32 | path | content hash u64 } x dependency count
+   tree:            see nanoparser_save_tree()
+
+   the first dependency is the source file itself
+*/
+#define PARSECACHE_MAGIC        "SURGEPTC"
+#define PARSECACHE_FORMAT       1 /* increment whenever the format changes */
+#define PARSECACHE_DIR          "parsecache/" /* in the cache of the assetfs */
+#define HEADER_SIZE             20
+#define MAX_PATH_LENGTH         4096
+
+/* private stuff */
+STATIC_DARRAY(char*, dependencies); /* files read while constructing a tree (absolute paths) */
+static void add_dependency(const char* fullpath);
+static char* cache_vpath(const char* vpath);
+static parsetree_program_t* read_cached_tree(const char* cache_fullpath, const char* fullpath, bool* success);
+static bool read_header(FILE* fp, const char* fullpath);
+static void write_cached_tree(const char* cache_fullpath, const parsetree_program_t* tree);
+
+
+
+/* public API */
+
+/*
+ * parsecache_construct_tree()
+ * Constructs the parse tree of a file given its virtual path.
+ * If the file (and the files it #includes) hasn't changed since
+ * it was last parsed, the tree is loaded from the cache
+ */
+parsetree_program_t* parsecache_construct_tree(const char* vpath)
+{
+    char* fullpath = str_dup(assetfs_fullpath(vpath));
+    char* cvpath = cache_vpath(vpath);
+    parsetree_program_t* tree = NULL;
+    bool success = false;
+
+    /* is there a cached tree? */
+    if(assetfs_exists(cvpath) && assetfs_is_cache_file(cvpath)) {
+        tree = read_cached_tree(assetfs_fullpath(cvpath), fullpath, &success);
+        if(!success)
+            logfile_debug("Cached parse tree \"%s\" is out of date", cvpath);
+    }
+
+    /* parse the file and update the cache */
+    if(!success) {
+        darray_init(dependencies);
+        nanoparser_set_dependency_function(add_dependency);
+        tree = nanoparser_construct_tree(fullpath);
+        nanoparser_set_dependency_function(NULL);
+
+        write_cached_tree(assetfs_create_cache_file(cvpath), tree);
+
+        for(int i = 0; i < darray_length(dependencies); i++)
+            free(dependencies[i]);
+        darray_release(dependencies);
+    }
+
+    free(cvpath);
+    free(fullpath);
+    return tree;
+}
+
+
+
+/* private */
+
+/* a file has been read by the parser */
+void add_dependency(const char* fullpath)
+{
+    darray_push(dependencies, str_dup(fullpath));
+}
+
+/* the virtual path of the cached tree of a file */
+char* cache_vpath(const char* vpath)
+{
+    char* cvpath = mallocx((strlen(PARSECACHE_DIR) + strlen(vpath) + 5) * sizeof(*cvpath));
+    return strcat(strcat(strcpy(cvpath, PARSECACHE_DIR), vpath), ".bin");
+}
+
+/* reads a cached tree, provided that it's up to date */
+parsetree_program_t* read_cached_tree(const char* cache_fullpath, const char* fullpath, bool* success)
+{
+    parsetree_program_t* tree = NULL;
+    FILE* fp;
+
+    *success = false;
+    if(NULL != (fp = fopen(cache_fullpath, "rb"))) {
+        if(read_header(fp, fullpath))
+            *success = nanoparser_load_tree(fp, &tree);
+        fclose(fp);
+    }
+
+    return tree;
+}
+
+/* reads the header of a cached tree, checking if its dependencies have changed */
+bool read_header(FILE* fp, const char* fullpath)
+{
+    uint8_t header[HEADER_SIZE], buf[8];
+    char path[MAX_PATH_LENGTH];
+    uint32_t dependency_count;
+
+    /* validate the header */
+    if(1 != fread(header, sizeof(header), 1, fp) || memcmp(header, PARSECACHE_MAGIC, 8) != 0)
+        return false;
+    else if(le32_to_cpu(header + 8) != PARSECACHE_FORMAT || le32_to_cpu(header + 12) != GAME_VERSION_CODE)
+        return false;
+    else if(0 == (dependency_count = le32_to_cpu(header + 16)))
+        return false;
+
+    /* validate the dependencies */
+    for(uint32_t i = 0; i < dependency_count; i++) {
+        uint32_t path_length;
+        uint64_t hash;
+
+        if(1 != fread(buf, 4, 1, fp) || (path_length = le32_to_cpu(buf)) >= sizeof(path))
+            return false;
+        else if(1 != fread(path, path_length, 1, fp) || 1 != fread(buf, 8, 1, fp))
+            return false;
+        path[path_length] = '\0';
+
+        /* the source file must come first */
+        if(i == 0 && strcmp(path, fullpath) != 0)
+            return false;
+
+        /* has the file changed? */
+        if(!hash_file(path, &hash) || hash != le64_to_cpu(buf))
+            return false;
+    }
+
+    return true;
+}
+
+/* writes a tree to the cache */
+void write_cached_tree(const char* cache_fullpath, const parsetree_program_t* tree)
+{
+    uint8_t header[HEADER_SIZE], buf[8];
+    bool success = true;
+    FILE* fp;
+
+    if(NULL == (fp = fopen(cache_fullpath, "wb"))) {
+        logfile_warning("Can't write cached parse tree \"%s\"", cache_fullpath);
+        return;
+    }
+
+    /* header */
+    memcpy(header, PARSECACHE_MAGIC, 8);
+    cpu_to_le32(PARSECACHE_FORMAT, header + 8);
+    cpu_to_le32(GAME_VERSION_CODE, header + 12);
+    cpu_to_le32((uint32_t)darray_length(dependencies), header + 16);
+    success = success && (1 == fwrite(header, sizeof(header), 1, fp));
+
+    /* dependencies */
+    for(int i = 0; i < darray_length(dependencies) && success; i++) {
+        uint32_t path_length = strlen(dependencies[i]);
+        uint64_t hash;
+
+        success = success && (path_length < MAX_PATH_LENGTH) && hash_file(dependencies[i], &hash);
+        if(success) {
+            cpu_to_le32(path_length, buf);
+            success = success && (1 == fwrite(buf, 4, 1, fp));
+            success = success && (1 == fwrite(dependencies[i], path_length, 1, fp));
+            cpu_to_le64(hash, buf);
+            success = success && (1 == fwrite(buf, 8, 1, fp));
+        }
+    }
+
+    /* tree */
+    success = success && nanoparser_save_tree(tree, fp);
+
+    if(fclose(fp) != 0 || !success) {
+        logfile_warning("Can't write cached parse tree \"%s\"", cache_fullpath);
+        remove(cache_fullpath);
+    }
+}
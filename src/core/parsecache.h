@@ -0,0 +1,36 @@
+/*
+ * Open Surge Engine
+ * parsecache.h - cache of parse trees
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PARSECACHE_H
+#define _PARSECACHE_H
+
+#include "nanoparser/nanoparser.h"
+
+/*
+   The parse cache stores the parse trees of the config
+   assets (sprites, fonts, bricksets...) in the cache of
+   the assetfs, so that they can be loaded without any
+   tokenizing. A cached tree is keyed by the content
+   hash of its source file and of the files it #includes.
+*/
+
+parsetree_program_t* parsecache_construct_tree(const char* vpath); /* same as nanoparser_construct_tree(), but takes a virtual path */
+
+#endif
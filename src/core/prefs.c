@@ -129,10 +129,6 @@ static void prefs_add_entry(prefs_t* prefs, prefsentry_t* entry);
 static int prefs_count_entries(const prefs_t* prefs);
 static uint16_t le16_to_cpu(const uint8_t* buf);
 static void cpu_to_le16(uint16_t input, uint8_t* buf);
-static uint32_t le32_to_cpu(const uint8_t* buf);
-static void cpu_to_le32(uint32_t input, uint8_t* buf);
-static uint64_t le64_to_cpu(const uint8_t* buf);
-static void cpu_to_le64(uint64_t input, uint8_t* buf);
 static uint32_t double_serialize(double input, uint8_t* buf);
 static double double_deserialize(const uint8_t* buf, uint32_t size);
 static inline int keycmp(const char* a, const char* b);
@@ -517,24 +513,6 @@ int prefs_count_entries(const prefs_t* prefs)
 }
 
 /* endianess conversion */
-uint32_t le32_to_cpu(const uint8_t* buf)
-{
-    return
-        ((uint32_t)buf[0]) |
-        (((uint32_t)buf[1]) << 8) |
-        (((uint32_t)buf[2]) << 16) |
-        (((uint32_t)buf[3]) << 24)
-    ;
-}
-
-void cpu_to_le32(uint32_t input, uint8_t* buf)
-{
-    buf[0] = (input & 0x000000FF);
-    buf[1] = (input & 0x0000FF00) >> 8;
-    buf[2] = (input & 0x00FF0000) >> 16;
-    buf[3] = (input & 0xFF000000) >> 24;
-}
-
 uint16_t le16_to_cpu(const uint8_t* buf)
 {
     return
@@ -549,32 +527,6 @@ void cpu_to_le16(uint16_t input, uint8_t* buf)
     buf[1] = (input & 0xFF00) >> 8;
 }
 
-uint64_t le64_to_cpu(const uint8_t* buf)
-{
-    return
-        ((uint64_t)buf[0]) |
-        (((uint64_t)buf[1]) << 8) |
-        (((uint64_t)buf[2]) << 16) |
-        (((uint64_t)buf[3]) << 24) |
-        (((uint64_t)buf[4]) << 32) |
-        (((uint64_t)buf[5]) << 40) |
-        (((uint64_t)buf[6]) << 48) |
-        (((uint64_t)buf[7]) << 56)
-    ;
-}
-
-void cpu_to_le64(uint64_t input, uint8_t* buf)
-{
-    buf[0] = (input & 0x00000000000000FFLL);
-    buf[1] = (input & 0x000000000000FF00LL) >> 8;
-    buf[2] = (input & 0x0000000000FF0000LL) >> 16;
-    buf[3] = (input & 0x00000000FF000000LL) >> 24;
-    buf[4] = (input & 0x000000FF00000000LL) >> 32;
-    buf[5] = (input & 0x0000FF0000000000LL) >> 40;
-    buf[6] = (input & 0x00FF000000000000LL) >> 48;
-    buf[7] = (input & 0xFF00000000000000LL) >> 56;
-}
-
 /* Jenkins' hash function */
 uint32_t hash(const char* str)
 {
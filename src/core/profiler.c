@@ -0,0 +1,455 @@
+/*
+ * Open Surge Engine
+ * profiler.c - frame profiler
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "profiler.h"
+#include "video.h"
+#include "image.h"
+#include "color.h"
+#include "font.h"
+#include "input.h"
+#include "timer.h"
+#include "logfile.h"
+#include "stringutil.h"
+#include "darray.h"
+#include "memtrack.h"
+#include "resourcemanager.h"
+#include "util.h"
+
+#if defined(A5BUILD)
+#include <allegro5/allegro.h>
+#endif
+
+/* private stuff */
+#define MAX_ZONES           64 /* maximum number of distinct phases */
+#define MAX_DEPTH           8 /* maximum nesting level */
+#define MAX_SPANS           256 /* maximum number of timed scopes per frame */
+#define MAX_PATH_LENGTH     128
+#define ROW_HEIGHT          4 /* height of a row of the flame bar, in pixels */
+static const double FRAME_BUDGET = 1.0 / 60.0; /* in seconds */
+static const double SMOOTHING = 0.05; /* smoothing factor of the displayed timings */
+
+/* a phase of the frame, identified by its name and by its parent */
+typedef struct zone_t {
+    const char* name; /* a string literal */
+    char path[MAX_PATH_LENGTH]; /* e.g., "render/render_level/sort" */
+    int parent; /* index of the parent zone, or -1 */
+    int depth; /* nesting level */
+    int calls; /* number of scopes in the current frame */
+    double elapsed; /* time spent in the current frame, in seconds */
+    double average; /* smoothed time per frame, in seconds */
+    DARRAY(float, samples); /* time spent in each collected frame, in milliseconds */
+} zone_t;
+
+/* a timed scope, relative to the beginning of its frame */
+typedef struct span_t {
+    int zone;
+    double start, end; /* in seconds */
+} span_t;
+
+static zone_t zone[MAX_ZONES];
+static int zone_count = 0;
+
+static int stack[MAX_DEPTH]; /* the open scopes */
+static double stack_start[MAX_DEPTH];
+static int stack_top = 0; /* may exceed MAX_DEPTH; deeper scopes are not timed */
+
+static span_t span[2][MAX_SPANS]; /* the spans of the current and of the previous frame */
+static int span_count[2] = { 0, 0 };
+static int current = 0; /* index of the current frame in span[] */
+
+static double frame_start = 0.0;
+static double frame_duration = 0.0, average_frame_duration = 0.0;
+static unsigned frame_number = 0;
+static uint32_t frame_allocations = 0; /* calls to mallocx() in the previous frame */
+static uint32_t allocations_at_frame_start = 0;
+
+static bool collecting = false; /* collect statistics? */
+static unsigned first_collected_frame = 0;
+STATIC_DARRAY(float, frame_samples); /* duration of each collected frame, in milliseconds */
+
+static bool visible = false;
+static FILE* csv = NULL;
+static input_t* in = NULL;
+static font_t* legend = NULL;
+
+static double now();
+static int find_zone(const char* name, int parent);
+static color_t zone_color(int zone_id);
+static void write_frame(unsigned frame, double duration);
+static void compute_statistics(const char* zone, float* samples, int count, profilerstats_t* stats);
+static int compare_samples(const void* a, const void* b);
+
+
+
+/* public API */
+
+/*
+ * profiler_init()
+ * Initializes the profiler. If csv_filepath isn't NULL,
+ * the timings of each frame are written to that file
+ */
+void profiler_init(const char* csv_filepath)
+{
+    zone_count = 0;
+    stack_top = 0;
+    span_count[0] = span_count[1] = 0;
+    current = 0;
+    frame_number = 0;
+    frame_duration = average_frame_duration = 0.0;
+    frame_start = now();
+    frame_allocations = 0;
+    allocations_at_frame_start = allocation_count();
+    collecting = false;
+    darray_init(frame_samples);
+
+    in = input_create_user("profiler");
+    legend = font_create("default");
+    font_set_position(legend, v2d_new(2, 2 + ROW_HEIGHT * MAX_DEPTH));
+    font_set_visible(legend, false);
+
+    if(csv_filepath != NULL) {
+        if(NULL != (csv = fopen(csv_filepath, "w"))) {
+            logfile_message("Writing the frame profile to \"%s\"", csv_filepath);
+            fprintf(csv, "frame,zone,depth,calls,ms\n");
+        }
+        else
+            logfile_message("Can't open \"%s\" for writing", csv_filepath);
+    }
+}
+
+/*
+ * profiler_release()
+ * Releases the profiler, closing the CSV file
+ */
+void profiler_release()
+{
+    if(csv != NULL) {
+        fclose(csv);
+        csv = NULL;
+    }
+
+    for(int i = 0; i < zone_count; i++)
+        darray_release(zone[i].samples);
+    darray_release(frame_samples);
+    zone_count = 0;
+
+    font_destroy(legend);
+    legend = NULL;
+
+    input_destroy(in);
+    in = NULL;
+}
+
+/*
+ * profiler_new_frame()
+ * Ends the current frame and starts a new one
+ */
+void profiler_new_frame()
+{
+    double t = now();
+
+    /* scopes can't span across frames */
+    stack_top = 0;
+
+    /* finish the current frame */
+    frame_duration = t - frame_start;
+    average_frame_duration += SMOOTHING * (frame_duration - average_frame_duration);
+    for(int i = 0; i < zone_count; i++)
+        zone[i].average += SMOOTHING * (zone[i].elapsed - zone[i].average);
+    if(csv != NULL)
+        write_frame(frame_number, frame_duration);
+    if(collecting && frame_number >= first_collected_frame) {
+        darray_push(frame_samples, (float)(frame_duration * 1000.0));
+        for(int i = 0; i < zone_count; i++) {
+            if(zone[i].calls > 0)
+                darray_push(zone[i].samples, (float)(zone[i].elapsed * 1000.0));
+        }
+    }
+
+    /* count the allocations */
+    frame_allocations = allocation_count() - allocations_at_frame_start;
+    allocations_at_frame_start = allocation_count();
+    memtrack_new_frame();
+
+    /* start a new frame */
+    for(int i = 0; i < zone_count; i++) {
+        zone[i].elapsed = 0.0;
+        zone[i].calls = 0;
+    }
+    current = 1 - current;
+    span_count[current] = 0;
+    frame_start = t;
+    frame_number++;
+}
+
+/*
+ * profiler_begin()
+ * Starts timing a phase of the frame. name must be a string literal
+ */
+void profiler_begin(const char* name)
+{
+    if(stack_top < MAX_DEPTH) {
+        int parent = (stack_top > 0) ? stack[stack_top - 1] : -1;
+        stack[stack_top] = (parent >= -1) ? find_zone(name, parent) : -2;
+        stack_start[stack_top] = now();
+    }
+
+    stack_top++;
+}
+
+/*
+ * profiler_end()
+ * Ends the phase that was most recently started
+ */
+void profiler_end()
+{
+    int zone_id;
+    double t;
+
+    if(stack_top == 0 || --stack_top >= MAX_DEPTH)
+        return;
+    else if((zone_id = stack[stack_top]) < 0)
+        return;
+
+    t = now();
+    zone[zone_id].elapsed += t - stack_start[stack_top];
+    zone[zone_id].calls++;
+
+    if(span_count[current] < MAX_SPANS) {
+        span_t* s = &span[current][span_count[current]++];
+        s->zone = zone_id;
+        s->start = stack_start[stack_top] - frame_start;
+        s->end = t - frame_start;
+    }
+}
+
+/*
+ * profiler_render()
+ * Renders the flame bar of the previous frame,
+ * if the overlay is visible
+ */
+void profiler_render()
+{
+    const int previous = 1 - current;
+    const int width = VIDEO_SCREEN_W;
+    const double scale = (width / 2) / FRAME_BUDGET; /* pixels per second */
+    char text[1024] = "";
+    int length = 0;
+
+    /* toggle the overlay */
+    if(input_button_pressed(in, IB_FIRE1))
+        profiler_show(!visible);
+
+    if(!visible)
+        return;
+
+    /* flame bar: one row per nesting level */
+    image_rectfill(0, 0, width - 1, ROW_HEIGHT * MAX_DEPTH - 1, color_rgb(0, 0, 0));
+    for(int i = 0; i < span_count[previous]; i++) {
+        const span_t* s = &span[previous][i];
+        int y = ROW_HEIGHT * zone[s->zone].depth;
+        int x1 = (int)(s->start * scale), x2 = (int)(s->end * scale);
+        if(x1 < width)
+            image_rectfill(x1, y, min(x2, width - 1), y + ROW_HEIGHT - 2, zone_color(s->zone));
+    }
+    image_line(width / 2, 0, width / 2, ROW_HEIGHT * MAX_DEPTH - 1, color_rgb(255, 255, 255)); /* the frame budget */
+
+    /* legend: the outermost phases */
+    length += snprintf(text, sizeof(text), "frame %.2f ms\n", average_frame_duration * 1000.0);
+    for(int i = 0; i < zone_count && length < (int)sizeof(text); i++) {
+        if(zone[i].depth <= 1) {
+            uint8_t r, g, b, a;
+            color_unmap(zone_color(i), &r, &g, &b, &a);
+            length += snprintf(text + length, sizeof(text) - length, "%*s<color=%02x%02x%02x>%s</color> %.2f ms\n", 2 * zone[i].depth, "", r, g, b, zone[i].name, zone[i].average * 1000.0);
+        }
+    }
+
+    /* legend: memory */
+    if(memtrack_is_enabled()) {
+        memstats_t mem[16];
+        int count = memtrack_get_stats(mem, sizeof(mem) / sizeof(mem[0]));
+        for(int i = 0; i < count && length < (int)sizeof(text); i++)
+            length += snprintf(text + length, sizeof(text) - length, "%*s%s %.1f KB (peak %.1f KB) %u allocs\n", i > 0 ? 2 : 0, "", mem[i].tag, mem[i].live_bytes / 1024.0, mem[i].peak_bytes / 1024.0, mem[i].frame_allocations);
+    }
+    else if(length < (int)sizeof(text))
+        length += snprintf(text + length, sizeof(text) - length, "%u allocs\n", frame_allocations);
+
+    /* legend: resource manager */
+    if(resourcemanager_is_initialized() && length < (int)sizeof(text)) {
+        const resourcemanager_stats_t* res = resourcemanager_stats();
+        length += snprintf(text + length, sizeof(text) - length, "resources %.1f MB (unused %.1f MB)\n  %lu hits %lu misses %lu evictions\n",
+            res->used_bytes / 1048576.0, res->unused_bytes / 1048576.0,
+            (unsigned long)res->hits, (unsigned long)res->misses, (unsigned long)res->evictions);
+    }
+
+    font_set_text(legend, "%s", text);
+    font_set_visible(legend, true);
+    font_render(legend, v2d_new(VIDEO_SCREEN_W / 2, VIDEO_SCREEN_H / 2));
+}
+
+/*
+ * profiler_show()
+ * Shows or hides the overlay
+ */
+void profiler_show(bool show)
+{
+    visible = show;
+}
+
+/*
+ * profiler_is_visible()
+ * Is the overlay visible?
+ */
+bool profiler_is_visible()
+{
+    return visible;
+}
+
+/*
+ * profiler_collect_statistics()
+ * Starts or stops keeping the timings of every frame. The
+ * frame in progress is not collected, since it may have
+ * been disturbed by whatever made us start collecting
+ */
+void profiler_collect_statistics(bool collect)
+{
+    if(collect && !collecting)
+        first_collected_frame = frame_number + 1;
+
+    collecting = collect;
+}
+
+/*
+ * profiler_get_statistics()
+ * Computes the statistics of the collected frames. The first
+ * entry refers to the whole frame; the others, to its phases.
+ * Returns the number of entries written to stats
+ */
+int profiler_get_statistics(profilerstats_t* stats, int max_count)
+{
+    int count = 0;
+
+    if(count < max_count)
+        compute_statistics("frame", frame_samples, darray_length(frame_samples), &stats[count++]);
+
+    for(int i = 0; i < zone_count && count < max_count; i++) {
+        if(darray_length(zone[i].samples) > 0)
+            compute_statistics(zone[i].path, zone[i].samples, darray_length(zone[i].samples), &stats[count++]);
+    }
+
+    return count;
+}
+
+
+
+/* private */
+
+/* the current time, in seconds */
+double now()
+{
+#if defined(A5BUILD)
+    return al_get_time();
+#else
+    return timer_get_ticks() * 0.001;
+#endif
+}
+
+/* finds (or creates) a zone given its name and its parent. Returns -2 if there's no room */
+int find_zone(const char* name, int parent)
+{
+    zone_t* z;
+
+    for(int i = 0; i < zone_count; i++) {
+        if(zone[i].parent == parent && (zone[i].name == name || strcmp(zone[i].name, name) == 0))
+            return i;
+    }
+
+    if(zone_count >= MAX_ZONES)
+        return -2;
+
+    z = &zone[zone_count];
+    z->name = name;
+    z->parent = parent;
+    z->depth = (parent >= 0) ? zone[parent].depth + 1 : 0;
+    z->calls = 0;
+    z->elapsed = z->average = 0.0;
+    darray_init(z->samples);
+    str_cpy(z->path, (parent >= 0) ? zone[parent].path : "", sizeof(z->path));
+    if(parent >= 0)
+        strncat(z->path, "/", sizeof(z->path) - strlen(z->path) - 1);
+    strncat(z->path, name, sizeof(z->path) - strlen(z->path) - 1);
+
+    return zone_count++;
+}
+
+/* the color of a zone in the flame bar */
+color_t zone_color(int zone_id)
+{
+    static const uint8_t palette[][3] = {
+        { 230, 80, 60 }, { 240, 160, 40 }, { 230, 220, 60 }, { 120, 200, 80 },
+        { 60, 180, 200 }, { 80, 120, 230 }, { 170, 100, 220 }, { 220, 100, 170 }
+    };
+    const uint8_t* c = palette[zone_id % (sizeof(palette) / sizeof(palette[0]))];
+    return color_rgb(c[0], c[1], c[2]);
+}
+
+/* writes the timings of a frame to the CSV file. The first
+   row of each frame, with an empty zone, is the whole frame */
+void write_frame(unsigned frame, double duration)
+{
+    fprintf(csv, "%u,,0,1,%.4f\n", frame, duration * 1000.0);
+    for(int i = 0; i < zone_count; i++) {
+        if(zone[i].calls > 0)
+            fprintf(csv, "%u,%s,%d,%d,%.4f\n", frame, zone[i].path, zone[i].depth + 1, zone[i].calls, zone[i].elapsed * 1000.0);
+    }
+}
+
+/* computes the statistics of a phase. samples will be sorted */
+void compute_statistics(const char* zone, float* samples, int count, profilerstats_t* stats)
+{
+    double sum = 0.0;
+
+    stats->zone = zone;
+    stats->frames = count;
+    stats->min = stats->avg = stats->p99 = stats->max = 0.0;
+    if(count == 0)
+        return;
+
+    qsort(samples, count, sizeof(*samples), compare_samples);
+    for(int i = 0; i < count; i++)
+        sum += samples[i];
+
+    stats->min = samples[0];
+    stats->max = samples[count - 1];
+    stats->avg = sum / count;
+    stats->p99 = samples[min(count - 1, (int)(0.99 * count))];
+}
+
+/* compares two samples */
+int compare_samples(const void* a, const void* b)
+{
+    float x = *((const float*)a), y = *((const float*)b);
+    return (x > y) - (x < y);
+}
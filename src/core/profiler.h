@@ -0,0 +1,59 @@
+/*
+ * Open Surge Engine
+ * profiler.h - frame profiler
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <stdbool.h>
+
+/*
+   The profiler measures how each frame of the game is
+   split across its phases. A phase is delimited by a pair
+   of profiler_begin() / profiler_end() calls, which may be
+   nested. The name of a phase must be a string literal.
+
+   The timings may be displayed on the screen as a flame
+   bar (one row per nesting level) and may be exported to a
+   CSV file, one row per phase per frame.
+*/
+
+void profiler_init(const char* csv_filepath); /* csv_filepath may be NULL */
+void profiler_release();
+void profiler_new_frame(); /* call it at the beginning of each frame */
+void profiler_render(); /* renders the overlay (if visible) */
+
+void profiler_begin(const char* name); /* starts a phase */
+void profiler_end(); /* ends the phase that was most recently started */
+
+void profiler_show(bool show); /* show/hide the overlay */
+bool profiler_is_visible(); /* is the overlay visible? */
+
+/* statistics of a phase over the collected frames, in milliseconds */
+typedef struct profilerstats_t {
+    const char* zone; /* e.g., "update/players"; the first entry is the whole "frame" */
+    int frames; /* number of frames in which the phase took place */
+    double min, avg, p99, max;
+} profilerstats_t;
+
+void profiler_collect_statistics(bool collect); /* keep the timings of every frame, starting with the next one */
+int profiler_get_statistics(profilerstats_t* stats, int max_count); /* returns the number of entries written to stats */
+
+#endif
@@ -24,17 +24,52 @@
 #include "audio.h"
 #include "logfile.h"
 
+/* resource types */
+typedef enum resourcetype_t {
+    RESOURCE_IMAGE,
+    RESOURCE_SAMPLE,
+    RESOURCE_MUSIC
+} resourcetype_t;
+
+/* a resource: unreferenced resources are kept in a LRU list */
+typedef struct resource_t resource_t;
+struct resource_t {
+    resourcetype_t type;
+    void* data; /* image_t*, sound_t* or music_t* */
+    char* key;
+    size_t size; /* approximate memory usage, in bytes */
+    bool unused; /* is it in the LRU list? */
+    resource_t* prev; /* more recently used */
+    resource_t* next; /* less recently used */
+};
+
+static resource_t* resource_create(resourcetype_t type, const char* key, void* data);
+static void resource_destroy(resource_t* resource);
+static size_t resource_size(const resource_t* resource);
+
 /* code generation */
-HASHTABLE_GENERATE_CODE(image_t, image_destroy);
-HASHTABLE_GENERATE_CODE(sound_t, sound_destroy);
-HASHTABLE_GENERATE_CODE(music_t, music_destroy);
+HASHTABLE_GENERATE_CODE(resource_t, resource_destroy);
 
 /* private data */
-static HASHTABLE(image_t, images);
-static HASHTABLE(sound_t, samples);
-static HASHTABLE(music_t, musics);
+static const size_t DEFAULT_MEMORY_BUDGET = 128 * 1024 * 1024; /* in bytes */
+static HASHTABLE(resource_t, images);
+static HASHTABLE(resource_t, samples);
+static HASHTABLE(resource_t, musics);
+static resource_t* lru_head = NULL; /* most recently used unreferenced resource */
+static resource_t* lru_tail = NULL; /* least recently used unreferenced resource */
+static resourcemanager_stats_t stats = { 0 };
+static size_t memory_budget = 0; /* in bytes */
 static bool is_valid = false; /* validity flag */
 
+/* private methods */
+static void add_resource(hashtable_resource_t* table, resourcetype_t type, const char* key, void* data);
+static void* find_resource(hashtable_resource_t* table, const char* key, bool count);
+static int ref_resource(hashtable_resource_t* table, const char* key);
+static int unref_resource(hashtable_resource_t* table, const char* key);
+static hashtable_resource_t* table_of(resourcetype_t type);
+static void lru_push(resource_t* resource);
+static void lru_remove(resource_t* resource);
+
 
 /* public methods */
 
@@ -42,9 +77,11 @@ static bool is_valid = false; /* validity flag */
 void resourcemanager_init()
 {
     if(!is_valid) {
-        images = hashtable_image_t_create();
-        samples = hashtable_sound_t_create();
-        musics = hashtable_music_t_create();
+        images = hashtable_resource_t_create();
+        samples = hashtable_resource_t_create();
+        musics = hashtable_resource_t_create();
+        lru_head = lru_tail = NULL;
+        memory_budget = DEFAULT_MEMORY_BUDGET;
         is_valid = true;
     }
 }
@@ -52,19 +89,43 @@ void resourcemanager_init()
 void resourcemanager_release()
 {
     if(is_valid) {
+        logfile_message(
+            "Resource manager: %lu hits, %lu misses, %lu evictions",
+            (unsigned long)stats.hits, (unsigned long)stats.misses, (unsigned long)stats.evictions
+        );
+
         is_valid = false;
-        images = hashtable_image_t_destroy(images);
-        samples = hashtable_sound_t_destroy(samples);
-        musics = hashtable_music_t_destroy(musics);
+        images = hashtable_resource_t_destroy(images);
+        samples = hashtable_resource_t_destroy(samples);
+        musics = hashtable_resource_t_destroy(musics);
     }
 }
 
+/* evicts the least recently used unreferenced resources
+   while the memory budget is exceeded */
 void resourcemanager_release_unused_resources()
 {
     if(is_valid) {
-        hashtable_image_t_release_unreferenced_entries(images);
-        hashtable_sound_t_release_unreferenced_entries(samples);
-        hashtable_music_t_release_unreferenced_entries(musics);
+        size_t used_bytes = stats.used_bytes;
+        int count = 0;
+
+        while(stats.used_bytes > memory_budget && lru_tail != NULL) {
+            resource_t* resource = lru_tail;
+            hashtable_resource_t_remove(table_of(resource->type), resource->key);
+
+            /* couldn't remove it? take it off the list, so that we don't spin */
+            if(lru_tail == resource) {
+                logfile_warning("Resource manager: can't evict \"%s\"", resource->key);
+                lru_remove(resource);
+                continue;
+            }
+
+            stats.evictions++;
+            count++;
+        }
+
+        if(count > 0)
+            logfile_debug("Resource manager: evicted %d resources (%lu KB)", count, (unsigned long)((used_bytes - stats.used_bytes) / 1024));
     }
 }
 
@@ -73,34 +134,53 @@ bool resourcemanager_is_initialized()
     return is_valid;
 }
 
+/* sets the memory budget, in bytes: unreferenced
+   resources are evicted only when it's exceeded */
+void resourcemanager_set_memory_budget(size_t bytes)
+{
+    memory_budget = bytes;
+    logfile_message("Resource manager: memory budget set to %lu KB", (unsigned long)(bytes / 1024));
+}
+
+/* hit, miss and eviction counters; memory usage */
+const resourcemanager_stats_t* resourcemanager_stats()
+{
+    return &stats;
+}
+
 
 
 /* -------- images ------- */
 void resourcemanager_add_image(const char *key, image_t *data)
 {
-    hashtable_image_t_add(images, key, data);
+    add_resource(images, RESOURCE_IMAGE, key, data);
 }
 
 image_t* resourcemanager_find_image(const char *key)
 {
-    return hashtable_image_t_find(images, key);
+    return find_resource(images, key, true);
+}
+
+image_t* resourcemanager_peek_image(const char *key)
+{
+    return find_resource(images, key, false);
 }
 
 int resourcemanager_ref_image(const char *key)
 {
-    return hashtable_image_t_ref(images, key);
+    return ref_resource(images, key);
 }
 
 int resourcemanager_unref_image(const char *key)
 {
-    return is_valid ? hashtable_image_t_unref(images, key) : 0;
+    return is_valid ? unref_resource(images, key) : 0;
 }
 
 /* returns TRUE on success (i.e., the image has been successfully purged) */
 bool resourcemanager_purge_image(const char *key)
 {
-    if(is_valid && resourcemanager_find_image(key) != NULL) {
-        int refs = hashtable_image_t_refcount(images, key);
+    if(is_valid && hashtable_resource_t_find(images, key) != NULL) {
+        int refs = hashtable_resource_t_refcount(images, key);
 
         /* sanity check */
         if(refs > 0) {
@@ -109,8 +189,8 @@ bool resourcemanager_purge_image(const char *key)
         }
 
         /* purge the image */
-        logfile_message("resourcemanager_purge_image('%s')...", key);
-        hashtable_image_t_remove(images, key);
+        logfile_debug("resourcemanager_purge_image('%s')...", key);
+        hashtable_resource_t_remove(images, key);
     }
 
     /* done */
@@ -120,41 +200,225 @@ bool resourcemanager_purge_image(const char *key)
 /* -------- musics --------- */
 void resourcemanager_add_music(const char *key, music_t *data)
 {
-    hashtable_music_t_add(musics, key, data);
+    add_resource(musics, RESOURCE_MUSIC, key, data);
 }
 
 music_t* resourcemanager_find_music(const char *key)
 {
-    return hashtable_music_t_find(musics, key);
+    return find_resource(musics, key, true);
 }
 
 int resourcemanager_ref_music(const char *key)
 {
-    return hashtable_music_t_ref(musics, key);
+    return ref_resource(musics, key);
 }
 
 int resourcemanager_unref_music(const char *key)
 {
-    return is_valid ? hashtable_music_t_unref(musics, key) : 0;
+    return is_valid ? unref_resource(musics, key) : 0;
 }
 
 /* ------- samples ------- */
 void resourcemanager_add_sample(const char *key, sound_t *data)
 {
-    hashtable_sound_t_add(samples, key, data);
+    add_resource(samples, RESOURCE_SAMPLE, key, data);
 }
 
 sound_t* resourcemanager_find_sample(const char *key)
 {
-    return hashtable_sound_t_find(samples, key);
+    return find_resource(samples, key, true);
+}
+
+sound_t* resourcemanager_peek_sample(const char *key)
+{
+    return find_resource(samples, key, false);
 }
 
 int resourcemanager_ref_sample(const char *key)
 {
-    return hashtable_sound_t_ref(samples, key);
+    return ref_resource(samples, key);
 }
 
 int resourcemanager_unref_sample(const char *key)
 {
-    return is_valid ? hashtable_sound_t_unref(samples, key) : 0;
+    return is_valid ? unref_resource(samples, key) : 0;
+}
+
+
+
+/* private methods */
+
+/* creates a new resource */
+resource_t* resource_create(resourcetype_t type, const char* key, void* data)
+{
+    resource_t* resource = mallocx(sizeof *resource);
+
+    resource->type = type;
+    resource->data = data;
+    resource->key = str_dup(key);
+    resource->unused = false;
+    resource->prev = resource->next = NULL;
+    resource->size = resource_size(resource);
+
+    stats.used_bytes += resource->size;
+    return resource;
+}
+
+/* computes the approximate memory usage of a resource */
+size_t resource_size(const resource_t* resource)
+{
+    switch(resource->type) {
+        case RESOURCE_IMAGE:
+            return 4 * (size_t)image_width(resource->data) * (size_t)image_height(resource->data);
+
+        case RESOURCE_SAMPLE:
+            return sound_size(resource->data);
+
+        case RESOURCE_MUSIC:
+            return music_size(resource->data);
+    }
+
+    return 0;
+}
+
+/* destroys a resource (called by the hash table) */
+void resource_destroy(resource_t* resource)
+{
+    lru_remove(resource);
+    stats.used_bytes -= resource->size;
+
+    switch(resource->type) {
+        case RESOURCE_IMAGE:
+            image_destroy(resource->data);
+            break;
+
+        case RESOURCE_SAMPLE:
+            sound_destroy(resource->data);
+            break;
+
+        case RESOURCE_MUSIC:
+            music_destroy(resource->data);
+            break;
+    }
+
+    free(resource->key);
+    free(resource);
+}
+
+/* adds a new unreferenced resource to a table */
+void add_resource(hashtable_resource_t* table, resourcetype_t type, const char* key, void* data)
+{
+    if(hashtable_resource_t_find(table, key) == NULL) {
+        resource_t* resource = resource_create(type, key, data);
+        hashtable_resource_t_add(table, key, resource);
+        lru_push(resource);
+    }
+}
+
+/* finds a resource, optionally updating the hit & miss counters */
+void* find_resource(hashtable_resource_t* table, const char* key, bool count)
+{
+    resource_t* resource = hashtable_resource_t_find(table, key);
+
+    if(resource != NULL) {
+        /* peeking isn't using: it doesn't change the LRU order */
+        if(count) {
+            stats.hits++;
+            if(resource->unused) {
+                /* mark as recently used */
+                lru_remove(resource);
+                lru_push(resource);
+            }
+        }
+        return resource->data;
+    }
+
+    if(count)
+        stats.misses++;
+    return NULL;
+}
+
+/* increments the reference counter of a resource */
+int ref_resource(hashtable_resource_t* table, const char* key)
+{
+    int refs = hashtable_resource_t_ref(table, key);
+
+    /* the resource is now in use */
+    if(refs == 1)
+        lru_remove(hashtable_resource_t_find(table, key));
+
+    return refs;
+}
+
+/* decrements the reference counter of a resource */
+int unref_resource(hashtable_resource_t* table, const char* key)
+{
+    int refs = hashtable_resource_t_unref(table, key);
+
+    /* the resource is no longer in use */
+    if(refs == 0) {
+        resource_t* resource = hashtable_resource_t_find(table, key);
+        if(resource != NULL && !resource->unused)
+            lru_push(resource);
+    }
+
+    return refs;
+}
+
+/* the table that stores resources of the given type */
+hashtable_resource_t* table_of(resourcetype_t type)
+{
+    switch(type) {
+        case RESOURCE_IMAGE:
+            return images;
+
+        case RESOURCE_SAMPLE:
+            return samples;
+
+        case RESOURCE_MUSIC:
+            return musics;
+    }
+
+    return NULL;
+}
+
+/* adds a resource to the front of the LRU list */
+void lru_push(resource_t* resource)
+{
+    /* its size may have changed (e.g., samples are decoded asynchronously) */
+    size_t size = resource_size(resource);
+    stats.used_bytes += size - resource->size;
+    resource->size = size;
+
+    resource->prev = NULL;
+    resource->next = lru_head;
+    if(lru_head != NULL)
+        lru_head->prev = resource;
+    else
+        lru_tail = resource;
+    lru_head = resource;
+
+    resource->unused = true;
+    stats.unused_bytes += resource->size;
+}
+
+/* removes a resource from the LRU list, if it's there */
+void lru_remove(resource_t* resource)
+{
+    if(resource == NULL || !resource->unused)
+        return;
+
+    if(resource->prev != NULL)
+        resource->prev->next = resource->next;
+    else
+        lru_head = resource->next;
+
+    if(resource->next != NULL)
+        resource->next->prev = resource->prev;
+    else
+        lru_tail = resource->prev;
+
+    resource->prev = resource->next = NULL;
+    resource->unused = false;
+    stats.unused_bytes -= resource->size;
 }
@@ -22,21 +22,35 @@
 #define _RESOURCEMANAGER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* forward declarations */
 struct image_t;
 struct sound_t;
 struct music_t;
 
+/* resource manager statistics */
+typedef struct resourcemanager_stats_t {
+    uint64_t hits; /* how many times a resource was found in the dictionary */
+    uint64_t misses; /* how many times a resource had to be loaded */
+    uint64_t evictions; /* how many unreferenced resources have been released */
+    size_t used_bytes; /* approximate memory usage of all resources */
+    size_t unused_bytes; /* approximate memory usage of the unreferenced resources */
+} resourcemanager_stats_t;
+
 /* resource manager: public methods */
 void resourcemanager_init(); /* initializes the resource manager */
 void resourcemanager_release(); /* releases the resource manager */
-void resourcemanager_release_unused_resources(); /* memory optimization: reference counting */
+void resourcemanager_release_unused_resources(); /* memory optimization: evicts unreferenced resources (LRU) if over budget */
 bool resourcemanager_is_initialized(); /* is the resource manager initialized? */
+void resourcemanager_set_memory_budget(size_t bytes); /* unreferenced resources are kept in memory up to this budget */
+const resourcemanager_stats_t* resourcemanager_stats(); /* hit, miss and eviction counters */
 
 /* data handling */
 void resourcemanager_add_image(const char *key, struct image_t *data); /* adds an image to the dictionary */
 struct image_t* resourcemanager_find_image(const char *key); /* finds an image in the dictionary */
+struct image_t* resourcemanager_peek_image(const char *key); /* same, but it isn't counted as a hit or a miss, nor marked as recently used */
 int resourcemanager_ref_image(const char *key); /* increments and returns the reference counting */
 int resourcemanager_unref_image(const char *key); /* decrements and returns the reference counting */
 bool resourcemanager_purge_image(const char *key); /* use with care */
@@ -48,6 +62,7 @@ int resourcemanager_unref_music(const char *key);
 
 void resourcemanager_add_sample(const char *key, struct sound_t *data);
 struct sound_t* resourcemanager_find_sample(const char *key);
+struct sound_t* resourcemanager_peek_sample(const char *key);
 int resourcemanager_ref_sample(const char *key);
 int resourcemanager_unref_sample(const char *key);
 
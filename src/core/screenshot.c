@@ -19,18 +19,51 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "screenshot.h"
 #include "assetfs.h"
 #include "logfile.h"
+#include "stringutil.h"
 #include "image.h"
 #include "video.h"
 #include "input.h"
+#include "util.h"
+
+#if defined(A5BUILD)
+#include <allegro5/allegro.h>
+#endif
+
+/* a screenshot waiting to be encoded */
+typedef struct screenshot_t screenshot_t;
+struct screenshot_t {
+    uint8_t* pixels; /* RGBA */
+    int width, height;
+    char* filename; /* relative path */
+    char* fullpath; /* absolute path, resolved on the main thread */
+    bool success;
+    screenshot_t* next;
+};
 
 /* private data */
 #define MAX_SCREENSHOTS     (1 << 30)
 static input_t *in;
 static const char* screenshot_filename(int screenshot_id);
 static int next_screenshot_id = 0;
+static screenshot_t* create_screenshot(const char* filename);
+static screenshot_t* destroy_screenshot(screenshot_t* screenshot);
+static void encode_screenshot(screenshot_t* screenshot);
+static void report_screenshot(const screenshot_t* screenshot);
+
+#if defined(A5BUILD)
+/* screenshots are encoded and written to disk on a separate thread */
+static screenshot_t* queued = NULL; /* screenshots to be encoded (FIFO) */
+static screenshot_t* encoded = NULL; /* screenshots to be reported on the main thread */
+static int in_flight = 0; /* screenshots not yet reported (main thread only) */
+static ALLEGRO_THREAD* encoder = NULL;
+static ALLEGRO_MUTEX* mutex = NULL;
+static ALLEGRO_COND* cond = NULL;
+static void* encoder_thread(ALLEGRO_THREAD* thread, void* arg);
+#endif
 
 /*
  * screenshot_init()
@@ -44,6 +77,15 @@ void screenshot_init()
     /* What's the next screenshot? */
     while(assetfs_exists(screenshot_filename(next_screenshot_id)) &&
     ++next_screenshot_id < MAX_SCREENSHOTS);
+
+#if defined(A5BUILD)
+    /* Start the encoder */
+    mutex = al_create_mutex();
+    cond = al_create_cond();
+    if(mutex == NULL || cond == NULL || NULL == (encoder = al_create_thread(encoder_thread, NULL)))
+        fatal_error("screenshot_init(): can't create the encoder thread");
+    al_start_thread(encoder);
+#endif
 }
 
 
@@ -54,17 +96,48 @@ void screenshot_init()
  */
 void screenshot_update()
 {
-    image_t* snapshot;
-
     /* take the snapshot */
     if(input_button_pressed(in, IB_FIRE1) || input_button_pressed(in, IB_FIRE2)) {
-        const char *filename = screenshot_filename(next_screenshot_id++);
-        logfile_message("New screenshot: \"%s\"", filename);
-        snapshot = image_snapshot();
-        image_save(snapshot, filename);
-        image_destroy(snapshot);
-        video_showmessage("New screenshot: %s", filename);
+        screenshot_t* screenshot = create_screenshot(screenshot_filename(next_screenshot_id));
+
+        /* couldn't copy the screen? skip it */
+        if(screenshot != NULL) {
+            next_screenshot_id++;
+
+#if defined(A5BUILD)
+            /* copy the screen to memory and encode it later */
+            screenshot_t** last;
+            al_lock_mutex(mutex);
+            for(last = &queued; *last != NULL; last = &((*last)->next));
+            *last = screenshot;
+            al_signal_cond(cond);
+            al_unlock_mutex(mutex);
+            in_flight++;
+#else
+            encode_screenshot(screenshot);
+            report_screenshot(screenshot);
+            destroy_screenshot(screenshot);
+#endif
+        }
+    }
+
+#if defined(A5BUILD)
+    /* report the screenshots that have been written */
+    if(in_flight > 0) {
+        screenshot_t* list;
+
+        al_lock_mutex(mutex);
+        list = encoded;
+        encoded = NULL;
+        al_unlock_mutex(mutex);
+
+        while(list != NULL) {
+            report_screenshot(list);
+            list = destroy_screenshot(list);
+            in_flight--;
+        }
     }
+#endif
 }
 
 
@@ -74,6 +147,25 @@ void screenshot_update()
  */
 void screenshot_release()
 {
+#if defined(A5BUILD)
+    /* Wait for the pending screenshots */
+    al_lock_mutex(mutex);
+    al_set_thread_should_stop(encoder);
+    al_signal_cond(cond);
+    al_unlock_mutex(mutex);
+    al_join_thread(encoder, NULL);
+    al_destroy_thread(encoder);
+    al_destroy_cond(cond);
+    al_destroy_mutex(mutex);
+    encoder = NULL;
+    cond = NULL;
+    mutex = NULL;
+
+    while(encoded != NULL)
+        encoded = destroy_screenshot(encoded);
+    in_flight = 0;
+#endif
+
     /* We're done with the input object */
     input_destroy(in);
 }
@@ -89,4 +181,94 @@ const char* screenshot_filename(int screenshot_id)
     static char filename[32];
     snprintf(filename, sizeof(filename), "screenshots/s%03d.png", screenshot_id);
     return filename;
-}
\ No newline at end of file
+}
+
+/* takes a screenshot, copying the screen to memory. Returns NULL on error */
+screenshot_t* create_screenshot(const char* filename)
+{
+    screenshot_t* screenshot;
+    int width, height;
+    uint8_t* pixels;
+
+    if(NULL == (pixels = image_snapshot_pixels(&width, &height)))
+        return NULL;
+
+    screenshot = mallocx(sizeof *screenshot);
+    screenshot->pixels = pixels;
+    screenshot->width = width;
+    screenshot->height = height;
+    screenshot->filename = str_dup(filename);
+    screenshot->fullpath = str_dup(assetfs_create_cache_file(filename));
+    screenshot->success = false;
+    screenshot->next = NULL;
+
+    return screenshot;
+}
+
+/* destroys a screenshot, returning the next one */
+screenshot_t* destroy_screenshot(screenshot_t* screenshot)
+{
+    screenshot_t* next = screenshot->next;
+
+    free(screenshot->fullpath);
+    free(screenshot->filename);
+    free(screenshot->pixels);
+    free(screenshot);
+
+    return next;
+}
+
+/* encodes a screenshot and writes it to disk (may run on the encoder thread) */
+void encode_screenshot(screenshot_t* screenshot)
+{
+    /* screenshots are opaque */
+    for(int i = 4 * screenshot->width * screenshot->height - 1; i >= 0; i -= 4)
+        screenshot->pixels[i] = 255;
+
+    screenshot->success = image_save_pixels(screenshot->pixels, screenshot->width, screenshot->height, screenshot->fullpath);
+}
+
+/* tells the user about a screenshot that has been written (main thread) */
+void report_screenshot(const screenshot_t* screenshot)
+{
+    if(screenshot->success) {
+        logfile_message("New screenshot: \"%s\"", screenshot->filename);
+        video_showmessage("New screenshot: %s", screenshot->filename);
+    }
+    else
+        logfile_message("Failed to save screenshot to \"%s\"", screenshot->fullpath);
+}
+
+#if defined(A5BUILD)
+/* encoder thread: encodes the queued screenshots, in order */
+void* encoder_thread(ALLEGRO_THREAD* thread, void* arg)
+{
+    al_lock_mutex(mutex);
+    for(;;) {
+        screenshot_t* screenshot = queued;
+        screenshot_t** last;
+
+        /* wait for a screenshot. Pending ones are written before we stop */
+        if(screenshot == NULL) {
+            if(al_get_thread_should_stop(thread))
+                break;
+            al_wait_cond(cond, mutex);
+            continue;
+        }
+
+        /* encode it without holding the lock */
+        queued = screenshot->next;
+        screenshot->next = NULL;
+        al_unlock_mutex(mutex);
+        encode_screenshot(screenshot);
+        al_lock_mutex(mutex);
+
+        /* the main thread will report it */
+        for(last = &encoded; *last != NULL; last = &((*last)->next));
+        *last = screenshot;
+    }
+    al_unlock_mutex(mutex);
+
+    return NULL;
+}
+#endif
@@ -117,7 +117,7 @@ void spatialhash_##T##_add(spatialhash_##T *sh, T *element) \
     \
     for(p = sh->bucket[row][col]; p != NULL; p = p->next) { \
         if(p->data == element) { \
-            logfile_message("spatialhash_" #T "_add(): element '%p' already exists! It won't be added.", element); \
+            logfile_debug("spatialhash_" #T "_add(): element '%p' already exists! It won't be added.", element); \
             return; \
         } \
     } \
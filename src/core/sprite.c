@@ -28,6 +28,7 @@
 #include "hashtable.h"
 #include "resourcemanager.h"
 #include "nanoparser/nanoparser.h"
+#include "parsecache.h"
 
 /* private stuff ;) */
 #define SPRITE_MAX_ANIM         1024 /* sprites can have at most SPRITE_MAX_ANIM animations (numbered 0 .. SPRITE_MAX_ANIM-1) */
@@ -49,6 +50,7 @@ static void fix_sprite_animations(spriteinfo_t *spr); /* fixes the animations of
 static int traverse(const parsetree_statement_t *stmt);
 static int traverse_sprite_attributes(const parsetree_statement_t *stmt, void *spriteinfo);
 static int traverse_animation_attributes(const parsetree_statement_t *stmt, void *animation);
+static int traverse_preload_attributes(const parsetree_statement_t *stmt, void *unused);
 
 
 /* public methods */
@@ -161,6 +163,16 @@ spriteinfo_t* spriteinfo_create(const parsetree_program_t *tree)
     return sprite;
 }
 
+/*
+ * spriteinfo_preload()
+ * Schedules the spritesheet referenced by the passed
+ * tree to be loaded asynchronously (see image_preload())
+ */
+void spriteinfo_preload(const parsetree_program_t *tree)
+{
+    nanoparser_traverse_program_ex(tree, NULL, traverse_preload_attributes);
+}
+
 /*
  * spriteinfo_destroy()
  * Destroys a spriteinfo_t object
@@ -216,9 +228,8 @@ void spriteinfo_destroy(spriteinfo_t *info)
  */
 int dirfill(const char *vpath, void *param)
 {
-    const char* fullpath = assetfs_fullpath(vpath);
     parsetree_program_t** p = (parsetree_program_t**)param;
-    *p = nanoparser_append_program(*p, nanoparser_construct_tree(fullpath));
+    *p = nanoparser_append_program(*p, parsecache_construct_tree(vpath));
     return 0;
 }
 
@@ -300,17 +311,17 @@ void validate_sprite(spriteinfo_t *spr)
     int i, j, n;
 
     if(spr->frame_w > spr->rect_w || spr->frame_h > spr->rect_h) {
-        logfile_message("Sprite error: frame_size (%d,%d) can't be larger than source_rect size (%d,%d)", spr->frame_w, spr->frame_h, spr->rect_w, spr->rect_h);
+        logfile_warning("Sprite error: frame_size (%d,%d) can't be larger than source_rect size (%d,%d)", spr->frame_w, spr->frame_h, spr->rect_w, spr->rect_h);
         spr->frame_w = min(spr->frame_w, spr->rect_w);
         spr->frame_h = min(spr->frame_h, spr->rect_h);
-        logfile_message("Adjusting frame_size to (%d,%d)", spr->frame_w, spr->frame_h);
+        logfile_warning("Adjusting frame_size to (%d,%d)", spr->frame_w, spr->frame_h);
     }
 
     if(spr->rect_w % spr->frame_w > 0 || spr->rect_h % spr->frame_h > 0) {
-        logfile_message("Sprite error: incompatible frame_size (%d,%d) x source_rect size (%d,%d). source_rect size should be a multiple of frame_size.", spr->frame_w, spr->frame_h, spr->rect_w, spr->rect_h);
+        logfile_warning("Sprite error: incompatible frame_size (%d,%d) x source_rect size (%d,%d). source_rect size should be a multiple of frame_size.", spr->frame_w, spr->frame_h, spr->rect_w, spr->rect_h);
         spr->rect_w = (spr->rect_w % spr->frame_w > 0) ? (spr->rect_w - spr->rect_w % spr->frame_w + spr->frame_w) : spr->rect_w;
         spr->rect_h = (spr->rect_h % spr->frame_h > 0) ? (spr->rect_h - spr->rect_h % spr->frame_h + spr->frame_h) : spr->rect_h;
-        logfile_message("Adjusting source_rect size to (%d,%d)", spr->rect_w, spr->rect_h);
+        logfile_warning("Adjusting source_rect size to (%d,%d)", spr->rect_w, spr->rect_h);
     }
 
     if(spr->animation_count < 1 || spr->animation_data == NULL)
@@ -321,9 +332,9 @@ void validate_sprite(spriteinfo_t *spr)
         if(spr->animation_data[i] == NULL) continue;
         for(j=0; j<spr->animation_data[i]->frame_count; j++) {
             if(!(spr->animation_data[i]->data[j] >= 0 && spr->animation_data[i]->data[j] < n)) {
-                logfile_message("Sprite error: invalid frame '%d' of animation %d. Animation frames must be in range %d..%d", spr->animation_data[i]->data[j], i, 0, n-1);
+                logfile_warning("Sprite error: invalid frame '%d' of animation %d. Animation frames must be in range %d..%d", spr->animation_data[i]->data[j], i, 0, n-1);
                 spr->animation_data[i]->data[j] = clip(spr->animation_data[i]->data[j], 0, n-1);
-                logfile_message("Adjusting animation frame to %d", spr->animation_data[i]->data[j]);
+                logfile_warning("Adjusting animation frame to %d", spr->animation_data[i]->data[j]);
             }
         }
     }
@@ -341,7 +352,7 @@ void validate_animation(animation_t *anim)
 
     if(anim->repeat_from < 0 || anim->repeat_from >= anim->frame_count) {
         anim->repeat_from = clip(anim->repeat_from, 0, anim->frame_count-1);
-        logfile_message("Animation error: the 'repeat_from' field has been adjusted to %d", anim->repeat_from);
+        logfile_warning("Animation error: the 'repeat_from' field has been adjusted to %d", anim->repeat_from);
     }
 }
 
@@ -411,12 +422,12 @@ int traverse(const parsetree_statement_t *stmt)
         nanoparser_expect_program(p2, "Must provide sprite attributes");
 
         s = nanoparser_get_string(p1);
-        logfile_message("Loading sprite \"%s\" defined in \"%s\"", s, nanoparser_get_file(stmt));
+        logfile_debug("Loading sprite \"%s\" defined in \"%s\"", s, nanoparser_get_file(stmt));
 
         if(NULL == hashtable_spriteinfo_t_find(sprites, s))
             register_sprite(s, spriteinfo_create(nanoparser_get_program(p2)));
         else
-            logfile_message("WARNING: can't redefine sprite \"%s\" in \"%s\" near line %d", s, nanoparser_get_file(stmt), nanoparser_get_line_number(stmt));
+            logfile_warning("WARNING: can't redefine sprite \"%s\" in \"%s\" near line %d", s, nanoparser_get_file(stmt), nanoparser_get_line_number(stmt));
     }
     else
         fatal_error("Can't load sprite. Unknown identifier \"%s\" in \"%s\" near line %d", identifier, nanoparser_get_file(stmt), nanoparser_get_line_number(stmt));
@@ -575,3 +586,19 @@ int traverse_animation_attributes(const parsetree_statement_t *stmt, void *anima
 
     return 0;
 }
+
+/* finds the spritesheet of a sprite block */
+int traverse_preload_attributes(const parsetree_statement_t *stmt, void *unused)
+{
+    const char *identifier = nanoparser_get_identifier(stmt);
+    const parsetree_parameter_t *param_list = nanoparser_get_parameter_list(stmt);
+    const parsetree_parameter_t *p1;
+
+    if(str_icmp(identifier, "source_file") == 0) {
+        p1 = nanoparser_get_nth_parameter(param_list, 1);
+        nanoparser_expect_string(p1, "Must provide path to the source_file");
+        image_preload(nanoparser_get_string(p1));
+    }
+
+    return 0;
+}
@@ -87,6 +87,9 @@ int sprite_animation_exists(const char* sprite_name, int anim_id);
 /* creates an anonymous spriteinfo_t object by parsing the passed tree */
 spriteinfo_t *spriteinfo_create(const parsetree_program_t *tree);
 
+/* schedules the spritesheet referenced by the passed tree to be loaded asynchronously */
+void spriteinfo_preload(const parsetree_program_t *tree);
+
 /* if you have called spriteinfo_create(), call this too when you're done with the sprite */
 void spriteinfo_destroy(spriteinfo_t *info);
 
@@ -32,9 +32,12 @@
 #include <sys/time.h>
 #endif
 
+static float fixed_timestep = 0.0f; /* simulated time step (if nonzero) */
+
 #if defined(A5BUILD)
 static float delta_time = 0.0f;
 static double current_time = 0.0;
+static double time_offset = 0.0; /* keeps the clock monotonic after a period of simulated time */
 #else
 
 /* constants */
@@ -94,8 +97,16 @@ void timer_update()
     static const float maximum_delta = 0.018f;
     static double old_time = 0.0;
 
+    /* fixed time step: the clock is simulated */
+    if(fixed_timestep > 0.0f) {
+        delta_time = fixed_timestep;
+        current_time += fixed_timestep;
+        old_time = current_time;
+        return;
+    }
+
     /* compute delta time */
-    current_time = al_get_time();
+    current_time = al_get_time() + time_offset;
     delta_time = current_time - old_time;
 
     if(delta_time < minimum_delta)
@@ -123,7 +134,7 @@ void timer_update()
             break;
     }
     delta_time = min(delta_time, MAX_FRAME_INTERVAL);
-    delta = (float)delta_time * 0.001f;
+    delta = (fixed_timestep > 0.0f) ? fixed_timestep : (float)delta_time * 0.001f;
 
     /* done! */
     last_time = timer_get_ticks();
@@ -157,6 +168,36 @@ float timer_get_delta()
 }
 
 
+/*
+ * timer_set_fixed_timestep()
+ * Makes timer_get_delta() return a fixed value (in seconds), so that
+ * the game runs in lock-step with the main loop regardless of how long
+ * each frame takes. In the Allegro 5 build, the clock itself is then
+ * simulated. Set it to zero to go back to real time
+ */
+void timer_set_fixed_timestep(float timestep)
+{
+#if defined(A5BUILD)
+    /* resume the real clock from the simulated one */
+    if(fixed_timestep > 0.0f && timestep <= 0.0f)
+        time_offset = current_time - al_get_time();
+#endif
+
+    fixed_timestep = max(timestep, 0.0f);
+}
+
+
+/*
+ * timer_get_fixed_timestep()
+ * Returns the fixed time step, in seconds,
+ * or zero if the game runs in real time
+ */
+float timer_get_fixed_timestep()
+{
+    return fixed_timestep;
+}
+
+
 /*
  * timer_get_ticks()
  * Elapsed milliseconds since
@@ -31,5 +31,7 @@ void timer_release();
 /* main utilities */
 float timer_get_delta();
 uint32_t timer_get_ticks();
+void timer_set_fixed_timestep(float timestep); /* in seconds; zero disables it */
+float timer_get_fixed_timestep();
 
 #endif
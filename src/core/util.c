@@ -30,6 +30,11 @@
 #include "timer.h"
 #include "logfile.h"
 #include "resourcemanager.h"
+#include "memtrack.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #if defined(A5BUILD)
 #include <allegro5/allegro.h>
@@ -49,6 +54,10 @@ static bool game_over = false;
 #else
 static volatile int game_over = FALSE;
 #endif
+static uint64_t random_state = 0; /* state of random64() */
+static volatile uint32_t allocations = 0; /* number of calls to mallocx() and reallocx() */
+static inline void count_allocation();
+static uint64_t wang_hash(uint64_t key);
 static void merge_sort_recursive(void *base, size_t size, int (*comparator)(const void*,const void*), int p, int q);
 static inline void merge_sort_mix(void *base, size_t size, int (*comparator)(const void*,const void*), int p, int q, int m);
 
@@ -70,6 +79,8 @@ void *__mallocx(size_t bytes, const char* location)
     if(!p)
         fatal_error("Out of memory in mallocx(%u) at %s", bytes, location);
 
+    count_allocation();
+    memtrack_allocated(p, bytes, location);
     return p;
 }
 
@@ -81,14 +92,39 @@ void *__mallocx(size_t bytes, const char* location)
  */
 void* __reallocx(void *ptr, size_t bytes, const char* location)
 {
-    void *p = realloc(ptr, bytes);
+    void *p;
 
-    if(!p)
+    memtrack_released(ptr); /* before another thread gets the same address */
+    if(NULL == (p = realloc(ptr, bytes)))
         fatal_error("Out of memory in reallocx(%u) at %s", bytes, location);
 
+    count_allocation();
+    memtrack_allocated(p, bytes, location);
     return p;
 }
 
+/*
+ * allocation_count()
+ * The number of calls to mallocx() and reallocx() so far
+ */
+uint32_t allocation_count()
+{
+    return allocations;
+}
+
+#if defined(TRACK_ALLOCATIONS)
+/*
+ * __freex()
+ * Similar to free(), but keeps track of the
+ * released memory. See memtrack.h
+ */
+void __freex(void* ptr)
+{
+    memtrack_released(ptr);
+    (free)(ptr);
+}
+#endif
+
 
 
 /* Game routines */
@@ -155,7 +191,8 @@ void fatal_error(const char *fmt, ...)
     va_end(args);
 
     /* display an error */
-    logfile_message("----- crash -----\n%s", buf);
+    logfile_error("----- crash -----\n%s", buf);
+    logfile_flush();
 #if defined(A5BUILD)
     al_show_native_message_box(al_get_current_display(),
         "Error",
@@ -210,25 +247,101 @@ float lerp_angle(float alpha, float beta, float t)
  */
 uint64_t random64()
 {
-    static uint64_t state = 0;
-
-    /* generate seed: wang hash */
-    if(!state) {
-        state = time(NULL);
-        state = (~state) + (state << 21);
-        state ^= state >> 24;
-        state = (state + (state << 3)) + (state << 8);
-        state ^= state >> 14;
-        state = (state + (state << 2)) + (state << 4);
-        state ^= state >> 28;
-        state += state << 31;
-    }
+    /* generate seed */
+    if(!random_state)
+        random_state = wang_hash(time(NULL));
 
     /* xorshift */ 
-    state ^= state << 13;
-    state ^= state >> 7;
-    state ^= state << 17;
-    return state;
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+/*
+ * random_seed()
+ * Seeds both rand() and random64(), so that the
+ * sequences of pseudo-random numbers can be reproduced
+ */
+void random_seed(uint32_t seed)
+{
+    srand(seed);
+    random_state = wang_hash(seed);
+    if(!random_state)
+        random_state = 1; /* xorshift gets stuck at zero */
+}
+
+/*
+ * hash_file()
+ * Computes the FNV-1a hash of the contents of a file
+ * given its absolute path. Returns false on error
+ */
+bool hash_file(const char* fullpath, uint64_t* hash)
+{
+    uint8_t buf[4096];
+    size_t n;
+    bool success;
+    FILE* fp;
+
+    if(NULL == (fp = fopen(fullpath, "rb")))
+        return false;
+
+    *hash = 0xCBF29CE484222325ULL;
+    while((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        for(size_t i = 0; i < n; i++) {
+            *hash ^= buf[i];
+            *hash *= 0x100000001B3ULL;
+        }
+    }
+
+    success = (ferror(fp) == 0);
+    fclose(fp);
+    return success;
+}
+
+/*
+ * le32_to_cpu()
+ * Reads a 32-bit word stored in little-endian format
+ */
+uint32_t le32_to_cpu(const uint8_t* buf)
+{
+    return
+        ((uint32_t)buf[0]) |
+        (((uint32_t)buf[1]) << 8) |
+        (((uint32_t)buf[2]) << 16) |
+        (((uint32_t)buf[3]) << 24)
+    ;
+}
+
+/*
+ * cpu_to_le32()
+ * Stores a 32-bit word in little-endian format
+ */
+void cpu_to_le32(uint32_t input, uint8_t* buf)
+{
+    buf[0] = (input & 0x000000FF);
+    buf[1] = (input & 0x0000FF00) >> 8;
+    buf[2] = (input & 0x00FF0000) >> 16;
+    buf[3] = (input & 0xFF000000) >> 24;
+}
+
+/*
+ * le64_to_cpu()
+ * Reads a 64-bit word stored in little-endian format
+ */
+uint64_t le64_to_cpu(const uint8_t* buf)
+{
+    return ((uint64_t)le32_to_cpu(buf)) | (((uint64_t)le32_to_cpu(buf + 4)) << 32);
+}
+
+/*
+ * cpu_to_le64()
+ * Stores a 64-bit word in little-endian format
+ */
+void cpu_to_le64(uint64_t input, uint8_t* buf)
+{
+    cpu_to_le32((uint32_t)(input & 0xFFFFFFFF), buf);
+    cpu_to_le32((uint32_t)(input >> 32), buf + 4);
 }
 
 /*
@@ -300,3 +413,27 @@ void merge_sort_mix(void *base, size_t size, int (*comparator)(const void*,const
         free(arr);
 }
 
+/* wang hash */
+uint64_t wang_hash(uint64_t key)
+{
+    key = (~key) + (key << 21);
+    key ^= key >> 24;
+    key = (key + (key << 3)) + (key << 8);
+    key ^= key >> 14;
+    key = (key + (key << 2)) + (key << 4);
+    key ^= key >> 28;
+    key += key << 31;
+    return key;
+}
+
+/* counts an allocation (mallocx may be called from any thread) */
+void count_allocation()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+    _InterlockedIncrement((volatile long*)&allocations);
+#else
+    allocations++;
+#endif
+}
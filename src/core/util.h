@@ -24,6 +24,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include "global.h"
 
 /* redefinitions */
@@ -57,6 +58,9 @@
 #define nearly_equal(a,b)       (((b)==0||(a)==0)?(fabs((a)+(b))<1e-5):(fabs((a)-(b))<=max(1e-5*max(fabs(a),fabs(b)),0)))
 #define mallocx(bytes)          __mallocx((bytes), __FILE__ ":" STRINGIFY(__LINE__))
 #define reallocx(ptr,bytes)     __reallocx((ptr), (bytes), __FILE__ ":" STRINGIFY(__LINE__))
+#if defined(TRACK_ALLOCATIONS)
+#define free(ptr)               __freex(ptr) /* see memtrack.h */
+#endif
 
 /* Game routines */
 void game_quit(void); /* quit */
@@ -66,6 +70,10 @@ int game_version_compare(int version, int sub_version, int wip_version); /* comp
 /* Memory management */
 void* __mallocx(size_t bytes, const char* location);
 void* __reallocx(void *ptr, size_t bytes, const char* location);
+uint32_t allocation_count(); /* number of calls to mallocx() and reallocx() */
+#if defined(TRACK_ALLOCATIONS)
+void __freex(void* ptr);
+#endif
 
 /* Misc utilities */
 void fatal_error(const char *fmt, ...);
@@ -73,5 +81,13 @@ void merge_sort(void *base, size_t num, size_t size, int (*comparator)(const voi
 float lerp(float a, float b, float t); /* linear interpolation */
 float lerp_angle(float alpha, float beta, float t); /* alpha, beta in radians */
 uint64_t random64(); /* pseudo-random 64-bit number */
+void random_seed(uint32_t seed); /* seeds rand() and random64() */
+
+/* Binary files */
+bool hash_file(const char* fullpath, uint64_t* hash); /* FNV-1a hash of the contents of a file; returns false on error */
+uint32_t le32_to_cpu(const uint8_t* buf); /* reads a little-endian 32-bit word */
+void cpu_to_le32(uint32_t input, uint8_t* buf); /* writes a little-endian 32-bit word */
+uint64_t le64_to_cpu(const uint8_t* buf); /* reads a little-endian 64-bit word */
+void cpu_to_le64(uint64_t input, uint8_t* buf); /* writes a little-endian 64-bit word */
 
 #endif
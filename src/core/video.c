@@ -84,6 +84,7 @@ static videoresolution_t video_resolution = VIDEORESOLUTION_1X;
 static bool video_fullscreen = false;
 static bool video_showfps = false;
 static bool video_smooth = false;
+static bool video_vsync = true;
 static int fps_rate = 0;
 
 /* Video Message */
@@ -210,6 +211,8 @@ void video_changemode(videoresolution_t resolution, bool smooth, bool fullscreen
         al_set_new_display_flags(ALLEGRO_PROGRAMMABLE_PIPELINE);
         al_set_new_display_flags(video_fullscreen ? ALLEGRO_FULLSCREEN_WINDOW : ALLEGRO_WINDOWED);
         al_set_new_display_option(ALLEGRO_COLOR_SIZE, suggested_bpp, ALLEGRO_SUGGEST);
+        if(!video_vsync)
+            al_set_new_display_option(ALLEGRO_VSYNC, 2, ALLEGRO_SUGGEST); /* 2 means off */
         if(window_size.x >= window_size.y)
             al_set_new_display_option(ALLEGRO_SUPPORTED_ORIENTATIONS, ALLEGRO_DISPLAY_ORIENTATION_LANDSCAPE, ALLEGRO_SUGGEST);
         else
@@ -656,6 +659,17 @@ bool video_is_window_active()
 
 
 
+/*
+ * video_disable_vsync()
+ * Don't wait for the vertical retrace when flipping the
+ * display (e.g., for benchmarks). Call before video_init()
+ */
+void video_disable_vsync()
+{
+    video_vsync = false;
+}
+
+
 /*
  * video_show_fps()
  * Shows/hides the FPS counter
@@ -696,6 +710,24 @@ void video_display_loading_screen()
     video_render();
 }
 
+/*
+ * video_draw_loading_screen()
+ * Draws a loading screen with a progress bar
+ * (progress is in [0,1]). Call it on the render
+ * cycle of a scene that is loading its assets
+ */
+void video_draw_loading_screen(float progress)
+{
+    image_t *img = image_load(LOADING_SCREEN_FILE);
+    int w = VIDEO_SCREEN_W / 2, x = (VIDEO_SCREEN_W - w) / 2, y = VIDEO_SCREEN_H - 16;
+
+    image_clear(color_rgb(0, 0, 0));
+    image_blit(img, 0, 0, (VIDEO_SCREEN_W - image_width(img))/2, (VIDEO_SCREEN_H - image_height(img))/2, image_width(img), image_height(img));
+    image_rectfill(x, y, x + w - 1, y + 1, color_rgb(64, 64, 64));
+    image_rectfill(x, y, x + (int)(clip(progress, 0.0f, 1.0f) * (w - 1)), y + 1, color_rgb(255, 255, 255));
+    image_unload(img);
+}
+
 
 
 /* private stuff */
@@ -50,6 +50,7 @@ bool video_is_smooth();
 bool video_is_fullscreen();
 v2d_t video_get_screen_size(); /* usually, 426x240 */
 v2d_t video_get_window_size(); /* the real size of the window, in pixels */
+void video_disable_vsync(); /* call before video_init() */
 
 /* backbuffer */
 #define VIDEO_SCREEN_W            ((int)(video_get_screen_size().x))
@@ -66,5 +67,6 @@ void video_showmessage(const char *fmt, ...);
 
 /* loading screen */
 void video_display_loading_screen();
+void video_draw_loading_screen(float progress); /* progress is in [0,1] */
 
 #endif
@@ -101,6 +101,8 @@ static void render(const bgtheme_t *theme, v2d_t camera_position, int foreground
 static int traverse(const parsetree_statement_t *stmt, void *bgtheme);
 static int traverse_background_attributes(const parsetree_statement_t *stmt, void *background);
 static void validate_background(const background_t *bg);
+static int traverse_preload(const parsetree_statement_t *stmt, void *unused);
+static int traverse_preload_attributes(const parsetree_statement_t *stmt, void *unused);
 
 
 /* public methods */
@@ -131,13 +133,31 @@ bgtheme_t* background_load(const char *filepath)
     return bgtheme;
 }
 
+/*
+ * background_preload()
+ * Schedules the images of a background theme to be
+ * loaded asynchronously. Call background_load() afterwards
+ */
+void background_preload(const char *filepath)
+{
+    parsetree_program_t *tree;
+    const char *fullpath;
+
+    logfile_debug("Preloading background \"%s\"...", filepath);
+    fullpath = assetfs_fullpath(filepath);
+
+    tree = nanoparser_construct_tree(fullpath);
+    nanoparser_traverse_program_ex(tree, NULL, traverse_preload);
+    tree = nanoparser_deconstruct_tree(tree);
+}
+
 /*
  * background_unload()
  * Unloads a background theme
  */
 bgtheme_t* background_unload(bgtheme_t *bgtheme)
 {
-    logfile_message("Will unload background \"%s\"...", bgtheme->filepath);
+    logfile_debug("Will unload background \"%s\"...", bgtheme->filepath);
 
     if(bgtheme->data != NULL) {
         for(int i = 0; i < bgtheme->length; i++)
@@ -481,6 +501,36 @@ int traverse_background_attributes(const parsetree_statement_t *stmt, void *back
     return 0;
 }
 
+int traverse_preload(const parsetree_statement_t *stmt, void *unused)
+{
+    const char *identifier = nanoparser_get_identifier(stmt);
+    const parsetree_parameter_t *param_list = nanoparser_get_parameter_list(stmt);
+    const parsetree_parameter_t *p1;
+
+    if(str_icmp(identifier, "background") == 0) {
+        p1 = nanoparser_get_nth_parameter(param_list, 1);
+        nanoparser_expect_program(p1, "Can't read background. Missing background attributes");
+        nanoparser_traverse_program_ex(nanoparser_get_program(p1), NULL, traverse_preload_attributes);
+    }
+
+    return 0;
+}
+
+int traverse_preload_attributes(const parsetree_statement_t *stmt, void *unused)
+{
+    const char *identifier = nanoparser_get_identifier(stmt);
+    const parsetree_parameter_t *param_list = nanoparser_get_parameter_list(stmt);
+    const parsetree_parameter_t *p1;
+
+    if(str_icmp(identifier, "sprite") == 0) {
+        p1 = nanoparser_get_nth_parameter(param_list, 1);
+        nanoparser_expect_program(p1, "Can't read background attributes: sprite block expected");
+        spriteinfo_preload(nanoparser_get_program(p1));
+    }
+
+    return 0;
+}
+
 void validate_background(const background_t *bg)
 {
     if(bg->data == NULL)
@@ -26,6 +26,7 @@
 typedef struct bgtheme_t bgtheme_t;
 
 bgtheme_t* background_load(const char *filepath); /* loads a bg/fg theme from a .bg file */
+void background_preload(const char *filepath); /* loads the images of a .bg file asynchronously */
 bgtheme_t* background_unload(bgtheme_t *bgtheme); /* unloads the bg/fg theme */
 void background_update(bgtheme_t *bgtheme); /* updates the given theme */
 void background_render_bg(const bgtheme_t *bgtheme, v2d_t camera_position); /* renders the background */
@@ -41,6 +41,8 @@
 #include "../core/audio.h"
 #include "../core/sprite.h"
 #include "../core/nanoparser/nanoparser.h"
+#include "../core/parsecache.h"
+#include "../core/jobs.h"
 
 /* constants */
 #define BRKDATA_MAX             16384 /* up to BRKDATA_MAX bricks per theme are supported */
@@ -92,6 +94,14 @@ struct maskdetails_t {
     int x, y, w, h;
 };
 
+/* bricks whose collision masks are created from the same (locked) image */
+typedef struct maskbatch_t maskbatch_t;
+struct maskbatch_t {
+    const image_t* image;
+    int count;
+    int brick_id[BRKDATA_MAX];
+};
+
 /* private stuff */
 static brickdata_t *brickdata_get(int id);
 static void brick_animate(brick_t *brk);
@@ -101,8 +111,12 @@ static void validate_brickdata(const brickdata_t *obj);
 static int traverse(const parsetree_statement_t *stmt);
 static int traverse_brick_attributes(const parsetree_statement_t *stmt, void *brickdata);
 static int traverse_collisionmask(const parsetree_statement_t *stmt, void *maskdetails);
+static int traverse_preload(const parsetree_statement_t *stmt);
+static int traverse_preload_attributes(const parsetree_statement_t *stmt, void *unused);
 static collisionmask_t *read_collisionmask(const parsetree_program_t *block);
 static void create_collisionmasks();
+static void create_collisionmask_batch(maskbatch_t* batch, const image_t* image);
+static void create_collisionmask_job(int index, void* batch);
 static obstacle_t* create_obstacle(const brick_t* brick);
 static obstacle_t* destroy_obstacle(obstacle_t* obstacle);
 static inline int get_obstacle_flags(const brick_t* brick);
@@ -132,7 +146,6 @@ static const float BRICK_FLOAT_TTL = 0.75f; /* time to live: seconds before a fl
 void brickset_load(const char* filename)
 {
     int i;
-    const char* fullpath;
     parsetree_program_t* tree;
 
     if(brickset_loaded()) {
@@ -141,20 +154,19 @@ void brickset_load(const char* filename)
     }
 
     logfile_message("Loading brickset \"%s\"...", filename);
-    fullpath = assetfs_fullpath(filename);
 
     brickdata_count = 0;
     for(i=0; i<BRKDATA_MAX; i++) 
         brickdata[i] = NULL;
 
-    tree = nanoparser_construct_tree(fullpath);
+    tree = parsecache_construct_tree(filename);
     nanoparser_traverse_program(tree, traverse);
     tree = nanoparser_deconstruct_tree(tree);
 
     if(brickdata_count == 0)
         fatal_error("FATAL ERROR: no bricks have been defined in \"%s\"", filename);
 
-    logfile_message("Creating collision masks...");
+    logfile_debug("Creating collision masks...");
     create_collisionmasks();
 
     logfile_message("The brickset has been loaded.");
@@ -162,6 +174,24 @@ void brickset_load(const char* filename)
 
 
 
+/*
+ * brickset_preload()
+ * Schedules the images of a brickset to be loaded
+ * asynchronously. Call brickset_load() afterwards
+ */
+void brickset_preload(const char* filename)
+{
+    parsetree_program_t* tree;
+
+    logfile_debug("Preloading brickset \"%s\"...", filename);
+
+    tree = parsecache_construct_tree(filename);
+    nanoparser_traverse_program(tree, traverse_preload);
+    tree = nanoparser_deconstruct_tree(tree);
+}
+
+
+
 /*
  * brickset_unload()
  * Unloads the current brickset
@@ -1188,7 +1218,7 @@ int traverse_brick_attributes(const parsetree_statement_t *stmt, void *brickdata
     }
     else if(str_icmp(identifier, "collision_mask") == 0) { /* deprecated */
         p1 = nanoparser_get_nth_parameter(param_list, 1);
-        logfile_message("WARNING: brick parameter collision_mask is deprecated. Use mask instead.");
+        logfile_warning("WARNING: brick parameter collision_mask is deprecated. Use mask instead.");
         nanoparser_expect_program(p1, "Can't read brick attributes: collision_mask expects a block");
         if(dat->mask != NULL)
             collisionmask_destroy(dat->mask);
@@ -1243,6 +1273,51 @@ int traverse_collisionmask(const parsetree_statement_t *stmt, void *maskdetails)
     return 0;
 }
 
+/* finds the images referenced by the brickset */
+int traverse_preload(const parsetree_statement_t *stmt)
+{
+    const char *identifier = nanoparser_get_identifier(stmt);
+    const parsetree_parameter_t *param_list = nanoparser_get_parameter_list(stmt);
+    const parsetree_parameter_t *p2;
+
+    if(str_icmp(identifier, "brick") == 0) {
+        p2 = nanoparser_get_nth_parameter(param_list, 2);
+        nanoparser_expect_program(p2, "Can't load bricks: brick attributes must be provided");
+        nanoparser_traverse_program_ex(nanoparser_get_program(p2), NULL, traverse_preload_attributes);
+    }
+
+    return 0;
+}
+
+/* finds the images referenced by a brick */
+int traverse_preload_attributes(const parsetree_statement_t *stmt, void *unused)
+{
+    const char *identifier = nanoparser_get_identifier(stmt);
+    const parsetree_parameter_t *param_list = nanoparser_get_parameter_list(stmt);
+    const parsetree_parameter_t *p1;
+
+    if(str_icmp(identifier, "sprite") == 0) {
+        p1 = nanoparser_get_nth_parameter(param_list, 1);
+        nanoparser_expect_program(p1, "Can't read brick attributes: a sprite block must be specified");
+        spriteinfo_preload(nanoparser_get_program(p1));
+    }
+    else if(str_icmp(identifier, "mask") == 0) {
+        p1 = nanoparser_get_nth_parameter(param_list, 1);
+        nanoparser_expect_string(p1, "Can't read brick attrbitues: mask must be a filename");
+        image_preload(nanoparser_get_string(p1));
+    }
+    else if(str_icmp(identifier, "collision_mask") == 0) { /* deprecated */
+        maskdetails_t s = { NULL, 0, 0, 0, 0 };
+        p1 = nanoparser_get_nth_parameter(param_list, 1);
+        nanoparser_expect_program(p1, "Can't read brick attributes: collision_mask expects a block");
+        nanoparser_traverse_program_ex(nanoparser_get_program(p1), (void*)(&s), traverse_collisionmask);
+        if(s.source_file != NULL)
+            image_preload(s.source_file);
+    }
+
+    return 0;
+}
+
 /* read a collision mask from a file (deprecated) */
 collisionmask_t *read_collisionmask(const parsetree_program_t *block)
 {
@@ -1264,18 +1339,20 @@ collisionmask_t *read_collisionmask(const parsetree_program_t *block)
 /* creates the collision masks of all bricks */
 void create_collisionmasks()
 {
+    static maskbatch_t batch; /* too large for the stack */
     int i;
     image_t* mask = NULL;
     const char* prev_maskfile = "";
 
     /* creates the collision masks */
+    batch.count = 0;
     for(i = 0; i < brickdata_count; i++) {
         if(brickdata[i] != NULL && brickdata[i]->type != BRK_PASSABLE && brickdata[i]->mask == NULL) {
             const char* maskfile = brickdata[i]->maskfile ? brickdata[i]->maskfile : brickdata[i]->data->source_file;
-            spriteinfo_t* sprite = brickdata[i]->data;
 
             if(mask == NULL || 0 != str_icmp(prev_maskfile, maskfile)) {
                 if(mask != NULL) {
+                    create_collisionmask_batch(&batch, mask);
                     image_unlock(mask);
                     image_unload(mask);
                 }
@@ -1284,17 +1361,12 @@ void create_collisionmasks()
                 prev_maskfile = maskfile;
             }
 
-            brickdata[i]->mask = collisionmask_create(
-                mask,
-                sprite->rect_x,
-                sprite->rect_y,
-                sprite->frame_w,
-                sprite->frame_h
-            );
+            batch.brick_id[batch.count++] = i;
         }
     }
 
     if(mask != NULL) {
+        create_collisionmask_batch(&batch, mask);
         image_unlock(mask);
         image_unload(mask);
     }
@@ -1307,4 +1379,29 @@ void create_collisionmasks()
             brickdata[i]->maskimg = collisionmask_to_image(brickdata[i]->mask, color);
         }
     }
+}
+
+/* creates the collision masks of a batch of bricks in parallel.
+   Reading the pixels of a locked image is thread-safe */
+void create_collisionmask_batch(maskbatch_t* batch, const image_t* image)
+{
+    batch->image = image;
+    jobs_parallel_for(batch->count, create_collisionmask_job, batch);
+    batch->count = 0;
+}
+
+/* creates the collision mask of the index-th brick of a batch */
+void create_collisionmask_job(int index, void* batch)
+{
+    const maskbatch_t* b = (const maskbatch_t*)batch;
+    brickdata_t* data = brickdata[b->brick_id[index]];
+    const spriteinfo_t* sprite = data->data;
+
+    data->mask = collisionmask_create(
+        b->image,
+        sprite->rect_x,
+        sprite->rect_y,
+        sprite->frame_w,
+        sprite->frame_h
+    );
 }
\ No newline at end of file
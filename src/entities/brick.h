@@ -85,6 +85,7 @@ struct brick_list_t {
 
 /* brickset: theme interface */
 void brickset_load(const char *filename); /* loads a brickset */
+void brickset_preload(const char *filename); /* loads the images of a brickset asynchronously */
 void brickset_unload(); /* unloads the current brickset */
 int brickset_size(); /* number of bricks */
 int brickset_loaded(); /* is a brickset loaded? */
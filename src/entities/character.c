@@ -21,6 +21,7 @@
 #include "character.h"
 #include "../core/hashtable.h"
 #include "../core/nanoparser/nanoparser.h"
+#include "../core/parsecache.h"
 #include "../core/assetfs.h"
 #include "../core/util.h"
 #include "../core/stringutil.h"
@@ -149,9 +150,8 @@ void character_delete(character_t* c)
 
 int dirfill(const char *vpath, void *param)
 {
-    const char* fullpath = assetfs_fullpath(vpath);
     parsetree_program_t** p = (parsetree_program_t**)param;
-    *p = nanoparser_append_program(*p, nanoparser_construct_tree(fullpath));
+    *p = nanoparser_append_program(*p, parsecache_construct_tree(vpath));
     return 0;
 }
 
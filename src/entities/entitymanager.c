@@ -25,7 +25,10 @@
 #include "legacy/item.h"
 #include "legacy/enemy.h"
 #include "../core/spatialhash.h"
+#include "../core/darray.h"
+#include "../core/video.h"
 #include "../core/util.h"
+#include "../core/logfile.h"
 
 /* defining the spatial hashes */
 SPATIALHASH_GENERATE_CODE(brick_t)
@@ -50,9 +53,43 @@ static int brick_count;
 static int item_count;
 static int object_count;
 
+static void (*on_remove_brick)(brick_t*);
+static void (*on_remove_item)(item_t*);
+static void (*on_remove_object)(enemy_t*);
+
+/* bounds of the bricks, kept up to date as bricks are stored and removed.
+   The unmoving bricks are also grouped in columns, so that the height of
+   the level can be sampled without querying the spatial hash */
+#define MAX_BRICK_COLUMNS 10240 /* limit memory usage */
+typedef struct brickcolumn_t brickcolumn_t;
+struct brickcolumn_t {
+    int bottom; /* largest y-coordinate of the unmoving bricks overlapping this column */
+    int bottom_count; /* how many of these bricks reach that y-coordinate? */
+    int brick_count; /* how many unmoving bricks overlap this column? */
+    int dirty; /* bottom must be recomputed (a brick defining it was removed) */
+};
+
+STATIC_DARRAY(brickcolumn_t, brick_columns);
+static int brick_column_width;
+static int bricks_right, bricks_right_count;
+static int bricks_bottom, bricks_bottom_count;
+static int bricks_bounds_dirty;
+
+static void track_brick(const brick_t *brick);
+static void untrack_brick(const brick_t *brick);
+static int columns_of_brick(const brick_t *brick, int *first_column, int *last_column);
+static void refresh_brick_column(int column);
+static void refresh_brick_bounds();
+static int sample_brick_column(brick_t *brick, void *column);
+static int sample_brick_bounds(brick_t *brick, void *unused);
+static inline int floor_div(int a, int b);
+
 static void add_to_dead_bricks_list(brick_t *brick);
 static void add_to_dead_items_list(item_t *item);
 static void add_to_dead_objects_list(enemy_t *object);
+static void remove_from_dead_bricks_list(brick_t *brick);
+static void remove_from_dead_items_list(item_t *item);
+static void remove_from_dead_objects_list(enemy_t *object);
 
 static int retrieve_nonpersistent_bricks(brick_t *brick, void *ref_to_brick_list);
 static int retrieve_bricks(brick_t *brick, void *ref_to_brick_list);
@@ -92,6 +129,16 @@ void entitymanager_init()
     item_count = 0;
     object_count = 0;
 
+    on_remove_brick = NULL;
+    on_remove_item = NULL;
+    on_remove_object = NULL;
+
+    darray_init(brick_columns);
+    brick_column_width = max(1, VIDEO_SCREEN_W / 4);
+    bricks_right = bricks_bottom = -LARGE_INT;
+    bricks_right_count = bricks_bottom_count = 0;
+    bricks_bounds_dirty = FALSE;
+
     bricks = spatialhash_brick_t_create(brick_destroy, get_brick_xpos, get_brick_ypos, get_brick_width, get_brick_height);
     items = spatialhash_item_t_create(item_destroy, get_item_xpos, get_item_ypos, get_item_width, get_item_height);
     objects = spatialhash_enemy_t_create(enemy_destroy, get_object_xpos, get_object_ypos, get_object_width, get_object_height);
@@ -101,15 +148,16 @@ void entitymanager_release()
 {
     logfile_message("Releasing the Entity Manager...");
 
-    logfile_message("releasing bricks...");
+    logfile_debug("releasing bricks...");
     bricks = spatialhash_brick_t_destroy(bricks);
     brick_count = 0;
+    darray_release(brick_columns);
 
-    logfile_message("releasing built-in items...");
+    logfile_debug("releasing built-in items...");
     items = spatialhash_item_t_destroy(items);
     item_count = 0;
 
-    logfile_message("releasing custom objects...");
+    logfile_debug("releasing custom objects...");
     objects = spatialhash_enemy_t_destroy(objects);
     object_count = 0;
 }
@@ -118,6 +166,7 @@ void entitymanager_store_brick(brick_t *brick)
 {
     (IS_MOVING_BRICK(brick) ? spatialhash_brick_t_add_persistent : spatialhash_brick_t_add)(bricks, brick);
     brick_count++;
+    track_brick(brick);
 }
 
 void entitymanager_store_item(item_t *item)
@@ -272,12 +321,45 @@ int entitymanager_get_number_of_objects()
     return object_count;
 }
 
+int entitymanager_get_brick_bounds(int *right, int *bottom)
+{
+    if(bricks_bounds_dirty)
+        refresh_brick_bounds();
+
+    *right = bricks_right;
+    *bottom = bricks_bottom;
+    return brick_count > 0;
+}
+
+int entitymanager_get_brick_column_width()
+{
+    return brick_column_width;
+}
+
+int entitymanager_get_brick_column_bottom(int column, int *bottom)
+{
+    brickcolumn_t *c;
+
+    if(column < 0 || column >= darray_length(brick_columns))
+        return FALSE;
+
+    c = &brick_columns[column];
+    if(c->dirty)
+        refresh_brick_column(column);
+
+    *bottom = c->bottom;
+    return c->brick_count > 0 && c->bottom > -LARGE_INT;
+}
+
 void entitymanager_remove_dead_bricks()
 {
     brick_list_t *it, *next;
 
     for(it = dead_bricks; it != NULL; it = next) {
         next = it->next;
+        if(on_remove_brick != NULL)
+            on_remove_brick(it->data);
+        untrack_brick(it->data);
         spatialhash_brick_t_remove(bricks, it->data);
         brick_count--;
         free(it);
@@ -292,6 +374,8 @@ void entitymanager_remove_dead_items()
 
     for(it = dead_items; it != NULL; it = next) {
         next = it->next;
+        if(on_remove_item != NULL)
+            on_remove_item(it->data);
         spatialhash_item_t_remove(items, it->data);
         item_count--;
         free(it);
@@ -306,6 +390,8 @@ void entitymanager_remove_dead_objects()
 
     for(it = dead_objects; it != NULL; it = next) {
         next = it->next;
+        if(on_remove_object != NULL)
+            on_remove_object(it->data);
         spatialhash_enemy_t_remove(objects, it->data);
         object_count--;
         free(it);
@@ -314,6 +400,45 @@ void entitymanager_remove_dead_objects()
     dead_objects = NULL;
 }
 
+void entitymanager_set_removal_listener(void (*on_remove_brick_fn)(brick_t*), void (*on_remove_item_fn)(item_t*), void (*on_remove_object_fn)(enemy_t*))
+{
+    on_remove_brick = on_remove_brick_fn;
+    on_remove_item = on_remove_item_fn;
+    on_remove_object = on_remove_object_fn;
+}
+
+void entitymanager_remove_brick(brick_t *brick)
+{
+    remove_from_dead_bricks_list(brick);
+    untrack_brick(brick);
+    spatialhash_brick_t_remove(bricks, brick);
+    brick_count--;
+}
+
+void entitymanager_remove_item(item_t *item)
+{
+    remove_from_dead_items_list(item);
+    spatialhash_item_t_remove(items, item);
+    item_count--;
+}
+
+void entitymanager_remove_object(enemy_t *object)
+{
+    remove_from_dead_objects_list(object);
+    spatialhash_enemy_t_remove(objects, object);
+    object_count--;
+}
+
+int entitymanager_get_brick_columns(int left, int right, int *first_column, int *last_column)
+{
+    /* column j samples the interval [ j*w - (w+1)/2, j*w - (w+1)/2 + w ] */
+    int w = brick_column_width, half = (w + 1) / 2;
+
+    *first_column = max(0, -floor_div(-(left + half - w), w)); /* ceil */
+    *last_column = min(MAX_BRICK_COLUMNS - 1, floor_div(right + half, w));
+    return *first_column <= *last_column;
+}
+
 /* private methods */
 int get_brick_xpos(const brick_t *brick)
 {
@@ -494,3 +619,196 @@ void add_to_dead_objects_list(enemy_t *object)
     else
         prev->next = node;
 }
+
+void remove_from_dead_bricks_list(brick_t *brick)
+{
+    brick_list_t *it, *prev;
+
+    for(prev = NULL, it = dead_bricks; it != NULL; prev = it, it = it->next) {
+        if(it->data == brick) {
+            if(prev == NULL)
+                dead_bricks = it->next;
+            else
+                prev->next = it->next;
+            free(it);
+            return;
+        }
+    }
+}
+
+void remove_from_dead_items_list(item_t *item)
+{
+    item_list_t *it, *prev;
+
+    for(prev = NULL, it = dead_items; it != NULL; prev = it, it = it->next) {
+        if(it->data == item) {
+            if(prev == NULL)
+                dead_items = it->next;
+            else
+                prev->next = it->next;
+            free(it);
+            return;
+        }
+    }
+}
+
+void remove_from_dead_objects_list(enemy_t *object)
+{
+    enemy_list_t *it, *prev;
+
+    for(prev = NULL, it = dead_objects; it != NULL; prev = it, it = it->next) {
+        if(it->data == object) {
+            if(prev == NULL)
+                dead_objects = it->next;
+            else
+                prev->next = it->next;
+            free(it);
+            return;
+        }
+    }
+}
+
+/* bounds of the bricks */
+void track_brick(const brick_t *brick)
+{
+    v2d_t bottomright = v2d_add(brick_spawnpoint(brick), brick_size(brick));
+    int right = (int)bottomright.x, bottom = (int)bottomright.y;
+    int first, last;
+
+    /* bounding box of all bricks */
+    if(right > bricks_right) {
+        bricks_right = right;
+        bricks_right_count = 1;
+    }
+    else if(right == bricks_right)
+        bricks_right_count++;
+
+    if(bottom > bricks_bottom) {
+        bricks_bottom = bottom;
+        bricks_bottom_count = 1;
+    }
+    else if(bottom == bricks_bottom)
+        bricks_bottom_count++;
+
+    /* columns of the unmoving bricks */
+    if(IS_MOVING_BRICK(brick) || !columns_of_brick(brick, &first, &last))
+        return;
+
+    while(darray_length(brick_columns) <= last) {
+        brickcolumn_t empty = { -LARGE_INT, 0, 0, FALSE };
+        darray_push(brick_columns, empty);
+    }
+
+    for(int j = first; j <= last; j++) {
+        brickcolumn_t *c = &brick_columns[j];
+        if(bottom > c->bottom || (c->dirty && bottom == c->bottom)) {
+            c->bottom = bottom;
+            c->bottom_count = 1;
+            c->dirty = FALSE;
+        }
+        else if(bottom == c->bottom)
+            c->bottom_count++;
+        c->brick_count++;
+    }
+}
+
+void untrack_brick(const brick_t *brick)
+{
+    v2d_t bottomright = v2d_add(brick_spawnpoint(brick), brick_size(brick));
+    int right = (int)bottomright.x, bottom = (int)bottomright.y;
+    int first, last;
+
+    /* the bounding box is recomputed lazily */
+    if(right == bricks_right && --bricks_right_count <= 0)
+        bricks_bounds_dirty = TRUE;
+    if(bottom == bricks_bottom && --bricks_bottom_count <= 0)
+        bricks_bounds_dirty = TRUE;
+
+    /* so are the columns */
+    if(IS_MOVING_BRICK(brick) || !columns_of_brick(brick, &first, &last))
+        return;
+
+    for(int j = first; j <= last && j < darray_length(brick_columns); j++) {
+        brickcolumn_t *c = &brick_columns[j];
+        if(--c->brick_count <= 0) {
+            c->bottom = -LARGE_INT;
+            c->bottom_count = c->brick_count = 0;
+            c->dirty = FALSE;
+        }
+        else if(bottom == c->bottom && --c->bottom_count <= 0)
+            c->dirty = TRUE;
+    }
+}
+
+/* columns overlapped by a brick */
+int columns_of_brick(const brick_t *brick, int *first_column, int *last_column)
+{
+    int left = (int)brick_spawnpoint(brick).x;
+    int right = left + (int)brick_size(brick).x;
+
+    return entitymanager_get_brick_columns(left, right, first_column, last_column);
+}
+
+void refresh_brick_column(int column)
+{
+    brickcolumn_t *c = &brick_columns[column];
+    int w = brick_column_width;
+
+    c->bottom = -LARGE_INT;
+    c->bottom_count = 0;
+    c->dirty = FALSE;
+    spatialhash_brick_t_foreach(bricks, column * w - (w + 1) / 2, -LARGE_INT/2, w, LARGE_INT, (void*)(&column), sample_brick_column);
+}
+
+void refresh_brick_bounds()
+{
+    bricks_right = bricks_bottom = -LARGE_INT;
+    bricks_right_count = bricks_bottom_count = 0;
+    bricks_bounds_dirty = FALSE;
+    spatialhash_brick_t_forall(bricks, NULL, sample_brick_bounds);
+}
+
+int sample_brick_column(brick_t *brick, void *column)
+{
+    int j = *((int*)column), first, last;
+
+    if(!IS_MOVING_BRICK(brick) && columns_of_brick(brick, &first, &last) && j >= first && j <= last) {
+        brickcolumn_t *c = &brick_columns[j];
+        int bottom = (int)(brick_spawnpoint(brick).y + brick_size(brick).y);
+        if(bottom > c->bottom) {
+            c->bottom = bottom;
+            c->bottom_count = 1;
+        }
+        else if(bottom == c->bottom)
+            c->bottom_count++;
+    }
+
+    return 0;
+}
+
+int sample_brick_bounds(brick_t *brick, void *unused)
+{
+    v2d_t bottomright = v2d_add(brick_spawnpoint(brick), brick_size(brick));
+
+    if((int)bottomright.x > bricks_right) {
+        bricks_right = (int)bottomright.x;
+        bricks_right_count = 1;
+    }
+    else if((int)bottomright.x == bricks_right)
+        bricks_right_count++;
+
+    if((int)bottomright.y > bricks_bottom) {
+        bricks_bottom = (int)bottomright.y;
+        bricks_bottom_count = 1;
+    }
+    else if((int)bottomright.y == bricks_bottom)
+        bricks_bottom_count++;
+
+    return 0;
+}
+
+/* integer division rounding towards -infinity */
+int floor_div(int a, int b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
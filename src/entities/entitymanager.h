@@ -60,10 +60,22 @@ struct enemy_list_t* entitymanager_release_retrieved_object_list(struct enemy_li
 void entitymanager_remove_dead_bricks();
 void entitymanager_remove_dead_items();
 void entitymanager_remove_dead_objects();
+void entitymanager_set_removal_listener(void (*on_remove_brick)(struct brick_t*), void (*on_remove_item)(struct item_t*), void (*on_remove_object)(struct enemy_t*)); /* called before a dead entity is destroyed; any of them may be NULL */
+
+/* removing (and destroying) entities immediately, dead or alive */
+void entitymanager_remove_brick(struct brick_t *brick);
+void entitymanager_remove_item(struct item_t *item);
+void entitymanager_remove_object(struct enemy_t *object);
 
 /* other utilities */
 int entitymanager_get_number_of_bricks();
 int entitymanager_get_number_of_items();
 int entitymanager_get_number_of_objects();
 
+/* bounds of the bricks (computed from their spawn points) */
+int entitymanager_get_brick_bounds(int *right, int *bottom); /* bottom-right corner of the bricks; returns FALSE if there are no bricks */
+int entitymanager_get_brick_column_width(); /* the unmoving bricks are grouped in columns of this width */
+int entitymanager_get_brick_column_bottom(int column, int *bottom); /* largest y of the unmoving bricks near x = column * width; returns FALSE if there are none */
+int entitymanager_get_brick_columns(int left, int right, int *first_column, int *last_column); /* columns overlapped by the interval [left, right]; returns FALSE if there are none */
+
 #endif
@@ -216,10 +216,9 @@ enemy_t *enemy_destroy(enemy_t *enemy)
  */
 void enemy_update(enemy_t *enemy, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, enemy_list_t *object_list)
 {
-    objectmachine_t *machine = *(objectvm_get_reference_to_current_state(enemy->vm));
     if(enemy->state == ES_DEAD) return;
     nanocalcext_set_target_object((object_t*)enemy, brick_list, item_list, object_list);
-    machine->update(machine, team, team_size, brick_list, item_list, object_list);
+    objectvm_update_current_state(enemy->vm, team, team_size, brick_list, item_list, object_list);
 }
 
 
@@ -51,14 +51,21 @@ typedef struct objectdecorator_t objectdecorator_t;
 struct objectdecorator_t {
     objectmachine_t base; /* objectdecorator_t implements the objectmachine_t interface */
     objectmachine_t *decorated_machine; /* what are we decorating? */
+    object_t *object; /* the object instance of the decorated machine (cached) */
 };
 
 /* given an object machine, get its object instance */
 object_t* objectdecorator_get_object_instance(objectmachine_t *obj)
 {
     objectdecorator_t *me = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = me->decorated_machine;
-    return decorated_machine->get_object_instance(decorated_machine);
+    return me->object;
+}
+
+/* given an object machine, get the machine it decorates */
+objectmachine_t* objectdecorator_get_decorated_machine(objectmachine_t *obj)
+{
+    objectdecorator_t *me = (objectdecorator_t*)obj;
+    return me->decorated_machine;
 }
 
 
@@ -75,7 +82,7 @@ struct objectdecorator_addcollectibles_t {
 /* private methods */
 static void addcollectibles_init(objectmachine_t *obj);
 static void addcollectibles_release(objectmachine_t *obj);
-static void addcollectibles_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool addcollectibles_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void addcollectibles_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -94,7 +101,9 @@ objectmachine_t* objectdecorator_addcollectibles_new(objectmachine_t *decorated_
     obj->update = addcollectibles_update;
     obj->render = addcollectibles_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->collectibles = collectibles;
 
     return obj;
@@ -126,15 +135,13 @@ void addcollectibles_release(objectmachine_t *obj)
     free(obj);
 }
 
-void addcollectibles_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool addcollectibles_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_addcollectibles_t *me = (objectdecorator_addcollectibles_t*)obj;
 
     player_set_collectibles( player_get_collectibles() + (int)expression_evaluate(me->collectibles) );
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void addcollectibles_render(objectmachine_t *obj, v2d_t camera_position)
@@ -157,7 +164,7 @@ struct objectdecorator_addlives_t {
 /* private methods */
 static void addlives_init(objectmachine_t *obj);
 static void addlives_release(objectmachine_t *obj);
-static void addlives_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool addlives_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void addlives_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -176,7 +183,9 @@ objectmachine_t* objectdecorator_addlives_new(objectmachine_t *decorated_machine
     obj->update = addlives_update;
     obj->render = addlives_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->lives = lives;
 
     return obj;
@@ -208,15 +217,13 @@ void addlives_release(objectmachine_t *obj)
     free(obj);
 }
 
-void addlives_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool addlives_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_addlives_t *me = (objectdecorator_addlives_t*)obj;
 
     player_set_lives( player_get_lives() + (int)expression_evaluate(me->lives) );
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void addlives_render(objectmachine_t *obj, v2d_t camera_position)
@@ -239,7 +246,7 @@ struct objectdecorator_addtoscore_t {
 /* private methods */
 static void addtoscore_init(objectmachine_t *obj);
 static void addtoscore_release(objectmachine_t *obj);
-static void addtoscore_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool addtoscore_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void addtoscore_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -257,7 +264,9 @@ objectmachine_t* objectdecorator_addtoscore_new(objectmachine_t *decorated_machi
     obj->update = addtoscore_update;
     obj->render = addtoscore_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->score = score;
 
     return obj;
@@ -289,15 +298,13 @@ void addtoscore_release(objectmachine_t *obj)
     free(obj);
 }
 
-void addtoscore_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool addtoscore_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_addtoscore_t *me = (objectdecorator_addtoscore_t*)obj;
 
     level_add_to_score( (int)expression_evaluate(me->score) );
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void addtoscore_render(objectmachine_t *obj, v2d_t camera_position)
@@ -319,7 +326,7 @@ struct objectdecorator_asktoleave_t {
 /* private methods */
 static void asktoleave_init(objectmachine_t *obj);
 static void asktoleave_release(objectmachine_t *obj);
-static void asktoleave_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool asktoleave_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void asktoleave_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -338,7 +345,9 @@ objectmachine_t* objectdecorator_asktoleave_new(objectmachine_t *decorated_machi
     obj->update = asktoleave_update;
     obj->render = asktoleave_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -368,14 +377,11 @@ void asktoleave_release(objectmachine_t *obj)
     free(obj);
 }
 
-void asktoleave_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool asktoleave_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
-
     level_ask_to_leave();
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void asktoleave_render(objectmachine_t *obj, v2d_t camera_position)
@@ -399,7 +405,7 @@ struct objectdecorator_attachtoplayer_t {
 /* private methods */
 static void attachtoplayer_init(objectmachine_t *obj);
 static void attachtoplayer_release(objectmachine_t *obj);
-static void attachtoplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool attachtoplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void attachtoplayer_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -420,7 +426,9 @@ objectmachine_t* objectdecorator_attachtoplayer_new(objectmachine_t *decorated_m
     obj->update = attachtoplayer_update;
     obj->render = attachtoplayer_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->offset_x = offset_x;
     me->offset_y = offset_y;
 
@@ -455,10 +463,8 @@ void attachtoplayer_release(objectmachine_t *obj)
     free(obj);
 }
 
-void attachtoplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool attachtoplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_attachtoplayer_t *me = (objectdecorator_attachtoplayer_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(object);
@@ -469,7 +475,7 @@ void attachtoplayer_update(objectmachine_t *obj, player_t **team, int team_size,
     object->attached_to_player_offset = v2d_rotate(offset, -player->actor->angle);
     object->actor->position = v2d_add(player->actor->position, object->attached_to_player_offset);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void attachtoplayer_render(objectmachine_t *obj, v2d_t camera_position)
@@ -557,7 +563,7 @@ static void stopsamplestrategy_release(audiostrategy_t *s);
 /* private methods */
 static void audiocommand_init(objectmachine_t *obj);
 static void audiocommand_release(objectmachine_t *obj);
-static void audiocommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool audiocommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void audiocommand_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* audiocommand_make_decorator(objectmachine_t *decorated_machine, audiostrategy_t *strategy);
@@ -618,15 +624,13 @@ void audiocommand_release(objectmachine_t *obj)
     free(obj);
 }
 
-void audiocommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool audiocommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_audio_t *me = (objectdecorator_audio_t*)obj;
 
     me->strategy->update(me->strategy);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void audiocommand_render(objectmachine_t *obj, v2d_t camera_position)
@@ -656,7 +660,9 @@ objectmachine_t* audiocommand_make_decorator(objectmachine_t *decorated_machine,
     obj->update = audiocommand_update;
     obj->render = audiocommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->strategy = strategy;
 
     return obj;
@@ -814,7 +820,7 @@ struct objectdecorator_bounceplayer_t {
 /* private methods */
 static void bounceplayer_init(objectmachine_t *obj);
 static void bounceplayer_release(objectmachine_t *obj);
-static void bounceplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool bounceplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void bounceplayer_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -833,7 +839,9 @@ objectmachine_t* objectdecorator_bounceplayer_new(objectmachine_t *decorated_mac
     obj->update = bounceplayer_update;
     obj->render = bounceplayer_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -863,16 +871,14 @@ void bounceplayer_release(objectmachine_t *obj)
     free(obj);
 }
 
-void bounceplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool bounceplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
 
     player_bounce_ex(player, object->actor, FALSE);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void bounceplayer_render(objectmachine_t *obj, v2d_t camera_position)
@@ -896,7 +902,7 @@ struct objectdecorator_bullettrajectory_t {
 /* private methods */
 static void bullettrajectory_init(objectmachine_t *obj);
 static void bullettrajectory_release(objectmachine_t *obj);
-static void bullettrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool bullettrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void bullettrajectory_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -917,7 +923,9 @@ objectmachine_t* objectdecorator_bullettrajectory_new(objectmachine_t *decorated
     obj->update = bullettrajectory_update;
     obj->render = bullettrajectory_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->speed_x = speed_x;
     me->speed_y = speed_y;
 
@@ -952,10 +960,8 @@ void bullettrajectory_release(objectmachine_t *obj)
     free(obj);
 }
 
-void bullettrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool bullettrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_bullettrajectory_t *me = (objectdecorator_bullettrajectory_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     float dt = timer_get_delta();
@@ -965,7 +971,7 @@ void bullettrajectory_update(objectmachine_t *obj, player_t **team, int team_siz
     ds = v2d_multiply(speed, dt);
     object->actor->position = v2d_add(object->actor->position, ds);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void bullettrajectory_render(objectmachine_t *obj, v2d_t camera_position)
@@ -989,7 +995,7 @@ struct objectdecorator_camerafocus_t {
 /* private methods */
 static void camerafocus_init(objectmachine_t *obj);
 static void camerafocus_release(objectmachine_t *obj);
-static void camerafocus_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool camerafocus_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void camerafocus_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* camerafocus_make_decorator(objectmachine_t *decorated_machine, void (*strategy)(objectmachine_t*));
@@ -1024,7 +1030,9 @@ objectmachine_t* camerafocus_make_decorator(objectmachine_t *decorated_machine,
     obj->update = camerafocus_update;
     obj->render = camerafocus_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->strategy = strategy;
 
     return obj;
@@ -1055,15 +1063,13 @@ void camerafocus_release(objectmachine_t *obj)
     free(obj);
 }
 
-void camerafocus_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool camerafocus_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_camerafocus_t *me = (objectdecorator_camerafocus_t*)obj;
 
     me->strategy(obj);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void camerafocus_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1100,7 +1106,7 @@ struct objectdecorator_changeclosestobjectstate_t {
 /* private methods */
 static void changeclosestobjectstate_init(objectmachine_t *obj);
 static void changeclosestobjectstate_release(objectmachine_t *obj);
-static void changeclosestobjectstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool changeclosestobjectstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void changeclosestobjectstate_render(objectmachine_t *obj, v2d_t camera_position);
 
 static object_t *find_closest_object(object_t *me, object_list_t *list, const char* desired_name, float *distance);
@@ -1119,7 +1125,9 @@ objectmachine_t* objectdecorator_changeclosestobjectstate_new(objectmachine_t *d
     obj->update = changeclosestobjectstate_update;
     obj->render = changeclosestobjectstate_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->object_name = str_dup(object_name);
     me->new_state_name = str_dup(new_state_name);
@@ -1152,11 +1160,9 @@ void changeclosestobjectstate_release(objectmachine_t *obj)
     free(obj);
 }
 
-void changeclosestobjectstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool changeclosestobjectstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_changeclosestobjectstate_t *me = (objectdecorator_changeclosestobjectstate_t*)obj;
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
     object_t *target = find_closest_object(object, object_list, me->object_name, NULL);
 
@@ -1166,7 +1172,7 @@ void changeclosestobjectstate_update(objectmachine_t *obj, player_t **team, int
         nanocalcext_set_target_object(object, brick_list, item_list, object_list); /* restore nanocalc's target object */
     }
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void changeclosestobjectstate_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1223,7 +1229,7 @@ static void changeparentstate_strategy(objectdecorator_children_t *me, player_t
 /* private methods */
 static void childrencommand_init(objectmachine_t *obj);
 static void childrencommand_release(objectmachine_t *obj);
-static void childrencommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool childrencommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void childrencommand_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t *childrencommand_make_decorator(objectmachine_t *decorated_machine, childrenstrategy_t strategy, expression_t *offset_x, expression_t *offset_y, const char *object_name, const char *child_name, const char *new_state_name);
@@ -1259,7 +1265,9 @@ objectmachine_t *childrencommand_make_decorator(objectmachine_t *decorated_machi
     obj->update = childrencommand_update;
     obj->render = childrencommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->strategy = strategy;
     me->offset_x = offset_x;
@@ -1308,15 +1316,13 @@ void childrencommand_release(objectmachine_t *obj)
     free(obj);
 }
 
-void childrencommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool childrencommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_children_t *me = (objectdecorator_children_t*)obj;
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
 
     me->strategy(me, team, team_size, brick_list, item_list, object_list);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void childrencommand_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1386,7 +1392,7 @@ struct objectdecorator_clearlevel_t {
 /* private methods */
 static void clearlevel_init(objectmachine_t *obj);
 static void clearlevel_release(objectmachine_t *obj);
-static void clearlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool clearlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void clearlevel_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -1405,7 +1411,9 @@ objectmachine_t* objectdecorator_clearlevel_new(objectmachine_t *decorated_machi
     obj->update = clearlevel_update;
     obj->render = clearlevel_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -1435,15 +1443,13 @@ void clearlevel_release(objectmachine_t *obj)
     free(obj);
 }
 
-void clearlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool clearlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
 
     level_clear(object->actor);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void clearlevel_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1467,7 +1473,7 @@ struct objectdecorator_createitem_t {
 /* private methods */
 static void createitem_init(objectmachine_t *obj);
 static void createitem_release(objectmachine_t *obj);
-static void createitem_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool createitem_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void createitem_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -1484,7 +1490,9 @@ objectmachine_t* objectdecorator_createitem_new(objectmachine_t *decorated_machi
     obj->update = createitem_update;
     obj->render = createitem_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->item_id = item_id;
     me->offset_x = offset_x;
     me->offset_y = offset_y;
@@ -1517,11 +1525,9 @@ void createitem_release(objectmachine_t *obj)
     free(obj);
 }
 
-void createitem_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool createitem_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_createitem_t *me = (objectdecorator_createitem_t*)obj;
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
     int item_id;
     v2d_t offset;
@@ -1532,7 +1538,7 @@ void createitem_update(objectmachine_t *obj, player_t **team, int team_size, bri
 
     level_create_legacy_item(item_id, v2d_add(object->actor->position, offset));
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void createitem_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1554,7 +1560,7 @@ struct objectdecorator_destroy_t {
 /* private methods */
 static void destroy_init(objectmachine_t *obj);
 static void destroy_release(objectmachine_t *obj);
-static void destroy_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool destroy_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void destroy_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -1575,7 +1581,9 @@ objectmachine_t* objectdecorator_destroy_new(objectmachine_t *decorated_machine)
     obj->update = destroy_update;
     obj->render = destroy_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -1606,16 +1614,13 @@ void destroy_release(objectmachine_t *obj)
     free(obj);
 }
 
-void destroy_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool destroy_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    /*objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;*/
-
     object_t *object = obj->get_object_instance(obj);
     object->state = ES_DEAD;
 
     /* suspend the execution */
-    /*decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);*/
+    return false;
 }
 
 void destroy_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1641,7 +1646,7 @@ struct objectdecorator_dialogbox_t {
 /* private methods */
 static void dialogbox_init(objectmachine_t *obj);
 static void dialogbox_release(objectmachine_t *obj);
-static void dialogbox_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool dialogbox_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void dialogbox_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* dialogbox_make_decorator(objectmachine_t *decorated_machine, const char *title, const char *message, void (*strategy)());
@@ -1676,7 +1681,9 @@ objectmachine_t* dialogbox_make_decorator(objectmachine_t *decorated_machine, co
     obj->update = dialogbox_update;
     obj->render = dialogbox_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->title = str_dup(title);
     me->message = str_dup(message);
     me->strategy = strategy;
@@ -1707,15 +1714,13 @@ void dialogbox_release(objectmachine_t *obj)
     free(obj);
 }
 
-void dialogbox_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool dialogbox_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_dialogbox_t *me = (objectdecorator_dialogbox_t*)obj;
 
     me->strategy(me);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void dialogbox_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1751,7 +1756,7 @@ struct objectdecorator_ellipticaltrajectory_t {
 /* private methods */
 static void ellipticaltrajectory_init(objectmachine_t *obj);
 static void ellipticaltrajectory_release(objectmachine_t *obj);
-static void ellipticaltrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool ellipticaltrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void ellipticaltrajectory_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -1770,7 +1775,9 @@ objectmachine_t* objectdecorator_ellipticaltrajectory_new(objectmachine_t *decor
     obj->update = ellipticaltrajectory_update;
     obj->render = ellipticaltrajectory_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->amplitude_x = amplitude_x;
     me->amplitude_y = amplitude_y;
     me->angularspeed_x = angularspeed_x;
@@ -1813,10 +1820,8 @@ void ellipticaltrajectory_release(objectmachine_t *obj)
     free(obj);
 }
 
-void ellipticaltrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool ellipticaltrajectory_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_ellipticaltrajectory_t *me = (objectdecorator_ellipticaltrajectory_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     actor_t *act = object->actor;
@@ -1887,7 +1892,7 @@ void ellipticaltrajectory_update(objectmachine_t *obj, player_t **team, int team
     }
 
     /* decorator pattern */
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void ellipticaltrajectory_render(objectmachine_t *obj, v2d_t camera_position)
@@ -1910,7 +1915,7 @@ struct objectdecorator_enemy_t {
 /* private methods */
 static void enemydecorator_init(objectmachine_t *obj);
 static void enemydecorator_release(objectmachine_t *obj);
-static void enemydecorator_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool enemydecorator_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void enemydecorator_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -1929,7 +1934,9 @@ objectmachine_t* objectdecorator_enemy_new(objectmachine_t *decorated_machine, e
     obj->update = enemydecorator_update;
     obj->render = enemydecorator_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->score = score;
 
@@ -1962,11 +1969,9 @@ void enemydecorator_release(objectmachine_t *obj)
     free(obj);
 }
 
-void enemydecorator_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool enemydecorator_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
     objectdecorator_enemy_t *me = (objectdecorator_enemy_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
     int i, score;
 
@@ -1992,7 +1997,7 @@ void enemydecorator_update(objectmachine_t *obj, player_t **team, int team_size,
         }
     }
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void enemydecorator_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2063,7 +2068,7 @@ static void objectdecorator_executefor_destructor(objectdecorator_executebase_t
 /* private methods */
 static void executecommand_init(objectmachine_t *obj);
 static void executecommand_release(objectmachine_t *obj);
-static void executecommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool executecommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void executecommand_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -2081,7 +2086,9 @@ objectmachine_t* objectdecorator_execute_new(objectmachine_t *decorated_machine,
     obj->update = executecommand_update;
     obj->render = executecommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     _me->state_name = str_dup(state_name);
     _me->update = objectdecorator_execute_update;
@@ -2103,7 +2110,9 @@ objectmachine_t* objectdecorator_executeif_new(objectmachine_t *decorated_machin
     obj->update = executecommand_update;
     obj->render = executecommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     _me->state_name = str_dup(state_name);
     _me->update = objectdecorator_executeif_update;
@@ -2126,7 +2135,9 @@ objectmachine_t* objectdecorator_executeunless_new(objectmachine_t *decorated_ma
     obj->update = executecommand_update;
     obj->render = executecommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     _me->state_name = str_dup(state_name);
     _me->update = objectdecorator_executeunless_update;
@@ -2149,7 +2160,9 @@ objectmachine_t* objectdecorator_executewhile_new(objectmachine_t *decorated_mac
     obj->update = executecommand_update;
     obj->render = executecommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     _me->state_name = str_dup(state_name);
     _me->update = objectdecorator_executewhile_update;
@@ -2172,7 +2185,9 @@ objectmachine_t* objectdecorator_executefor_new(objectmachine_t *decorated_machi
     obj->update = executecommand_update;
     obj->render = executecommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     _me->state_name = str_dup(state_name);
     _me->update = objectdecorator_executefor_update;
@@ -2210,16 +2225,14 @@ void executecommand_release(objectmachine_t *obj)
     free(obj);
 }
 
-void executecommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool executecommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_executebase_t *me = (objectdecorator_executebase_t*)obj;
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
 
     me->update(me, object, team, team_size, brick_list, item_list, object_list);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void executecommand_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2237,8 +2250,7 @@ void executecommand_render(objectmachine_t *obj, v2d_t camera_position)
 /* private */
 void objectdecorator_execute_update(objectdecorator_executebase_t *ex, object_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectmachine_t *other_state = objectvm_get_state_by_name(obj->vm, ex->state_name);
-    other_state->update(other_state, team, team_size, brick_list, item_list, object_list);
+    objectvm_update_state(obj->vm, ex->state_name, team, team_size, brick_list, item_list, object_list);
 }
 
 void objectdecorator_execute_render(objectdecorator_executebase_t *ex, object_t *obj, v2d_t camera_position)
@@ -2255,10 +2267,9 @@ void objectdecorator_execute_destructor(objectdecorator_executebase_t *ex)
 void objectdecorator_executeif_update(objectdecorator_executebase_t *ex, object_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_executeif_t *me = (objectdecorator_executeif_t*)ex;
-    objectmachine_t *other_state = objectvm_get_state_by_name(obj->vm, ex->state_name);
 
     if(fabs(expression_evaluate(me->condition)) >= 1e-5)
-        other_state->update(other_state, team, team_size, brick_list, item_list, object_list);
+        objectvm_update_state(obj->vm, ex->state_name, team, team_size, brick_list, item_list, object_list);
 }
 
 void objectdecorator_executeif_render(objectdecorator_executebase_t *ex, object_t *obj, v2d_t camera_position)
@@ -2275,10 +2286,9 @@ void objectdecorator_executeif_destructor(objectdecorator_executebase_t *ex)
 void objectdecorator_executeunless_update(objectdecorator_executebase_t *ex, object_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_executeunless_t *me = (objectdecorator_executeunless_t*)ex;
-    objectmachine_t *other_state = objectvm_get_state_by_name(obj->vm, ex->state_name);
 
     if(!(fabs(expression_evaluate(me->condition)) >= 1e-5))
-        other_state->update(other_state, team, team_size, brick_list, item_list, object_list);
+        objectvm_update_state(obj->vm, ex->state_name, team, team_size, brick_list, item_list, object_list);
 }
 
 void objectdecorator_executeunless_render(objectdecorator_executebase_t *ex, object_t *obj, v2d_t camera_position)
@@ -2295,11 +2305,10 @@ void objectdecorator_executeunless_destructor(objectdecorator_executebase_t *ex)
 void objectdecorator_executewhile_update(objectdecorator_executebase_t *ex, object_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_executewhile_t *me = (objectdecorator_executewhile_t*)ex;
-    objectmachine_t *other_state = objectvm_get_state_by_name(obj->vm, ex->state_name);
     objectmachine_t *this_state = *(objectvm_get_reference_to_current_state(obj->vm));
 
     while(fabs(expression_evaluate(me->condition)) >= 1e-5) {
-        other_state->update(other_state, team, team_size, brick_list, item_list, object_list);
+        objectvm_update_state(obj->vm, ex->state_name, team, team_size, brick_list, item_list, object_list);
         if(this_state != *(objectvm_get_reference_to_current_state(obj->vm)))
             break;
     }
@@ -2319,12 +2328,11 @@ void objectdecorator_executewhile_destructor(objectdecorator_executebase_t *ex)
 void objectdecorator_executefor_update(objectdecorator_executebase_t *ex, object_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_executefor_t *me = (objectdecorator_executefor_t*)ex;
-    objectmachine_t *other_state = objectvm_get_state_by_name(obj->vm, ex->state_name);
     objectmachine_t *this_state = *(objectvm_get_reference_to_current_state(obj->vm));
 
     expression_evaluate(me->initial);
     while(fabs(expression_evaluate(me->condition)) >= 1e-5) {
-        other_state->update(other_state, team, team_size, brick_list, item_list, object_list);
+        objectvm_update_state(obj->vm, ex->state_name, team, team_size, brick_list, item_list, object_list);
         if(this_state != *(objectvm_get_reference_to_current_state(obj->vm)))
             break;
         expression_evaluate(me->iteration);
@@ -2353,7 +2361,7 @@ struct objectdecorator_gravity_t {
 /* private methods */
 static void gravity_init(objectmachine_t *obj);
 static void gravity_release(objectmachine_t *obj);
-static void gravity_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool gravity_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void gravity_render(objectmachine_t *obj, v2d_t camera_position);
 
 static int hit_test(const brick_t* brk, int x, int y);
@@ -2374,7 +2382,9 @@ objectmachine_t* objectdecorator_gravity_new(objectmachine_t *decorated_machine)
     obj->update = gravity_update;
     obj->render = gravity_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -2406,10 +2416,8 @@ void gravity_release(objectmachine_t *obj)
     free(obj);
 }
 
-void gravity_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool gravity_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
     actor_t *act = object->actor;
     float dt = timer_get_delta();
@@ -2500,7 +2508,7 @@ void gravity_update(objectmachine_t *obj, player_t **team, int team_size, brick_
 
     /* --------------------------- */
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void gravity_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2568,7 +2576,7 @@ static int acid_strategy(player_t *p);
 /* private methods */
 static void hitplayer_init(objectmachine_t *obj);
 static void hitplayer_release(objectmachine_t *obj);
-static void hitplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool hitplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void hitplayer_render(objectmachine_t *obj, v2d_t camera_position);
 static objectmachine_t *hitplayer_make_decorator(objectmachine_t *decorated_machine, int (*strategy)(player_t*));
 
@@ -2611,7 +2619,9 @@ objectmachine_t *hitplayer_make_decorator(objectmachine_t *decorated_machine, in
     obj->update = hitplayer_update;
     obj->render = hitplayer_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->should_hit_the_player = strategy;
 
     return obj;
@@ -2638,10 +2648,8 @@ void hitplayer_release(objectmachine_t *obj)
     free(obj);
 }
 
-void hitplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool hitplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_hitplayer_t *me = (objectdecorator_hitplayer_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
@@ -2649,7 +2657,7 @@ void hitplayer_update(objectmachine_t *obj, player_t **team, int team_size, bric
     if(!player_is_invincible(player) && me->should_hit_the_player(player))
         player_hit_ex(player, object->actor);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void hitplayer_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2693,7 +2701,7 @@ struct objectdecorator_jump_t {
 /* private methods */
 static void jump_init(objectmachine_t *obj);
 static void jump_release(objectmachine_t *obj);
-static void jump_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool jump_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void jump_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -2712,7 +2720,9 @@ objectmachine_t* objectdecorator_jump_new(objectmachine_t *decorated_machine, ex
     obj->update = jump_update;
     obj->render = jump_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->jump_strength = jump_strength;
 
     return obj;
@@ -2744,10 +2754,8 @@ void jump_release(objectmachine_t *obj)
     free(obj);
 }
 
-void jump_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool jump_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_jump_t *me = (objectdecorator_jump_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     actor_t *act = object->actor;
@@ -2765,7 +2773,7 @@ void jump_update(objectmachine_t *obj, player_t **team, int team_size, brick_lis
     /*act->jump_strength = jump_strength;
     input_simulate_button_down(act->input, IB_FIRE1);*/
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void jump_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2787,7 +2795,7 @@ struct objectdecorator_killplayer_t {
 /* private methods */
 static void killplayer_init(objectmachine_t *obj);
 static void killplayer_release(objectmachine_t *obj);
-static void killplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool killplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void killplayer_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -2808,7 +2816,9 @@ objectmachine_t* objectdecorator_killplayer_new(objectmachine_t *decorated_machi
     obj->update = killplayer_update;
     obj->render = killplayer_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -2839,15 +2849,13 @@ void killplayer_release(objectmachine_t *obj)
     free(obj);
 }
 
-void killplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool killplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
 
     player_kill(player);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void killplayer_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2870,7 +2878,7 @@ struct objectdecorator_launchurl_t {
 /* private methods */
 static void launchurl_init(objectmachine_t *obj);
 static void launchurl_release(objectmachine_t *obj);
-static void launchurl_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool launchurl_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void launchurl_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -2891,7 +2899,9 @@ objectmachine_t* objectdecorator_launchurl_new(objectmachine_t *decorated_machin
     obj->update = launchurl_update;
     obj->render = launchurl_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->url = str_dup(url);
 
@@ -2923,16 +2933,14 @@ void launchurl_release(objectmachine_t *obj)
     free(obj);
 }
 
-void launchurl_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool launchurl_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_launchurl_t *me = (objectdecorator_launchurl_t*)obj;
 
     if(!launch_url(me->url))
         video_showmessage("Can't open URL.");
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void launchurl_render(objectmachine_t *obj, v2d_t camera_position)
@@ -2955,7 +2963,7 @@ struct objectdecorator_loadlevel_t {
 /* private methods */
 static void loadlevel_init(objectmachine_t *obj);
 static void loadlevel_release(objectmachine_t *obj);
-static void loadlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool loadlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void loadlevel_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -2976,7 +2984,9 @@ objectmachine_t* objectdecorator_loadlevel_new(objectmachine_t *decorated_machin
     obj->update = loadlevel_update;
     obj->render = loadlevel_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->level_path = str_dup(level_path);
 
     return obj;
@@ -3009,15 +3019,13 @@ void loadlevel_release(objectmachine_t *obj)
     free(obj);
 }
 
-void loadlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool loadlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    /*objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;*/
     objectdecorator_loadlevel_t *me = (objectdecorator_loadlevel_t*)obj;
 
     level_change(me->level_path);
 
-    /*decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);*/
+    return false;
 }
 
 void loadlevel_render(objectmachine_t *obj, v2d_t camera_position)
@@ -3043,7 +3051,7 @@ struct objectdecorator_lockcamera_t {
 /* private methods */
 static void lockcamera_init(objectmachine_t *obj);
 static void lockcamera_release(objectmachine_t *obj);
-static void lockcamera_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool lockcamera_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void lockcamera_render(objectmachine_t *obj, v2d_t camera_position);
 
 static void get_rectangle_coordinates(objectdecorator_lockcamera_t *me, int *x1, int *y1, int *x2, int *y2);
@@ -3064,7 +3072,9 @@ objectmachine_t* objectdecorator_lockcamera_new(objectmachine_t *decorated_machi
     obj->update = lockcamera_update;
     obj->render = lockcamera_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->x1 = x1;
     me->y1 = y1;
@@ -3111,10 +3121,8 @@ void lockcamera_release(objectmachine_t *obj)
     free(obj);
 }
 
-void lockcamera_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool lockcamera_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(object);
     objectdecorator_lockcamera_t *me = (objectdecorator_lockcamera_t*)obj;
@@ -3186,7 +3194,7 @@ void lockcamera_update(objectmachine_t *obj, player_t **team, int team_size, bri
         ta->position.y = clip(ta->position.y, ry, ry + rh);
     }
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void lockcamera_render(objectmachine_t *obj, v2d_t camera_position)
@@ -3257,7 +3265,7 @@ struct objectdecorator_look_t {
 static objectmachine_t* objectdecorator_look_new(objectmachine_t *decorated_machine, void (*look_strategy)(objectdecorator_look_t*));
 static void look_init(objectmachine_t *obj);
 static void look_release(objectmachine_t *obj);
-static void look_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool look_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void look_render(objectmachine_t *obj, v2d_t camera_position);
 
 /* private strategies */
@@ -3308,7 +3316,9 @@ objectmachine_t* objectdecorator_look_new(objectmachine_t *decorated_machine, vo
     obj->update = look_update;
     obj->render = look_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->look_strategy = look_strategy;
 
     return obj;
@@ -3336,15 +3346,13 @@ void look_release(objectmachine_t *obj)
     free(obj);
 }
 
-void look_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool look_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_look_t *me = (objectdecorator_look_t*)obj;
 
     me->look_strategy(me);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void look_render(objectmachine_t *obj, v2d_t camera_position)
@@ -3411,7 +3419,7 @@ struct objectdecorator_mosquitomovement_t {
 /* private methods */
 static void mosquitomovement_init(objectmachine_t *obj);
 static void mosquitomovement_release(objectmachine_t *obj);
-static void mosquitomovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool mosquitomovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void mosquitomovement_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -3432,7 +3440,9 @@ objectmachine_t* objectdecorator_mosquitomovement_new(objectmachine_t *decorated
     obj->update = mosquitomovement_update;
     obj->render = mosquitomovement_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->speed = speed;
 
     return obj;
@@ -3465,10 +3475,8 @@ void mosquitomovement_release(objectmachine_t *obj)
     free(obj);
 }
 
-void mosquitomovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool mosquitomovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_mosquitomovement_t *me = (objectdecorator_mosquitomovement_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(object);
@@ -3482,7 +3490,7 @@ void mosquitomovement_update(objectmachine_t *obj, player_t **team, int team_siz
         object->actor->position = v2d_add(object->actor->position, ds);
     }
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void mosquitomovement_render(objectmachine_t *obj, v2d_t camera_position)
@@ -3505,7 +3513,7 @@ struct objectdecorator_moveplayer_t {
 /* private methods */
 static void moveplayer_init(objectmachine_t *obj);
 static void moveplayer_release(objectmachine_t *obj);
-static void moveplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool moveplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void moveplayer_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -3526,7 +3534,9 @@ objectmachine_t* objectdecorator_moveplayer_new(objectmachine_t *decorated_machi
     obj->update = moveplayer_update;
     obj->render = moveplayer_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->speed_x = speed_x;
     me->speed_y = speed_y;
 
@@ -3561,10 +3571,8 @@ void moveplayer_release(objectmachine_t *obj)
     free(obj);
 }
 
-void moveplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool moveplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_moveplayer_t *me = (objectdecorator_moveplayer_t*)obj;
     float dt = timer_get_delta();
     v2d_t speed = v2d_new(expression_evaluate(me->speed_x), expression_evaluate(me->speed_y));
@@ -3573,7 +3581,7 @@ void moveplayer_update(objectmachine_t *obj, player_t **team, int team_size, bri
 
     player->actor->position = v2d_add(player->actor->position, ds);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void moveplayer_render(objectmachine_t *obj, v2d_t camera_position)
@@ -3595,7 +3603,7 @@ struct objectdecorator_nextlevel_t {
 /* private methods */
 static void nextlevel_init(objectmachine_t *obj);
 static void nextlevel_release(objectmachine_t *obj);
-static void nextlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool nextlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void nextlevel_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -3614,7 +3622,9 @@ objectmachine_t* objectdecorator_nextlevel_new(objectmachine_t *decorated_machin
     obj->update = nextlevel_update;
     obj->render = nextlevel_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -3644,14 +3654,11 @@ void nextlevel_release(objectmachine_t *obj)
     free(obj);
 }
 
-void nextlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool nextlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
-
     level_jump_to_next_stage();
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void nextlevel_render(objectmachine_t *obj, v2d_t camera_position)
@@ -3683,7 +3690,7 @@ struct observeplayerstrategy_t {
 /* private methods */
 static void observeplayer_init(objectmachine_t *obj);
 static void observeplayer_release(objectmachine_t *obj);
-static void observeplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool observeplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void observeplayer_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* observeplayer_make_decorator(objectmachine_t *decorated_machine, observeplayerstrategy_t *strategy);
@@ -3736,7 +3743,9 @@ objectmachine_t* observeplayer_make_decorator(objectmachine_t *decorated_machine
     obj->update = observeplayer_update;
     obj->render = observeplayer_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->strategy = strategy;
 
     return obj;
@@ -3776,15 +3785,13 @@ void observeplayer_release(objectmachine_t *obj)
     free(obj);
 }
 
-void observeplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool observeplayer_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_observeplayer_t *me = (objectdecorator_observeplayer_t*)obj;
 
     me->strategy->run(me->strategy, team, team_size);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void observeplayer_render(objectmachine_t *obj, v2d_t camera_position)
@@ -4111,7 +4118,7 @@ static int onmusicplay_should_trigger_event(eventstrategy_t *event, object_t *ob
 static objectmachine_t *onevent_make_decorator(objectmachine_t *decorated_machine, const char *new_state_name, eventstrategy_t *strategy);
 static void onevent_init(objectmachine_t *obj);
 static void onevent_release(objectmachine_t *obj);
-static void onevent_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool onevent_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void onevent_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -4395,7 +4402,9 @@ objectmachine_t *onevent_make_decorator(objectmachine_t *decorated_machine, cons
     obj->update = onevent_update;
     obj->render = onevent_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->new_state_name = str_dup(new_state_name);
     me->strategy = strategy;
 
@@ -4427,17 +4436,17 @@ void onevent_release(objectmachine_t *obj)
     free(obj);
 }
 
-void onevent_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool onevent_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_onevent_t *me = (objectdecorator_onevent_t*)obj;
     object_t *object = obj->get_object_instance(obj);
 
-    if(me->strategy->should_trigger_event(me->strategy, object, team, team_size, brick_list, item_list, object_list))
+    if(me->strategy->should_trigger_event(me->strategy, object, team, team_size, brick_list, item_list, object_list)) {
         objectvm_set_current_state(object->vm, me->new_state_name);
-    else
-        decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+        return false; /* suspend the execution */
+    }
+
+    return true;
 }
 
 void onevent_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5227,7 +5236,7 @@ struct objectdecorator_pause_t {
 /* private methods */
 static void pause_init(objectmachine_t *obj);
 static void pause_release(objectmachine_t *obj);
-static void pause_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool pause_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void pause_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -5246,7 +5255,9 @@ objectmachine_t* objectdecorator_pause_new(objectmachine_t *decorated_machine)
     obj->update = pause_update;
     obj->render = pause_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -5276,14 +5287,11 @@ void pause_release(objectmachine_t *obj)
     free(obj);
 }
 
-void pause_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool pause_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
-
     level_pause();
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void pause_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5306,7 +5314,7 @@ struct objectdecorator_playeraction_t {
 /* private methods */
 static void playeraction_init(objectmachine_t *obj);
 static void playeraction_release(objectmachine_t *obj);
-static void playeraction_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool playeraction_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void playeraction_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t *playeraction_make_decorator(objectmachine_t *decorated_machine, void (*update_strategy)(player_t*));
@@ -5401,7 +5409,9 @@ objectmachine_t* playeraction_make_decorator(objectmachine_t *decorated_machine,
     obj->update = playeraction_update;
     obj->render = playeraction_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->update = update_strategy;
 
     return obj;
@@ -5429,16 +5439,14 @@ void playeraction_release(objectmachine_t *obj)
     free(obj);
 }
 
-void playeraction_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool playeraction_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_playeraction_t *me = (objectdecorator_playeraction_t*)obj;
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
 
     me->update(player);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void playeraction_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5518,7 +5526,7 @@ struct objectdecorator_playermovement_t {
 /* private methods */
 static void playermovement_init(objectmachine_t *obj);
 static void playermovement_release(objectmachine_t *obj);
-static void playermovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool playermovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void playermovement_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t *playermovement_make_decorator(objectmachine_t *decorated_machine, int enable);
@@ -5556,7 +5564,9 @@ objectmachine_t* playermovement_make_decorator(objectmachine_t *decorated_machin
     obj->update = playermovement_update;
     obj->render = playermovement_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->enable = enable;
 
     return obj;
@@ -5584,16 +5594,14 @@ void playermovement_release(objectmachine_t *obj)
     free(obj);
 }
 
-void playermovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool playermovement_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_playermovement_t *me = (objectdecorator_playermovement_t*)obj;
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
 
     player_set_frozen(player, !me->enable);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void playermovement_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5627,7 +5635,7 @@ struct objectdecorator_popquest_t {
 /* private methods */
 static void questcommand_init(objectmachine_t *obj);
 static void questcommand_release(objectmachine_t *obj);
-static void questcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool questcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void questcommand_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -5668,7 +5676,9 @@ objectmachine_t* setup_decorator(objectdecorator_quest_t *me, objectmachine_t *d
     obj->update = questcommand_update;
     obj->render = questcommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->update = update_fun;
 
@@ -5696,15 +5706,13 @@ void questcommand_release(objectmachine_t *obj)
     free(obj);
 }
 
-void questcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool questcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     objectdecorator_quest_t *me = (objectdecorator_quest_t*)obj;
-    /*objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;*/
 
     me->update(me);
 
-    /*decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);*/
+    return false;
 }
 
 void questcommand_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5741,7 +5749,7 @@ struct objectdecorator_resetglobals_t {
 /* private methods */
 static void resetglobals_init(objectmachine_t *obj);
 static void resetglobals_release(objectmachine_t *obj);
-static void resetglobals_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool resetglobals_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void resetglobals_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -5760,7 +5768,9 @@ objectmachine_t* objectdecorator_resetglobals_new(objectmachine_t *decorated_mac
     obj->update = resetglobals_update;
     obj->render = resetglobals_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -5790,18 +5800,15 @@ void resetglobals_release(objectmachine_t *obj)
     free(obj);
 }
 
-void resetglobals_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool resetglobals_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
-
     /* reset globals */
     symboltable_clear(symboltable_get_global_table());
 
     /* reset arrays */
     nanocalc_addons_resetarrays();
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void resetglobals_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5823,7 +5830,7 @@ struct objectdecorator_restartlevel_t {
 /* private methods */
 static void restartlevel_init(objectmachine_t *obj);
 static void restartlevel_release(objectmachine_t *obj);
-static void restartlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool restartlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void restartlevel_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -5844,7 +5851,9 @@ objectmachine_t* objectdecorator_restartlevel_new(objectmachine_t *decorated_mac
     obj->update = restartlevel_update;
     obj->render = restartlevel_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -5875,14 +5884,11 @@ void restartlevel_release(objectmachine_t *obj)
     free(obj);
 }
 
-void restartlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool restartlevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    /*objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;*/
-
     level_restart();
 
-    /*decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);*/
+    return false;
 }
 
 void restartlevel_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5904,7 +5910,7 @@ struct objectdecorator_returntopreviousstate_t {
 /* private methods */
 static void returntopreviousstate_init(objectmachine_t *obj);
 static void returntopreviousstate_release(objectmachine_t *obj);
-static void returntopreviousstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool returntopreviousstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void returntopreviousstate_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -5923,7 +5929,9 @@ objectmachine_t* objectdecorator_returntopreviousstate_new(objectmachine_t *deco
     obj->update = returntopreviousstate_update;
     obj->render = returntopreviousstate_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -5953,15 +5961,12 @@ void returntopreviousstate_release(objectmachine_t *obj)
     free(obj);
 }
 
-void returntopreviousstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool returntopreviousstate_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    /*objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;*/
-
     object_t *object = obj->get_object_instance(obj);
     objectvm_return_to_previous_state(object->vm);
 
-    /*decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);*/
+    return false;
 }
 
 void returntopreviousstate_render(objectmachine_t *obj, v2d_t camera_position)
@@ -5983,7 +5988,7 @@ struct objectdecorator_savelevel_t {
 /* private methods */
 static void savelevel_init(objectmachine_t *obj);
 static void savelevel_release(objectmachine_t *obj);
-static void savelevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool savelevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void savelevel_render(objectmachine_t *obj, v2d_t camera_position);
 static void fix_objects(object_t *obj, void *any_data); /* will fix obj and its children (ie, set ptr->created_from_editor to TRUE) */
 static void unfix_objects(object_t *obj, void *any_data); /* will undo whatever fix_objects() did */
@@ -6006,7 +6011,9 @@ objectmachine_t* objectdecorator_savelevel_new(objectmachine_t *decorated_machin
     obj->update = savelevel_update;
     obj->render = savelevel_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     return obj;
 }
@@ -6037,17 +6044,15 @@ void savelevel_release(objectmachine_t *obj)
     free(obj);
 }
 
-void savelevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool savelevel_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     object_t *o = obj->get_object_instance(obj);
 
     fix_objects(o, NULL);
     level_persist();
     unfix_objects(o, NULL);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void savelevel_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6084,7 +6089,7 @@ struct objectdecorator_setabsoluteposition_t {
 /* private methods */
 static void setabsoluteposition_init(objectmachine_t *obj);
 static void setabsoluteposition_release(objectmachine_t *obj);
-static void setabsoluteposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setabsoluteposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setabsoluteposition_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6105,7 +6110,9 @@ objectmachine_t* objectdecorator_setabsoluteposition_new(objectmachine_t *decora
     obj->update = setabsoluteposition_update;
     obj->render = setabsoluteposition_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->pos_x = xpos;
     me->pos_y = ypos;
 
@@ -6140,17 +6147,15 @@ void setabsoluteposition_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setabsoluteposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setabsoluteposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setabsoluteposition_t *me = (objectdecorator_setabsoluteposition_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     v2d_t pos = v2d_new(expression_evaluate(me->pos_x), expression_evaluate(me->pos_y));
 
     object->actor->position = pos;
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setabsoluteposition_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6173,7 +6178,7 @@ struct objectdecorator_setalpha_t {
 /* private methods */
 static void setalpha_init(objectmachine_t *obj);
 static void setalpha_release(objectmachine_t *obj);
-static void setalpha_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setalpha_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setalpha_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6194,7 +6199,9 @@ objectmachine_t* objectdecorator_setalpha_new(objectmachine_t *decorated_machine
     obj->update = setalpha_update;
     obj->render = setalpha_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->alpha = alpha;
 
     return obj;
@@ -6227,17 +6234,15 @@ void setalpha_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setalpha_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setalpha_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setalpha_t *me = (objectdecorator_setalpha_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     float alpha = clip(expression_evaluate(me->alpha), 0.0f, 1.0f);
 
     object->actor->alpha = alpha;
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setalpha_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6260,7 +6265,7 @@ struct objectdecorator_setangle_t {
 /* private methods */
 static void setangle_init(objectmachine_t *obj);
 static void setangle_release(objectmachine_t *obj);
-static void setangle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setangle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setangle_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6281,7 +6286,9 @@ objectmachine_t* objectdecorator_setangle_new(objectmachine_t *decorated_machine
     obj->update = setangle_update;
     obj->render = setangle_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->angle = angle;
 
     return obj;
@@ -6314,17 +6321,15 @@ void setangle_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setangle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setangle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setangle_t *me = (objectdecorator_setangle_t*)obj;
     object_t *object = obj->get_object_instance(obj);
 
     float angle = expression_evaluate(me->angle);
     object->actor->angle = angle * PI / 180.0f;
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setangle_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6394,7 +6399,7 @@ struct objectdecorator_setanimation_t {
 /* private methods */
 static void setanimation_init(objectmachine_t *obj);
 static void setanimation_release(objectmachine_t *obj);
-static void setanimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setanimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setanimation_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* setanimation_make_decorator(objectdecorator_setanimationstrategy_t *strategy, objectmachine_t *decorated_machine);
@@ -6449,15 +6454,13 @@ void setanimation_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setanimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setanimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setanimation_t *me = (objectdecorator_setanimation_t*)obj;
 
     me->strategy->update(obj);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setanimation_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6617,7 +6620,9 @@ objectmachine_t* setanimation_make_decorator(objectdecorator_setanimationstrateg
     obj->update = setanimation_update;
     obj->render = setanimation_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->strategy = strategy;
 
@@ -6635,7 +6640,7 @@ struct objectdecorator_setobstacle_t {
 /* private methods */
 static void setobstacle_init(objectmachine_t *obj);
 static void setobstacle_release(objectmachine_t *obj);
-static void setobstacle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setobstacle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setobstacle_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6656,7 +6661,9 @@ objectmachine_t* objectdecorator_setobstacle_new(objectmachine_t *decorated_mach
     obj->update = setobstacle_update;
     obj->render = setobstacle_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->is_obstacle = is_obstacle;
     me->angle = angle;
 
@@ -6690,10 +6697,8 @@ void setobstacle_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setobstacle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setobstacle_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setobstacle_t *me = (objectdecorator_setobstacle_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     /*float angle = expression_evaluate(me->angle);*/ /* deprecated */
@@ -6713,7 +6718,7 @@ void setobstacle_update(objectmachine_t *obj, player_t **team, int team_size, br
     object->obstacle = me->is_obstacle;
 
     /* done */
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setobstacle_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6737,7 +6742,7 @@ struct objectdecorator_setplayeranimation_t {
 /* private methods */
 static void setplayeranimation_init(objectmachine_t *obj);
 static void setplayeranimation_release(objectmachine_t *obj);
-static void setplayeranimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setplayeranimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setplayeranimation_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6758,7 +6763,9 @@ objectmachine_t* objectdecorator_setplayeranimation_new(objectmachine_t *decorat
     obj->update = setplayeranimation_update;
     obj->render = setplayeranimation_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->sprite_name = str_dup(sprite_name);
     me->animation_id = animation_id;
 
@@ -6793,17 +6800,15 @@ void setplayeranimation_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setplayeranimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setplayeranimation_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setplayeranimation_t *me = (objectdecorator_setplayeranimation_t*)obj;
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
     int animation_id = (int)expression_evaluate(me->animation_id);
 
     player_override_animation(player, sprite_get_animation(me->sprite_name, animation_id));
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setplayeranimation_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6826,7 +6831,7 @@ struct objectdecorator_setplayerinputmap_t {
 /* private methods */
 static void setplayerinputmap_init(objectmachine_t *obj);
 static void setplayerinputmap_release(objectmachine_t *obj);
-static void setplayerinputmap_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setplayerinputmap_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setplayerinputmap_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6845,7 +6850,9 @@ objectmachine_t* objectdecorator_setplayerinputmap_new(objectmachine_t *decorate
     obj->update = setplayerinputmap_update;
     obj->render = setplayerinputmap_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->inputmap_name = str_dup(inputmap_name);
 
     return obj;
@@ -6877,10 +6884,8 @@ void setplayerinputmap_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setplayerinputmap_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setplayerinputmap_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setplayerinputmap_t *me = (objectdecorator_setplayerinputmap_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(object);
@@ -6889,7 +6894,7 @@ void setplayerinputmap_update(objectmachine_t *obj, player_t **team, int team_si
     /* I'm sure 'in' is an inputuserdefined_t* */
     input_change_mapping((inputuserdefined_t*)in, me->inputmap_name);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setplayerinputmap_render(objectmachine_t *obj, v2d_t camera_position)
@@ -6912,7 +6917,7 @@ struct objectdecorator_setplayerposition_t {
 /* private methods */
 static void setplayerposition_init(objectmachine_t *obj);
 static void setplayerposition_release(objectmachine_t *obj);
-static void setplayerposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setplayerposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setplayerposition_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -6933,7 +6938,9 @@ objectmachine_t* objectdecorator_setplayerposition_new(objectmachine_t *decorate
     obj->update = setplayerposition_update;
     obj->render = setplayerposition_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->offset_x = xpos;
     me->offset_y = ypos;
 
@@ -6968,10 +6975,8 @@ void setplayerposition_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setplayerposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setplayerposition_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setplayerposition_t *me = (objectdecorator_setplayerposition_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(object);
@@ -6979,7 +6984,7 @@ void setplayerposition_update(objectmachine_t *obj, player_t **team, int team_si
 
     player->actor->position = v2d_add(object->actor->position, offset);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setplayerposition_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7003,7 +7008,7 @@ struct objectdecorator_setplayerspeed_t {
 /* private methods */
 static void setplayerspeed_init(objectmachine_t *obj);
 static void setplayerspeed_release(objectmachine_t *obj);
-static void setplayerspeed_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setplayerspeed_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setplayerspeed_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* setplayerspeed_make_decorator(objectmachine_t *decorated_machine, expression_t *speed, void (*strategy)(player_t*,expression_t*));
@@ -7042,7 +7047,9 @@ objectmachine_t* setplayerspeed_make_decorator(objectmachine_t *decorated_machin
     obj->update = setplayerspeed_update;
     obj->render = setplayerspeed_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->speed = speed;
     me->strategy = strategy;
 
@@ -7072,16 +7079,14 @@ void setplayerspeed_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setplayerspeed_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setplayerspeed_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setplayerspeed_t *me = (objectdecorator_setplayerspeed_t*)obj;
     player_t *player = enemy_get_observed_player(obj->get_object_instance(obj));
 
     me->strategy(player, me->speed);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setplayerspeed_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7115,7 +7120,7 @@ struct objectdecorator_setscale_t {
 /* private methods */
 static void setscale_init(objectmachine_t *obj);
 static void setscale_release(objectmachine_t *obj);
-static void setscale_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setscale_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setscale_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -7136,7 +7141,9 @@ objectmachine_t* objectdecorator_setscale_new(objectmachine_t *decorated_machine
     obj->update = setscale_update;
     obj->render = setscale_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->scale_x = scale_x;
     me->scale_y = scale_y;
 
@@ -7171,10 +7178,8 @@ void setscale_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setscale_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setscale_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setscale_t *me = (objectdecorator_setscale_t*)obj;
     object_t *object = obj->get_object_instance(obj);
 
@@ -7182,7 +7187,7 @@ void setscale_update(objectmachine_t *obj, player_t **team, int team_size, brick
     float scale_y = max(0.0f, expression_evaluate(me->scale_y));
     object->actor->scale = v2d_new(scale_x, scale_y);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setscale_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7205,7 +7210,7 @@ struct objectdecorator_setzindex_t {
 /* private methods */
 static void setzindex_init(objectmachine_t *obj);
 static void setzindex_release(objectmachine_t *obj);
-static void setzindex_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool setzindex_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void setzindex_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -7224,7 +7229,9 @@ objectmachine_t* objectdecorator_setzindex_new(objectmachine_t *decorated_machin
     obj->update = setzindex_update;
     obj->render = setzindex_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->zindex = zindex;
 
     return obj;
@@ -7256,10 +7263,8 @@ void setzindex_release(objectmachine_t *obj)
     free(obj);
 }
 
-void setzindex_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool setzindex_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_setzindex_t *me = (objectdecorator_setzindex_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     float zindex = expression_evaluate(me->zindex); /* no clip() */
@@ -7268,7 +7273,7 @@ void setzindex_update(objectmachine_t *obj, player_t **team, int team_size, bric
     object->zindex = zindex;
 
     /* decorator pattern */
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void setzindex_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7291,7 +7296,7 @@ struct objectdecorator_showhide_t {
 /* private methods */
 static void showhide_init(objectmachine_t *obj);
 static void showhide_release(objectmachine_t *obj);
-static void showhide_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool showhide_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void showhide_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* showhide_make_decorator(objectmachine_t *decorated_machine, int show);
@@ -7323,7 +7328,9 @@ static objectmachine_t* showhide_make_decorator(objectmachine_t *decorated_machi
     obj->update = showhide_update;
     obj->render = showhide_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->show = show;
 
@@ -7355,16 +7362,15 @@ void showhide_release(objectmachine_t *obj)
     free(obj);
 }
 
-void showhide_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool showhide_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
     object_t *object = obj->get_object_instance(obj);
     objectdecorator_t *dec = (objectdecorator_t*)obj;
     objectdecorator_showhide_t *me = (objectdecorator_showhide_t*)dec;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
 
     object->actor->visible = me->show;
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void showhide_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7388,7 +7394,7 @@ struct objectdecorator_simulatebutton_t {
 /* private methods */
 static void simulatebutton_init(objectmachine_t *obj);
 static void simulatebutton_release(objectmachine_t *obj);
-static void simulatebutton_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool simulatebutton_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void simulatebutton_render(objectmachine_t *obj, v2d_t camera_position);
 
 static objectmachine_t* simulatebutton_make_decorator(objectmachine_t *decorated_machine, const char *button_name, void (*callback)(input_t*,inputbutton_t));
@@ -7419,7 +7425,9 @@ objectmachine_t* simulatebutton_make_decorator(objectmachine_t *decorated_machin
     obj->update = simulatebutton_update;
     obj->render = simulatebutton_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->callback = callback;
     me->button = IB_UP;
 
@@ -7478,10 +7486,8 @@ void simulatebutton_release(objectmachine_t *obj)
     free(obj);
 }
 
-void simulatebutton_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool simulatebutton_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_simulatebutton_t *me = (objectdecorator_simulatebutton_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = enemy_get_observed_player(object);
@@ -7489,7 +7495,7 @@ void simulatebutton_update(objectmachine_t *obj, player_t **team, int team_size,
     input_restore(player->actor->input); /* so that non-active players will respond to this command */
     me->callback(player->actor->input, me->button);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void simulatebutton_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7513,7 +7519,7 @@ struct objectdecorator_switchcharacter_t {
 /* private methods */
 static void switchcharacter_init(objectmachine_t *obj);
 static void switchcharacter_release(objectmachine_t *obj);
-static void switchcharacter_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool switchcharacter_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void switchcharacter_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -7532,7 +7538,9 @@ objectmachine_t* objectdecorator_switchcharacter_new(objectmachine_t *decorated_
     obj->update = switchcharacter_update;
     obj->render = switchcharacter_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->name = (name != NULL && *name != 0) ? str_dup(name) : NULL;
     me->force_switch = force_switch;
@@ -7567,10 +7575,8 @@ void switchcharacter_release(objectmachine_t *obj)
     free(obj);
 }
 
-void switchcharacter_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool switchcharacter_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_switchcharacter_t *me = (objectdecorator_switchcharacter_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     player_t *player = level_player(); /* active player */
@@ -7603,7 +7609,7 @@ void switchcharacter_update(objectmachine_t *obj, player_t **team, int team_size
     else
         fatal_error("Can't switch character: player '%s' does not exist!", me->name);
 
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void switchcharacter_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7634,7 +7640,7 @@ struct objectdecorator_textout_t {
 /* private methods */
 static void textout_init(objectmachine_t *obj);
 static void textout_release(objectmachine_t *obj);
-static void textout_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool textout_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void textout_render(objectmachine_t *obj, v2d_t camera_position);
 
 objectmachine_t* textout_make_decorator(objectmachine_t *decorated_machine, textoutstyle_t style, const char *font_name, expression_t *xpos, expression_t *ypos, const char *text, expression_t *max_width, expression_t *index_of_first_char, expression_t *length);
@@ -7691,10 +7697,8 @@ void textout_release(objectmachine_t *obj)
     free(obj);
 }
 
-void textout_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool textout_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_textout_t *me = (objectdecorator_textout_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     symboltable_t *st = objectvm_get_symbol_table(object->vm);
@@ -7733,7 +7737,7 @@ void textout_update(objectmachine_t *obj, player_t **team, int team_size, brick_
     font_set_position(me->fnt, v2d_add(object->actor->position, pos));
 
     /* done! */
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void textout_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7761,7 +7765,9 @@ objectmachine_t* textout_make_decorator(objectmachine_t *decorated_machine, text
     obj->update = textout_update;
     obj->render = textout_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->style = style;
     me->fnt = font_create(font_name);
@@ -7803,7 +7809,7 @@ struct objectdecorator_variables_t {
 /* private methods */
 static void varcommand_init(objectmachine_t *obj);
 static void varcommand_release(objectmachine_t *obj);
-static void varcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool varcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void varcommand_render(objectmachine_t *obj, v2d_t camera_position);
 
 /* private strategies */
@@ -7828,7 +7834,9 @@ objectmachine_t* objectdecorator_let_new(objectmachine_t *decorated_machine, exp
     obj->update = varcommand_update;
     obj->render = varcommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->expr = expr;
     me->new_state_name = NULL;
@@ -7848,7 +7856,9 @@ objectmachine_t* objectdecorator_if_new(objectmachine_t *decorated_machine, expr
     obj->update = varcommand_update;
     obj->render = varcommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->expr = expr;
     me->new_state_name = str_dup(new_state_name);
@@ -7868,7 +7878,9 @@ objectmachine_t* objectdecorator_unless_new(objectmachine_t *decorated_machine,
     obj->update = varcommand_update;
     obj->render = varcommand_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
 
     me->expr = expr;
     me->new_state_name = str_dup(new_state_name);
@@ -7904,18 +7916,18 @@ void varcommand_release(objectmachine_t *obj)
     free(obj);
 }
 
-void varcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool varcommand_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_variables_t *me = (objectdecorator_variables_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     float result = expression_evaluate(me->expr);
 
-    if(me->must_change_state(result))
+    if(me->must_change_state(result)) {
         objectvm_set_current_state(object->vm, me->new_state_name);
-    else
-        decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+        return false; /* suspend the execution */
+    }
+
+    return true;
 }
 
 void varcommand_render(objectmachine_t *obj, v2d_t camera_position)
@@ -7939,7 +7951,7 @@ struct objectdecorator_walk_t {
 /* private methods */
 static void walk_init(objectmachine_t *obj);
 static void walk_release(objectmachine_t *obj);
-static void walk_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool walk_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void walk_render(objectmachine_t *obj, v2d_t camera_position);
 
 
@@ -7958,7 +7970,9 @@ objectmachine_t* objectdecorator_walk_new(objectmachine_t *decorated_machine, ex
     obj->update = walk_update;
     obj->render = walk_render;
     obj->get_object_instance = objectdecorator_get_object_instance; /* inherits from superclass */
+    obj->get_decorated_machine = objectdecorator_get_decorated_machine; /* inherits from superclass */
     dec->decorated_machine = decorated_machine;
+    dec->object = decorated_machine->get_object_instance(decorated_machine);
     me->speed = speed;
 
     return obj;
@@ -7991,10 +8005,8 @@ void walk_release(objectmachine_t *obj)
     free(obj);
 }
 
-void walk_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool walk_update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    objectdecorator_t *dec = (objectdecorator_t*)obj;
-    objectmachine_t *decorated_machine = dec->decorated_machine;
     objectdecorator_walk_t *me = (objectdecorator_walk_t*)obj;
     object_t *object = obj->get_object_instance(obj);
     actor_t *act = object->actor;
@@ -8033,7 +8045,7 @@ void walk_update(objectmachine_t *obj, player_t **team, int team_size, brick_lis
     }
 
     /* decorator pattern */
-    decorated_machine->update(decorated_machine, team, team_size, brick_list, item_list, object_list);
+    return true;
 }
 
 void walk_render(objectmachine_t *obj, v2d_t camera_position)
@@ -29,12 +29,25 @@ struct objectbasicmachine_t {
     object_t *object; /* I'm attached to this object */
 };
 
+/* object program class */
+typedef struct objectcommand_t objectcommand_t;
+struct objectcommand_t {
+    objectmachine_t *machine; /* the command */
+    bool (*update)(objectmachine_t*, player_t**, int, brick_list_t*, item_list_t*, object_list_t*); /* machine->update */
+};
+
+struct objectprogram_t {
+    int length; /* number of commands */
+    objectcommand_t command[]; /* contiguous array of commands */
+};
+
 /* private methods */
 static void init(objectmachine_t *obj);
 static void release(objectmachine_t *obj);
-static void update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
+static bool update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 static void render(objectmachine_t *obj, v2d_t camera_position);
 static object_t* get_object_instance(objectmachine_t *obj);
+static objectmachine_t* get_decorated_machine(objectmachine_t *obj);
 
 
 
@@ -52,11 +65,50 @@ objectmachine_t* objectbasicmachine_new(object_t *object)
     obj->update = update;
     obj->render = render;
     obj->get_object_instance = get_object_instance;
+    obj->get_decorated_machine = get_decorated_machine;
     me->object = object;
 
     return obj;
 }
 
+/* compiles a machine: each command of the decorator chain
+   becomes an entry of a flat array */
+objectprogram_t* objectprogram_create(objectmachine_t *machine)
+{
+    objectprogram_t *program;
+    objectmachine_t *m;
+    int length = 0;
+
+    for(m = machine; m != NULL; m = m->get_decorated_machine(m))
+        length++;
+
+    program = mallocx(sizeof *program + length * sizeof(objectcommand_t));
+    program->length = length;
+    for(m = machine, length = 0; m != NULL; m = m->get_decorated_machine(m), length++) {
+        program->command[length].machine = m;
+        program->command[length].update = m->update;
+    }
+
+    return program;
+}
+
+/* destroys a program */
+objectprogram_t* objectprogram_destroy(objectprogram_t *program)
+{
+    free(program);
+    return NULL;
+}
+
+/* runs a program */
+void objectprogram_update(const objectprogram_t *program, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+{
+    const objectcommand_t *cmd = program->command;
+    const objectcommand_t *end = cmd + program->length;
+
+    while(cmd != end && cmd->update(cmd->machine, team, team_size, brick_list, item_list, object_list))
+        cmd++;
+}
+
 
 /* private methods */
 void init(objectmachine_t *obj)
@@ -69,9 +121,9 @@ void release(objectmachine_t *obj)
     free(obj);
 }
 
-void update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+bool update(objectmachine_t *obj, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
 {
-    ; /* empty */
+    return false; /* end of the state */
 }
 
 void render(objectmachine_t *obj, v2d_t camera_position)
@@ -91,3 +143,7 @@ object_t* get_object_instance(objectmachine_t *obj)
     return me->object;
 }
 
+objectmachine_t* get_decorated_machine(objectmachine_t *obj)
+{
+    return NULL;
+}
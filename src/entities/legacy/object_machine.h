@@ -21,6 +21,7 @@
 #ifndef _OBJECT_MACHINE_H
 #define _OBJECT_MACHINE_H
 
+#include <stdbool.h>
 #include "../../core/v2d.h"
 #include "../player.h"
 #include "../brick.h"
@@ -33,12 +34,20 @@ typedef struct objectmachine_t objectmachine_t;
 struct objectmachine_t {
     void (*init)(objectmachine_t*); /* initializes the object */
     void (*release)(objectmachine_t*); /* releases the object */
-    void (*update)(objectmachine_t*, player_t**, int, brick_list_t*, item_list_t*, object_list_t*); /* updates the object (runs every frame) */
+    bool (*update)(objectmachine_t*, player_t**, int, brick_list_t*, item_list_t*, object_list_t*); /* updates the object (runs every frame); returns false to suspend the execution of the state */
     void (*render)(objectmachine_t*, v2d_t); /* renders the object */
     object_t* (*get_object_instance)(objectmachine_t*);
+    objectmachine_t* (*get_decorated_machine)(objectmachine_t*); /* the machine that runs after this one, or NULL */
 };
 
 objectmachine_t* objectbasicmachine_new(object_t *object); /* constructs a basic, empty machine */
 
+/* object program: a state compiled to a flat array of commands,
+   so that a single loop updates it (instead of a chain of calls) */
+typedef struct objectprogram_t objectprogram_t;
+objectprogram_t* objectprogram_create(objectmachine_t *machine); /* compiles a (decorated) machine */
+objectprogram_t* objectprogram_destroy(objectprogram_t *program); /* destroys a program (the machine is kept) */
+void objectprogram_update(const objectprogram_t *program, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list); /* runs the commands in order, until one of them suspends the execution */
+
 #endif
 
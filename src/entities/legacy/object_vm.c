@@ -32,6 +32,7 @@ struct objectvm_t
     enemy_t* owner; /* who owns this VM? */
     objectmachine_list_t* state_list; /* list of states */
     objectmachine_t** reference_to_current_state; /* reference to the current state */
+    objectmachine_list_t* current_state; /* node of the current state */
     symboltable_t* symbol_table; /* object's private symbol table (stores its variables) */
     objectmachine_stack_t* history; /* stores previous states */
 };
@@ -40,6 +41,7 @@ struct objectvm_t
 struct objectmachine_list_t {
     char *name;
     objectmachine_t *data;
+    objectprogram_t *program; /* data, compiled (on its first run) */
     objectmachine_list_t *next;
 };
 
@@ -47,6 +49,7 @@ static objectmachine_list_t* objectmachine_list_new(objectmachine_list_t* list,
 static objectmachine_list_t* objectmachine_list_delete(objectmachine_list_t* list);
 static objectmachine_list_t* objectmachine_list_find(objectmachine_list_t* list, const char *name);
 static objectmachine_list_t* objectmachine_list_findmachine(objectmachine_list_t* list, objectmachine_t* machine);
+static void objectmachine_list_update(objectmachine_list_t* node, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list);
 
 /* stack of object machines */
 #define OBJECTMACHINE_STACK_CAPACITY 5 /* return_to_previous_state history */
@@ -71,6 +74,7 @@ objectvm_t* objectvm_create(enemy_t* owner)
     vm->owner = owner;
     vm->state_list = NULL;
     vm->reference_to_current_state = NULL;
+    vm->current_state = NULL;
     vm->history = objectmachine_stack_new();
     vm->symbol_table = symboltable_new();
     return vm;
@@ -82,6 +86,7 @@ objectvm_t* objectvm_destroy(objectvm_t* vm)
     vm->history = objectmachine_stack_delete(vm->history);
     vm->state_list = objectmachine_list_delete(vm->state_list);
     vm->reference_to_current_state = NULL;
+    vm->current_state = NULL;
     vm->owner = NULL;
     free(vm);
     return NULL;
@@ -125,6 +130,7 @@ void objectvm_set_current_state(objectvm_t* vm, const char *name)
     if(m != NULL) {
         if(vm->reference_to_current_state != &(m->data)) {
             vm->reference_to_current_state = &(m->data);
+            vm->current_state = m;
             objectmachine_stack_push(vm->history, m);
         }
     }
@@ -141,6 +147,7 @@ void objectvm_return_to_previous_state(objectvm_t *vm)
 
     if(m != NULL) {
         vm->reference_to_current_state = &(m->data);
+        vm->current_state = m;
         objectmachine_stack_push(vm->history, m);
     }
     else
@@ -164,6 +171,22 @@ objectmachine_t* objectvm_get_state_by_name(objectvm_t* vm, const char *name)
         return m->data;
 }
 
+void objectvm_update_current_state(objectvm_t* vm, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+{
+    if(vm->current_state != NULL)
+        objectmachine_list_update(vm->current_state, team, team_size, brick_list, item_list, object_list);
+}
+
+void objectvm_update_state(objectvm_t* vm, const char *name, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+{
+    objectmachine_list_t *m = objectmachine_list_find(vm->state_list, name);
+
+    if(m != NULL)
+        objectmachine_list_update(m, team, team_size, brick_list, item_list, object_list);
+    else
+        fatal_error("Object script error: can't find state \"%s\" in object \"%s\".", name, vm->owner->name);
+}
+
 /* objectmachine_list_t: private methods */
 
 objectmachine_list_t* objectmachine_list_new(objectmachine_list_t* list, const char *name, enemy_t *owner)
@@ -171,6 +194,7 @@ objectmachine_list_t* objectmachine_list_new(objectmachine_list_t* list, const c
     objectmachine_list_t *l = mallocx(sizeof *l);
     l->name = str_dup(name);
     l->data = objectbasicmachine_new(owner);
+    l->program = NULL;
     l->next = list;
     return l;
 }
@@ -181,6 +205,8 @@ objectmachine_list_t* objectmachine_list_delete(objectmachine_list_t* list)
         objectmachine_t *machine = list->data;
         objectmachine_list_delete(list->next);
         free(list->name);
+        if(list->program != NULL)
+            objectprogram_destroy(list->program);
         machine->release(machine);
         free(list);
     }
@@ -212,6 +238,15 @@ objectmachine_list_t* objectmachine_list_findmachine(objectmachine_list_t* list,
         return NULL;   
 }
 
+void objectmachine_list_update(objectmachine_list_t* node, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list)
+{
+    /* the decorators of a state are fixed once the object is compiled */
+    if(node->program == NULL)
+        node->program = objectprogram_create(node->data);
+
+    objectprogram_update(node->program, team, team_size, brick_list, item_list, object_list);
+}
+
 /* objectmachine_stack_t: private methods */
 
 objectmachine_stack_t* objectmachine_stack_new()
@@ -43,5 +43,7 @@ void objectvm_set_current_state(objectvm_t* vm, const char *name); /* sets the c
 void objectvm_return_to_previous_state(objectvm_t *vm); /* returns to the previous state */
 void objectvm_reset_history(objectvm_t *vm); /* resets the history of states (can't return to previous state anymore) */
 objectmachine_t* objectvm_get_state_by_name(objectvm_t* vm, const char *name); /* retrieves a specific state by name */
+void objectvm_update_current_state(objectvm_t* vm, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list); /* runs the current state */
+void objectvm_update_state(objectvm_t* vm, const char *name, player_t **team, int team_size, brick_list_t *brick_list, item_list_t *item_list, object_list_t *object_list); /* runs a specific state */
 
 #endif
@@ -168,6 +168,12 @@ player_t *player_create(const char *character_name)
     p->underwater_timer = 0.0f;
     p->breath_time = PLAYER_UNDERWATER_BREATH;
 
+    /* sounds that must not be dropped when the voices run out */
+    sound_set_priority(SFX_DAMAGE, SOUND_PRIORITY_HIGH);
+    sound_set_priority(SFX_GETHIT, SOUND_PRIORITY_HIGH);
+    sound_set_priority(SFX_DROWN, SOUND_PRIORITY_HIGH);
+    sound_set_priority(c->sample.death, SOUND_PRIORITY_HIGH);
+
     /* character system: setting the multipliers */
     physicsactor_set_acc(p->pa, physicsactor_get_acc(p->pa) * c->multiplier.acc);
     physicsactor_set_dec(p->pa, physicsactor_get_dec(p->pa) * c->multiplier.dec);
@@ -31,6 +31,7 @@
 #include "../core/util.h"
 #include "../core/video.h"
 #include "../core/image.h"
+#include "../core/profiler.h"
 #include "../scenes/level.h"
 #include "../scripting/scripting.h"
 
@@ -193,11 +194,15 @@ void renderqueue_end()
         arr[--i] = it->cell;
 
     /* sort stuff. we need an stable sorting algorithm here. */
+    profiler_begin("sort");
     merge_sort(arr, size, sizeof *arr, cmp_fun);
+    profiler_end();
 
     /* render everything */
+    profiler_begin("draw");
     for(i=0; i<size; i++)
         arr[i].render(arr[i].entity, camera);
+    profiler_end();
 
     /* release the temporary array */
     free(arr);
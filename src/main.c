@@ -32,9 +32,8 @@ int main(int argc, char **argv)
 {
     engine_init(argc, argv);
     engine_mainloop();
-    engine_release();
 
-    return 0;
+    return engine_release();
 }
 
 #if !defined(A5BUILD)
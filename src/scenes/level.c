@@ -32,6 +32,10 @@
 #include "quest.h"
 #include "util/editorgrp.h"
 #include "util/editorcmd.h"
+#include "util/editorindex.h"
+#include "util/levelcache.h"
+#include "util/levelstream.h"
+#include "util/preloadmanifest.h"
 #include "../core/scene.h"
 #include "../core/storyboard.h"
 #include "../core/global.h"
@@ -42,13 +46,20 @@
 #include "../core/timer.h"
 #include "../core/sprite.h"
 #include "../core/assetfs.h"
+#include "../core/assetloader.h"
+#include "../core/jobs.h"
 #include "../core/stringutil.h"
 #include "../core/logfile.h"
 #include "../core/lang.h"
 #include "../core/nanoparser/nanoparser.h"
 #include "../core/font.h"
 #include "../core/prefs.h"
+#include "../core/quest.h"
 #include "../core/modmanager.h"
+#include "../core/profiler.h"
+#include "../core/inputrecorder.h"
+#include "../core/benchmark.h"
+#include "../core/darray.h"
 #include "../entities/actor.h"
 #include "../entities/brick.h"
 #include "../entities/player.h"
@@ -60,6 +71,7 @@
 #include "../entities/sfx.h"
 #include "../entities/legacy/item.h"
 #include "../entities/legacy/enemy.h"
+#include "../entities/legacy/object_vm.h"
 #include "../physics/obstacle.h"
 #include "../scripting/scripting.h"
 #include "../scenes/editorpal.h"
@@ -123,7 +135,6 @@ static bool is_setup_object(const char* object_name);
 #define DEFAULT_WATERLEVEL      LARGE_INT
 #define DEFAULT_WATERCOLOR()    color_rgb(0,32,192)
 #define PATH_MAXLEN             1024
-#define LINE_MAXLEN             1024
 
 /* level attributes */
 static char file[PATH_MAXLEN];
@@ -161,10 +172,79 @@ static void save_level_state(levelstate_t* state);
 static void restore_level_state(const levelstate_t* state);
 static void clear_level_state(levelstate_t* state);
 
+/* level snapshot */
+typedef enum snapshotentry_type_t snapshotentry_type_t;
+enum snapshotentry_type_t {
+    SNAPSHOT_BRICK,
+    SNAPSHOT_LEGACY_ITEM,
+    SNAPSHOT_LEGACY_OBJECT,
+    SNAPSHOT_ENTITY
+};
+typedef struct snapshotentry_t snapshotentry_t;
+struct snapshotentry_t { /* an entity spawned by the level file */
+    snapshotentry_type_t type;
+    v2d_t position;
+    int id; /* brick id or legacy item type */
+    bricklayer_t layer;
+    brickflip_t flip;
+    char* name; /* legacy object or SurgeScript entity */
+    uint64_t entity_id;
+    int spawned_in_the_editor;
+    int materialized; /* is there an instance of this entry in the level? */
+    int removed; /* the instance has been destroyed during gameplay; it won't be spawned again */
+    const animation_t* spawn_animation; /* legacy item: animation right after it was spawned */
+    union {
+        brick_t* brick;
+        item_t* item;
+        enemy_t* object;
+        surgescript_objecthandle_t handle;
+    } instance;
+};
+static struct { /* recorded after the level is loaded; used to restart it in place */
+    bool is_valid;
+    bool is_recording;
+    DARRAY(snapshotentry_t, entry);
+    char* player_name[TEAM_MAX];
+    int player_count;
+    int dialogregion_size;
+    dialogregion_t dialogregion[DIALOGREGION_MAX];
+    levelstate_t state;
+
+    /* large levels are streamed: only the sections near the camera are materialized */
+    levelstream_t* stream; /* NULL if the level isn't being streamed */
+    fasthash_t* instances; /* instance of a brick, legacy item or legacy object -> entry */
+    int has_bricks, bricks_right, bricks_bottom; /* bounds of the bricks of the level file */
+    DARRAY(int, brick_column_bottom); /* see entitymanager_get_brick_column_bottom() */
+} snapshot = { .is_valid = false, .is_recording = false, .entry = NULL, .stream = NULL };
+static void snapshot_begin();
+static void snapshot_end();
+static void snapshot_release();
+static void snapshot_record_brick(int id, v2d_t position, bricklayer_t layer, brickflip_t flip);
+static void snapshot_record_legacy_item(int type, v2d_t position);
+static void snapshot_record_legacy_object(const char* name, v2d_t position);
+static void snapshot_record_entity(const char* name, v2d_t position, uint64_t entity_id, int spawned_in_the_editor);
+static void snapshot_spawn();
+static void snapshot_spawn_entry(int index, void* unused);
+static void snapshot_evict_entry(int index, void* unused);
+static void snapshot_stop_streaming();
+static void snapshot_compute_brick_bounds();
+static int snapshot_get_brick_bounds(int* right, int* bottom);
+static int snapshot_get_brick_column_bottom(int column, int* bottom);
+static void snapshot_track_instance(const void* instance, snapshotentry_t* entry);
+static void snapshot_forget_instance(const void* instance);
+static void snapshot_remove_instance(const void* instance);
+static void snapshot_on_remove_brick(brick_t* brick);
+static void snapshot_on_remove_item(item_t* item);
+static void snapshot_on_remove_object(enemy_t* object);
+static bool snapshot_find_changed_state(surgescript_object_t* object, void* changed);
+static void update_stream(v2d_t camera);
+static bool restart_in_place();
+
 /* internal data */
 static int level_width;/* width of this level (in pixels) */
 static int level_height; /* height of this level (in pixels) */
 static int *height_at, height_at_count; /* level height at different sample points */
+static int height_at_levels, height_at_sample_width; /* height_at is a sparse table: height_at[k * height_at_count + j] is the max of 2^k samples starting at j */
 static float level_timer;
 static music_t *music;
 static sound_t *override_music;
@@ -195,13 +275,59 @@ static font_t *dlgbox_title, *dlgbox_message;
 static void level_load(const char *filepath);
 static void level_unload();
 static int level_save(const char *filepath);
-static void level_interpret_line(const char *filename, int fileline, const char *line);
+static void level_traverse(const char *filepath, levelcache_callback_t interpret);
 static void level_interpret_parsed_line(const char *filename, int fileline, const char *identifier, int param_count, const char **param);
 
+/* asynchronous loading */
+static int is_loading; /* are the assets of the level being loaded? */
+static int must_restore_state; /* restore saved_state after loading (restart) */
+static void level_preload(const char *filepath);
+static void level_preload_parsed_line(const char *filename, int fileline, const char *identifier, int param_count, const char **param);
+static void finish_loading();
+static preloadmanifest_t* preload_manifest = NULL; /* sounds used by the level */
+static void record_sound(const char *path);
+typedef struct levelreader_t levelreader_t;
+struct levelreader_t { /* a .lev file read on a worker thread */
+    char *filepath; /* relative path */
+    char *fullpath; /* absolute paths, resolved on the main thread */
+    char *cache_fullpath;
+    levelcache_t *cache; /* the compiled level (NULL on error) */
+    int is_ready; /* set on the main thread when the worker is done */
+};
+static levelreader_t *preloaded_level = NULL; /* the level being read by level_preload() */
+static music_t *preloaded_music = NULL; /* we keep a reference to the music of the level being loaded */
+static levelreader_t* read_level(const char *filepath, void (*callback)(void*));
+static levelreader_t* destroy_levelreader(levelreader_t *reader);
+static void read_level_job(void *reader);
+static void preload_level_assets(void *reader);
+static void release_preloaded_level();
+static void preload_brickset(const char *path, void *unused);
+static void preload_background(const char *path, void *unused);
+static void preload_music(const char *path, void *unused);
+
+/* prefetching */
+static const float PREFETCH_DELAY = 5.0f; /* prefetch the next level of the quest after this many seconds */
+static const int DEFAULT_PREFETCH_BUDGET = 64; /* in megabytes; may be changed in the preferences (.prefetchbudget) */
+static int must_prefetch; /* should we prefetch the next level? */
+static char prefetched_level[PATH_MAXLEN] = ""; /* the level being prefetched, if any */
+static size_t prefetch_budget = 0; /* in bytes */
+static music_t *prefetched_music = NULL; /* we keep a reference to the music of the next level */
+static void prefetch_next_level();
+static void release_prefetched_assets();
+static void prefetch_level_assets(void* reader);
+static void prefetch_parsed_line(const char *filename, int fileline, const char *identifier, int param_count, const char **param);
+static void prefetch_brickset(const char* path, void* unused);
+static void prefetch_background(const char* path, void* unused);
+static void prefetch_music(const char* path, void* unused);
+
+/* streaming */
+static const int DEFAULT_STREAMING_THRESHOLD = 20000; /* stream levels having more entities than this; may be changed in the preferences (.streamingthreshold); zero disables streaming */
+static const int STREAM_SECTION_SIZE = 1024; /* in pixels */
+
 /* internal methods */
 static int inside_screen(int x, int y, int w, int h, int margin);
 static void update_level_size();
-static void update_level_height_samples(int level_width, int level_height);
+static void update_level_height_samples(int level_width, int level_height, int has_bricks);
 static void restart(int preserve_level_state);
 static void render_players();
 static void update_music();
@@ -223,6 +349,8 @@ static void late_update_ssobject(surgescript_object_t* object, void* param);
 static void render_ssobjects();
 static bool render_ssobject(surgescript_object_t* object, void* param);
 static bool ssobject_exists(const char* object_name);
+static bool ssobject_is_entity(const char* object_name);
+static bool ssobject_is_editable(const char* object_name);
 static surgescript_object_t* level_ssobject();
 static surgescript_object_t* spawn_ssobject(const char* object_name, v2d_t spawn_point, int spawned_in_the_editor);
 static bool save_ssobject(surgescript_object_t* object, void* param);
@@ -344,6 +472,17 @@ static int editor_ssobj_index(const char* entity_name); /* an index k such that
 static const char* editor_ssobj_name(int entity_index); /* the inverse of editor_ssobj_index() */
 static bool editor_remove_ssobj(surgescript_object_t* object, void* data);
 static bool editor_pick_ssobj(surgescript_object_t* object, void* data);
+static void editor_ssobj_bounding_box(surgescript_object_t* object, float box[4]);
+
+/* editor: spatial index of the SurgeScript entities */
+static editorindex_t* editor_ssobj_spatial_index;
+static void editor_ssobj_index_init();
+static void editor_ssobj_index_release();
+static void editor_ssobj_index_add(surgescript_object_t* object);
+static bool editor_ssobj_index_add_tree(surgescript_object_t* object, void* data);
+static void editor_ssobj_index_remove(surgescript_object_t* object);
+static surgescript_object_t* editor_ssobj_at_cursor();
+static void editor_ssobj_at_cursor_candidate(uint64_t handle, void* data);
 
 /* editor: bricks */
 static int* editor_brick; /* an array of all valid brick numbers */
@@ -450,12 +589,7 @@ static editor_action_list_t* editor_action_delete_list(editor_action_list_t *lis
  */
 void level_load(const char *filepath)
 {
-    char line[LINE_MAXLEN];
-    const char* fullpath;
-    FILE* fp;
-
     logfile_message("Loading level \"%s\"...", filepath);
-    fullpath = assetfs_fullpath(filepath);
 
     /* default values */
     str_cpy(file, filepath, sizeof(file)); /* it's the relative filepath we want */
@@ -489,20 +623,11 @@ void level_load(const char *filepath)
     init_setup_object_list();
 
     /* traversing the level file */
-    fp = fopen(fullpath, "r");
-    if(fp != NULL) {
-        int ln = 0;
-        while(fgets(line, sizeof(line) / sizeof(char), fp)) {
-            if(*line) {
-                char *q = line + strlen(line) - 1;
-                if(*q == '\n') *q = '\0'; /* no newlines, please! */
-                level_interpret_line(fullpath, ++ln, line);
-            }
-        }
-        fclose(fp);
-    }
-    else
-        fatal_error("Can\'t open level file \"%s\".", fullpath);
+    snapshot_begin();
+    level_traverse(filepath, level_interpret_parsed_line);
+
+    /* spawn the entities of the level file */
+    snapshot_spawn();
 
     /* load the music */
     block_music = FALSE;
@@ -515,13 +640,15 @@ void level_load(const char *filepath)
     level_width = 0;
     level_height = 0;
     height_at_count = 0;
+    height_at_levels = 0;
+    height_at_sample_width = 1;
     height_at = NULL;
     update_level_size();
 
     /* players */
     if(team_size == 0) {
         /* default players */
-        logfile_message("Loading the default players...");
+        logfile_debug("Loading the default players...");
         team[team_size++] = player_create("Surge");
         team[team_size++] = player_create("Neon");
         team[team_size++] = player_create("Charge");
@@ -533,6 +660,9 @@ void level_load(const char *filepath)
     player_set_collectibles(0);
     surgescript_object_call_function(scripting_util_surgeengine_component(surgescript_vm(), "Player"), "__spawnPlayers", NULL, 0, NULL);
 
+    /* snapshot of the loaded level */
+    snapshot_end();
+
     /* setup objects (2) */
     spawn_setup_objects();
 
@@ -574,15 +704,15 @@ void level_unload()
     release_setup_object_list();
 
     /* unloading the brickset */
-    logfile_message("Unloading the brickset...");
+    logfile_debug("Unloading the brickset...");
     brickset_unload();
 
     /* unloading the background */
-    logfile_message("Unloading the background...");
+    logfile_debug("Unloading the background...");
     backgroundtheme = background_unload(backgroundtheme);
 
     /* destroying the players */
-    logfile_message("Unloading the players...");
+    logfile_debug("Unloading the players...");
     for(i=0; i<team_size; i++)
         player_destroy(team[i]);
     team_size = 0;
@@ -595,6 +725,7 @@ void level_unload()
         free(height_at);
     height_at = NULL;
     height_at_count = 0;
+    height_at_levels = 0;
 
     /* misc */
     camera_unlock();
@@ -628,7 +759,7 @@ int level_save(const char *filepath)
     /* open for writing */
     logfile_message("level_save(\"%s\")", fullpath);
     if(NULL == (fp=fopen(fullpath, "w"))) {
-        logfile_message("Warning: could not open \"%s\" for writing.", fullpath);
+        logfile_warning("Warning: could not open \"%s\" for writing.", fullpath);
         video_showmessage("Could not open \"%s\" for writing.", fullpath);
         return FALSE;
     }
@@ -761,53 +892,89 @@ int level_save(const char *filepath)
 }
 
 /*
- * level_interpret_line()
- * Interprets a line from the .lev file
+ * level_preload()
+ * Loads the assets of a level in the background. The .lev file
+ * is read (and compiled, if necessary) on a worker thread. Then
+ * its brickset and its background are parsed, so that their images
+ * are decoded asynchronously, and its music is opened. These run
+ * as jobs of the asset loader, spread across frames, because the
+ * parser isn't thread-safe. The level is loaded afterwards.
+ *
+ * Entity sprites need no preloading: all spritesheets are loaded by
+ * sprite_init(). Sounds are decoded on a worker thread by sound_load(),
+ * and the ones the level used the last time it was played are
+ * preloaded from its manifest. The entities are spawned on the main
+ * thread by level_load(), but large levels are streamed: only the
+ * sections around the camera are materialized
+ */
+void level_preload(const char *filepath)
+{
+    logfile_debug("Preloading level \"%s\"...", filepath);
+    release_preloaded_level();
+    preloaded_level = read_level(filepath, preload_level_assets);
+}
+
+/*
+ * level_preload_parsed_line()
+ * Preloads the assets referenced by a command of a level
+ */
+void level_preload_parsed_line(const char *filename, int fileline, const char *identifier, int param_count, const char **param)
+{
+    if(param_count != 1)
+        return; /* level_interpret_parsed_line() will complain */
+
+    if(str_icmp(identifier, "theme") == 0)
+        assetloader_enqueue(param[0], NULL, preload_brickset);
+    else if(str_icmp(identifier, "bgtheme") == 0)
+        assetloader_enqueue(param[0], NULL, preload_background);
+    else if(str_icmp(identifier, "music") == 0)
+        assetloader_enqueue(param[0], NULL, preload_music);
+}
+
+/*
+ * record_sound()
+ * Adds a sound loaded while playing the
+ * level to its preload manifest
+ */
+void record_sound(const char *path)
+{
+    if(preload_manifest != NULL)
+        preloadmanifest_add(preload_manifest, path);
+}
+
+/*
+ * level_traverse()
+ * Reads a .lev file, calling interpret() for each of its commands.
+ * We read the compiled version of the file (see util/levelcache.h),
+ * compiling it first if it's out of date. If the level has been
+ * read in the background by level_preload(), we use that instead
  */
-void level_interpret_line(const char *filename, int fileline, const char *line)
-{
-    int param_count, i;
-    char *param[16], *identifier;
-    char tmp[LINE_MAXLEN], *p, *q;
-    const int sz = (sizeof(tmp)/sizeof(*tmp))-1;
-
-    /* skip spaces */
-    for(p=(char*)line; isspace((int)*p); p++);
-    if(0 == *p) return;
-
-    /* reading the identifier */
-    for(q=tmp; *p && !isspace(*p) && q<tmp+sz; *q++ = *p++) { ; } *q=0;
-    if(strncmp(tmp, "//", 2) == 0 || *tmp == '#') return; /* comment */
-    identifier = str_dup(tmp);
-
-    /* skip spaces */
-    for(; isspace((int)*p); p++);
-
-    /* read the arguments */
-    param_count = 0;
-    if(0 != *p) {
-        int quotes;
-        while(*p && param_count<sizeof(param)/sizeof(*param)) {
-            quotes = (*p == '"') && !!(p++); /* short-circuit AND */
-            for(q=tmp; *p && ((!quotes && !isspace(*p)) || (quotes && !(*p == '"' && *(p-1) != '\\'))) && q<tmp+sz; *q++ = *p++) { ; } *q=0;
-            quotes = (*p == '"') && !!(p++);
-            param[param_count++] = str_dup(tmp);
-            for(; isspace((int)*p); p++); /* skip spaces */
+void level_traverse(const char *filepath, levelcache_callback_t interpret)
+{
+    const char *fullpath, *cache_fullpath;
+    levelcache_t* cache;
+
+    /* has the level been read in the background? */
+    if(preloaded_level != NULL && preloaded_level->is_ready && preloaded_level->cache != NULL) {
+        if(strcmp(preloaded_level->filepath, filepath) == 0) {
+            levelcache_foreach_command(preloaded_level->cache, interpret);
+            return;
         }
     }
 
-    /* interpret the line */
-    level_interpret_parsed_line(filename, fileline, identifier, param_count, (const char**)param);
+    /* read it now */
+    cache_fullpath = levelcache_fullpath(filepath);
+    fullpath = assetfs_fullpath(filepath);
+    if(NULL == (cache = levelcache_load(fullpath, cache_fullpath)))
+        fatal_error("Can\'t open level file \"%s\".", fullpath);
 
-    /* free the stuff */
-    for(i=0; i<param_count; i++)
-        free(param[i]);
-    free(identifier);
+    levelcache_foreach_command(cache, interpret);
+    cache = levelcache_close(cache);
 }
 
 /*
  * level_interpret_parsed_line()
- * Interprets a line parsed by level_interpret_line()
+ * Interprets a command of the level
  */
 void level_interpret_parsed_line(const char *filename, int fileline, const char *identifier, int param_count, const char **param)
 {
@@ -819,52 +986,52 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
                 brickset_load(theme);
             }
             else
-                logfile_message("Level loader - command 'theme' expects one parameter: brickset filepath. Did you forget to double quote the brickset filepath?");
+                logfile_warning("Level loader - command 'theme' expects one parameter: brickset filepath. Did you forget to double quote the brickset filepath?");
         }
         else
-            logfile_message("Level loader - duplicate command 'theme' on line %d. Ignoring...", fileline);
+            logfile_warning("Level loader - duplicate command 'theme' on line %d. Ignoring...", fileline);
     }
     else if(str_icmp(identifier, "bgtheme") == 0) {
         if(param_count == 1)
             str_cpy(bgtheme, param[0], sizeof(bgtheme));
         else
-            logfile_message("Level loader - command 'bgtheme' expects one parameter: background filepath. Did you forget to double quote the background filepath?");
+            logfile_warning("Level loader - command 'bgtheme' expects one parameter: background filepath. Did you forget to double quote the background filepath?");
     }
     else if(str_icmp(identifier, "grouptheme") == 0) {
         if(param_count == 1)
             str_cpy(grouptheme, param[0], sizeof(grouptheme));
         else
-            logfile_message("Level loader - command 'grouptheme' expects one parameter: grouptheme filepath. Did you forget to double quote the grouptheme filepath?");
+            logfile_warning("Level loader - command 'grouptheme' expects one parameter: grouptheme filepath. Did you forget to double quote the grouptheme filepath?");
     }
     else if(str_icmp(identifier, "music") == 0) {
         if(param_count == 1)
             str_cpy(musicfile, param[0], sizeof(musicfile));
         else
-            logfile_message("Level loader - command 'music' expects one parameter: music filepath. Did you forget to double quote the music filepath?");
+            logfile_warning("Level loader - command 'music' expects one parameter: music filepath. Did you forget to double quote the music filepath?");
     }
     else if(str_icmp(identifier, "name") == 0) {
         if(param_count == 1)
             str_cpy(name, param[0], sizeof(name));
         else
-            logfile_message("Level loader - command 'name' expects one parameter: level name. Did you forget to double quote the level name?");
+            logfile_warning("Level loader - command 'name' expects one parameter: level name. Did you forget to double quote the level name?");
     }
     else if(str_icmp(identifier, "author") == 0) {
         if(param_count == 1)
             str_cpy(author, param[0], sizeof(name));
         else
-            logfile_message("Level loader - command 'author' expects one parameter: author name. Did you forget to double quote the author name?");
+            logfile_warning("Level loader - command 'author' expects one parameter: author name. Did you forget to double quote the author name?");
     }
     else if(str_icmp(identifier, "version") == 0) {
         if(param_count == 1)
             str_cpy(version, param[0], sizeof(name));
         else
-            logfile_message("Level loader - command 'version' expects one parameter: level version");
+            logfile_warning("Level loader - command 'version' expects one parameter: level version");
     }
     else if(str_icmp(identifier, "license") == 0) {
         if(param_count == 1)
             str_cpy(license, param[0], sizeof(license));
         else
-            logfile_message("Level loader - command 'license' expects one parameter: license name. Did you forget to double quote the license parameter?");
+            logfile_warning("Level loader - command 'license' expects one parameter: license name. Did you forget to double quote the license parameter?");
     }
     else if(str_icmp(identifier, "requires") == 0) {
         if(param_count == 1) {
@@ -880,19 +1047,19 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
             }
         }
         else
-            logfile_message("Level loader - command 'requires' expects one parameter: minimum required engine version");
+            logfile_warning("Level loader - command 'requires' expects one parameter: minimum required engine version");
     }
     else if(str_icmp(identifier, "act") == 0) {
         if(param_count == 1)
             act = clip(atoi(param[0]), 0, 99);
         else
-            logfile_message("Level loader - command 'act' expects one parameter: act number");
+            logfile_warning("Level loader - command 'act' expects one parameter: act number");
     }
     else if(str_icmp(identifier, "waterlevel") == 0) {
         if(param_count == 1)
             waterlevel = atoi(param[0]);
         else
-            logfile_message("Level loader - command 'waterlevel' expects one parameter: y coordinate");
+            logfile_warning("Level loader - command 'waterlevel' expects one parameter: y coordinate");
     }
     else if(str_icmp(identifier, "watercolor") == 0) {
         if(param_count == 3) {
@@ -903,7 +1070,7 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
             );
         }
         else
-            logfile_message("Level loader - command 'watercolor' expects three parameters: red, green, blue");
+            logfile_warning("Level loader - command 'watercolor' expects three parameters: red, green, blue");
     }
     else if(str_icmp(identifier, "spawn_point") == 0) {
         if(param_count == 2) {
@@ -912,7 +1079,7 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
             spawn_point = v2d_new(x, y);
         }
         else
-            logfile_message("Level loader - command 'spawn_point' expects two parameters: xpos, ypos");
+            logfile_warning("Level loader - command 'spawn_point' expects two parameters: xpos, ypos");
     }
     else if(str_icmp(identifier, "dialogbox") == 0) {
         if(param_count == 6) {
@@ -927,20 +1094,20 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
                 str_cpy(d->message, param[5], sizeof(d->message));
             }
             else
-                logfile_message("Level loader - command 'dialogbox' has reached %d repetitions.", dialogregion_size);
+                logfile_warning("Level loader - command 'dialogbox' has reached %d repetitions.", dialogregion_size);
         }
         else
-            logfile_message("Level loader - command 'dialogbox' expects six parameters: rect_xpos, rect_ypos, rect_width, rect_height, title, message. Did you forget to double quote the message?");
+            logfile_warning("Level loader - command 'dialogbox' expects six parameters: rect_xpos, rect_ypos, rect_width, rect_height, title, message. Did you forget to double quote the message?");
     }
     else if(str_icmp(identifier, "readonly") == 0) {
         if(!readonly) {
             if(param_count == 0)
                 readonly = TRUE;
             else
-                logfile_message("Level loader - command 'readonly' expects no parameters");
+                logfile_warning("Level loader - command 'readonly' expects no parameters");
         }
         else
-            logfile_message("Level loader - duplicate command 'readonly' on line %d. Ignoring...", fileline);
+            logfile_warning("Level loader - duplicate command 'readonly' on line %d. Ignoring...", fileline);
     }
     else if(str_icmp(identifier, "brick") == 0) {
         if(param_count == 3 || param_count == 4 || param_count == 5) {
@@ -959,15 +1126,15 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
                 }
 
                 if(brick_exists(id))
-                    level_create_brick(id, v2d_new(x,y), layer, flip);
+                    snapshot_record_brick(id, v2d_new(x,y), layer, flip);
                 else
-                    logfile_message("Level loader - invalid brick: %d", id);
+                    logfile_warning("Level loader - invalid brick: %d", id);
             }
             else
-                logfile_message("Level loader - warning: cannot create a new brick if the theme is not defined");
+                logfile_warning("Level loader - warning: cannot create a new brick if the theme is not defined");
         }
         else
-            logfile_message("Level loader - command 'brick' expects three, four or five parameters: id, xpos, ypos [, layer_name [, flip_flags]]");
+            logfile_warning("Level loader - command 'brick' expects three, four or five parameters: id, xpos, ypos [, layer_name [, flip_flags]]");
     }
     else if(str_icmp(identifier, "entity") == 0) {
         if(param_count == 3 || param_count == 4) {
@@ -975,19 +1142,18 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
             int x = atoi(param[1]);
             int y = atoi(param[2]);
             if(!is_setup_object(name)) {
-                surgescript_object_t* obj = level_create_object(name, v2d_new(x, y));
-                if(obj != NULL) {
-                    if(!surgescript_object_has_tag(obj, "entity"))
+                if(ssobject_exists(name)) {
+                    if(!ssobject_is_entity(name))
                         fatal_error("Level loader - can't spawn \"%s\": object is not an entity", name);
-                    else if(param_count > 3 && get_ssobj_extradata(obj))
-                        get_ssobj_extradata(obj)->entity_id = str_to_x64(param[3]);
+                    else
+                        snapshot_record_entity(name, v2d_new(x, y), param_count > 3 ? str_to_x64(param[3]) : random64(), ssobject_is_editable(name));
                 }
                 else
-                    logfile_message("Level loader - can't spawn \"%s\": entity doesn't exist", name);
+                    logfile_warning("Level loader - can't spawn \"%s\": entity doesn't exist", name);
             }
         }
         else
-            logfile_message("Level loader - command 'entity' expects three or four parameters: name, xpos, ypos [, id]");
+            logfile_warning("Level loader - command 'entity' expects three or four parameters: name, xpos, ypos [, id]");
     }
     else if(
         str_icmp(identifier, "setup") == 0 ||
@@ -999,10 +1165,10 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
                     add_to_setup_object_list(param[i]);
             }
             else
-                logfile_message("Level loader - command '%s' expects one or more parameters: object_name1 [, object_name2 [, ... [, object_nameN] ... ] ]", identifier);
+                logfile_warning("Level loader - command '%s' expects one or more parameters: object_name1 [, object_name2 [, ... [, object_nameN] ... ] ]", identifier);
         }
         else
-            logfile_message("Level loader - duplicate command '%s' on line %d. Ignoring... (note: the command accepts one or more parameters)", identifier, fileline);
+            logfile_warning("Level loader - duplicate command '%s' on line %d. Ignoring... (note: the command accepts one or more parameters)", identifier, fileline);
     }
     else if(str_icmp(identifier, "players") == 0) {
         if(team_size == 0) {
@@ -1014,7 +1180,7 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
                                 fatal_error("Level loader - duplicate entry of player '%s' in '%s' near line %d", param[i], filename, fileline);
                         }
 
-                        logfile_message("Loading player '%s'...", param[i]);
+                        logfile_debug("Loading player '%s'...", param[i]);
                         team[team_size++] = player_create(param[i]);
                     }
                     else
@@ -1022,28 +1188,24 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
                 }
             }
             else
-                logfile_message("Level loader - command 'players' expects one or more parameters: character_name1 [, character_name2 [, ... [, character_nameN] ... ] ]");
+                logfile_warning("Level loader - command 'players' expects one or more parameters: character_name1 [, character_name2 [, ... [, character_nameN] ... ] ]");
         }
         else
-            logfile_message("Level loader - duplicate command 'players' on line %d. Ignoring... (note: 'players' accepts one or more parameters)", fileline);
+            logfile_warning("Level loader - duplicate command 'players' on line %d. Ignoring... (note: 'players' accepts one or more parameters)", fileline);
     }
     else if(str_icmp(identifier, "item") == 0) {
         if(param_count == 3) {
             int type = atoi(param[0]);
             int x = atoi(param[1]);
             int y = atoi(param[2]);
-            surgescript_object_t* object = NULL;
             const char* object_name = item2surgescript(type); /* legacy item ported to SurgeScript? */
-            if(object_name != NULL && (object = level_create_object(object_name, v2d_new(x, y))) != NULL) {
-                ssobj_extradata_t* data = get_ssobj_extradata(object);
-                if(data != NULL)
-                    data->spawned_in_the_editor = TRUE; /* force this flag, so the port gets persisted */
-            }
+            if(object_name != NULL && ssobject_exists(object_name))
+                snapshot_record_entity(object_name, v2d_new(x, y), random64(), TRUE); /* force the editor flag, so the port gets persisted */
             else
-                level_create_legacy_item(type, v2d_new(x, y)); /* no; create legacy item */
+                snapshot_record_legacy_item(type, v2d_new(x, y)); /* no; create legacy item */
         }
         else
-            logfile_message("Level loader - command 'item' expects three parameters: type, xpos, ypos");
+            logfile_warning("Level loader - command 'item' expects three parameters: type, xpos, ypos");
     }
     else if(
         str_icmp(identifier, "object") == 0 ||
@@ -1054,24 +1216,23 @@ void level_interpret_parsed_line(const char *filename, int fileline, const char
             int x = atoi(param[1]);
             int y = atoi(param[2]);
             if(!is_setup_object(name)) {
-                surgescript_object_t* obj = level_create_object(name, v2d_new(x, y));
-                if(obj != NULL) {
-                    if(!surgescript_object_has_tag(obj, "entity"))
+                if(ssobject_exists(name)) {
+                    if(!ssobject_is_entity(name))
                         fatal_error("Level loader - can't spawn \"%s\": object is not an entity", name);
+                    else
+                        snapshot_record_entity(name, v2d_new(x, y), random64(), ssobject_is_editable(name));
                 }
-                else if(enemy_exists(name)) {
-                    enemy_t* e = level_create_legacy_object(name, v2d_new(x, y)); /* old API */
-                    e->created_from_editor = TRUE;
-                }
+                else if(enemy_exists(name))
+                    snapshot_record_legacy_object(name, v2d_new(x, y)); /* old API */
                 else
-                    logfile_message("Level loader - can't spawn \"%s\": object doesn't exist", name);
+                    logfile_warning("Level loader - can't spawn \"%s\": object doesn't exist", name);
             }
         }
         else
-            logfile_message("Level loader - command '%s' expects three parameters: name, xpos, ypos", identifier);
+            logfile_warning("Level loader - command '%s' expects three parameters: name, xpos, ypos", identifier);
     }
     else
-        logfile_message("Level loader - unknown command '%s'\nin '%s' near line %d", identifier, filename, fileline);
+        logfile_warning("Level loader - unknown command '%s'\nin '%s' near line %d", identifier, filename, fileline);
 }
 
 
@@ -1118,10 +1279,6 @@ void level_init(void *path_to_lev_file)
     particle_init();
     music_stop();
 
-    /* level init */
-    level_load(filepath);
-    spawn_players();
-
     /* dialog box */
     dlgbox_active = FALSE;
     dlgbox_starttime = 0;
@@ -1131,8 +1288,24 @@ void level_init(void *path_to_lev_file)
     dlgbox_title = font_create("dialogbox");
     dlgbox_message = font_create("dialogbox");
 
-    /* editor */
-    editor_init();
+    /* level init: the .lev file is read and the images are decoded
+       in the background; the level is loaded when they're ready */
+    str_cpy(file, filepath, sizeof(file));
+    must_restore_state = FALSE;
+    must_prefetch = TRUE;
+    level_preload(filepath);
+
+    /* the sounds used by the level the last time it was played
+       are decoded as well, so that playing them won't block */
+    preload_manifest = preloadmanifest_load(filepath);
+    preloadmanifest_foreach(preload_manifest, sound_preload);
+    sound_set_load_function(record_sound);
+
+    /* recorded input & benchmarks don't depend on how long the loading takes */
+    inputrecorder_suspend();
+    benchmark_suspend();
+
+    is_loading = TRUE; /* see level_update() */
 
     /* done! */
     logfile_message("level_init() ok");
@@ -1155,10 +1328,20 @@ void level_update()
     enemy_list_t *major_enemies, *enode;
     v2d_t cam = level_editmode() ? editor_camera : camera_get_position();
 
+    /* loading the assets of the level... */
+    if(is_loading) {
+        if(preloaded_level->is_ready && !assetloader_is_busy())
+            finish_loading();
+        return;
+    }
+
     entitymanager_remove_dead_bricks();
     entitymanager_remove_dead_items();
     entitymanager_remove_dead_objects();
 
+    /* stream the sections of the level around the camera */
+    update_stream(cam);
+
     /* next stage in the quest... */
     if(jump_to_next_stage) {
         jump_to_next_stage = FALSE;
@@ -1192,6 +1375,12 @@ void level_update()
     /* music */
     update_music();
 
+    /* prefetch the next level of the quest */
+    if(must_prefetch && level_timer >= PREFETCH_DELAY && !assetloader_is_busy()) {
+        must_prefetch = FALSE;
+        prefetch_next_level();
+    }
+
     /* level editor */
     if(editor_is_enabled()) {
         entitymanager_set_active_region(
@@ -1312,6 +1501,7 @@ void level_update()
     background_update(backgroundtheme);
 
     /* update legacy items */
+    profiler_begin("entities");
     for(inode = major_items; inode != NULL; inode = inode->next) {
         float x = inode->data->actor->position.x;
         float y = inode->data->actor->position.y;
@@ -1355,7 +1545,10 @@ void level_update()
         }
     }
 
+    profiler_end();
+
     /* update players */
+    profiler_begin("players");
     for(i=0; i<team_size; i++) {
         float x = team[i]->actor->position.x;
         float y = team[i]->actor->position.y;
@@ -1377,6 +1570,8 @@ void level_update()
         }
     }
 
+    profiler_end();
+
     /* some objects are attached to the player... */
     for(enode = major_enemies; enode != NULL; enode = enode->next) {
         float x = enode->data->actor->position.x;
@@ -1396,10 +1591,12 @@ void level_update()
     }
 
     /* update bricks */
+    profiler_begin("bricks");
     for(bnode = major_bricks; bnode != NULL; bnode = bnode->next) {
         /* update this brick */
         brick_update(bnode->data, team, team_size, major_bricks, major_items, major_enemies);
     }
+    profiler_end();
 
     /* basic camera */
     if(level_cleared)
@@ -1409,11 +1606,15 @@ void level_update()
     camera_update();
 
     /* update scripts */
+    profiler_begin("scripts");
     clear_bricklike_ssobjects();
     update_ssobjects();
+    profiler_end();
 
     /* update particles */
+    profiler_begin("particles");
     particle_update_all(major_bricks);
+    profiler_end();
 
     /* update dialog box */
     update_dialogregions();
@@ -1466,6 +1667,12 @@ void level_render()
     item_list_t *major_items;
     enemy_list_t *major_enemies;
 
+    /* loading the assets of the level... */
+    if(is_loading) {
+        video_draw_loading_screen(assetloader_progress());
+        return;
+    }
+
     /* very important, if we restart the level */
     if(level_timer < 0.05f)
         return;
@@ -1510,11 +1717,19 @@ void level_release()
     logfile_message("level_release()");
 
     particle_release();
-    level_unload();
-    camera_release();
-    editor_release();
+    if(!is_loading) {
+        level_unload();
+        camera_release();
+        editor_release();
+    }
     prefs_save(modmanager_prefs());
     clear_level_state(&saved_state);
+    snapshot_release();
+    release_preloaded_level();
+    release_prefetched_assets();
+
+    sound_set_load_function(NULL);
+    preload_manifest = preloadmanifest_unload(preload_manifest);
 
     font_destroy(dlgbox_title);
     font_destroy(dlgbox_message);
@@ -1737,18 +1952,8 @@ enemy_t* level_create_legacy_object(const char *name, v2d_t position)
  */
 surgescript_object_t* level_create_object(const char* object_name, v2d_t position)
 {
-    if(ssobject_exists(object_name)) {
-        surgescript_vm_t* vm = surgescript_vm();
-        surgescript_tagsystem_t* tag_system = surgescript_vm_tagsystem(vm);
-        int spawned_in_the_editor =
-            /* note: objects not created with this function (e.g., via scripting)
-               will not have this flag set to true */
-            surgescript_tagsystem_has_tag(tag_system, object_name, "entity") &&
-            !surgescript_tagsystem_has_tag(tag_system, object_name, "private") &&
-            !is_setup_object(object_name)
-        ;
-        return spawn_ssobject(object_name, position, spawned_in_the_editor);
-    }
+    if(ssobject_exists(object_name))
+        return spawn_ssobject(object_name, position, ssobject_is_editable(object_name));
     else
         return NULL;
 }
@@ -1769,6 +1974,19 @@ surgescript_object_t* level_get_entity_by_id(const char* entity_id)
         if(surgescript_objectmanager_exists(manager, data->handle)) /* the object may have been deleted */
             return surgescript_objectmanager_get(manager, data->handle);
     }
+    else if(snapshot.stream != NULL) {
+        /* the entity may be in a section that isn't materialized */
+        for(int i = 0; i < darray_length(snapshot.entry); i++) {
+            const snapshotentry_t* entry = &snapshot.entry[i];
+            if(entry->type == SNAPSHOT_ENTITY && entry->entity_id == id) {
+                if(entry->materialized || entry->removed)
+                    break;
+
+                snapshot_spawn_entry(i, NULL);
+                return surgescript_objectmanager_get(surgescript_vm_objectmanager(surgescript_vm()), entry->instance.handle);
+            }
+        }
+    }
 
     return NULL; /* not found */
 }
@@ -1838,23 +2056,22 @@ v2d_t level_size()
 int level_height_at(int xpos)
 {
     const int WINDOW_SIZE = VIDEO_SCREEN_W * 2;
-    int a, b, i, best, sample_width;
+    int a, b, k, sample_width;
 
     if(height_at != NULL && xpos >= 0 && xpos < level_width) {
         /* clipping interval indexes */
-        sample_width = max(0, level_width) / max(1, height_at_count - 1);
+        sample_width = height_at_sample_width;
         a = ((xpos - WINDOW_SIZE / 2) + ((sample_width + 1) / 2)) / sample_width;
         b = ((xpos + WINDOW_SIZE / 2) + ((sample_width + 1) / 2)) / sample_width;
         a = clip(a, 0, height_at_count - 1);
         b = clip(b, 0, height_at_count - 1);
 
-        /* get the best height in [a,b] */
-        best = height_at[b];
-        for(i = a; i < b; i++) {
-            if(height_at[i] > best)
-                best = height_at[i];
-        }
-        return best;
+        /* get the best height in [a,b]: max of two overlapping blocks of 2^k samples */
+        for(k = 0; (2 << k) <= b - a + 1; k++);
+        return max(
+            height_at[k * height_at_count + a],
+            height_at[k * height_at_count + b - (1 << k) + 1]
+        );
     }
     
     return level_height;
@@ -1869,6 +2086,7 @@ void level_override_music(sound_t *sample)
 {
     music_stop();
     override_music = sample;
+    sound_set_priority(override_music, SOUND_PRIORITY_HIGH);
     sound_play(override_music);
 }
 
@@ -2143,6 +2361,7 @@ void render_level(brick_list_t *major_bricks, item_list_t *major_items, enemy_li
     enemy_list_t *enode;
 
     /* starting up the render queue... */
+    profiler_begin("render_level");
     renderqueue_begin( camera_get_position() );
 
         /* render background */
@@ -2186,6 +2405,7 @@ void render_level(brick_list_t *major_bricks, item_list_t *major_items, enemy_li
 
     /* okay, enough! let's render */
     renderqueue_end();
+    profiler_end();
 }
 
 /* true if a given region is inside the screen position */
@@ -2207,75 +2427,66 @@ int inside_screen(int x, int y, int w, int h, int margin)
 void update_level_size()
 {
     int max_x, max_y;
-    v2d_t bottomright;
-    brick_list_t *p, *brick_list;
-
-    /* get all bricks */
-    brick_list = entitymanager_retrieve_all_bricks();
+    int has_bricks;
 
-    /* compute the bounding box */
-    max_x = max_y = -LARGE_INT;
-    for(p=brick_list; p; p=p->next) {
-        bottomright = v2d_add(brick_spawnpoint(p->data), brick_size(p->data));
-        max_x = max(max_x, (int)bottomright.x);
-        max_y = max(max_y, (int)bottomright.y);
-    }
+    /* the bounding box is kept by the entity manager (or by the snapshot, if the level is streamed) */
+    if(snapshot.stream != NULL)
+        has_bricks = snapshot_get_brick_bounds(&max_x, &max_y);
+    else
+        has_bricks = entitymanager_get_brick_bounds(&max_x, &max_y);
 
     /* validation */
     level_width = max(max_x, VIDEO_SCREEN_W);
     level_height = max(max_y, VIDEO_SCREEN_H);
-    if(brick_list == NULL) { /* no bricks have been found */
+    if(!has_bricks) { /* no bricks have been found */
         /* this is probably a special scene */
         level_width = level_height = LARGE_INT;
-        update_level_height_samples(0, LARGE_INT);
+        update_level_height_samples(0, LARGE_INT, FALSE);
     }
     else
-        update_level_height_samples(level_width, level_height);
-
-    /* done! */
-    brick_list = entitymanager_release_retrieved_brick_list(brick_list);
+        update_level_height_samples(level_width, level_height, TRUE);
 }
 
 /* samples the level height at different points (xpos) */
-void update_level_height_samples(int level_width, int level_height)
+void update_level_height_samples(int level_width, int level_height, int has_bricks)
 {
-    const int SAMPLE_WIDTH = VIDEO_SCREEN_W / 4;
+    const int SAMPLE_WIDTH = entitymanager_get_brick_column_width();
     const int MAX_SAMPLES = 10240; /* limit memory usage */
-    int j, num_samples = 1 + (max(0, level_width) / SAMPLE_WIDTH);
+    int j, k, bottom, num_samples = 1 + (max(0, level_width) / SAMPLE_WIDTH);
+    int *prev, *cur;
 
     /* limit the number of samples */
     if(num_samples > MAX_SAMPLES)
         num_samples = MAX_SAMPLES;
 
-    /* allocate the height_at vector */
+    /* allocate the height_at sparse table */
+    for(k = 0; (2 << k) <= num_samples; k++);
     if(height_at != NULL)
         free(height_at);
-    height_at = mallocx(num_samples * sizeof(*height_at));
+    height_at = mallocx((k + 1) * num_samples * sizeof(*height_at));
     height_at_count = num_samples;
+    height_at_levels = k + 1;
+    height_at_sample_width = SAMPLE_WIDTH;
 
-    /* sample the height of the level at different points */
+    /* sample the height of the level at different points.
+       The columns of bricks are kept by the entity manager
+       (or by the snapshot, if the level is streamed) */
     for(j = 0; j < num_samples; j++) {
-        brick_list_t *p, *brick_list;
-
-        entitymanager_set_active_region(
-            j * SAMPLE_WIDTH - (SAMPLE_WIDTH + 1) / 2,
-            -LARGE_INT/2,
-            SAMPLE_WIDTH,
-            LARGE_INT
-        );
+        int found = has_bricks && (snapshot.stream != NULL ? snapshot_get_brick_column_bottom(j, &bottom) : entitymanager_get_brick_column_bottom(j, &bottom));
+        if(found)
+            height_at[j] = max(0, bottom);
+        else /* no bricks have been found */
+            height_at[j] = (j > 0) ? height_at[j-1] : level_height;
+    }
 
-        brick_list = entitymanager_retrieve_active_unmoving_bricks();
-        {
-            height_at[j] = 0;
-            for(p = brick_list; p; p = p->next) {
-                int bottom = (int)(brick_spawnpoint(p->data).y + brick_size(p->data).y);
-                if(bottom > height_at[j])
-                    height_at[j] = bottom;
-            }
-            if(brick_list == NULL) /* no bricks have been found */
-                height_at[j] = (j > 0) ? height_at[j-1] : level_height;
-        }
-        brick_list = entitymanager_release_retrieved_brick_list(brick_list);
+    /* range maximum queries */
+    for(k = 1; k < height_at_levels; k++) {
+        prev = height_at + (k-1) * num_samples;
+        cur = height_at + k * num_samples;
+        for(j = 0; j + (1 << k) <= num_samples; j++)
+            cur[j] = max(prev[j], prev[j + (1 << (k-1))]);
+        for(; j < num_samples; j++)
+            cur[j] = prev[j];
     }
 }
 
@@ -2286,6 +2497,13 @@ void restart(int preserve_level_state)
     char path[PATH_MAXLEN];
     levelstate_t state = saved_state;
 
+    /* restart the level in place, if possible */
+    if(preserve_level_state && restart_in_place()) {
+        restore_level_state(&saved_state);
+        spawn_players(); /* reposition players */
+        return;
+    }
+
     /* restart the scene */
     scenestack_pop();
     scenestack_push(
@@ -2296,11 +2514,225 @@ void restart(int preserve_level_state)
     /* restore the saved state */
     if(preserve_level_state) {
         saved_state = state;
+        if(!is_loading) {
+            restore_level_state(&saved_state);
+            spawn_players(); /* reposition players */
+        }
+        else
+            must_restore_state = TRUE; /* see finish_loading() */
+    }
+}
+
+/* warms the assets of the next level of the quest while this one plays.
+   The .lev file is read on a worker thread, which compiles it if the
+   compiled level is out of date, so that loading the level won't have
+   to. Its brickset, background and music are then prefetched with low
+   priority */
+void prefetch_next_level()
+{
+    prefs_t* prefs = modmanager_prefs();
+    int budget = prefs_has_item(prefs, ".prefetchbudget") ? prefs_get_int(prefs, ".prefetchbudget") : DEFAULT_PREFETCH_BUDGET;
+    const quest_t* quest = quest_current();
+    int id = quest_next_level();
+    const char* path;
+
+    /* is this level part of the current quest? */
+    if(quest == NULL || id <= 0 || id >= quest->level_count || str_icmp(quest->level_path[id-1], file) != 0)
+        return;
+
+    /* is the next entry of the quest a level? */
+    path = quest->level_path[id];
+    if(path[0] == '<' || budget <= 0)
+        return;
+
+    /* read the .lev file in the background */
+    logfile_message("Prefetching level \"%s\" (budget: %d MB)...", path, budget);
+    release_prefetched_assets();
+    str_cpy(prefetched_level, path, sizeof(prefetched_level));
+    prefetch_budget = (size_t)budget * 1024 * 1024;
+    read_level(path, prefetch_level_assets);
+}
+
+/* releases the references to the prefetched assets. The prefetch jobs
+   that are still pending will do nothing */
+void release_prefetched_assets()
+{
+    *prefetched_level = '\0';
+    image_release_prefetched();
+
+    if(prefetched_music != NULL) {
+        music_unref(prefetched_music);
+        prefetched_music = NULL;
+    }
+}
+
+/* schedules the assets of a level read in the background to be prefetched, one per frame */
+void prefetch_level_assets(void* reader)
+{
+    levelreader_t* r = (levelreader_t*)reader;
+
+    if(r->cache != NULL && str_icmp(r->filepath, prefetched_level) == 0)
+        levelcache_foreach_command(r->cache, prefetch_parsed_line);
+
+    destroy_levelreader(r);
+}
+
+/* prefetches the assets referenced by a command of the next level */
+void prefetch_parsed_line(const char *filename, int fileline, const char *identifier, int param_count, const char **param)
+{
+    if(param_count != 1)
+        return;
+
+    if(str_icmp(identifier, "theme") == 0)
+        assetloader_prefetch(param[0], NULL, prefetch_brickset);
+    else if(str_icmp(identifier, "bgtheme") == 0)
+        assetloader_prefetch(param[0], NULL, prefetch_background);
+    else if(str_icmp(identifier, "music") == 0)
+        assetloader_prefetch(param[0], NULL, prefetch_music);
+}
+
+/* parses a brickset and prefetches its images */
+void prefetch_brickset(const char* path, void* unused)
+{
+    if(*prefetched_level) {
+        image_begin_prefetch(prefetch_budget);
+        brickset_preload(path);
+        image_end_prefetch();
+    }
+}
+
+/* parses a background and prefetches its images */
+void prefetch_background(const char* path, void* unused)
+{
+    if(*prefetched_level) {
+        image_begin_prefetch(prefetch_budget);
+        background_preload(path);
+        image_end_prefetch();
+    }
+}
+
+/* opens the music of the next level */
+void prefetch_music(const char* path, void* unused)
+{
+    if(*prefetched_level && prefetched_music == NULL)
+        prefetched_music = music_load(path);
+}
+
+/* loads the level after its assets have been preloaded */
+void finish_loading()
+{
+    char path[PATH_MAXLEN];
+
+    is_loading = FALSE;
+    inputrecorder_resume();
+    benchmark_resume();
+    level_load(str_cpy(path, file, sizeof(path)));
+    spawn_players();
+    editor_init();
+
+    /* the level holds its own references now */
+    release_preloaded_level();
+    release_prefetched_assets();
+
+    /* restart the level preserving its state */
+    if(must_restore_state) {
+        must_restore_state = FALSE;
         restore_level_state(&saved_state);
         spawn_players(); /* reposition players */
     }
 }
 
+/* reads a .lev file on a worker thread. callback(reader)
+   runs on the main thread when the worker is done */
+levelreader_t* read_level(const char *filepath, void (*callback)(void*))
+{
+    levelreader_t *reader = mallocx(sizeof *reader);
+    job_t *job;
+
+    /* the assetfs isn't thread-safe */
+    reader->filepath = str_dup(filepath);
+    reader->cache_fullpath = str_dup(levelcache_fullpath(filepath));
+    reader->fullpath = str_dup(assetfs_fullpath(filepath));
+    reader->cache = NULL;
+    reader->is_ready = FALSE;
+
+    job = jobs_create(read_level_job, reader);
+    jobs_on_complete(job, callback, reader);
+    jobs_submit(job);
+    job = jobs_destroy(job);
+
+    return reader;
+}
+
+/* destroys a level reader */
+levelreader_t* destroy_levelreader(levelreader_t *reader)
+{
+    if(reader->cache != NULL)
+        reader->cache = levelcache_close(reader->cache);
+
+    free(reader->cache_fullpath);
+    free(reader->fullpath);
+    free(reader->filepath);
+    free(reader);
+    return NULL;
+}
+
+/* reads (and compiles, if necessary) a .lev file; runs on a worker thread */
+void read_level_job(void *reader)
+{
+    levelreader_t *r = (levelreader_t*)reader;
+    r->cache = levelcache_load(r->fullpath, r->cache_fullpath);
+}
+
+/* schedules the assets of a level read by level_preload() to be loaded */
+void preload_level_assets(void *reader)
+{
+    levelreader_t *r = (levelreader_t*)reader;
+
+    /* the level has been released while it was being read */
+    if(r != preloaded_level) {
+        destroy_levelreader(r);
+        return;
+    }
+
+    r->is_ready = TRUE;
+    if(r->cache != NULL)
+        levelcache_foreach_command(r->cache, level_preload_parsed_line);
+}
+
+/* releases the level read by level_preload() and the references to its assets.
+   If it's still being read, it's destroyed when the worker is done */
+void release_preloaded_level()
+{
+    if(preloaded_level != NULL && preloaded_level->is_ready)
+        destroy_levelreader(preloaded_level);
+    preloaded_level = NULL;
+
+    if(preloaded_music != NULL) {
+        music_unref(preloaded_music);
+        preloaded_music = NULL;
+    }
+}
+
+/* parses a brickset and schedules its images to be loaded */
+void preload_brickset(const char *path, void *unused)
+{
+    brickset_preload(path);
+}
+
+/* parses a background and schedules its images to be loaded */
+void preload_background(const char *path, void *unused)
+{
+    background_preload(path);
+}
+
+/* opens the music of the level being loaded */
+void preload_music(const char *path, void *unused)
+{
+    if(preloaded_level != NULL && preloaded_music == NULL)
+        preloaded_music = music_load(path);
+}
+
 
 /* reconfigures the input devices of the
  * players after switching characters */
@@ -2509,7 +2941,7 @@ void spawn_setup_objects()
                 e->created_from_editor = FALSE;
             }
             else {
-                logfile_message("Missing setup object: %s", me->object_name);
+                logfile_warning("Missing setup object: %s", me->object_name);
                 video_showmessage("Missing setup object: %s", me->object_name);
             }
         }
@@ -2633,6 +3065,501 @@ void clear_level_state(levelstate_t* state)
 }
 
 
+/* level snapshot */
+
+/* starts recording the entities spawned by the level file */
+void snapshot_begin()
+{
+    snapshot_release();
+    darray_init(snapshot.entry);
+    snapshot.is_recording = true;
+}
+
+/* stops recording and saves the state of the freshly loaded level */
+void snapshot_end()
+{
+    if(!snapshot.is_recording)
+        return;
+
+    for(int i = 0; i < team_size; i++)
+        snapshot.player_name[i] = str_dup(team[i]->name);
+    snapshot.player_count = team_size;
+
+    snapshot.dialogregion_size = dialogregion_size;
+    memcpy(snapshot.dialogregion, dialogregion, dialogregion_size * sizeof(*dialogregion));
+
+    save_level_state(&snapshot.state);
+    snapshot.is_recording = false;
+    snapshot.is_valid = true;
+}
+
+/* discards the snapshot */
+void snapshot_release()
+{
+    if(snapshot.entry != NULL) {
+        for(int i = 0; i < darray_length(snapshot.entry); i++) {
+            if(snapshot.entry[i].name != NULL)
+                free(snapshot.entry[i].name);
+        }
+        darray_release(snapshot.entry);
+    }
+
+    for(int i = 0; i < snapshot.player_count; i++)
+        free(snapshot.player_name[i]);
+    snapshot.player_count = 0;
+
+    if(snapshot.stream != NULL) {
+        snapshot.stream = levelstream_destroy(snapshot.stream);
+        snapshot.instances = fasthash_destroy(snapshot.instances);
+        darray_release(snapshot.brick_column_bottom);
+    }
+
+    snapshot.dialogregion_size = 0;
+    clear_level_state(&snapshot.state);
+    snapshot.is_recording = false;
+    snapshot.is_valid = false;
+}
+
+/* records a brick of the level file */
+void snapshot_record_brick(int id, v2d_t position, bricklayer_t layer, brickflip_t flip)
+{
+    if(snapshot.is_recording) {
+        darray_push(snapshot.entry, ((snapshotentry_t){
+            .type = SNAPSHOT_BRICK,
+            .position = position,
+            .id = id,
+            .layer = layer,
+            .flip = flip
+        }));
+    }
+}
+
+/* records a legacy item of the level file */
+void snapshot_record_legacy_item(int type, v2d_t position)
+{
+    if(snapshot.is_recording) {
+        darray_push(snapshot.entry, ((snapshotentry_t){
+            .type = SNAPSHOT_LEGACY_ITEM,
+            .position = position,
+            .id = type
+        }));
+    }
+}
+
+/* records a legacy object of the level file */
+void snapshot_record_legacy_object(const char* name, v2d_t position)
+{
+    if(snapshot.is_recording) {
+        darray_push(snapshot.entry, ((snapshotentry_t){
+            .type = SNAPSHOT_LEGACY_OBJECT,
+            .position = position,
+            .name = str_dup(name)
+        }));
+    }
+}
+
+/* records a SurgeScript entity of the level file */
+void snapshot_record_entity(const char* name, v2d_t position, uint64_t entity_id, int spawned_in_the_editor)
+{
+    if(snapshot.is_recording) {
+        darray_push(snapshot.entry, ((snapshotentry_t){
+            .type = SNAPSHOT_ENTITY,
+            .position = position,
+            .name = str_dup(name),
+            .entity_id = entity_id,
+            .spawned_in_the_editor = spawned_in_the_editor
+        }));
+    }
+}
+
+/* spawns the entities of the level file in the order they were
+   recorded. Large levels are streamed: only the sections around
+   the camera are materialized (see update_stream()) */
+void snapshot_spawn()
+{
+    prefs_t* prefs = modmanager_prefs();
+    int threshold = prefs_has_item(prefs, ".streamingthreshold") ? prefs_get_int(prefs, ".streamingthreshold") : DEFAULT_STREAMING_THRESHOLD;
+    int count = darray_length(snapshot.entry);
+
+    for(int i = 0; i < count; i++) {
+        snapshot.entry[i].materialized = FALSE;
+        snapshot.entry[i].removed = FALSE;
+    }
+
+    /* small level: spawn everything */
+    if(snapshot.stream == NULL && (threshold <= 0 || count <= threshold)) {
+        for(int i = 0; i < count; i++)
+            snapshot_spawn_entry(i, NULL);
+        return;
+    }
+
+    /* large level: split it in sections */
+    if(snapshot.stream == NULL) {
+        logfile_message("Streaming %d entities of the level...", count);
+        snapshot.stream = levelstream_create(STREAM_SECTION_SIZE);
+        for(int i = 0; i < count; i++) {
+            /* bricks are added to all sections they overlap. The size of
+               the other entities is unknown until they're spawned: they
+               are added by their spawn point, and the margin around the
+               camera in update_stream() accounts for their extent */
+            const snapshotentry_t* entry = &snapshot.entry[i];
+            const image_t* image = (entry->type == SNAPSHOT_BRICK) ? brick_image_preview(entry->id) : NULL;
+            int width = (image != NULL) ? image_width(image) : 1;
+            int height = (image != NULL) ? image_height(image) : 1;
+            levelstream_add(snapshot.stream, i, (int)entry->position.x, (int)entry->position.y, width, height);
+        }
+        snapshot_compute_brick_bounds();
+        logfile_message("The level has been split in %d sections", levelstream_section_count(snapshot.stream));
+    }
+    else {
+        /* restarting the level: all instances are gone */
+        levelstream_reset(snapshot.stream);
+        fasthash_destroy(snapshot.instances);
+    }
+
+    /* materialize the sections around the spawn point */
+    snapshot.instances = fasthash_create(NULL, 10);
+    entitymanager_set_removal_listener(snapshot_on_remove_brick, snapshot_on_remove_item, snapshot_on_remove_object);
+    update_stream(spawn_point);
+}
+
+/* spawns an entry of the snapshot, unless it's already in the level */
+void snapshot_spawn_entry(int index, void* unused)
+{
+    snapshotentry_t* entry = &snapshot.entry[index];
+
+    if(entry->materialized || entry->removed)
+        return;
+
+    switch(entry->type) {
+        case SNAPSHOT_BRICK:
+            entry->instance.brick = level_create_brick(entry->id, entry->position, entry->layer, entry->flip);
+            snapshot_track_instance(entry->instance.brick, entry);
+            break;
+
+        case SNAPSHOT_LEGACY_ITEM:
+            entry->instance.item = level_create_legacy_item(entry->id, entry->position);
+            entry->spawn_animation = entry->instance.item->actor->animation;
+            snapshot_track_instance(entry->instance.item, entry);
+            break;
+
+        case SNAPSHOT_LEGACY_OBJECT:
+            entry->instance.object = level_create_legacy_object(entry->name, entry->position);
+            entry->instance.object->created_from_editor = TRUE;
+            snapshot_track_instance(entry->instance.object, entry);
+            break;
+
+        case SNAPSHOT_ENTITY: {
+            surgescript_object_t* object = spawn_ssobject(entry->name, entry->position, entry->spawned_in_the_editor);
+            ssobj_extradata_t* data = get_ssobj_extradata(object);
+            if(data != NULL)
+                data->entity_id = entry->entity_id;
+            entry->instance.handle = surgescript_object_handle(object);
+            break;
+        }
+    }
+
+    entry->materialized = TRUE;
+}
+
+/* evicts an entry of the snapshot from the level. Entities that have
+   been changed (moved away from their spawn points or left their initial
+   state, e.g., a crushed item box) or that are tagged "awake" or "detached"
+   are kept in the level; the ones that have been destroyed won't be
+   spawned again */
+void snapshot_evict_entry(int index, void* unused)
+{
+    snapshotentry_t* entry = &snapshot.entry[index];
+    bool is_alive = true, is_unchanged = false;
+
+    if(!entry->materialized)
+        return;
+
+    switch(entry->type) {
+        case SNAPSHOT_BRICK: {
+            brick_t* brick = entry->instance.brick;
+            is_alive = brick_is_alive(brick);
+            is_unchanged = v2d_magnitude(v2d_subtract(brick_position(brick), brick_spawnpoint(brick))) < 1.0f;
+            if(!is_alive || is_unchanged) {
+                snapshot_forget_instance(brick);
+                entitymanager_remove_brick(brick);
+            }
+            break;
+        }
+
+        case SNAPSHOT_LEGACY_ITEM: {
+            item_t* item = entry->instance.item;
+            is_alive = (item->state != IS_DEAD);
+            is_unchanged = !item->always_active &&
+                item->actor->animation == entry->spawn_animation && /* legacy items have no named states */
+                v2d_magnitude(v2d_subtract(item->actor->position, item->actor->spawn_point)) < 1.0f;
+            if(!is_alive || is_unchanged) {
+                snapshot_forget_instance(item);
+                entitymanager_remove_item(item);
+            }
+            break;
+        }
+
+        case SNAPSHOT_LEGACY_OBJECT: {
+            enemy_t* object = entry->instance.object;
+            is_alive = (object->state != ES_DEAD);
+            is_unchanged = !object->always_active &&
+                str_icmp(objectvm_get_current_state(object->vm), "main") == 0 &&
+                v2d_magnitude(v2d_subtract(object->actor->position, object->actor->spawn_point)) < 1.0f;
+            if(!is_alive || is_unchanged) {
+                snapshot_forget_instance(object);
+                entitymanager_remove_object(object);
+            }
+            break;
+        }
+
+        case SNAPSHOT_ENTITY: {
+            surgescript_objectmanager_t* manager = surgescript_vm_objectmanager(surgescript_vm());
+            surgescript_object_t* object = surgescript_objectmanager_exists(manager, entry->instance.handle) ? surgescript_objectmanager_get(manager, entry->instance.handle) : NULL;
+            ssobj_extradata_t* data = (object != NULL) ? get_ssobj_extradata(object) : NULL;
+
+            /* the handle may have been reused by another object */
+            is_alive = (data != NULL && data->entity_id == entry->entity_id && !surgescript_object_is_killed(object));
+            is_unchanged = is_alive &&
+                !surgescript_object_has_tag(object, "awake") &&
+                !surgescript_object_has_tag(object, "detached") &&
+                v2d_magnitude(v2d_subtract(scripting_util_world_position(object), data->spawn_point)) < 1.0f;
+            if(is_unchanged) {
+                /* the entity or any of its children left the "main" state */
+                bool changed = false;
+                surgescript_object_traverse_tree_ex(object, &changed, snapshot_find_changed_state);
+                is_unchanged = !changed;
+            }
+            if(is_unchanged) {
+                surgescript_object_kill(object);
+                clear_ssobj_extradata(object);
+            }
+            break;
+        }
+    }
+
+    if(!is_alive) {
+        entry->removed = TRUE;
+        entry->materialized = FALSE;
+    }
+    else if(is_unchanged)
+        entry->materialized = FALSE;
+}
+
+/* traversal callback: sets *changed if an object is not in its initial state */
+bool snapshot_find_changed_state(surgescript_object_t* object, void* changed)
+{
+    if(strcmp(surgescript_object_state(object), "main") != 0)
+        *((bool*)changed) = true;
+
+    return !*((bool*)changed);
+}
+
+/* materializes the whole level and stops streaming it */
+void snapshot_stop_streaming()
+{
+    if(snapshot.stream != NULL) {
+        logfile_message("Materializing the whole level...");
+        levelstream_materialize_all(snapshot.stream, NULL, snapshot_spawn_entry);
+        entitymanager_set_removal_listener(NULL, NULL, NULL);
+        snapshot.stream = levelstream_destroy(snapshot.stream);
+        snapshot.instances = fasthash_destroy(snapshot.instances);
+        darray_release(snapshot.brick_column_bottom);
+        update_level_size();
+    }
+}
+
+/* computes the bounds of the bricks of the level file, as
+   the entity manager would if all of them were in the level */
+void snapshot_compute_brick_bounds()
+{
+    snapshot.has_bricks = FALSE;
+    snapshot.bricks_right = snapshot.bricks_bottom = -LARGE_INT;
+    darray_init(snapshot.brick_column_bottom);
+
+    for(int i = 0; i < darray_length(snapshot.entry); i++) {
+        const snapshotentry_t* entry = &snapshot.entry[i];
+        const image_t* image;
+        int left, right, bottom, first, last;
+
+        if(entry->type != SNAPSHOT_BRICK || (image = brick_image_preview(entry->id)) == NULL)
+            continue;
+
+        left = (int)entry->position.x;
+        right = left + image_width(image);
+        bottom = (int)entry->position.y + image_height(image);
+        snapshot.bricks_right = max(snapshot.bricks_right, right);
+        snapshot.bricks_bottom = max(snapshot.bricks_bottom, bottom);
+        snapshot.has_bricks = TRUE;
+
+        /* columns of the unmoving bricks */
+        if(brick_behavior_preview(entry->id) != BRB_CIRCULAR && entitymanager_get_brick_columns(left, right, &first, &last)) {
+            while(darray_length(snapshot.brick_column_bottom) <= last)
+                darray_push(snapshot.brick_column_bottom, -LARGE_INT);
+            for(int j = first; j <= last; j++)
+                snapshot.brick_column_bottom[j] = max(snapshot.brick_column_bottom[j], bottom);
+        }
+    }
+}
+
+/* bottom-right corner of the bricks of the level file */
+int snapshot_get_brick_bounds(int* right, int* bottom)
+{
+    *right = snapshot.bricks_right;
+    *bottom = snapshot.bricks_bottom;
+    return snapshot.has_bricks;
+}
+
+/* largest y of the unmoving bricks of the level file near the given column */
+int snapshot_get_brick_column_bottom(int column, int* bottom)
+{
+    if(column < 0 || column >= darray_length(snapshot.brick_column_bottom))
+        return FALSE;
+
+    *bottom = snapshot.brick_column_bottom[column];
+    return *bottom > -LARGE_INT;
+}
+
+/* keeps track of an instance of a streamed entry */
+void snapshot_track_instance(const void* instance, snapshotentry_t* entry)
+{
+    if(snapshot.instances != NULL)
+        fasthash_put(snapshot.instances, (uint64_t)(uintptr_t)instance, entry);
+}
+
+/* stops keeping track of an instance that is about to be destroyed */
+void snapshot_forget_instance(const void* instance)
+{
+    if(snapshot.instances != NULL)
+        fasthash_delete(snapshot.instances, (uint64_t)(uintptr_t)instance);
+}
+
+/* a dead instance is about to be destroyed by the entity manager.
+   Its entry is marked as removed, so that it won't be spawned again */
+void snapshot_remove_instance(const void* instance)
+{
+    snapshotentry_t* entry;
+
+    if(snapshot.instances != NULL && (entry = fasthash_get(snapshot.instances, (uint64_t)(uintptr_t)instance)) != NULL) {
+        entry->removed = TRUE;
+        entry->materialized = FALSE;
+        snapshot_forget_instance(instance);
+    }
+}
+
+/* the entity manager is removing a dead brick */
+void snapshot_on_remove_brick(brick_t* brick)
+{
+    snapshot_remove_instance(brick);
+}
+
+/* the entity manager is removing a dead legacy item */
+void snapshot_on_remove_item(item_t* item)
+{
+    snapshot_remove_instance(item);
+}
+
+/* the entity manager is removing a dead legacy object */
+void snapshot_on_remove_object(enemy_t* object)
+{
+    snapshot_remove_instance(object);
+}
+
+/* materializes the sections of a streamed level around the camera
+   and evicts the ones far away. The surroundings of the player are
+   materialized as well, since the camera may lag behind it */
+void update_stream(v2d_t camera)
+{
+    if(snapshot.stream != NULL) {
+        v2d_t focus = (player != NULL) ? player->actor->position : camera;
+        int left = (int)min(camera.x, focus.x), right = (int)max(camera.x, focus.x);
+        int top = (int)min(camera.y, focus.y), bottom = (int)max(camera.y, focus.y);
+
+        levelstream_update(
+            snapshot.stream,
+            left - VIDEO_SCREEN_W/2 - 2*DEFAULT_MARGIN,
+            top - VIDEO_SCREEN_H/2 - 2*DEFAULT_MARGIN,
+            (right - left) + VIDEO_SCREEN_W + 4*DEFAULT_MARGIN,
+            (bottom - top) + VIDEO_SCREEN_H + 4*DEFAULT_MARGIN,
+            NULL,
+            snapshot_spawn_entry,
+            snapshot_evict_entry
+        );
+    }
+}
+
+/* restarts the level from its snapshot, keeping the brickset, the
+   background, the music and the other assets. The level file isn't
+   read again. Returns false if the snapshot can't be used */
+bool restart_in_place()
+{
+    if(!snapshot.is_valid || is_loading || editor_is_enabled())
+        return false;
+
+    logfile_message("Restarting level \"%s\" in place...", file);
+
+    /* scripting: unloading the Level... */
+    if(surgescript_vm_is_active(surgescript_vm()))
+        surgescript_object_call_function(scripting_util_surgeengine_component(surgescript_vm(), "LevelManager"), "onLevelUnload", NULL, 0, NULL);
+    ssobj_extradata = fasthash_destroy(ssobj_extradata);
+    cached_level_ssobject = NULL;
+
+    /* destroy the entities & the players */
+    entitymanager_release();
+    for(int i = 0; i < team_size; i++)
+        player_destroy(team[i]);
+    team_size = 0;
+    player = NULL;
+
+    /* reset the scene */
+    level_timer = 0.0f;
+    override_music = NULL;
+    block_music = FALSE;
+    quit_level = FALSE;
+    dead_player_timeout = 0.0f;
+    level_cleared = FALSE;
+    jump_to_next_stage = FALSE;
+    dlgbox_active = FALSE;
+    dlgbox->position.y = VIDEO_SCREEN_H;
+    clear_bricklike_ssobjects();
+    particle_release();
+    particle_init();
+    camera_release();
+    music_stop();
+
+    /* restore the attributes of the level */
+    restore_level_state(&snapshot.state);
+    dialogregion_size = snapshot.dialogregion_size;
+    memcpy(dialogregion, snapshot.dialogregion, dialogregion_size * sizeof(*dialogregion));
+
+    /* scripting: preparing a new Level... */
+    ssobj_extradata = fasthash_create(free_ssobj_extradata, 15);
+    surgescript_object_call_function(scripting_util_surgeengine_component(surgescript_vm(), "LevelManager"), "onLevelLoad", NULL, 0, NULL);
+
+    /* respawn the entities of the level file */
+    entitymanager_init();
+    snapshot_spawn();
+    update_level_size();
+
+    /* players */
+    for(int i = 0; i < snapshot.player_count; i++)
+        team[team_size++] = player_create(snapshot.player_name[i]);
+    level_change_player(team[0]);
+    spawn_players();
+    camera_init();
+    camera_set_position(player->actor->position);
+    player_set_collectibles(0);
+    surgescript_object_call_function(scripting_util_surgeengine_component(surgescript_vm(), "Player"), "__spawnPlayers", NULL, 0, NULL);
+
+    /* setup objects */
+    spawn_setup_objects();
+
+    /* done! */
+    logfile_message("The level has been restarted.");
+    return true;
+}
+
+
 /* scripting */
 
 /* update surgescript */
@@ -2805,6 +3732,28 @@ bool ssobject_exists(const char* object_name)
     return surgescript_programpool_is_compiled(pool, object_name);
 }
 
+/* is the specified object an entity? */
+bool ssobject_is_entity(const char* object_name)
+{
+    surgescript_vm_t* vm = surgescript_vm();
+    surgescript_tagsystem_t* tag_system = surgescript_vm_tagsystem(vm);
+    return surgescript_tagsystem_has_tag(tag_system, object_name, "entity");
+}
+
+/* is the specified object an entity that can be placed in the editor? */
+bool ssobject_is_editable(const char* object_name)
+{
+    /* note: objects not spawned with level_create_object()
+       (e.g., via scripting) will not have this flag set to true */
+    surgescript_vm_t* vm = surgescript_vm();
+    surgescript_tagsystem_t* tag_system = surgescript_vm_tagsystem(vm);
+    return
+        surgescript_tagsystem_has_tag(tag_system, object_name, "entity") &&
+        !surgescript_tagsystem_has_tag(tag_system, object_name, "private") &&
+        !is_setup_object(object_name)
+    ;
+}
+
 /* get the Level object (SurgeScript) */
 surgescript_object_t* level_ssobject()
 {
@@ -2848,7 +3797,7 @@ surgescript_object_t* spawn_ssobject(const char* object_name, v2d_t spawn_point,
             /* sanity check for entities */
             if(surgescript_object_has_tag(object, "detached") && !surgescript_object_has_tag(object, "private")) {
                 surgescript_tagsystem_t* tag_system = surgescript_vm_tagsystem(vm);
-                logfile_message("WARNING: object \"%s\" is tagged as detached, but not private. Fixing...");
+                logfile_warning("WARNING: object \"%s\" is tagged as detached, but not private. Fixing...", object_name);
                 surgescript_tagsystem_add_tag(tag_system, object_name, "private");
             }
         }
@@ -2952,6 +3901,7 @@ void editor_init()
     while(editor_item_list[++editor_item_list_size] >= 0);
     editor_cursor_entity_type = EDT_BRICK;
     editor_cursor_entity_id = 0;
+    editor_ssobj_spatial_index = NULL;
     /*editor_previous_video_resolution = video_get_resolution();
     editor_previous_video_smooth = video_is_smooth();*/
     editor_enemy_name = objects_get_list_of_names(&editor_enemy_name_length);
@@ -2996,6 +3946,7 @@ void editor_release()
     editorgrp_release();
 
     /* SurgeScript entities */
+    editor_ssobj_index_release();
     editor_ssobj_release();
 
     /* bricks */
@@ -3329,8 +4280,7 @@ void editor_update()
 
             /* SurgeScript entity */
             case EDT_SSOBJ: {
-                surgescript_object_t* ssobject = NULL;
-                surgescript_object_traverse_tree_ex(level_ssobject(), &ssobject, editor_pick_ssobj);
+                surgescript_object_t* ssobject = editor_ssobj_at_cursor();
                 if(ssobject != NULL) {
                     int index = editor_ssobj_index(surgescript_object_name(ssobject));
                     if(!pick_object) {
@@ -3470,6 +4420,9 @@ void editor_enable()
 {
     logfile_message("Entering the level editor");
 
+    /* the whole level must be in memory */
+    snapshot_stop_streaming();
+
     /* activating the editor */
     editor_action_init();
     editor_enabled = TRUE;
@@ -3482,6 +4435,12 @@ void editor_enable()
     editor_previous_video_resolution = video_get_resolution();
     editor_previous_video_smooth = video_is_smooth();
     video_changemode(VIDEORESOLUTION_EDT, FALSE, video_is_fullscreen());
+
+    /* indexing the entities */
+    editor_ssobj_index_init();
+
+    /* the level may be modified; restart it from its file */
+    snapshot_release();
 }
 
 
@@ -3495,6 +4454,7 @@ void editor_disable()
 
     /* disabling the level editor */
     editor_action_release();
+    editor_ssobj_index_release();
     editor_enabled = FALSE;
 
     /* notify the SurgeScript entities */
@@ -4322,18 +5282,8 @@ void editor_tooltip_update()
 {
     font_set_visible(editor_tooltip_font, false);
     if(editor_cursor_entity_type == EDT_SSOBJ) {
-        surgescript_object_t* target = NULL;
-        surgescript_object_t* level = level_ssobject();
-        surgescript_objectmanager_t* manager = surgescript_object_manager(level);
-        int n = surgescript_object_child_count(level);
-
         /* locate a target (onmouseover) */
-        for(int i = 0; i < n; i++) {
-            surgescript_objecthandle_t handle = surgescript_object_nth_child(level, i);
-            surgescript_object_t* child = surgescript_objectmanager_get(manager, handle);
-            if(get_ssobj_extradata(child) != NULL)
-                editor_pick_ssobj(child, &target);
-        }
+        surgescript_object_t* target = editor_ssobj_at_cursor();
 
         /* found a target */
         if(target != NULL && !surgescript_object_is_killed(target)) {
@@ -4724,6 +5674,10 @@ void editor_action_commit(editor_action_t action)
                 }
                 editor_ssobj_picked_entity.id = 0;
                 editor_ssobj_picked_entity.name[0] = '\0';
+
+                /* index the new entity */
+                if(ssobj != NULL)
+                    editor_ssobj_index_add(ssobj);
                 break;
             }
 
@@ -4838,6 +5792,7 @@ bool editor_remove_ssobj(surgescript_object_t* object, void* data)
             if(editor_ssobj_index(object_name) == action->obj_id) {
                 v2d_t delta = v2d_subtract(scripting_util_world_position(object), action->obj_position);
                 if(nearly_equal(v2d_magnitude(delta), 0.0f)) {
+                    editor_ssobj_index_remove(object);
                     surgescript_object_kill(object);
                     clear_ssobj_extradata(object);
                 }
@@ -4859,15 +5814,7 @@ bool editor_pick_ssobj(surgescript_object_t* object, void* data)
             float b[4] = { editor_cursor.x + topleft.x , editor_cursor.y + topleft.y , editor_cursor.x + topleft.x , editor_cursor.y + topleft.y };
 
             /* find the bounding box of the entity */
-            const char* name = surgescript_object_name(object);
-            const animation_t* anim = sprite_animation_exists(name, 0) ? sprite_get_animation(name, 0) : sprite_get_animation(NULL, 0);
-            const image_t* img = sprite_get_image(anim, 0);
-            v2d_t worldpos = scripting_util_world_position(object);
-            v2d_t hot_spot = anim->hot_spot;
-            a[0] = worldpos.x - hot_spot.x;
-            a[1] = worldpos.y - hot_spot.y;
-            a[2] = a[0] + image_width(img);
-            a[3] = a[1] + image_height(img);
+            editor_ssobj_bounding_box(object, a);
 
             /* got collision between the cursor and the entity */
             if(bounding_box(a, b)) {
@@ -4883,6 +5830,88 @@ bool editor_pick_ssobj(surgescript_object_t* object, void* data)
         return false;
 }
 
+/* the bounding box of an entity, as displayed in the editor */
+void editor_ssobj_bounding_box(surgescript_object_t* object, float box[4])
+{
+    const char* name = surgescript_object_name(object);
+    const animation_t* anim = sprite_animation_exists(name, 0) ? sprite_get_animation(name, 0) : sprite_get_animation(NULL, 0);
+    const image_t* img = sprite_get_image(anim, 0);
+    v2d_t worldpos = scripting_util_world_position(object);
+    v2d_t hot_spot = anim->hot_spot;
+
+    box[0] = worldpos.x - hot_spot.x;
+    box[1] = worldpos.y - hot_spot.y;
+    box[2] = box[0] + image_width(img);
+    box[3] = box[1] + image_height(img);
+}
+
+
+
+/* editor: spatial index of the SurgeScript entities
+   (the entities don't move while the editor is enabled) */
+void editor_ssobj_index_init()
+{
+    editor_ssobj_spatial_index = editorindex_create(level_width, level_height);
+    surgescript_object_traverse_tree_ex(level_ssobject(), NULL, editor_ssobj_index_add_tree);
+    logfile_message("The level editor has indexed %d entities", editorindex_count(editor_ssobj_spatial_index));
+}
+
+void editor_ssobj_index_release()
+{
+    if(editor_ssobj_spatial_index != NULL)
+        editor_ssobj_spatial_index = editorindex_destroy(editor_ssobj_spatial_index);
+}
+
+void editor_ssobj_index_add(surgescript_object_t* object)
+{
+    if(editor_ssobj_spatial_index != NULL && is_ssobj_spawned_in_the_editor(object)) {
+        float box[4];
+        editor_ssobj_bounding_box(object, box);
+        editorindex_add(editor_ssobj_spatial_index, surgescript_object_handle(object), (int)box[0], (int)box[1], (int)ceilf(box[2] - box[0]), (int)ceilf(box[3] - box[1]));
+    }
+}
+
+bool editor_ssobj_index_add_tree(surgescript_object_t* object, void* data)
+{
+    if(surgescript_object_is_active(object)) {
+        editor_ssobj_index_add(object);
+        return true;
+    }
+    else
+        return false;
+}
+
+void editor_ssobj_index_remove(surgescript_object_t* object)
+{
+    if(editor_ssobj_spatial_index != NULL)
+        editorindex_remove(editor_ssobj_spatial_index, surgescript_object_handle(object));
+}
+
+/* the entity under the cursor, or NULL if there is none */
+surgescript_object_t* editor_ssobj_at_cursor()
+{
+    v2d_t topleft = v2d_subtract(editor_camera, v2d_new(VIDEO_SCREEN_W/2, VIDEO_SCREEN_H/2));
+    v2d_t position = v2d_add(editor_cursor, topleft);
+    surgescript_object_t* result = NULL;
+
+    if(editor_ssobj_spatial_index != NULL)
+        editorindex_query(editor_ssobj_spatial_index, (int)position.x - 1, (int)position.y - 1, 2, 2, &result, editor_ssobj_at_cursor_candidate);
+
+    return result;
+}
+
+void editor_ssobj_at_cursor_candidate(uint64_t handle, void* data)
+{
+    surgescript_objectmanager_t* manager = surgescript_vm_objectmanager(surgescript_vm());
+
+    /* the entity may have been deleted by a script */
+    if(surgescript_objectmanager_exists(manager, (surgescript_objecthandle_t)handle)) {
+        surgescript_object_t* object = surgescript_objectmanager_get(manager, (surgescript_objecthandle_t)handle);
+        if(!surgescript_object_is_killed(object))
+            editor_pick_ssobj(object, data);
+    }
+}
+
 
 
 /* extradata: extra metadata for SurgeScript objects */
@@ -38,7 +38,6 @@
 #include "../core/lang.h"
 #include "../core/input.h"
 #include "../core/timer.h"
-#include "../core/nanoparser/nanoparser.h"
 #include "../core/font.h"
 #include "../entities/actor.h"
 #include "../entities/background.h"
@@ -46,6 +45,7 @@
 #include "../entities/sfx.h"
 #include "../entities/legacy/nanocalc/nanocalc.h"
 #include "../entities/legacy/nanocalc/nanocalc_addons.h"
+#include "util/stageindex.h"
 
 
 
@@ -57,9 +57,8 @@ typedef struct {
     int requires[3]; /* required version */
 } stagedata_t;
 
-static stagedata_t* stagedata_load(const char *filename);
+static stagedata_t* stagedata_load(const char *filename, stageindex_t *index);
 static void stagedata_unload(stagedata_t *s);
-static int traverse(const parsetree_statement_t *stmt, void *stagedata);
 
 
 
@@ -308,6 +307,7 @@ void stageselect_render()
 /* loads the stage list from the level/ folder */
 void load_stage_list()
 {
+    stageindex_t *index;
     int i;
 
     video_display_loading_screen();
@@ -315,7 +315,9 @@ void load_stage_list()
 
     /* loading data */
     stage_count = 0;
-    assetfs_foreach_file("levels", ".lev", dirfill, NULL, enable_debug);
+    index = stageindex_load();
+    assetfs_foreach_file("levels", ".lev", dirfill, index, enable_debug);
+    index = stageindex_unload(index);
     qsort(stage_data, stage_count, sizeof(stagedata_t*), sort_cmp);
 
     /* fatal error */
@@ -361,7 +363,7 @@ int dirfill(const char *vpath, void *param)
     if(stage_count >= STAGE_MAX)
         return 0;
 
-    s = stagedata_load(vpath);
+    s = stagedata_load(vpath, (stageindex_t*)param);
     if(s != NULL) {
         ver = s->requires[0];
         subver = s->requires[1];
@@ -402,26 +404,26 @@ int sort_cmp(const void *a, const void *b)
 
 
 /* stagedata_t constructor. Returns NULL if filename is not a level. */
-stagedata_t* stagedata_load(const char *filename)
+stagedata_t* stagedata_load(const char *filename, stageindex_t *index)
 {
-    parsetree_program_t *prog;
-    stagedata_t* s = mallocx(sizeof *s);
-    const char* fullpath = assetfs_fullpath(filename);
+    stagedata_t* s;
+    stageinfo_t info;
     char* p;
 
+    /* the header of the level comes from the stage index */
+    if(!stageindex_get(index, filename, &info))
+        return NULL;
+
+    s = mallocx(sizeof *s);
     s->filepath = str_dup(filename);
     while((p = strchr(s->filepath, '\\')))
         *p = '/'; /* replace '\\' by '/' */
 
-    str_cpy(s->name, "Untitled", sizeof(s->name));
-    s->act = 1;
-    s->requires[0] = 0;
-    s->requires[1] = 0;
-    s->requires[2] = 0;
-
-    prog = nanoparser_construct_tree(fullpath);
-    nanoparser_traverse_program_ex(prog, (void*)s, traverse);
-    prog = nanoparser_deconstruct_tree(prog);
+    str_cpy(s->name, info.name, sizeof(s->name));
+    s->act = info.act;
+    s->requires[0] = info.requires[0];
+    s->requires[1] = info.requires[1];
+    s->requires[2] = info.requires[2];
 
     return s;
 }
@@ -432,23 +434,3 @@ void stagedata_unload(stagedata_t *s)
     free(s->filepath);
     free(s);
 }
-
-/* traverses a line of the level */
-int traverse(const parsetree_statement_t *stmt, void *stagedata)
-{
-    stagedata_t *s = (stagedata_t*)stagedata;
-    const char *id = nanoparser_get_identifier(stmt);
-    const parsetree_parameter_t *param_list = nanoparser_get_parameter_list(stmt);
-    const char *val = nanoparser_get_string(nanoparser_get_nth_parameter(param_list, 1));
-
-    if(str_icmp(id, "name") == 0)
-        str_cpy(s->name, val, sizeof(s->name));
-    else if(str_icmp(id, "act") == 0)
-        s->act = atoi(val);
-    else if(str_icmp(id, "requires") == 0)
-        sscanf(val, "%d.%d.%d", &(s->requires[0]), &(s->requires[1]), &(s->requires[2]));
-    else if(str_icmp(id, "brick") == 0) /* optimization */
-        return 1; /* stop the enumeration */
-
-    return 0;
-}
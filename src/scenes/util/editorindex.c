@@ -0,0 +1,187 @@
+/*
+ * Open Surge Engine
+ * editorindex.c - level editor: spatial index of entities
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "editorindex.h"
+#include "../../core/spatialhash.h"
+#include "../../core/util.h"
+
+#define FASTHASH_INLINE
+#include "../../core/fasthash.h"
+
+/* an entry of the index */
+typedef struct editorindex_entry_t editorindex_entry_t;
+struct editorindex_entry_t {
+    uint64_t key;
+    int x, y, width, height; /* bounding box */
+};
+
+/* the index */
+SPATIALHASH_GENERATE_CODE(editorindex_entry_t)
+
+struct editorindex_t {
+    spatialhash_editorindex_entry_t* grid; /* owns the entries */
+    fasthash_t* entries; /* key -> entry */
+    int count;
+};
+
+/* private stuff */
+struct query_t {
+    int x, y, width, height;
+    void* data;
+    void (*callback)(uint64_t,void*);
+};
+
+static editorindex_entry_t* destroy_entry(editorindex_entry_t* entry);
+static int entry_xpos(const editorindex_entry_t* entry);
+static int entry_ypos(const editorindex_entry_t* entry);
+static int entry_width(const editorindex_entry_t* entry);
+static int entry_height(const editorindex_entry_t* entry);
+static int visit_entry(editorindex_entry_t* entry, void* query);
+
+
+
+/* public API */
+
+/*
+ * editorindex_create()
+ * Creates a new index for a world of the given size
+ */
+editorindex_t* editorindex_create(int world_width, int world_height)
+{
+    editorindex_t* index = mallocx(sizeof *index);
+
+    index->grid = spatialhash_editorindex_entry_t_create_ex(destroy_entry, entry_xpos, entry_ypos, entry_width, entry_height, max(1, world_width), max(1, world_height));
+    index->entries = fasthash_create(NULL, 10);
+    index->count = 0;
+
+    return index;
+}
+
+/*
+ * editorindex_destroy()
+ * Destroys an index
+ */
+editorindex_t* editorindex_destroy(editorindex_t* index)
+{
+    index->entries = fasthash_destroy(index->entries);
+    index->grid = spatialhash_editorindex_entry_t_destroy(index->grid);
+    free(index);
+    return NULL;
+}
+
+/*
+ * editorindex_add()
+ * Adds an entry to the index. If the key is already
+ * in the index, its bounding box is updated
+ */
+void editorindex_add(editorindex_t* index, uint64_t key, int x, int y, int width, int height)
+{
+    editorindex_entry_t* entry;
+
+    editorindex_remove(index, key);
+
+    entry = mallocx(sizeof *entry);
+    entry->key = key;
+    entry->x = x;
+    entry->y = y;
+    entry->width = max(0, width);
+    entry->height = max(0, height);
+
+    spatialhash_editorindex_entry_t_add(index->grid, entry);
+    fasthash_put(index->entries, key, entry);
+    index->count++;
+}
+
+/*
+ * editorindex_remove()
+ * Removes an entry from the index
+ */
+void editorindex_remove(editorindex_t* index, uint64_t key)
+{
+    editorindex_entry_t* entry = fasthash_get(index->entries, key);
+
+    if(entry != NULL) {
+        fasthash_delete(index->entries, key);
+        spatialhash_editorindex_entry_t_remove(index->grid, entry); /* frees the entry */
+        index->count--;
+    }
+}
+
+/*
+ * editorindex_query()
+ * Calls callback(key, data) for each entry whose
+ * bounding box touches the given rectangle
+ */
+void editorindex_query(editorindex_t* index, int x, int y, int width, int height, void* data, void (*callback)(uint64_t,void*))
+{
+    struct query_t query = { x, y, width, height, data, callback };
+    spatialhash_editorindex_entry_t_foreach(index->grid, x, y, max(1, width), max(1, height), &query, visit_entry);
+}
+
+/*
+ * editorindex_count()
+ * The number of entries of the index
+ */
+int editorindex_count(const editorindex_t* index)
+{
+    return index->count;
+}
+
+
+
+/* private */
+
+editorindex_entry_t* destroy_entry(editorindex_entry_t* entry)
+{
+    free(entry);
+    return NULL;
+}
+
+int entry_xpos(const editorindex_entry_t* entry)
+{
+    return entry->x;
+}
+
+int entry_ypos(const editorindex_entry_t* entry)
+{
+    return entry->y;
+}
+
+int entry_width(const editorindex_entry_t* entry)
+{
+    return entry->width;
+}
+
+int entry_height(const editorindex_entry_t* entry)
+{
+    return entry->height;
+}
+
+/* the spatial hash enlarges the query rectangle; test the bounding boxes exactly */
+int visit_entry(editorindex_entry_t* entry, void* query)
+{
+    struct query_t* q = (struct query_t*)query;
+
+    if(entry->x <= q->x + q->width && entry->x + entry->width >= q->x &&
+       entry->y <= q->y + q->height && entry->y + entry->height >= q->y)
+        q->callback(entry->key, q->data);
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * Open Surge Engine
+ * editorindex.h - level editor: spatial index of entities
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EDITORINDEX_H
+#define _EDITORINDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+   The editor index is a spatial index of the entities
+   placed in the level editor, keyed by an id and by their
+   bounding boxes. It lets the editor pick the entity under
+   the cursor without traversing the whole level.
+*/
+
+typedef struct editorindex_t editorindex_t;
+
+editorindex_t* editorindex_create(int world_width, int world_height); /* creates a new index */
+editorindex_t* editorindex_destroy(editorindex_t* index); /* destroys an index */
+void editorindex_add(editorindex_t* index, uint64_t key, int x, int y, int width, int height); /* adds (or moves) an entry */
+void editorindex_remove(editorindex_t* index, uint64_t key); /* removes an entry, if it exists */
+void editorindex_query(editorindex_t* index, int x, int y, int width, int height, void* data, void (*callback)(uint64_t,void*)); /* calls callback(key, data) for the entries near the given rectangle */
+int editorindex_count(const editorindex_t* index); /* number of entries */
+
+#endif
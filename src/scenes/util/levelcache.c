@@ -0,0 +1,565 @@
+/*
+ * Open Surge Engine
+ * levelcache.c - compiled levels
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include "levelcache.h"
+#include "../../core/assetfs.h"
+#include "../../core/stringutil.h"
+#include "../../core/logfile.h"
+#include "../../core/global.h"
+#include "../../core/darray.h"
+#include "../../core/util.h"
+
+/* OS-specific includes */
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define LEVELCACHE_MMAP
+#endif
+
+/*
+   compiled level file format (little-endian):
+
+   header:      magic[8] | format u32 | engine version u32 | source hash u64 |
+                command count u32 | param count u32 | string table size u32
+   commands:    { fileline u32 | identifier u32 | param count u32 | first param u32 } x command count
+   params:      string offset u32 x param count
+   strings:     null-terminated strings, without duplicates
+*/
+#define LEVELCACHE_MAGIC        "SURGELVC"
+#define LEVELCACHE_FORMAT       1 /* increment whenever the format changes */
+#define LEVELCACHE_DIR          "levelcache/" /* in the cache of the assetfs */
+#define HEADER_SIZE             36
+#define COMMAND_SIZE            16
+#define PARAM_SIZE              4
+#define MAX_PARAMS              16 /* the level loader reads up to 16 parameters per line */
+#define LINE_MAXLENGTH          1024
+
+/* a compiled level */
+struct levelcache_t {
+    char* filename; /* absolute path of the .lev file (for error messages) */
+    const uint8_t* data; /* contents of the compiled file */
+    size_t size; /* size of data, in bytes */
+    bool mapped; /* is data memory-mapped? */
+    uint32_t command_count;
+    const uint8_t* commands;
+    const uint8_t* params;
+    const char* strings;
+};
+
+/* a level compiler */
+typedef struct levelcache_compiler_t levelcache_compiler_t;
+struct levelcache_compiler_t {
+    uint64_t source_hash; /* hash of the .lev file */
+    DARRAY(uint32_t, commands); /* 4 words per command */
+    DARRAY(uint32_t, params); /* string offsets */
+    DARRAY(char, strings); /* string table */
+    uint32_t* table; /* interned strings: offset + 1, or 0 if the slot is empty */
+    size_t table_cap, table_count;
+};
+
+/* private stuff */
+static char* cache_vpath(const char* filepath);
+static bool map_file(const char* fullpath, levelcache_t* cache);
+static void unmap_file(levelcache_t* cache);
+static bool validate(levelcache_t* cache, uint64_t source_hash);
+static bool compile(const char* fullpath, uint64_t source_hash, levelcache_t* cache);
+static void save(const levelcache_t* cache, const char* cache_fullpath);
+static levelcache_compiler_t* create_compiler(uint64_t source_hash);
+static levelcache_compiler_t* destroy_compiler(levelcache_compiler_t* compiler);
+static void compile_line(levelcache_compiler_t* compiler, int fileline, const char* line);
+static void add_command(levelcache_compiler_t* compiler, int fileline, const char* identifier, int param_count, const char** param);
+static uint8_t* serialize(const levelcache_compiler_t* compiler, size_t* size);
+static uint32_t intern(levelcache_compiler_t* compiler, const char* str);
+static void grow_table(levelcache_compiler_t* compiler);
+static inline uint32_t hash_str(const char* str);
+
+
+
+/* public API */
+
+/*
+ * levelcache_fullpath()
+ * The absolute path of the compiled version of a .lev file,
+ * given its relative path. The assetfs isn't thread-safe, so
+ * this must be called on the main thread
+ */
+const char* levelcache_fullpath(const char* filepath)
+{
+    char* vpath = cache_vpath(filepath);
+    const char* fullpath = assetfs_create_cache_file(vpath);
+
+    free(vpath);
+    return fullpath;
+}
+
+/*
+ * levelcache_load()
+ * Reads the compiled version of a .lev file, given the absolute
+ * paths of both. If it's missing or out of date, the .lev file is
+ * compiled and the result is written to cache_fullpath. Returns
+ * NULL if the .lev file can't be read. This may run on any thread
+ */
+levelcache_t* levelcache_load(const char* fullpath, const char* cache_fullpath)
+{
+    levelcache_t* cache;
+    uint64_t source_hash;
+
+    if(!hash_file(fullpath, &source_hash))
+        return NULL;
+
+    cache = mallocx(sizeof *cache);
+    cache->filename = str_dup(fullpath);
+    cache->data = NULL;
+    cache->size = 0;
+    cache->mapped = false;
+
+    /* is there an up-to-date compiled level? */
+    if(map_file(cache_fullpath, cache)) {
+        if(validate(cache, source_hash)) {
+            logfile_debug("Using compiled level \"%s\"", cache_fullpath);
+            return cache;
+        }
+
+        logfile_debug("Compiled level \"%s\" is out of date", cache_fullpath);
+        unmap_file(cache);
+    }
+
+    /* compile the .lev file */
+    if(!compile(fullpath, source_hash, cache))
+        return levelcache_close(cache);
+
+    save(cache, cache_fullpath);
+    return cache;
+}
+
+/*
+ * levelcache_close()
+ * Closes a compiled level
+ */
+levelcache_t* levelcache_close(levelcache_t* cache)
+{
+    unmap_file(cache);
+    free(cache->filename);
+    free(cache);
+    return NULL;
+}
+
+/*
+ * levelcache_foreach_command()
+ * Calls callback for each command of the compiled level, in the
+ * same order they appear in the .lev file. The strings passed to
+ * callback point to the compiled file and must not be modified
+ */
+void levelcache_foreach_command(const levelcache_t* cache, levelcache_callback_t callback)
+{
+    const char* param[MAX_PARAMS];
+
+    for(uint32_t i = 0; i < cache->command_count; i++) {
+        const uint8_t* command = cache->commands + i * COMMAND_SIZE;
+        int fileline = (int)le32_to_cpu(command);
+        const char* identifier = cache->strings + le32_to_cpu(command + 4);
+        uint32_t param_count = le32_to_cpu(command + 8);
+        const uint8_t* first_param = cache->params + le32_to_cpu(command + 12) * PARAM_SIZE;
+
+        for(uint32_t j = 0; j < param_count; j++)
+            param[j] = cache->strings + le32_to_cpu(first_param + j * PARAM_SIZE);
+
+        callback(cache->filename, fileline, identifier, (int)param_count, param);
+    }
+}
+
+/* private */
+
+/* the virtual path of the compiled version of a .lev file */
+char* cache_vpath(const char* filepath)
+{
+    char* vpath = mallocx((strlen(LEVELCACHE_DIR) + strlen(filepath) + 5) * sizeof(*vpath));
+    return strcat(strcat(strcpy(vpath, LEVELCACHE_DIR), filepath), ".bin");
+}
+
+/* maps a compiled file into memory (or reads it, if mmap isn't available) */
+bool map_file(const char* fullpath, levelcache_t* cache)
+{
+#if defined(LEVELCACHE_MMAP)
+    struct stat st;
+    void* data;
+    int fd;
+
+    if((fd = open(fullpath, O_RDONLY)) < 0)
+        return false;
+
+    if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); /* the mapping stays valid */
+    if(data == MAP_FAILED)
+        return false;
+
+    cache->data = (const uint8_t*)data;
+    cache->size = (size_t)st.st_size;
+    cache->mapped = true;
+    return true;
+#else
+    uint8_t* data;
+    long size;
+    FILE* fp;
+
+    if(NULL == (fp = fopen(fullpath, "rb")))
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+    if(size <= 0) {
+        fclose(fp);
+        return false;
+    }
+
+    data = mallocx(size);
+    if(1 != fread(data, size, 1, fp)) {
+        fclose(fp);
+        free(data);
+        return false;
+    }
+
+    fclose(fp);
+    cache->data = data;
+    cache->size = (size_t)size;
+    cache->mapped = false;
+    return true;
+#endif
+}
+
+/* releases the contents of a compiled file */
+void unmap_file(levelcache_t* cache)
+{
+    if(cache->data != NULL) {
+#if defined(LEVELCACHE_MMAP)
+        if(cache->mapped)
+            munmap((void*)cache->data, cache->size);
+        else
+            free((void*)cache->data);
+#else
+        free((void*)cache->data);
+#endif
+    }
+
+    cache->data = NULL;
+    cache->size = 0;
+}
+
+/* validates a compiled level and locates its sections */
+bool validate(levelcache_t* cache, uint64_t source_hash)
+{
+    uint32_t command_count, param_count, strings_size;
+    uint64_t expected_size;
+
+    /* validate the header */
+    if(cache->size < HEADER_SIZE || 0 != memcmp(cache->data, LEVELCACHE_MAGIC, 8))
+        return false;
+    else if(le32_to_cpu(cache->data + 8) != LEVELCACHE_FORMAT || le32_to_cpu(cache->data + 12) != GAME_VERSION_CODE)
+        return false;
+    else if(le64_to_cpu(cache->data + 16) != source_hash)
+        return false;
+
+    /* validate the size of the file */
+    command_count = le32_to_cpu(cache->data + 24);
+    param_count = le32_to_cpu(cache->data + 28);
+    strings_size = le32_to_cpu(cache->data + 32);
+    expected_size = HEADER_SIZE + (uint64_t)command_count * COMMAND_SIZE + (uint64_t)param_count * PARAM_SIZE + (uint64_t)strings_size;
+    if(expected_size != (uint64_t)cache->size || strings_size == 0)
+        return false;
+
+    /* locate the sections */
+    cache->command_count = command_count;
+    cache->commands = cache->data + HEADER_SIZE;
+    cache->params = cache->commands + (size_t)command_count * COMMAND_SIZE;
+    cache->strings = (const char*)(cache->params + (size_t)param_count * PARAM_SIZE);
+    if(cache->strings[strings_size - 1] != '\0')
+        return false;
+
+    /* validate the commands */
+    for(uint32_t i = 0; i < command_count; i++) {
+        const uint8_t* command = cache->commands + i * COMMAND_SIZE;
+        uint32_t count = le32_to_cpu(command + 8);
+        uint32_t first = le32_to_cpu(command + 12);
+
+        if(le32_to_cpu(command + 4) >= strings_size || count > MAX_PARAMS || first > param_count || count > param_count - first)
+            return false;
+    }
+
+    /* validate the params */
+    for(uint32_t i = 0; i < param_count; i++) {
+        if(le32_to_cpu(cache->params + i * PARAM_SIZE) >= strings_size)
+            return false;
+    }
+
+    /* success! */
+    return true;
+}
+
+/* adds a string to the string table, returning its offset */
+uint32_t intern(levelcache_compiler_t* compiler, const char* str)
+{
+    size_t mask = compiler->table_cap - 1;
+    size_t i = hash_str(str) & mask;
+    uint32_t offset;
+
+    /* is the string already in the table? */
+    for(; compiler->table[i] != 0; i = (i + 1) & mask) {
+        offset = compiler->table[i] - 1;
+        if(strcmp(compiler->strings + offset, str) == 0)
+            return offset;
+    }
+
+    /* add the string, including its terminator */
+    offset = (uint32_t)darray_length(compiler->strings);
+    do { darray_push(compiler->strings, *str); } while(*str++ != '\0');
+    compiler->table[i] = offset + 1;
+
+    /* keep the load factor below 1/2 */
+    if(2 * (++compiler->table_count) > compiler->table_cap)
+        grow_table(compiler);
+
+    return offset;
+}
+
+/* doubles the capacity of the table of interned strings */
+void grow_table(levelcache_compiler_t* compiler)
+{
+    size_t old_cap = compiler->table_cap;
+    uint32_t* old_table = compiler->table;
+    size_t mask;
+
+    compiler->table_cap *= 2;
+    compiler->table = mallocx(compiler->table_cap * sizeof(*(compiler->table)));
+    memset(compiler->table, 0, compiler->table_cap * sizeof(*(compiler->table)));
+    mask = compiler->table_cap - 1;
+
+    for(size_t j = 0; j < old_cap; j++) {
+        if(old_table[j] != 0) {
+            size_t i = hash_str(compiler->strings + (old_table[j] - 1)) & mask;
+            while(compiler->table[i] != 0)
+                i = (i + 1) & mask;
+            compiler->table[i] = old_table[j];
+        }
+    }
+
+    free(old_table);
+}
+
+/* FNV-1a */
+uint32_t hash_str(const char* str)
+{
+    uint32_t hash = 0x811C9DC5;
+
+    while(*str) {
+        hash ^= (uint8_t)(*(str++));
+        hash *= 0x1000193;
+    }
+
+    return hash;
+}
+
+/* compiles a .lev file into memory */
+bool compile(const char* fullpath, uint64_t source_hash, levelcache_t* cache)
+{
+    char line[LINE_MAXLENGTH];
+    levelcache_compiler_t* compiler;
+    int fileline = 0;
+    FILE* fp;
+
+    if(NULL == (fp = fopen(fullpath, "r")))
+        return false;
+
+    compiler = create_compiler(source_hash);
+    while(fgets(line, sizeof(line) / sizeof(char), fp)) {
+        if(*line) {
+            char *q = line + strlen(line) - 1;
+            if(*q == '\n') *q = '\0'; /* no newlines, please! */
+            compile_line(compiler, ++fileline, line);
+        }
+    }
+    fclose(fp);
+
+    cache->data = serialize(compiler, &(cache->size));
+    cache->mapped = false;
+    compiler = destroy_compiler(compiler);
+
+    return validate(cache, source_hash);
+}
+
+/* writes a compiled level to a file. We write to a temporary file and
+   then rename it, so that a compiled file that is mapped into memory
+   is never truncated */
+void save(const levelcache_t* cache, const char* cache_fullpath)
+{
+    char* tmp = mallocx((strlen(cache_fullpath) + 5) * sizeof(*tmp));
+    bool success = false;
+    FILE* fp;
+
+    strcat(strcpy(tmp, cache_fullpath), ".tmp");
+    if(NULL != (fp = fopen(tmp, "wb"))) {
+        success = (1 == fwrite(cache->data, cache->size, 1, fp));
+        success = (fclose(fp) == 0) && success;
+#if defined(_WIN32)
+        remove(cache_fullpath); /* rename() doesn't replace files on Windows */
+#endif
+        success = success && (rename(tmp, cache_fullpath) == 0);
+        if(!success)
+            remove(tmp);
+    }
+
+    if(success)
+        logfile_debug("Compiled level \"%s\" to \"%s\"", cache->filename, cache_fullpath);
+    else
+        logfile_warning("Can't write compiled level \"%s\"", cache_fullpath);
+
+    free(tmp);
+}
+
+/* creates a level compiler */
+levelcache_compiler_t* create_compiler(uint64_t source_hash)
+{
+    levelcache_compiler_t* compiler = mallocx(sizeof *compiler);
+
+    compiler->source_hash = source_hash;
+    darray_init_ex(compiler->commands, 4096);
+    darray_init_ex(compiler->params, 4096);
+    darray_init_ex(compiler->strings, 4096);
+
+    compiler->table_count = 0;
+    compiler->table_cap = 1024; /* a power of two */
+    compiler->table = mallocx(compiler->table_cap * sizeof(*(compiler->table)));
+    memset(compiler->table, 0, compiler->table_cap * sizeof(*(compiler->table)));
+
+    intern(compiler, ""); /* the string table is never empty */
+    return compiler;
+}
+
+/* destroys a level compiler */
+levelcache_compiler_t* destroy_compiler(levelcache_compiler_t* compiler)
+{
+    darray_release(compiler->strings);
+    darray_release(compiler->params);
+    darray_release(compiler->commands);
+    free(compiler->table);
+    free(compiler);
+    return NULL;
+}
+
+/* tokenizes a line of a .lev file and adds it to the compiled level */
+void compile_line(levelcache_compiler_t* compiler, int fileline, const char* line)
+{
+    int param_count, i;
+    char *param[MAX_PARAMS], *identifier;
+    char tmp[LINE_MAXLENGTH], *p, *q;
+    const int sz = (sizeof(tmp)/sizeof(*tmp))-1;
+
+    /* skip spaces */
+    for(p=(char*)line; isspace((int)*p); p++);
+    if(0 == *p) return;
+
+    /* reading the identifier */
+    for(q=tmp; *p && !isspace(*p) && q<tmp+sz; *q++ = *p++) { ; } *q=0;
+    if(strncmp(tmp, "//", 2) == 0 || *tmp == '#') return; /* comment */
+    identifier = str_dup(tmp);
+
+    /* skip spaces */
+    for(; isspace((int)*p); p++);
+
+    /* read the arguments */
+    param_count = 0;
+    if(0 != *p) {
+        int quotes;
+        while(*p && param_count<sizeof(param)/sizeof(*param)) {
+            quotes = (*p == '"') && !!(p++); /* short-circuit AND */
+            for(q=tmp; *p && ((!quotes && !isspace(*p)) || (quotes && !(*p == '"' && *(p-1) != '\\'))) && q<tmp+sz; *q++ = *p++) { ; } *q=0;
+            quotes = (*p == '"') && !!(p++);
+            param[param_count++] = str_dup(tmp);
+            for(; isspace((int)*p); p++); /* skip spaces */
+        }
+    }
+
+    /* add the command */
+    add_command(compiler, fileline, identifier, param_count, (const char**)param);
+
+    /* free the stuff */
+    for(i=0; i<param_count; i++)
+        free(param[i]);
+    free(identifier);
+}
+
+/* adds a command (a tokenized line of the .lev file) to the compiled level */
+void add_command(levelcache_compiler_t* compiler, int fileline, const char* identifier, int param_count, const char** param)
+{
+    param_count = clip(param_count, 0, MAX_PARAMS);
+
+    darray_push(compiler->commands, (uint32_t)fileline);
+    darray_push(compiler->commands, intern(compiler, identifier));
+    darray_push(compiler->commands, (uint32_t)param_count);
+    darray_push(compiler->commands, (uint32_t)darray_length(compiler->params));
+
+    for(int i = 0; i < param_count; i++)
+        darray_push(compiler->params, intern(compiler, param[i]));
+}
+
+/* stores a compiled level in a buffer, in the format of the compiled files */
+uint8_t* serialize(const levelcache_compiler_t* compiler, size_t* size)
+{
+    size_t word_count = darray_length(compiler->commands);
+    size_t param_count = darray_length(compiler->params);
+    size_t strings_size = darray_length(compiler->strings);
+    uint8_t *data, *p;
+
+    *size = HEADER_SIZE + 4 * (word_count + param_count) + strings_size;
+    p = data = mallocx(*size);
+
+    /* header */
+    memcpy(p, LEVELCACHE_MAGIC, 8);
+    cpu_to_le32(LEVELCACHE_FORMAT, p + 8);
+    cpu_to_le32(GAME_VERSION_CODE, p + 12);
+    cpu_to_le64(compiler->source_hash, p + 16);
+    cpu_to_le32((uint32_t)(word_count / 4), p + 24);
+    cpu_to_le32((uint32_t)param_count, p + 28);
+    cpu_to_le32((uint32_t)strings_size, p + 32);
+    p += HEADER_SIZE;
+
+    /* commands & params */
+    for(size_t i = 0; i < word_count; i++, p += 4)
+        cpu_to_le32(compiler->commands[i], p);
+    for(size_t i = 0; i < param_count; i++, p += 4)
+        cpu_to_le32(compiler->params[i], p);
+
+    /* strings */
+    memcpy(p, compiler->strings, strings_size);
+    return data;
+}
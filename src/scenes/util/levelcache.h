@@ -0,0 +1,51 @@
+/*
+ * Open Surge Engine
+ * levelcache.h - compiled levels
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LEVELCACHE_H
+#define _LEVELCACHE_H
+
+#include <stdbool.h>
+
+/*
+   A compiled level is a binary version of a .lev file,
+   stored in the cache of the assetfs. It holds the
+   commands of the level already tokenized, so that
+   they can be read from a memory-mapped file without
+   any parsing or copying.
+
+   The .lev file is the source of truth: a compiled
+   level stores the hash of its source, and it's
+   discarded whenever the source changes.
+
+   levelcache_load() doesn't touch the assetfs, so it
+   may run on a worker thread: resolve the paths on
+   the main thread beforehand.
+*/
+
+typedef struct levelcache_t levelcache_t;
+typedef void (*levelcache_callback_t)(const char *filename, int fileline, const char *identifier, int param_count, const char **param);
+
+/* reading compiled levels */
+const char* levelcache_fullpath(const char *filepath); /* absolute path of the compiled version of a .lev file (call it on the main thread) */
+levelcache_t* levelcache_load(const char *fullpath, const char *cache_fullpath); /* reads a compiled level, compiling the .lev file if necessary; thread-safe */
+levelcache_t* levelcache_close(levelcache_t *cache); /* closes a compiled level */
+void levelcache_foreach_command(const levelcache_t *cache, levelcache_callback_t callback); /* calls callback for each command, in order */
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ * Open Surge Engine
+ * levelstream.c - streaming of level sections
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include "levelstream.h"
+#include "../../core/darray.h"
+#include "../../core/util.h"
+
+#define FASTHASH_INLINE
+#include "../../core/fasthash.h"
+
+/* a section of the level */
+typedef struct levelstream_section_t levelstream_section_t;
+struct levelstream_section_t {
+    int column, row; /* the section covers [column * size, (column+1) * size) x [row * size, (row+1) * size) */
+    DARRAY(int, entry); /* indices of the entries, in the order they were added */
+    bool materialized;
+};
+
+/* the stream */
+struct levelstream_t {
+    int section_size;
+    DARRAY(levelstream_section_t*, section); /* owns the sections */
+    DARRAY(levelstream_section_t*, materialized); /* sections currently materialized */
+    DARRAY(int, refs); /* number of materialized sections of each entry */
+    fasthash_t* grid; /* (column, row) -> section */
+};
+
+/* private stuff */
+static inline uint64_t section_key(int column, int row);
+static inline int floor_div(int a, int b);
+static void materialize_section(levelstream_t* stream, levelstream_section_t* section, void* data, void (*materialize)(int,void*));
+static void evict_section(levelstream_t* stream, levelstream_section_t* section, void* data, void (*evict)(int,void*));
+static levelstream_section_t* get_section(levelstream_t* stream, int column, int row);
+
+
+
+/* public API */
+
+/*
+ * levelstream_create()
+ * Creates a new stream whose sections are
+ * squares of the given size, in pixels
+ */
+levelstream_t* levelstream_create(int section_size)
+{
+    levelstream_t* stream = mallocx(sizeof *stream);
+
+    stream->section_size = max(1, section_size);
+    darray_init(stream->section);
+    darray_init(stream->materialized);
+    darray_init(stream->refs);
+    stream->grid = fasthash_create(NULL, 10);
+
+    return stream;
+}
+
+/*
+ * levelstream_destroy()
+ * Destroys a stream
+ */
+levelstream_t* levelstream_destroy(levelstream_t* stream)
+{
+    for(int i = 0; i < darray_length(stream->section); i++) {
+        darray_release(stream->section[i]->entry);
+        free(stream->section[i]);
+    }
+
+    stream->grid = fasthash_destroy(stream->grid);
+    darray_release(stream->refs);
+    darray_release(stream->materialized);
+    darray_release(stream->section);
+    free(stream);
+
+    return NULL;
+}
+
+/*
+ * levelstream_add()
+ * Adds an entry occupying the given rectangle to all sections
+ * that overlap it. Entries are non-negative indices and should
+ * be added before the stream is updated
+ */
+void levelstream_add(levelstream_t* stream, int entry, int x, int y, int width, int height)
+{
+    int size = stream->section_size;
+    int first_column = floor_div(x, size), last_column = floor_div(x + max(1, width) - 1, size);
+    int first_row = floor_div(y, size), last_row = floor_div(y + max(1, height) - 1, size);
+
+    for(int row = first_row; row <= last_row; row++) {
+        for(int column = first_column; column <= last_column; column++) {
+            /* darray_push() evaluates its array argument more than once */
+            levelstream_section_t* section = get_section(stream, column, row);
+            darray_push(section->entry, entry);
+        }
+    }
+
+    while(darray_length(stream->refs) <= entry)
+        darray_push(stream->refs, 0);
+}
+
+/*
+ * levelstream_update()
+ * Materializes the sections touching the given rectangle: materialize(entry, data)
+ * is called for each of their entries that isn't yet materialized. Materialized
+ * sections farther than one section away from the rectangle are evicted:
+ * evict(entry, data) is called for each of their entries that has no other
+ * materialized section
+ */
+void levelstream_update(levelstream_t* stream, int x, int y, int width, int height, void* data, void (*materialize)(int,void*), void (*evict)(int,void*))
+{
+    int size = stream->section_size;
+    int first_column = floor_div(x, size), last_column = floor_div(x + max(1, width) - 1, size);
+    int first_row = floor_div(y, size), last_row = floor_div(y + max(1, height) - 1, size);
+    levelstream_section_t* last;
+
+    /* materialize the sections nearby first, so that the entries
+       shared with the sections being evicted stay in the level */
+    for(int row = first_row; row <= last_row; row++) {
+        for(int column = first_column; column <= last_column; column++) {
+            levelstream_section_t* section = fasthash_get(stream->grid, section_key(column, row));
+            if(section != NULL && !section->materialized)
+                materialize_section(stream, section, data, materialize);
+        }
+    }
+
+    /* evict the sections far away */
+    for(int i = darray_length(stream->materialized) - 1; i >= 0; i--) {
+        levelstream_section_t* section = stream->materialized[i];
+        if(
+            section->column < first_column - 1 || section->column > last_column + 1 ||
+            section->row < first_row - 1 || section->row > last_row + 1
+        ) {
+            evict_section(stream, section, data, evict);
+
+            /* swap & pop */
+            darray_pop(stream->materialized, last);
+            if(i < darray_length(stream->materialized))
+                stream->materialized[i] = last;
+        }
+    }
+}
+
+/*
+ * levelstream_materialize_all()
+ * Materializes all sections that aren't yet materialized
+ */
+void levelstream_materialize_all(levelstream_t* stream, void* data, void (*materialize)(int,void*))
+{
+    for(int i = 0; i < darray_length(stream->section); i++) {
+        if(!stream->section[i]->materialized)
+            materialize_section(stream, stream->section[i], data, materialize);
+    }
+}
+
+/*
+ * levelstream_reset()
+ * Marks all sections as evicted. No callbacks are called
+ */
+void levelstream_reset(levelstream_t* stream)
+{
+    for(int i = 0; i < darray_length(stream->materialized); i++)
+        stream->materialized[i]->materialized = false;
+
+    for(int i = 0; i < darray_length(stream->refs); i++)
+        stream->refs[i] = 0;
+
+    darray_clear(stream->materialized);
+}
+
+/*
+ * levelstream_section_count()
+ * The number of sections having at least one entry
+ */
+int levelstream_section_count(const levelstream_t* stream)
+{
+    return darray_length(stream->section);
+}
+
+/*
+ * levelstream_materialized_count()
+ * The number of sections currently materialized
+ */
+int levelstream_materialized_count(const levelstream_t* stream)
+{
+    return darray_length(stream->materialized);
+}
+
+
+
+/* private */
+
+uint64_t section_key(int column, int row)
+{
+    return ((uint64_t)((uint32_t)column) << 32) | (uint64_t)((uint32_t)row);
+}
+
+int floor_div(int a, int b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+void materialize_section(levelstream_t* stream, levelstream_section_t* section, void* data, void (*materialize)(int,void*))
+{
+    for(int j = 0; j < darray_length(section->entry); j++) {
+        int entry = section->entry[j];
+        if(stream->refs[entry]++ == 0)
+            materialize(entry, data);
+    }
+
+    section->materialized = true;
+    darray_push(stream->materialized, section);
+}
+
+void evict_section(levelstream_t* stream, levelstream_section_t* section, void* data, void (*evict)(int,void*))
+{
+    for(int j = 0; j < darray_length(section->entry); j++) {
+        int entry = section->entry[j];
+        if(--stream->refs[entry] == 0)
+            evict(entry, data);
+    }
+
+    section->materialized = false;
+}
+
+levelstream_section_t* get_section(levelstream_t* stream, int column, int row)
+{
+    uint64_t key = section_key(column, row);
+    levelstream_section_t* section = fasthash_get(stream->grid, key);
+
+    if(section == NULL) {
+        section = mallocx(sizeof *section);
+        section->column = column;
+        section->row = row;
+        section->materialized = false;
+        darray_init(section->entry);
+        darray_push(stream->section, section);
+        fasthash_put(stream->grid, key, section);
+    }
+
+    return section;
+}
@@ -0,0 +1,47 @@
+/*
+ * Open Surge Engine
+ * levelstream.h - streaming of level sections
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LEVELSTREAM_H
+#define _LEVELSTREAM_H
+
+#include <stdbool.h>
+
+/*
+   A level stream splits the level in square sections and
+   keeps track of which of them are materialized. Each section
+   holds the indices of the entries (spawn records) whose areas
+   overlap it. As the camera moves, the sections near it are
+   materialized and the sections far away are evicted. An entry
+   is materialized along with the first of its sections and
+   evicted along with the last one.
+*/
+
+typedef struct levelstream_t levelstream_t;
+
+levelstream_t* levelstream_create(int section_size); /* creates a new stream */
+levelstream_t* levelstream_destroy(levelstream_t* stream); /* destroys a stream */
+void levelstream_add(levelstream_t* stream, int entry, int x, int y, int width, int height); /* adds an entry occupying the given rectangle */
+void levelstream_update(levelstream_t* stream, int x, int y, int width, int height, void* data, void (*materialize)(int,void*), void (*evict)(int,void*)); /* materializes the sections touching the given rectangle and evicts the ones far from it */
+void levelstream_materialize_all(levelstream_t* stream, void* data, void (*materialize)(int,void*)); /* materializes all sections */
+void levelstream_reset(levelstream_t* stream); /* marks all sections as evicted, without calling back */
+int levelstream_section_count(const levelstream_t* stream); /* number of non-empty sections */
+int levelstream_materialized_count(const levelstream_t* stream); /* number of materialized sections */
+
+#endif
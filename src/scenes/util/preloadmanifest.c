@@ -0,0 +1,171 @@
+/*
+ * Open Surge Engine
+ * preloadmanifest.c - sounds used by a level
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "preloadmanifest.h"
+#include "../../core/assetfs.h"
+#include "../../core/stringutil.h"
+#include "../../core/logfile.h"
+#include "../../core/darray.h"
+#include "../../core/util.h"
+
+/*
+   preload manifest file format: a text file
+   with the relative path of a sound per line
+*/
+#define MANIFEST_DIR            "levelcache/" /* in the cache of the assetfs */
+#define MANIFEST_EXTENSION      ".manifest"
+#define LINE_MAXLENGTH          1024
+
+/* the manifest of a level */
+struct preloadmanifest_t {
+    char* vpath; /* virtual path of the manifest */
+    DARRAY(char*, sounds); /* relative paths */
+    bool modified;
+};
+
+/* private stuff */
+static bool contains(const preloadmanifest_t* manifest, const char* path);
+static bool write_manifest(const preloadmanifest_t* manifest, const char* fullpath);
+
+
+
+/* public API */
+
+/*
+ * preloadmanifest_load()
+ * Reads the preload manifest of a level from the cache.
+ * If there is no manifest, an empty one will be created
+ */
+preloadmanifest_t* preloadmanifest_load(const char *level_path)
+{
+    preloadmanifest_t* manifest = mallocx(sizeof *manifest);
+    char line[LINE_MAXLENGTH];
+
+    manifest->vpath = mallocx((strlen(MANIFEST_DIR) + strlen(level_path) + strlen(MANIFEST_EXTENSION) + 1) * sizeof(char));
+    strcat(strcat(strcpy(manifest->vpath, MANIFEST_DIR), level_path), MANIFEST_EXTENSION);
+    manifest->modified = false;
+    darray_init(manifest->sounds);
+
+    /* read the manifest */
+    if(assetfs_exists(manifest->vpath) && assetfs_is_cache_file(manifest->vpath)) {
+        FILE* fp = fopen(assetfs_fullpath(manifest->vpath), "r");
+
+        if(fp != NULL) {
+            while(fgets(line, sizeof(line), fp) != NULL) {
+                line[strcspn(line, "\r\n")] = '\0';
+                if(*line == '\0')
+                    continue;
+
+                /* skip the sounds that no longer exist */
+                if(assetfs_exists(line) && !contains(manifest, line))
+                    darray_push(manifest->sounds, str_dup(line));
+                else
+                    manifest->modified = true;
+            }
+
+            fclose(fp);
+        }
+    }
+
+    logfile_message("preloadmanifest_load(\"%s\"): %d sounds", level_path, (int)darray_length(manifest->sounds));
+    return manifest;
+}
+
+/*
+ * preloadmanifest_unload()
+ * Writes the manifest back to the cache
+ * (if it has changed) and releases it
+ */
+preloadmanifest_t* preloadmanifest_unload(preloadmanifest_t *manifest)
+{
+    if(manifest->modified) {
+        if(!write_manifest(manifest, assetfs_create_cache_file(manifest->vpath)))
+            logfile_message("Can't write the preload manifest \"%s\"", manifest->vpath);
+    }
+
+    for(int i = 0; i < darray_length(manifest->sounds); i++)
+        free(manifest->sounds[i]);
+    darray_release(manifest->sounds);
+
+    free(manifest->vpath);
+    free(manifest);
+    return NULL;
+}
+
+/*
+ * preloadmanifest_add()
+ * Adds a sound to the manifest (duplicates are ignored)
+ */
+void preloadmanifest_add(preloadmanifest_t *manifest, const char *path)
+{
+    if(*path != '\0' && strlen(path) < LINE_MAXLENGTH - 1 && !contains(manifest, path)) {
+        darray_push(manifest->sounds, str_dup(path));
+        manifest->modified = true;
+    }
+}
+
+/*
+ * preloadmanifest_foreach()
+ * Calls callback for each sound of the manifest
+ */
+void preloadmanifest_foreach(const preloadmanifest_t *manifest, void (*callback)(const char *path))
+{
+    for(int i = 0; i < darray_length(manifest->sounds); i++)
+        callback(manifest->sounds[i]);
+}
+
+
+
+/* private */
+
+/* checks if a sound is in the manifest */
+bool contains(const preloadmanifest_t* manifest, const char* path)
+{
+    for(int i = 0; i < darray_length(manifest->sounds); i++) {
+        if(str_icmp(manifest->sounds[i], path) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/* writes the manifest to a file */
+bool write_manifest(const preloadmanifest_t* manifest, const char* fullpath)
+{
+    bool success = true;
+    FILE* fp;
+
+    if(NULL == (fp = fopen(fullpath, "w")))
+        return false;
+
+    for(int i = 0; i < darray_length(manifest->sounds) && success; i++)
+        success = (fprintf(fp, "%s\n", manifest->sounds[i]) >= 0);
+
+    if(fclose(fp) != 0 || !success) {
+        remove(fullpath);
+        return false;
+    }
+
+    return true;
+}
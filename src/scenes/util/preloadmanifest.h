@@ -0,0 +1,39 @@
+/*
+ * Open Surge Engine
+ * preloadmanifest.h - sounds used by a level
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PRELOADMANIFEST_H
+#define _PRELOADMANIFEST_H
+
+/*
+   A preload manifest lists the sounds that have been
+   loaded while a level was being played. It's kept in
+   the cache of the assetfs, so that these sounds can be
+   decoded along with the other assets of the level when
+   it's loaded again, before they're first played.
+*/
+
+typedef struct preloadmanifest_t preloadmanifest_t;
+
+preloadmanifest_t* preloadmanifest_load(const char *level_path); /* reads the manifest of a level from the cache (it may be empty) */
+preloadmanifest_t* preloadmanifest_unload(preloadmanifest_t *manifest); /* writes the manifest back (if it has changed) and releases it */
+void preloadmanifest_add(preloadmanifest_t *manifest, const char *path); /* adds a sound to the manifest */
+void preloadmanifest_foreach(const preloadmanifest_t *manifest, void (*callback)(const char *path)); /* calls callback for each sound */
+
+#endif
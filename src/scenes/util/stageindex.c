@@ -0,0 +1,401 @@
+/*
+ * Open Surge Engine
+ * stageindex.c - cached metadata of the installed levels
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "stageindex.h"
+#include "../../core/assetfs.h"
+#include "../../core/hashtable.h"
+#include "../../core/stringutil.h"
+#include "../../core/logfile.h"
+#include "../../core/global.h"
+#include "../../core/util.h"
+
+/*
+   stage index file format (little-endian):
+
+   header:      magic[8] | format u32 | engine version u32 | entry count u32
+   entries:     { mtime u64 | size u64 | act u32 | requires u32 x 3 |
+                  path length u32 | name length u32 | path | name } x entry count
+*/
+#define STAGEINDEX_MAGIC        "SURGESTI"
+#define STAGEINDEX_FORMAT       1 /* increment whenever the format changes */
+#define STAGEINDEX_VPATH        "levelcache/stageindex.bin" /* in the cache of the assetfs */
+#define HEADER_SIZE             20
+#define ENTRY_SIZE              40 /* not counting the strings */
+#define LINE_MAXLENGTH          1024
+
+/* an entry of the index */
+typedef struct stageentry_t stageentry_t;
+struct stageentry_t {
+    char* filepath; /* relative path of the .lev file */
+    int64_t mtime; /* modification time of the .lev file */
+    int64_t size; /* size of the .lev file, in bytes */
+    stageinfo_t info; /* header of the level */
+    bool used; /* was this entry requested? (entries of removed levels aren't written back) */
+};
+
+static stageentry_t* stageentry_create(const char* filepath);
+static void stageentry_destroy(stageentry_t* entry);
+HASHTABLE_GENERATE_CODE(stageentry_t, stageentry_destroy);
+
+/* the index */
+struct stageindex_t {
+    hashtable_stageentry_t* entries;
+    int entry_count;
+    int used_count;
+    bool modified;
+};
+
+/* private stuff */
+static bool read_index(stageindex_t* index, const uint8_t* data, size_t size);
+static bool write_index(const stageindex_t* index, const char* fullpath);
+static void write_entry(stageentry_t* entry, void* fp);
+static bool read_header(const char* fullpath, stageinfo_t* info);
+static const char* read_word(const char* p, char* buf, size_t size);
+
+
+
+/* public API */
+
+/*
+ * stageindex_load()
+ * Reads the stage index from the cache. If there is
+ * no (valid) index, an empty one will be created
+ */
+stageindex_t* stageindex_load()
+{
+    stageindex_t* index = mallocx(sizeof *index);
+    index->entries = hashtable_stageentry_t_create();
+    index->entry_count = 0;
+    index->used_count = 0;
+    index->modified = false;
+
+    /* read the whole file at once */
+    if(assetfs_exists(STAGEINDEX_VPATH) && assetfs_is_cache_file(STAGEINDEX_VPATH)) {
+        const char* fullpath = assetfs_fullpath(STAGEINDEX_VPATH);
+        FILE* fp = fopen(fullpath, "rb");
+
+        if(fp != NULL) {
+            uint8_t* data = NULL;
+            long size = 0;
+            bool success = false;
+
+            if(fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+                data = mallocx(size);
+                success = (1 == fread(data, size, 1, fp)) && read_index(index, data, size);
+            }
+
+            if(!success) {
+                logfile_message("Discarding the stage index \"%s\"", fullpath);
+                index->entries = hashtable_stageentry_t_destroy(index->entries);
+                index->entries = hashtable_stageentry_t_create();
+                index->entry_count = 0;
+                index->modified = true;
+            }
+
+            free(data);
+            fclose(fp);
+        }
+    }
+
+    logfile_message("stageindex_load(): %d entries", index->entry_count);
+    return index;
+}
+
+/*
+ * stageindex_unload()
+ * Writes the stage index back to the cache (if it
+ * has changed) and releases it
+ */
+stageindex_t* stageindex_unload(stageindex_t* index)
+{
+    /* entries that weren't requested belong to levels that no longer exist */
+    if(index->modified || index->used_count < index->entry_count) {
+        const char* fullpath = assetfs_create_cache_file(STAGEINDEX_VPATH);
+        if(!write_index(index, fullpath)) {
+            logfile_message("Can't write the stage index \"%s\"", fullpath);
+            remove(fullpath);
+        }
+    }
+
+    hashtable_stageentry_t_destroy(index->entries);
+    free(index);
+    return NULL;
+}
+
+/*
+ * stageindex_get()
+ * Gets the header of a .lev file, given its relative path. The header
+ * is read from the index, unless the file is new or has been modified.
+ * Returns false if the file can't be read
+ */
+bool stageindex_get(stageindex_t* index, const char* filepath, stageinfo_t* info)
+{
+    const char* fullpath = assetfs_fullpath(filepath);
+    stageentry_t* entry = hashtable_stageentry_t_find(index->entries, filepath);
+    struct stat st;
+
+    if(stat(fullpath, &st) != 0)
+        return false;
+
+    /* read the header of a new or modified level */
+    if(entry == NULL || entry->mtime != (int64_t)st.st_mtime || entry->size != (int64_t)st.st_size) {
+        stageinfo_t header;
+        if(!read_header(fullpath, &header))
+            return false;
+
+        if(entry == NULL) {
+            entry = stageentry_create(filepath);
+            hashtable_stageentry_t_add(index->entries, filepath, entry);
+            index->entry_count++;
+        }
+
+        entry->mtime = (int64_t)st.st_mtime;
+        entry->size = (int64_t)st.st_size;
+        entry->info = header;
+        index->modified = true;
+    }
+
+    if(!entry->used) {
+        entry->used = true;
+        index->used_count++;
+    }
+
+    *info = entry->info;
+    return true;
+}
+
+
+
+/* private */
+
+/* creates an entry of the index */
+stageentry_t* stageentry_create(const char* filepath)
+{
+    stageentry_t* entry = mallocx(sizeof *entry);
+
+    entry->filepath = str_dup(filepath);
+    entry->mtime = 0;
+    entry->size = 0;
+    entry->used = false;
+    str_cpy(entry->info.name, "Untitled", sizeof(entry->info.name));
+    entry->info.act = 1;
+    entry->info.requires[0] = entry->info.requires[1] = entry->info.requires[2] = 0;
+
+    return entry;
+}
+
+/* destroys an entry of the index */
+void stageentry_destroy(stageentry_t* entry)
+{
+    free(entry->filepath);
+    free(entry);
+}
+
+/* reads the contents of an index file */
+bool read_index(stageindex_t* index, const uint8_t* data, size_t size)
+{
+    const uint8_t* end = data + size;
+    uint32_t entry_count;
+
+    /* validate the header */
+    if(size < HEADER_SIZE || memcmp(data, STAGEINDEX_MAGIC, 8) != 0)
+        return false;
+    else if(le32_to_cpu(data + 8) != STAGEINDEX_FORMAT || le32_to_cpu(data + 12) != GAME_VERSION_CODE)
+        return false;
+
+    /* read the entries */
+    entry_count = le32_to_cpu(data + 16);
+    data += HEADER_SIZE;
+    for(uint32_t i = 0; i < entry_count; i++) {
+        stageentry_t* entry;
+        uint32_t path_length, name_length;
+        char* path;
+
+        if((size_t)(end - data) < ENTRY_SIZE)
+            return false;
+
+        path_length = le32_to_cpu(data + 32);
+        name_length = le32_to_cpu(data + 36);
+        if(path_length == 0 || name_length >= sizeof(entry->info.name))
+            return false;
+        else if((size_t)(end - data) - ENTRY_SIZE < (size_t)path_length + name_length)
+            return false;
+
+        path = mallocx(path_length + 1);
+        memcpy(path, data + ENTRY_SIZE, path_length);
+        path[path_length] = '\0';
+        if(hashtable_stageentry_t_find(index->entries, path) != NULL) {
+            free(path);
+            return false;
+        }
+
+        entry = stageentry_create(path);
+        entry->mtime = (int64_t)le64_to_cpu(data);
+        entry->size = (int64_t)le64_to_cpu(data + 8);
+        entry->info.act = (int)le32_to_cpu(data + 16);
+        entry->info.requires[0] = (int)le32_to_cpu(data + 20);
+        entry->info.requires[1] = (int)le32_to_cpu(data + 24);
+        entry->info.requires[2] = (int)le32_to_cpu(data + 28);
+        memcpy(entry->info.name, data + ENTRY_SIZE + path_length, name_length);
+        entry->info.name[name_length] = '\0';
+
+        hashtable_stageentry_t_add(index->entries, path, entry);
+        index->entry_count++;
+        free(path);
+        data += ENTRY_SIZE + path_length + name_length;
+    }
+
+    return data == end;
+}
+
+/* writes the used entries of the index to a file */
+bool write_index(const stageindex_t* index, const char* fullpath)
+{
+    uint8_t header[HEADER_SIZE];
+    bool success;
+    FILE* fp;
+
+    if(NULL == (fp = fopen(fullpath, "wb")))
+        return false;
+
+    memcpy(header, STAGEINDEX_MAGIC, 8);
+    cpu_to_le32(STAGEINDEX_FORMAT, header + 8);
+    cpu_to_le32(GAME_VERSION_CODE, header + 12);
+    cpu_to_le32((uint32_t)index->used_count, header + 16);
+    fwrite(header, sizeof(header), 1, fp);
+    hashtable_stageentry_t_foreach(index->entries, fp, write_entry);
+
+    success = (ferror(fp) == 0);
+    return (fclose(fp) == 0) && success;
+}
+
+/* writes an entry of the index to a file */
+void write_entry(stageentry_t* entry, void* fp)
+{
+    uint8_t buf[ENTRY_SIZE];
+    uint32_t path_length = strlen(entry->filepath);
+    uint32_t name_length = strlen(entry->info.name);
+
+    if(!entry->used)
+        return;
+
+    cpu_to_le64((uint64_t)entry->mtime, buf);
+    cpu_to_le64((uint64_t)entry->size, buf + 8);
+    cpu_to_le32((uint32_t)entry->info.act, buf + 16);
+    cpu_to_le32((uint32_t)entry->info.requires[0], buf + 20);
+    cpu_to_le32((uint32_t)entry->info.requires[1], buf + 24);
+    cpu_to_le32((uint32_t)entry->info.requires[2], buf + 28);
+    cpu_to_le32(path_length, buf + 32);
+    cpu_to_le32(name_length, buf + 36);
+
+    fwrite(buf, sizeof(buf), 1, (FILE*)fp);
+    fwrite(entry->filepath, path_length, 1, (FILE*)fp);
+    fwrite(entry->info.name, name_length, 1, (FILE*)fp);
+}
+
+/* reads the header of a .lev file, line by line. We stop
+   as soon as we have the data we need or when the body
+   of the level (bricks, entities...) begins */
+bool read_header(const char* fullpath, stageinfo_t* info)
+{
+    char line[LINE_MAXLENGTH], id[32], val[128];
+    bool has_name = false, has_act = false, has_requires = false;
+    FILE* fp;
+
+    str_cpy(info->name, "Untitled", sizeof(info->name));
+    info->act = 1;
+    info->requires[0] = info->requires[1] = info->requires[2] = 0;
+
+    if(NULL == (fp = fopen(fullpath, "r")))
+        return false;
+
+    while(!(has_name && has_act && has_requires) && fgets(line, sizeof(line), fp) != NULL) {
+        const char* p = line;
+
+        /* skip the rest of a long line */
+        if(strchr(line, '\n') == NULL) {
+            int c;
+            while((c = fgetc(fp)) != '\n' && c != EOF);
+        }
+
+        /* read the identifier */
+        while(isspace((unsigned char)*p))
+            p++;
+        if(!isalpha((unsigned char)*p))
+            continue; /* comments, blank lines... */
+        p = read_word(p, id, sizeof(id));
+        p = read_word(p, val, sizeof(val));
+
+        /* read the value */
+        if(str_icmp(id, "name") == 0) {
+            str_cpy(info->name, val, sizeof(info->name));
+            has_name = true;
+        }
+        else if(str_icmp(id, "act") == 0) {
+            info->act = atoi(val);
+            has_act = true;
+        }
+        else if(str_icmp(id, "requires") == 0) {
+            sscanf(val, "%d.%d.%d", &(info->requires[0]), &(info->requires[1]), &(info->requires[2]));
+            has_requires = true;
+        }
+        else if(str_icmp(id, "brick") == 0 || str_icmp(id, "entity") == 0 || str_icmp(id, "item") == 0 || str_icmp(id, "enemy") == 0 || str_icmp(id, "object") == 0)
+            break; /* end of the header */
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/* reads a (possibly quoted) word, returning a pointer to the rest of the string */
+const char* read_word(const char* p, char* buf, size_t size)
+{
+    size_t n = 0;
+
+    while(isspace((unsigned char)*p))
+        p++;
+
+    if(*p == '"') {
+        for(p++; *p && *p != '"' && *p != '\n'; p++) {
+            if(*p == '\\' && *(p+1) != '\0')
+                p++; /* escape sequence */
+            if(n + 1 < size)
+                buf[n++] = *p;
+        }
+        if(*p == '"')
+            p++;
+    }
+    else {
+        for(; *p && !isspace((unsigned char)*p) && !(*p == '/' && *(p+1) == '/'); p++) {
+            if(n + 1 < size)
+                buf[n++] = *p;
+        }
+    }
+
+    buf[n] = '\0';
+    return p;
+}
@@ -0,0 +1,46 @@
+/*
+ * Open Surge Engine
+ * stageindex.h - cached metadata of the installed levels
+ * Copyright (C) 2019  Alexandre Martins <alemartf@gmail.com>
+ * http://opensurge2d.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _STAGEINDEX_H
+#define _STAGEINDEX_H
+
+#include <stdbool.h>
+
+/*
+   The stage index stores the header (name, act, required
+   version) of each .lev file, keyed by its path and by its
+   modification time. It's kept in the cache of the assetfs
+   and read in one go, so that the stage select screen
+   doesn't need to parse every level when it opens. Only
+   the header lines of new or modified levels are read.
+*/
+
+typedef struct stageindex_t stageindex_t;
+typedef struct stageinfo_t {
+    char name[128]; /* stage name */
+    int act; /* act number */
+    int requires[3]; /* required version */
+} stageinfo_t;
+
+stageindex_t* stageindex_load(); /* reads the index from the cache */
+stageindex_t* stageindex_unload(stageindex_t* index); /* writes the index back (if it has changed) and releases it */
+bool stageindex_get(stageindex_t* index, const char* filepath, stageinfo_t* info); /* gets the header of a .lev file; returns false on error */
+
+#endif
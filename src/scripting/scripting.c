@@ -155,7 +155,7 @@ void scripting_reload()
 
     /* reset the SurgeScript VM */
     if(!surgescript_vm_reset(vm)) {
-        logfile_message("Failed to reload the scripts");
+        logfile_error("Failed to reload the scripts");
         return;
     }
 